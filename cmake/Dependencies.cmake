@@ -28,6 +28,11 @@ if(PERFORMANCE_MONITORING)
   set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DPERFORMANCE_MONITORING")
 endif()
 
+# ---[ USE_OMPT
+if(USE_OMPT)
+  set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DUSE_OMPT")
+endif()
+
 # ---[ Google-glog
 include("cmake/External/glog.cmake")
 list(APPEND Caffe_INCLUDE_DIRS PUBLIC ${GLOG_INCLUDE_DIRS})
@@ -122,6 +122,7 @@ function(caffe_print_configuration_summary)
   caffe_status("  ALLOW_LMDB_NOLOCK :   ${ALLOW_LMDB_NOLOCK}")
   caffe_status("  USE_SYSTEMTAP           :   ${USE_SYSTEMTAP}")
   caffe_status("  PERFORMANCE_MONITORING  :   ${PERFORMANCE_MONITORING}")
+  caffe_status("  USE_OMPT                :   ${USE_OMPT}")
   caffe_status("")
   caffe_status("Dependencies:")
   caffe_status("  BLAS              : " APPLE THEN "Yes (vecLib)" ELSE "Yes (${BLAS})")
@@ -323,6 +323,24 @@ class Blob {
    */
   void ShareDiff(const Blob& other);
 
+  /**
+   * @brief Enable or disable row-sparse bookkeeping of the diff.
+   *
+   * Parameter blobs whose gradient only touches a few slices along the first
+   * axis (e.g. the EmbedLayer weights) can record which rows a Backward pass
+   * wrote. While enabled, every row not listed in diff_rows() is guaranteed
+   * to hold a zero diff, so ClearSparseDiff(), Update() and the solvers only
+   * visit the listed rows.
+   */
+  void set_diff_row_sparse(bool sparse);
+  /// @brief Sorted, unique rows that may hold a non-zero diff, or NULL when
+  ///        the diff is dense.
+  const vector<int>* diff_rows() const { return diff_rows_.get(); }
+  /// @brief Merge sorted, unique row indices into diff_rows().
+  void AddDiffRows(const vector<int>& rows);
+  /// @brief Zero the diff of the rows in diff_rows() and empty the list.
+  void ClearSparseDiff();
+
   bool ShapeEquals(const BlobProto& other);
 
  protected:
@@ -334,6 +352,7 @@ class Blob {
   vector<int> shape_;
   size_t count_;
   size_t capacity_;
+  shared_ptr<vector<int> > diff_rows_;
 
   DISABLE_COPY_AND_ASSIGN(Blob);
 };  // class Blob
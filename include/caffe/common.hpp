@@ -204,6 +204,14 @@ class Caffe {
   inline static int iter_size() { return Get().iter_size_; }
   inline static void set_iter_size(int val) { Get().iter_size_ = val; }
 
+  // Whether the layers being set up may leave their parameters unfilled,
+  // because trained weights are copied over them right after. A Net built
+  // this way fills the params its first load of weights does not cover.
+  inline static bool skip_param_fill() { return Get().skip_param_fill_; }
+  inline static void set_skip_param_fill(bool val) {
+    Get().skip_param_fill_ = val;
+  }
+
  protected:
 #ifndef CPU_ONLY
   cublasHandle_t cublas_handle_;
@@ -215,6 +223,7 @@ class Caffe {
   int solver_count_;
   bool root_solver_;
   int iter_size_;
+  bool skip_param_fill_;
 
  private:
   // The private constructor to avoid duplicate instantiation.
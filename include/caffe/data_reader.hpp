@@ -46,6 +46,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/common.hpp"
 #include "caffe/internal_thread.hpp"
 #include "caffe/util/blocking_queue.hpp"
+#include "caffe/util/bounded_queue.hpp"
 #include "caffe/util/db.hpp"
 
 namespace caffe {
@@ -63,22 +64,24 @@ class DataReader {
   explicit DataReader(const LayerParameter& param);
   ~DataReader();
 
-  inline BlockingQueue<std::string*>& free() const {
+  inline SPSCQueue<std::string*>& free() const {
     return queue_pair_->free_;
   }
-  inline BlockingQueue<std::string*>& full() const {
+  inline SPSCQueue<std::string*>& full() const {
     return queue_pair_->full_;
   }
 
  protected:
-  // Queue pairs are shared between a body and its readers
+  // Queue pairs are shared between a body and its readers. The body thread
+  // is the only producer of full_ and the layer's prefetch thread the only
+  // consumer, and the other way round for free_.
   class QueuePair {
    public:
     explicit QueuePair(int size);
     ~QueuePair();
 
-    BlockingQueue<std::string*> free_;
-    BlockingQueue<std::string*> full_;
+    SPSCQueue<std::string*> free_;
+    SPSCQueue<std::string*> full_;
 
   DISABLE_COPY_AND_ASSIGN(QueuePair);
   };
@@ -71,11 +71,12 @@ class RandNumbers {
   virtual uint32_t GetNextNumber() = 0;
 };
 
+// Draws crops, mirrors and resizes from a Philox stream, which needs no
+// state beyond its key, unlike the Mersenne twister it replaces.
 class GenRandNumbers: public RandNumbers {
  public:
   void Init() {
-    const unsigned int rng_seed = caffe_rng_rand();
-    rng_.reset(new Caffe::RNG(rng_seed));
+    rng_.reset(new PhiloxStream(caffe_philox()));
   }
 
   void Reset() { rng_.reset(); }
@@ -83,11 +84,10 @@ class GenRandNumbers: public RandNumbers {
 
   virtual uint32_t GetNextNumber() {
     CHECK(rng_);
-    caffe::rng_t* rng = static_cast<caffe::rng_t*>(rng_->generator());
-    return (*rng)();
+    return (*rng_)();
   }
  private:
-  shared_ptr<Caffe::RNG> rng_;
+  shared_ptr<PhiloxStream> rng_;
 };
 
 
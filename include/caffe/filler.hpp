@@ -376,6 +376,21 @@ template <typename Dtype> class GaborFiller : public Filler<Dtype> {
     }
   */
 };
+
+/**
+ * @brief Leaves the Blob as it is, for parameters that trained weights are
+ *        copied over right after set up (see Caffe::skip_param_fill). Net
+ *        runs the real fillers for the params the weights turn out not to
+ *        cover.
+ */
+template <typename Dtype> class SkipFiller : public Filler<Dtype> {
+ public:
+  explicit SkipFiller(const FillerParameter &param) : Filler<Dtype>(param) {}
+  virtual void Fill(Blob<Dtype> *blob) {
+    CHECK(blob->count());
+  }
+};
+
 /**
  * @brief Get a specific filler from the specification given in FillerParameter.
  *
@@ -385,7 +400,9 @@ template <typename Dtype> class GaborFiller : public Filler<Dtype> {
 template <typename Dtype>
 Filler<Dtype> *GetFiller(const FillerParameter &param) {
   const std::string &type = param.type();
-  if (type == "constant") {
+  if (Caffe::skip_param_fill()) {
+    return new SkipFiller<Dtype>(param);
+  } else if (type == "constant") {
     return new ConstantFiller<Dtype>(param);
   } else if (type == "gaussian") {
     return new GaussianFiller<Dtype>(param);
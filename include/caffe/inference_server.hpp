@@ -0,0 +1,187 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_INFERENCE_SERVER_HPP_
+#define CAFFE_INFERENCE_SERVER_HPP_
+
+#include <boost/thread.hpp>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "caffe/common.hpp"
+#include "caffe/net.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+namespace caffe {
+
+/**
+ * @brief One sample submitted to an InferenceServer, and its result.
+ *
+ * The input holds a single sample laid out like one item of the net's input
+ * blob. Once Wait returns, outputs holds the item of every net output blob
+ * that belongs to the sample, in the order of Net::output_blobs.
+ */
+template <typename Dtype>
+class InferenceRequest {
+ public:
+  explicit InferenceRequest(const vector<Dtype>& input)
+      : input_(input), done_(false), queue_depth_(0), batch_size_(0),
+        queue_ms_(0), latency_ms_(0) {}
+
+  /// @brief Blocks until a worker has run the sample.
+  void Wait();
+  bool done();
+
+  const vector<Dtype>& input() const { return input_; }
+  const vector<vector<Dtype> >& outputs() const { return outputs_; }
+  /// @brief Requests queued ahead of this one when it was submitted.
+  int queue_depth() const { return queue_depth_; }
+  /// @brief Number of requests run in the same forward pass.
+  int batch_size() const { return batch_size_; }
+  /// @brief Time from submission until a worker took the request.
+  double queue_ms() const { return queue_ms_; }
+  /// @brief Time from submission until the outputs were ready.
+  double latency_ms() const { return latency_ms_; }
+
+ private:
+  template <typename T> friend class InferenceServer;
+
+  vector<Dtype> input_;
+  vector<vector<Dtype> > outputs_;
+  boost::system_time submitted_;
+  boost::mutex mutex_;
+  boost::condition_variable cond_;
+  bool done_;
+  int queue_depth_;
+  int batch_size_;
+  double queue_ms_;
+  double latency_ms_;
+
+  DISABLE_COPY_AND_ASSIGN(InferenceRequest);
+};
+
+/// @brief Counters of an InferenceServer since it started.
+struct InferenceServerStats {
+  long requests;           // NOLINT(runtime/int)
+  long batches;            // NOLINT(runtime/int)
+  long padded_samples;     // NOLINT(runtime/int)
+  int max_queue_depth;
+  double mean_batch_size;
+  double mean_latency_ms;
+  double p50_latency_ms;
+  double p99_latency_ms;
+};
+
+/**
+ * @brief Serves single-sample requests with a pool of nets that share their
+ *        weights, batching the requests dynamically.
+ *
+ * Every worker owns a Net built from the same NetParameter; all but the
+ * first share the trained layers of the first one. The net must take a
+ * single input blob whose first axis is the batch. A worker takes the
+ * oldest queued request and waits for more to arrive while the oldest can
+ * still meet the latency budget, given the time the last forward pass of
+ * that batch size took, or until max_batch_size requests are queued. The
+ * batch is padded up to the next of the batch size buckets, so that the
+ * nets only ever see a few shapes and reshape without reallocating.
+ */
+template <typename Dtype>
+class InferenceServer {
+ public:
+  struct Options {
+    Options() : num_workers(1), max_batch_size(8), latency_budget_ms(10) {}
+    int num_workers;
+    int max_batch_size;
+    double latency_budget_ms;
+    /// Batch sizes the nets run at. Defaults to powers of two up to
+    /// max_batch_size, which is always added.
+    vector<int> batch_buckets;
+  };
+
+  /**
+   * @param param the net, which is built in the TEST phase.
+   * @param weights trained weights copied into the nets, if not empty.
+   */
+  InferenceServer(const NetParameter& param, const string& weights,
+                  const Options& options);
+  /// @brief Serves the queued requests, then stops the workers.
+  ~InferenceServer();
+
+  /// @brief Queues a sample; the request completes asynchronously.
+  shared_ptr<InferenceRequest<Dtype> > Submit(const vector<Dtype>& input);
+
+  InferenceServerStats stats();
+  /// @brief Number of values in a sample.
+  int sample_size() const { return sample_size_; }
+  const vector<int>& batch_buckets() const { return options_.batch_buckets; }
+  Net<Dtype>* net(int worker) { return nets_[worker].get(); }
+
+ private:
+  void WorkerEntry(int worker);
+  // Takes the next batch off the queue, or returns false once stopped and
+  // the queue is empty.
+  bool NextBatch(vector<shared_ptr<InferenceRequest<Dtype> > >* batch);
+  void Run(Net<Dtype>* net,
+           const vector<shared_ptr<InferenceRequest<Dtype> > >& batch);
+  int Bucket(int batch_size) const;
+
+  Options options_;
+  vector<int> sample_shape_;
+  int sample_size_;
+  vector<shared_ptr<Net<Dtype> > > nets_;
+  vector<shared_ptr<boost::thread> > workers_;
+  Caffe::Brew mode_;
+  int device_;
+
+  boost::mutex mutex_;
+  boost::condition_variable queue_cond_;
+  std::deque<shared_ptr<InferenceRequest<Dtype> > > queue_;
+  bool stop_;
+  // Last forward time of each bucket, in milliseconds.
+  std::map<int, double> forward_ms_;
+  InferenceServerStats stats_;
+  vector<double> latencies_;
+
+  DISABLE_COPY_AND_ASSIGN(InferenceServer);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_INFERENCE_SERVER_HPP_
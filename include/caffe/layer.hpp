@@ -120,9 +120,11 @@ class Layer {
    * layer.
    */
   explicit Layer(const LayerParameter& param)
-    : layer_param_(param), is_shared_(false) {
+    : layer_param_(param), is_shared_(false),
+      num_threads_(param.num_threads()) {
       // Set phase and copy blobs (if there are any).
       phase_ = param.phase();
+      reshaped_phase_ = phase_;
       // LOG(ERROR) << "layer " << layer_param_.name() << " construction with blobs size: " << layer_param_.blobs_size();
       if (layer_param_.blobs_size() > 0) {
         blobs_.resize(layer_param_.blobs_size());
@@ -215,6 +217,36 @@ class Layer {
   virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) = 0;
 
+  /**
+   * @brief Calls Reshape unless the bottom and top blobs still have the
+   *        shapes they had when it last returned.
+   *
+   * Forward and Net::Reshape go through this, so a net fed inputs of an
+   * unchanged shape does not redo the shape logic of every layer. A change
+   * of phase also calls Reshape.
+   */
+  void ReshapeIfChanged(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+  /**
+   * @brief Returns true if Reshape depends only on the shapes of the bottom
+   *        and top blobs, so that ReshapeIfChanged may skip it.
+   *
+   * Layers that size their tops from the bottom data return false.
+   */
+  virtual inline bool ReshapeDependsOnShapesOnly() const { return true; }
+
+  /**
+   * @brief Returns the number of OpenMP threads Forward and Backward run on,
+   *        0 meaning all of them.
+   *
+   * Taken from LayerParameter num_threads, or else chosen by
+   * ReshapeIfChanged from the size of the blobs of a layer without
+   * learnable parameters, so that small layers don't pay for waking up
+   * and joining the whole team.
+   */
+  inline int num_threads() const { return num_threads_; }
+
   /**
    * @brief Given the bottom blobs, compute the top blobs and the loss.
    *
@@ -529,12 +561,24 @@ class Layer {
   /** The mutex for sequential forward if this layer is shared */
   shared_ptr<boost::mutex> forward_mutex_;
 
+  /** The bottom then top shapes and the phase left by the last
+   *  ReshapeIfChanged */
+  vector<vector<int> > reshaped_shapes_;
+  Phase reshaped_phase_;
+
+  /** See num_threads() */
+  int num_threads_;
+
   /** Initialize forward_mutex_ */
   void InitMutex();
   /** Lock forward_mutex_ if this layer is shared */
   void Lock();
   /** Unlock forward_mutex_ if this layer is shared */
   void Unlock();
+  /** Limit the OpenMP threads of the caller to num_threads_ and return the
+   *  limit RestoreThreads puts back */
+  int LimitThreads();
+  void RestoreThreads(int num_threads);
 
   DISABLE_COPY_AND_ASSIGN(Layer);
 };  // class Layer
@@ -548,7 +592,8 @@ inline Dtype Layer<Dtype>::Forward(const vector<Blob<Dtype>*>& bottom,
   // Lock during forward to ensure sequential forward
   Lock();
   Dtype loss = 0;
-  Reshape(bottom, top);
+  ReshapeIfChanged(bottom, top);
+  const int num_threads = LimitThreads();
   switch (Caffe::mode()) {
   case Caffe::CPU:
     Forward_cpu(bottom, top);
@@ -582,6 +627,7 @@ inline Dtype Layer<Dtype>::Forward(const vector<Blob<Dtype>*>& bottom,
   default:
     LOG(FATAL) << "Unknown caffe mode.";
   }
+  RestoreThreads(num_threads);
   Unlock();
   return loss;
 }
@@ -590,6 +636,7 @@ template <typename Dtype>
 inline void Layer<Dtype>::Backward(const vector<Blob<Dtype>*>& top,
     const vector<bool>& propagate_down,
     const vector<Blob<Dtype>*>& bottom) {
+  const int num_threads = LimitThreads();
   switch (Caffe::mode()) {
   case Caffe::CPU:
     Backward_cpu(top, propagate_down, bottom);
@@ -600,6 +647,7 @@ inline void Layer<Dtype>::Backward(const vector<Blob<Dtype>*>& top,
   default:
     LOG(FATAL) << "Unknown caffe mode.";
   }
+  RestoreThreads(num_threads);
 }
 
 // Serialize LayerParameter to protocol buffer
@@ -0,0 +1,98 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_AUTOTUNED_CONV_LAYER_HPP_
+#define CAFFE_AUTOTUNED_CONV_LAYER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/winograd_conv_layer.hpp"
+#include "caffe/util/autotune_cache.hpp"
+
+namespace caffe {
+
+/**
+ * @brief A CAFFE engine convolution that picks its CPU forward
+ *        implementation by timing the candidates on the first Reshape of
+ *        each input shape.
+ *
+ * The candidates are im2col + GEMM ("GEMM"), the MKL-DNN 3D path when the
+ * channel counts allow it ("DIRECT"), and Winograd F(2, 3) and, for 2D,
+ * F(4, 3) when the layer is eligible ("WINOGRAD2", "WINOGRAD4"). The winner
+ * is recorded in convolution_param.autotune_cache under a key made of the
+ * layer geometry, input shape, data type, thread count and CPU model, so
+ * later runs skip the timing. Selected by the factory for CAFFE engine
+ * layers with convolution_param.autotune set.
+ */
+template <typename Dtype>
+class AutotunedConvolutionLayer : public WinogradConvolutionLayer<Dtype> {
+ public:
+  explicit AutotunedConvolutionLayer(const LayerParameter& param)
+      : WinogradConvolutionLayer<Dtype>(param) {}
+  virtual void LayerSetUp(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+  /// @brief The implementation Forward_cpu currently runs.
+  inline const string& choice() const { return choice_; }
+  /// @brief The cache key of the current input shape.
+  inline const string& tuning_key() const { return key_; }
+
+ protected:
+  string TuningKey(const vector<Blob<Dtype>*>& bottom) const;
+  vector<string> Candidates() const;
+  string Tune(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  void Apply(const string& choice, const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+  shared_ptr<AutotuneCache> cache_;
+  // What ConvolutionLayer chose for the MKL-DNN 3D path, 0 if unavailable.
+  int direct_type_;
+  string key_;
+  string choice_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_AUTOTUNED_CONV_LAYER_HPP_
@@ -80,6 +80,11 @@ class BaseConvolutionLayer : public Layer<Dtype> {
   void forward_cpu_gemm(const Dtype* input, const Dtype* weights,
       Dtype* output, bool skip_im2col = false);
   void forward_cpu_bias(Dtype* output, const Dtype* bias);
+  // Integer variant for quantized 3D inference: u8 input, s8 weights and an
+  // s32 output of conv_out_channels_ x conv_out_spatial_dim_. Uses
+  // col_buffer_u8_mt_, which the caller sizes to col_buffer_mt_size.
+  void forward_cpu_gemm_s8(const uint8_t* input, const int8_t* weights,
+      int32_t* output);
   void backward_cpu_gemm(const Dtype* input, const Dtype* weights,
       Dtype* output);
   void weight_cpu_gemm(const Dtype* input, const Dtype* output, Dtype*
@@ -152,6 +157,7 @@ class BaseConvolutionLayer : public Layer<Dtype> {
   size_t weight_diff_mt_size;  // openmp
   std::vector<Dtype> col_buffer_mt_;   //  openmp
   std::vector<Dtype> weight_diff_mt_;  // openmp
+  std::vector<uint8_t> col_buffer_u8_mt_;  // openmp, quantized path
 
  private:
   // wrap im2col/col2im so we don't have to remember the (long) argument lists
@@ -45,7 +45,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/internal_thread.hpp"
 #include "caffe/layer.hpp"
 #include "caffe/proto/caffe.pb.h"
-#include "caffe/util/blocking_queue.hpp"
+#include "caffe/util/bounded_queue.hpp"
 
 namespace caffe {
 
@@ -104,8 +104,9 @@ class BasePrefetchingDataLayer :
   virtual void Forward_gpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top);
 
-  // Prefetches batches (asynchronously if to GPU memory)
-  static const int PREFETCH_COUNT = 3;
+  // Number of batches prefetched (asynchronously if to GPU memory), taken
+  // from data_param.prefetch so deep pipelines can absorb I/O jitter.
+  int prefetch_count() const { return prefetch_.size(); }
 
  protected:
   virtual void InternalThreadEntry();
@@ -113,9 +114,14 @@ class BasePrefetchingDataLayer :
 
   virtual void GetBatch();
 
-  Batch<Dtype> prefetch_[PREFETCH_COUNT];
-  BlockingQueue<Batch<Dtype>*> prefetch_free_;
-  BlockingQueue<Batch<Dtype>*> prefetch_full_;
+  vector<shared_ptr<Batch<Dtype> > > prefetch_;
+  // Multi-producer/multi-consumer: in CPU mode Forward fills batches itself
+  // next to the prefetch thread, and the layer may be shared across solvers.
+  MPMCQueue<Batch<Dtype>*> prefetch_free_;
+  MPMCQueue<Batch<Dtype>*> prefetch_full_;
+  // The batch whose buffers the top blobs currently point to; it is handed
+  // back to prefetch_free_ on the next Forward instead of being copied.
+  Batch<Dtype>* prefetch_current_;
 
   Blob<Dtype> transformed_data_;
 };
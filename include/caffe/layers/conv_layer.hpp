@@ -45,6 +45,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/proto/caffe.pb.h"
 
 #include "caffe/layers/base_conv_layer.hpp"
+#include "caffe/util/pointwise_chain.hpp"
 #include "mkldnn.hpp"
 
 using namespace mkldnn;
@@ -122,7 +123,7 @@ class ConvolutionLayer : public BaseConvolutionLayer<Dtype> {
   virtual inline bool reverse_dimensions() { return false; }
   virtual void compute_output_shape();
 
- private:
+ protected:
   engine* cpu_engine;
   vector<primitive> pipeline_fwd;
   vector<primitive> pipeline_bwd_data;
@@ -166,6 +167,24 @@ class ConvolutionLayer : public BaseConvolutionLayer<Dtype> {
   vector<primitive> sums_bwds_wgts;
   vector<primitive> sums_bwds_bias;
 
+  // Pointwise ops fused into the output by Net::CompileNet, if any
+  PointwiseChain<Dtype> epilogue_;
+
+  // Integer 3D path, taken in TEST phase when quantization_param is given.
+  // Activations between layers stay in Dtype; only the GEMM runs in int8.
+  bool quantize_3d_;
+  float scale_in_;
+  vector<float> scale_params_;
+  vector<float> dequant_scale_;
+  vector<int8_t> weight_s8_;
+  vector<uint8_t> input_u8_;
+  vector<int32_t> output_s32_;
+  // The weights weight_s8_ was quantized from, and their version then
+  const SyncedMemory* quantized_weight_mem_;
+  unsigned long quantized_weight_version_;
+  void QuantizeWeights();
+  void Forward_3D_int8(const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top);
+
   int useAVX_t;
   int checkAVX();
   bool srcsync;
@@ -40,6 +40,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <vector>
 
+#ifdef USE_OPENCV
+#include <opencv2/core/core.hpp>
+#endif
+
 #include "caffe/blob.hpp"
 #include "caffe/data_reader.hpp"
 #include "caffe/data_transformer.hpp"
@@ -51,6 +55,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace caffe {
 
+class DecodedImageCache;
+
 template <typename Dtype>
 class DataLayer : public BasePrefetchingDataLayer<Dtype> {
  public:
@@ -67,8 +73,14 @@ class DataLayer : public BasePrefetchingDataLayer<Dtype> {
 
  protected:
   virtual void load_batch(Batch<Dtype>* batch);
+#ifdef USE_OPENCV
+  // Decodes an encoded datum like DataTransformer does, through the decoded
+  // cache.
+  cv::Mat DecodeDatum(const Datum& datum);
+#endif
 
   DataReader reader_;
+  shared_ptr<DecodedImageCache> decoded_cache_;
 };
 
 }  // namespace caffe
@@ -81,6 +81,12 @@ class DeconvolutionLayer : public BaseConvolutionLayer<Dtype> {
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
   virtual inline bool reverse_dimensions() { return true; }
   virtual void compute_output_shape();
+
+  /// @brief Whether Forward_cpu takes the direct sub-pixel path.
+  bool use_subpixel();
+  /// @brief Direct strided deconvolution of a whole batch, without col2im.
+  void forward_cpu_subpixel(const Dtype* bottom_data, const Dtype* weight,
+      const Dtype* bias, Dtype* top_data);
 };
 
 }  // namespace caffe
@@ -68,6 +68,8 @@ class DetectionEvaluateLayer : public Layer<Dtype> {
   virtual inline const char* type() const { return "DetectionEvaluate"; }
   virtual inline int ExactBottomBlobs() const { return 2; }
   virtual inline int ExactNumTopBlobs() const { return 1; }
+  // The top shapes depend on the bottom data.
+  virtual inline bool ReshapeDependsOnShapesOnly() const { return false; }
 
  protected:
   /**
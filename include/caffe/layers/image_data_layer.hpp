@@ -42,6 +42,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <utility>
 #include <vector>
 
+#ifdef USE_OPENCV
+#include <opencv2/core/core.hpp>
+#endif
+
 #include "caffe/blob.hpp"
 #include "caffe/data_transformer.hpp"
 #include "caffe/internal_thread.hpp"
@@ -51,6 +55,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace caffe {
 
+class DecodedImageCache;
+
 /**
  * @brief Provides data to the Net from image files.
  *
@@ -73,9 +79,14 @@ class ImageDataLayer : public BasePrefetchingDataLayer<Dtype> {
   shared_ptr<Caffe::RNG> prefetch_rng_;
   virtual void ShuffleImages();
   virtual void load_batch(Batch<Dtype>* batch);
+#ifdef USE_OPENCV
+  // Reads and resizes an image of lines_, through the decoded cache if any.
+  cv::Mat ReadImage(const string& filename);
+#endif
 
   vector<std::pair<std::string, int> > lines_;
   int lines_id_;
+  shared_ptr<DecodedImageCache> decoded_cache_;
 };
 
 
@@ -43,6 +43,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/blob.hpp"
 #include "caffe/layer.hpp"
 #include "caffe/proto/caffe.pb.h"
+#include "caffe/util/pointwise_chain.hpp"
 
 namespace caffe {
 
@@ -82,6 +83,8 @@ class InnerProductLayer : public Layer<Dtype> {
   bool bias_term_;
   Blob<Dtype> bias_multiplier_;
   bool transpose_;  ///< if true, assume transposed weights
+  /// Pointwise ops fused into the output by Net::CompileNet, if any
+  PointwiseChain<Dtype> epilogue_;
 };
 
 }  // namespace caffe
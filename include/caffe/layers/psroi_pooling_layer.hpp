@@ -69,6 +69,9 @@ class PSROIPoolingLayer : public Layer<Dtype> {
   int pooled_height_;
   int pooled_width_;
   Blob<int> mapping_channel_;
+  // Per-ROI [start, end) bin boundaries along h and w, computed in forward
+  // and reused by backward.
+  Blob<int> roi_bins_;
 };
 
 }  // namespace caffe
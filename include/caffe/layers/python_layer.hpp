@@ -70,6 +70,8 @@ class PythonLayer : public Layer<Dtype> {
       const vector<Blob<Dtype>*>& top) {
     self_.attr("reshape")(bottom, top);
   }
+  // A Python reshape may look at anything, so it is always called.
+  virtual inline bool ReshapeDependsOnShapesOnly() const { return false; }
 
   virtual inline bool ShareInParallel() const {
     return this->layer_param_.python_param().share_in_parallel();
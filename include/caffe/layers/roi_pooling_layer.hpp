@@ -82,6 +82,9 @@ class ROIPoolingLayer : public Layer<Dtype> {
   int pooled_w_;
   Dtype spatial_scale_;
   Blob<int> max_idx_;
+  // Per-ROI [start, end) bin boundaries along d, h and w, computed once per
+  // forward pass and shared by all channels of the ROI.
+  Blob<int> roi_bins_;
 };
 
 }  // namespace caffe
@@ -38,10 +38,16 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef CAFFE_WINDOW_DATA_LAYER_HPP_
 #define CAFFE_WINDOW_DATA_LAYER_HPP_
 
+#include <list>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
 
+#ifdef USE_OPENCV
+#include <opencv2/core/core.hpp>
+#endif
+
 #include "caffe/blob.hpp"
 #include "caffe/data_transformer.hpp"
 #include "caffe/internal_thread.hpp"
@@ -73,6 +79,18 @@ class WindowDataLayer : public BasePrefetchingDataLayer<Dtype> {
  protected:
   virtual unsigned int PrefetchRand();
   virtual void load_batch(Batch<Dtype>* batch);
+#ifdef USE_OPENCV
+  // Reads and decodes image image_index of image_database_.
+  cv::Mat DecodeImage(int image_index);
+  // Crops the window out of cv_img, warps it to crop_size x crop_size and
+  // stores it, mean-subtracted and scaled, as item item_id of top_data.
+  void WarpWindow(const cv::Mat& cv_img, const vector<float>& window,
+      bool do_mirror, int item_id, Dtype* top_data);
+  // Returns the cached decoded image for path and marks it most recently
+  // used, or an empty Mat.
+  cv::Mat FindDecodedImage(const string& path);
+  void CacheDecodedImage(const string& path, const cv::Mat& cv_img);
+#endif
 
   shared_ptr<Caffe::RNG> prefetch_rng_;
   vector<std::pair<std::string, vector<int> > > image_database_;
@@ -85,6 +103,13 @@ class WindowDataLayer : public BasePrefetchingDataLayer<Dtype> {
   bool has_mean_values_;
   bool cache_images_;
   vector<std::pair<std::string, Datum > > image_database_cache_;
+#ifdef USE_OPENCV
+  // LRU cache of decoded images, most recently used first. Only touched by
+  // the prefetch thread.
+  typedef std::list<std::pair<string, cv::Mat> > DecodedImageList;
+  DecodedImageList decoded_images_;
+  std::map<string, typename DecodedImageList::iterator> decoded_image_index_;
+#endif
 };
 
 }  // namespace caffe
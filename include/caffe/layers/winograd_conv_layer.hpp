@@ -0,0 +1,119 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_WINOGRAD_CONV_LAYER_HPP_
+#define CAFFE_WINOGRAD_CONV_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/conv_layer.hpp"
+
+namespace caffe {
+
+/**
+ * @brief Runs the CPU forward pass of 3x3 (2D) and 3x3x3 (3D), stride 1,
+ *        ungrouped convolutions with Winograd minimal filtering,
+ *        F(2, 3) or F(4, 3) along every spatial axis.
+ *
+ * Each output tile is computed from a transformed input tile and the
+ * transformed filters with one GEMM per tile element, using 2.25x (F(2x2))
+ * to 4x (F(4x4)) fewer multiplies than im2col + GEMM. The filter transform
+ * is cached and redone only when the weights are written, e.g. by
+ * Blob::Update. Backward and the GPU path are ConvolutionLayer's.
+ *
+ * Selected by engine WINOGRAD, or by the DEFAULT engine for eligible layers
+ * with auto_winograd set; in that case the layer only switches to F(2, 3)
+ * when there are enough channels for it to pay off and otherwise behaves as
+ * ConvolutionLayer.
+ */
+template <typename Dtype>
+class WinogradConvolutionLayer : public ConvolutionLayer<Dtype> {
+ public:
+  explicit WinogradConvolutionLayer(const LayerParameter& param)
+      : ConvolutionLayer<Dtype>(param) {}
+  virtual void LayerSetUp(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+  /// @brief Whether the kernel, stride, dilation and group settings allow
+  ///        Winograd for any number of spatial axes the layer may get.
+  static bool IsEligible(const ConvolutionParameter& conv_param);
+  /// @brief Whether Forward_cpu currently takes the Winograd path.
+  inline bool use_winograd() const { return use_winograd_; }
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+  // Switches to F(tile, 3) on every spatial axis and drops the cached
+  // filter transform. ComputeNumTiles must follow once the output shape is
+  // known.
+  void SetTile(int tile);
+  void ComputeNumTiles();
+  void TransformWeights();
+  void ForwardWinograd(const Dtype* bottom_data, const Dtype* bias,
+      Dtype* top_data);
+
+  // Whether engine WINOGRAD was asked for, and whether the layer's kernel,
+  // stride, dilation and group allow it at all.
+  bool forced_;
+  bool eligible_;
+  bool use_winograd_;
+  // Per spatial axis (2D uses a singleton depth axis): output tile size,
+  // input tile size, number of tiles, and the input, filter and output
+  // transform matrices.
+  int tile_out_[3];
+  int tile_in_[3];
+  int num_tiles_[3];
+  vector<Dtype> input_transform_[3];
+  vector<Dtype> filter_transform_[3];
+  vector<Dtype> output_transform_[3];
+  // Filters in the Winograd domain, tile element x output x input channel,
+  // and the weight storage and version they were computed from.
+  vector<Dtype> transformed_weight_;
+  const SyncedMemory* weight_mem_;
+  unsigned long weight_version_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_WINOGRAD_CONV_LAYER_HPP_
@@ -50,6 +50,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/proto/caffe.pb.h"
 
 #include "caffe/util/benchmark.hpp"
+#include "caffe/util/half_math.hpp"
 
 
 namespace caffe {
@@ -150,6 +151,12 @@ class Net {
    *        additional memory) the pre-trained layers from another Net.
    */
   void ShareTrainedLayersWith(const Net* other);
+  /**
+   * @brief Like ShareTrainedLayersWith, but gives this net a private copy of
+   *        the weights, so that it can keep running while the other net
+   *        updates them.
+   */
+  void CopyTrainedLayersFrom(const Net* other);
   // For an already initialized net, CopyTrainedLayersFrom() copies the already
   // trained layers from another net parameter instance.
   /**
@@ -224,6 +231,14 @@ class Net {
   inline const vector<bool>& layer_need_backward() const {
     return layer_need_backward_;
   }
+  /**
+   * @brief Returns, per layer, the number of layout conversions between
+   *        private (e.g. MKL-DNN blocked) and plain memory its last Forward
+   *        caused.
+   */
+  inline const vector<uint64_t>& layer_forward_conversions() const {
+    return layer_forward_conversions_;
+  }
   /// @brief returns the parameters
   inline const vector<shared_ptr<Blob<Dtype> > >& params() const {
     return params_;
@@ -289,6 +304,10 @@ class Net {
   /**
    * @brief Remove or Replace layers that the user specified should be excluded to increase
    *        computational performance.
+   *
+   * Bump the format tag of kCompiledNetBuild in net.cpp when a change to it
+   * or to one of its rules changes the compiled net, so that nets cached
+   * before are not reused.
    */
   static void CompileNet(const NetParameter& param,
     NetParameter* param_compiled);
@@ -325,6 +344,15 @@ class Net {
   static void CompilationRuleConvSumFusion(const NetParameter& param,
                              NetParameter* param_compiled);
 
+  /**
+  * @brief This is rule that merges chains of pointwise layers (ReLU, Power, Sigmoid,
+  *        Swish, Scale, Bias, Eltwise) of the CAFFE engine into one FusedPointwise layer,
+  *        or into the preceding Convolution/InnerProduct as an epilogue (parameter-free
+  *        ops only). Inference (TEST phase) on CPU only.
+  */
+  static void CompilationRulePointwiseFusion(const NetParameter& param,
+                             NetParameter* param_compiled);
+
    /**
   * @brief This is rule analyze for general sparse.
   */
@@ -430,6 +458,35 @@ class Net {
   /// @brief Append a new parameter blob to the net.
   void AppendParam(const NetParameter& param, const int layer_id,
                    const int param_id);
+  /**
+   * @brief Run FilterNet, InsertSplits, CompileNet and the batch size
+   *        adjustment of BN statistics on in_param. Sets engine_name_, and
+   *        uncompiled_param_ when BatchNorm/Scale get folded.
+   *
+   * Init skips this when CAFFE_COMPILED_NET_CACHE names a directory holding
+   * the result for in_param from an earlier run.
+   */
+  void CompileNetParameter(const NetParameter& in_param,
+                           NetParameter* param_compiled);
+
+  /**
+   * @brief Plan NetParameter.activation_storage: a blob is stored in 16 bits
+   *        after a layer using it if the next layer using it comes later
+   *        than right after, or if there is none and the net trains.
+   */
+  void InitHalfStorage(const NetParameter& param);
+
+  /**
+   * @brief Run the fillers of the params that no load since Init has
+   *        written, when the net was built with Caffe::skip_param_fill().
+   *        Called at the end of every load of trained weights.
+   */
+  void FillUnloadedParams();
+  inline void MarkParamLoaded(const int layer_id, const int blob_id) {
+    if (!unloaded_params_.empty()) {
+      unloaded_params_[layer_id][blob_id] = false;
+    }
+  }
 
   /// @brief Helper for displaying debug info in Forward.
   void ForwardDebugInfo(const int layer_id);
@@ -440,6 +497,9 @@ class Net {
   bool bn_scale_remove_;
   bool bn_scale_merge_;
   vector<string> kept_bn_layers_;
+  /// @brief Topology before CompileNet, kept (without blobs) only when
+  /// BatchNorm/Scale were folded, so that HDF5 weights can be folded on load.
+  NetParameter uncompiled_param_;
   /// @brief The network name
   string name_;
   /// @brief The engine name
@@ -451,6 +511,11 @@ class Net {
   vector<string> layer_names_;
   map<string, int> layer_names_index_;
   vector<bool> layer_need_backward_;
+  /// @brief see layer_forward_conversions()
+  vector<uint64_t> layer_forward_conversions_;
+  /// @brief the blobs stored as half_format_ after the forward of each layer
+  vector<vector<int> > half_storage_blob_ids_;
+  HalfFormat half_format_;
   /// @brief the blobs storing intermediate results between the layer.
   vector<shared_ptr<Blob<Dtype> > > blobs_;
   vector<string> blob_names_;
@@ -472,6 +537,9 @@ class Net {
   vector<int> param_owners_;
   vector<string> param_display_names_;
   vector<pair<int, int> > param_layer_indices_;
+  /// @brief The layer blobs whose fillers Init skipped and that no load has
+  /// written since, indexed like layers_[i]->blobs(); empty if none.
+  vector<vector<bool> > unloaded_params_;
   map<string, int> param_names_index_;
   /// blob indices for the input and the output of the net
   vector<int> net_input_blob_indices_;
@@ -45,6 +45,21 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace caffe {
 
+/**
+ * @brief The gradient of one element after Normalize and Regularize, as
+ *        computed inside the fused CPU updates.
+ */
+template <typename Dtype>
+struct RegularizedGradient {
+  Dtype scale;  // 1 / iter_size
+  Dtype decay;  // local weight decay
+  bool l1;
+  inline Dtype operator()(Dtype w, Dtype g) const {
+    return scale * g +
+        decay * (l1 ? Dtype((Dtype(0) < w) - (w < Dtype(0))) : w);
+  }
+};
+
 /**
  * @brief Optimizes the parameters of a Net using
  *        stochastic gradient descent (SGD) with momentum.
@@ -73,6 +88,33 @@ class SGDSolver : public Solver<Dtype> {
   virtual void Regularize(int param_id);
   virtual void ComputeUpdateValue(int param_id, Dtype rate);
   virtual void ClipGradients();
+  // Row-sparse updates of parameters whose diff tracks the touched rows
+  // (see Blob::diff_rows()); untouched rows keep their history unchanged.
+  virtual inline bool SupportsSparseUpdate() const {
+    return this->type() == string("SGD");
+  }
+  bool UseSparseUpdate(int param_id);
+  // Single-pass CPU updates (SolverParameter.fused_update). FusedUpdate runs
+  // Normalize, Regularize, ComputeUpdateValue and Blob::Update for elements
+  // [begin, end) of a parameter, leaving the update value in the diff; the
+  // pointers are taken before the parallel region.
+  struct FusedState {
+    Dtype* data;
+    Dtype* diff;
+    Dtype* history;
+    // The second history entry of Adam and AdaDelta, NULL otherwise.
+    Dtype* history2;
+  };
+  virtual inline bool SupportsFusedUpdate() const {
+    return this->type() == string("SGD") && !this->param_.local_lr_auto();
+  }
+  bool UseFusedUpdate(int param_id);
+  void ApplyFusedUpdates(const vector<int>& param_ids, Dtype rate);
+  RegularizedGradient<Dtype> GetRegularizedGradient(int param_id) const;
+  virtual void FusedUpdate(const FusedState& state, int param_id, Dtype rate,
+      int begin, int end);
+  void SparseNormalizeRegularize(int param_id);
+  virtual void ComputeSparseUpdateValue(int param_id, Dtype rate);
   virtual void SnapshotSolverState(const string& model_filename);
   virtual void SnapshotSolverStateToBinaryProto(const string& model_filename);
   virtual void SnapshotSolverStateToHDF5(const string& model_filename);
@@ -107,6 +149,9 @@ class NesterovSolver : public SGDSolver<Dtype> {
 
  protected:
   virtual void ComputeUpdateValue(int param_id, Dtype rate);
+  virtual inline bool SupportsFusedUpdate() const { return true; }
+  virtual void FusedUpdate(const typename SGDSolver<Dtype>::FusedState& state,
+      int param_id, Dtype rate, int begin, int end);
 
   DISABLE_COPY_AND_ASSIGN(NesterovSolver);
 };
@@ -122,6 +167,9 @@ class AdaGradSolver : public SGDSolver<Dtype> {
 
  protected:
   virtual void ComputeUpdateValue(int param_id, Dtype rate);
+  virtual inline bool SupportsFusedUpdate() const { return true; }
+  virtual void FusedUpdate(const typename SGDSolver<Dtype>::FusedState& state,
+      int param_id, Dtype rate, int begin, int end);
   void constructor_sanity_check() {
     CHECK_EQ(0, this->param_.momentum())
         << "Momentum cannot be used with AdaGrad.";
@@ -142,6 +190,9 @@ class RMSPropSolver : public SGDSolver<Dtype> {
 
  protected:
   virtual void ComputeUpdateValue(int param_id, Dtype rate);
+  virtual inline bool SupportsFusedUpdate() const { return true; }
+  virtual void FusedUpdate(const typename SGDSolver<Dtype>::FusedState& state,
+      int param_id, Dtype rate, int begin, int end);
   void constructor_sanity_check() {
     CHECK_EQ(0, this->param_.momentum())
         << "Momentum cannot be used with RMSProp.";
@@ -166,6 +217,9 @@ class AdaDeltaSolver : public SGDSolver<Dtype> {
  protected:
   void AdaDeltaPreSolve();
   virtual void ComputeUpdateValue(int param_id, Dtype rate);
+  virtual inline bool SupportsFusedUpdate() const { return true; }
+  virtual void FusedUpdate(const typename SGDSolver<Dtype>::FusedState& state,
+      int param_id, Dtype rate, int begin, int end);
 
   DISABLE_COPY_AND_ASSIGN(AdaDeltaSolver);
 };
@@ -190,6 +244,11 @@ class AdamSolver : public SGDSolver<Dtype> {
  protected:
   void AdamPreSolve();
   virtual void ComputeUpdateValue(int param_id, Dtype rate);
+  virtual inline bool SupportsSparseUpdate() const { return true; }
+  virtual void ComputeSparseUpdateValue(int param_id, Dtype rate);
+  virtual inline bool SupportsFusedUpdate() const { return true; }
+  virtual void FusedUpdate(const typename SGDSolver<Dtype>::FusedState& state,
+      int param_id, Dtype rate, int begin, int end);
 
   DISABLE_COPY_AND_ASSIGN(AdamSolver);
 };
@@ -104,7 +104,7 @@ class Solver {
   // RestoreSolverStateFrom___ protected methods. You should implement these
   // methods to restore the state from the appropriate snapshot type.
   void Restore(const char* resume_file);
-  virtual ~Solver() {}
+  virtual ~Solver();
   inline const SolverParameter& param() const { return param_; }
   inline SolverParameter& param() { return param_; }
   inline shared_ptr<Net<Dtype> > net() { return net_; }
@@ -152,6 +152,8 @@ class Solver {
   // Print learning rate to logs
   virtual void PrintLearningRate() = 0;
 
+  // Runs every test net on the current weights. Waits for a pending
+  // asynchronous test pass first.
   void TestAll();
 
  protected:
@@ -162,6 +164,12 @@ class Solver {
   void Test(const int test_net_id = 0);
   void TestClassification(const int test_net_id = 0);
   void TestDetection(const int test_net_id = 0);
+  // Asynchronous testing (test_async): copies the current weights into the
+  // test nets and runs them on a background thread while training goes on.
+  void StartAsyncTest();
+  // Joins a pending asynchronous test pass, interrupting it first if asked,
+  // and gives its cores back to training.
+  void FinishAsyncTest(bool interrupt);
   virtual void SnapshotSolverState(const string& model_filename) = 0;
   virtual void RestoreSolverStateFromHDF5(const string& state_file) = 0;
   virtual void RestoreSolverStateFromBinaryProto(const string& state_file) = 0;
@@ -190,6 +198,13 @@ class Solver {
 
   ForwardBackwardFunc forward_backward_;
 
+  // Iteration whose weights the test nets are evaluating.
+  int test_iter_;
+  // The background test pass, if any. Defined in solver.cpp to keep boost
+  // threads out of this header.
+  class AsyncTest;
+  shared_ptr<AsyncTest> async_test_;
+
   DISABLE_COPY_AND_ASSIGN(Solver);
 };
 
@@ -38,6 +38,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef CAFFE_SYNCEDMEM_HPP_
 #define CAFFE_SYNCEDMEM_HPP_
 
+#include <stdint.h>
 #include <cstdlib>
 
 #ifdef USE_MKL
@@ -47,6 +48,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "boost/thread/mutex.hpp"
 #include "caffe/common.hpp"
+#include "caffe/util/half_math.hpp"
+#include "caffe/util/host_allocator.hpp"
 
 namespace caffe {
 
@@ -55,6 +58,7 @@ namespace caffe {
 // The improvement in performance seems negligible in the single GPU case,
 // but might be more significant for parallel training. Most importantly,
 // it improved stability for large models on many GPUs.
+// Otherwise blocks come from the caching, NUMA-aware HostAllocator.
 inline void CaffeMallocHost(void** ptr, size_t size, bool* use_cuda) {
 #ifndef CPU_ONLY
   if (Caffe::mode() == Caffe::GPU) {
@@ -64,14 +68,8 @@ inline void CaffeMallocHost(void** ptr, size_t size, bool* use_cuda) {
   }
 #endif
 
-#ifdef USE_MKL
-    *ptr = mkl_malloc(size ? size : 1, 64);
-#else
-   *ptr = malloc(size);
-#endif
-
+  *ptr = HostAllocator::Get().Allocate(size);
   *use_cuda = false;
-  CHECK(*ptr) << "host allocation of size " << size << " failed";
 }
 
 inline void CaffeFreeHost(void* ptr, bool use_cuda) {
@@ -82,11 +80,7 @@ inline void CaffeFreeHost(void* ptr, bool use_cuda) {
   }
 #endif
 
-#ifdef USE_MKL
-    mkl_free(ptr);
-#else
-    free(ptr);
-#endif
+  HostAllocator::Get().Free(ptr);
 }
 
 // Base class
@@ -107,6 +101,11 @@ struct PrvMemDescr {
     PRV_DESCR_MKLDNN
   };
   virtual PrvDescrType get_descr_type() = 0;
+
+  // Number of layout conversions (reorders) done so far by all descriptors
+  static uint64_t conversions();
+  // To be called by descriptors for every conversion they execute
+  static void count_conversion();
 };
 
 /**
@@ -118,17 +117,19 @@ struct PrvMemDescr {
 class SyncedMemory {
  public:
   SyncedMemory()
-      : cpu_ptr_(NULL), gpu_ptr_(NULL),
+      : cpu_ptr_(NULL), gpu_ptr_(NULL), half_ptr_(NULL),
         size_(0), head_(UNINITIALIZED), own_cpu_data_(false),
         cpu_malloc_use_cuda_(false), own_gpu_data_(false), own_prv_data_(false),
-        gpu_device_(-1)
+        half_format_(FLOAT16), half_double_(false),
+        gpu_device_(-1), version_(0)
 
         {}
   explicit SyncedMemory(size_t size)
-      : cpu_ptr_(NULL), gpu_ptr_(NULL),
+      : cpu_ptr_(NULL), gpu_ptr_(NULL), half_ptr_(NULL),
         size_(size), head_(UNINITIALIZED), own_cpu_data_(false),
         cpu_malloc_use_cuda_(false), own_gpu_data_(false), own_prv_data_(false),
-        gpu_device_(-1)
+        half_format_(FLOAT16), half_double_(false),
+        gpu_device_(-1), version_(0)
 
         {}
   ~SyncedMemory();
@@ -142,14 +143,26 @@ class SyncedMemory {
 
   const void* cpu_ptr() const { return cpu_ptr_; }
 
+  // Returns to the uninitialized state of a new SyncedMemory of the same
+  // size, but keeps the owned host and device buffers for the next access.
+  void Recycle();
+
   shared_ptr<PrvMemDescr> prv_descriptor_;
   void set_prv_descriptor(shared_ptr<PrvMemDescr> descriptor, bool same_data);
   const void* prv_data();
   void* mutable_prv_data();
+  // Stores the data, Dtype values, in format and gives the pages of the CPU
+  // buffer back to the system until the next access converts them back into
+  // it. Does nothing unless the data is only held in a CPU buffer of its own.
+  template <typename Dtype>
+  void store_half(HalfFormat format);
   enum SyncedHead { UNINITIALIZED, HEAD_AT_CPU, HEAD_AT_GPU, SYNCED,
-                    HEAD_AT_PRV, SYNCED_PRV};
+                    HEAD_AT_PRV, SYNCED_PRV, HEAD_AT_HALF};
   SyncedHead head() { return head_; }
   size_t size() { return size_; }
+  // Bumped on every write access, so state derived from the data (such as
+  // transformed weights) can tell when it is stale.
+  unsigned long version() const { return version_; }
 
 #ifndef CPU_ONLY
   void async_gpu_push(const cudaStream_t& stream);
@@ -160,13 +173,17 @@ class SyncedMemory {
   void to_gpu();
   void* cpu_ptr_;
   void* gpu_ptr_;
+  void* half_ptr_;
   const size_t size_;
   SyncedHead head_;
   bool own_cpu_data_;
   bool cpu_malloc_use_cuda_;
   bool own_gpu_data_;
   bool own_prv_data_;
+  HalfFormat half_format_;
+  bool half_double_;  // whether half_ptr_ holds doubles rather than floats
   int gpu_device_;
+  unsigned long version_;
   boost::mutex mtx;
 
   DISABLE_COPY_AND_ASSIGN(SyncedMemory);
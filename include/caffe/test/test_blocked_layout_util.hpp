@@ -0,0 +1,158 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_TEST_BLOCKED_LAYOUT_UTIL_H_
+#define CAFFE_TEST_BLOCKED_LAYOUT_UTIL_H_
+
+#ifdef MKLDNN_SUPPORTED
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/layers/mkldnn_layers.hpp"
+#include "caffe/mkldnn_memory.hpp"
+
+namespace caffe {
+
+// The blocked layout checker runs a reference layer on bottoms in the plain
+// layout and on the same bottoms in the nChw8c layout an MKL-DNN layer
+// leaves, and checks that both give the same tops, the second ones still in
+// a private layout and without any conversion.
+class BlockedLayoutChecker {
+ public:
+  // Bottoms are filled uniformly from [min, max]
+  explicit BlockedLayoutChecker(float min = -1, float max = 1)
+      : owner_(LayerParameter()) {
+    filler_param_.set_min(min);
+    filler_param_.set_max(max);
+  }
+
+  // Moves the data of blob to the nChw8c layout, on behalf of an MKL-DNN
+  // layer
+  void ToBlocked(Blob<float>* blob) {
+    engine cpu_engine = CpuEngine::Instance().get_engine();
+    memory::dims dims = {blob->shape(0), blob->shape(1), blob->shape(2),
+                         blob->shape(3)};
+    shared_ptr<memory::primitive_desc> usr_memory_pd(
+        new memory::primitive_desc(memory::desc(dims,
+        memory::data_type::f32, memory::format::nchw), cpu_engine));
+    shared_ptr<memory::primitive_desc> prv_memory_pd(
+        new memory::primitive_desc(memory::desc(dims,
+        memory::data_type::f32, memory::format::nChw8c), cpu_engine));
+    shared_ptr<MKLDNNData<float> > descriptor(new MKLDNNData<float>(
+        usr_memory_pd, prv_memory_pd, blob, &owner_));
+    MKLDNNPrimitive<float> memory_primitive(descriptor->get_prv_memory());
+    descriptor->set_mkldnn_primitive(memory_primitive);
+    descriptor->convert_to_prv(blob->mutable_cpu_data());
+    blob->set_prv_data_descriptor(descriptor, false);
+  }
+
+  // Checks two LayerType layers of param with the same parameters, on
+  // bottoms of the given shapes.
+  template <typename LayerType>
+  void CheckForward(const LayerParameter& param,
+                    const vector<vector<int> >& bottom_shapes, int num_tops);
+
+  // Checks a neuron layer on one bottom of 2 x 16 x 3 x 4
+  template <typename LayerType>
+  void CheckForward(const LayerParameter& param) {
+    int shape[] = {2, 16, 3, 4};
+    CheckForward<LayerType>(param, vector<vector<int> >(1,
+        vector<int>(shape, shape + 4)), 1);
+  }
+
+ protected:
+  FillerParameter filler_param_;
+  MKLDNNReLULayer<float> owner_;
+};
+
+template <typename LayerType>
+void BlockedLayoutChecker::CheckForward(const LayerParameter& param,
+    const vector<vector<int> >& bottom_shapes, int num_tops) {
+  vector<shared_ptr<Blob<float> > > blobs;
+  vector<Blob<float>*> plain_bottom, plain_top, blocked_bottom, blocked_top;
+  UniformFiller<float> filler(filler_param_);
+  for (size_t i = 0; i < bottom_shapes.size(); ++i) {
+    blobs.push_back(shared_ptr<Blob<float> >(
+        new Blob<float>(bottom_shapes[i])));
+    filler.Fill(blobs.back().get());
+    plain_bottom.push_back(blobs.back().get());
+    blobs.push_back(shared_ptr<Blob<float> >(new Blob<float>()));
+    blobs.back()->CopyFrom(*plain_bottom.back(), false, true);
+    blocked_bottom.push_back(blobs.back().get());
+  }
+  for (int i = 0; i < num_tops; ++i) {
+    blobs.push_back(shared_ptr<Blob<float> >(new Blob<float>()));
+    plain_top.push_back(blobs.back().get());
+    blobs.push_back(shared_ptr<Blob<float> >(new Blob<float>()));
+    blocked_top.push_back(blobs.back().get());
+  }
+  LayerType plain_layer(param);
+  plain_layer.SetUp(plain_bottom, plain_top);
+  LayerType blocked_layer(param);
+  blocked_layer.SetUp(blocked_bottom, blocked_top);
+  for (size_t i = 0; i < plain_layer.blobs().size(); ++i) {
+    blocked_layer.blobs()[i]->CopyFrom(*plain_layer.blobs()[i]);
+  }
+  for (size_t i = 0; i < blocked_bottom.size(); ++i) {
+    ToBlocked(blocked_bottom[i]);
+  }
+  // Layers drawing random numbers draw the same ones
+  Caffe::set_random_seed(1701);
+  plain_layer.Forward(plain_bottom, plain_top);
+  Caffe::set_random_seed(1701);
+  const uint64_t conversions = PrvMemDescr::conversions();
+  blocked_layer.Forward(blocked_bottom, blocked_top);
+  EXPECT_EQ(PrvMemDescr::conversions(), conversions);
+  for (int i = 0; i < num_tops; ++i) {
+    EXPECT_TRUE(blocked_top[i]->prv_data() != NULL);
+    ASSERT_EQ(plain_top[i]->shape(), blocked_top[i]->shape());
+    const float* plain_data = plain_top[i]->cpu_data();
+    const float* blocked_data = blocked_top[i]->cpu_data();
+    for (int j = 0; j < plain_top[i]->count(); ++j) {
+      EXPECT_FLOAT_EQ(plain_data[j], blocked_data[j]);
+    }
+  }
+}
+
+}  // namespace caffe
+
+#endif  // MKLDNN_SUPPORTED
+
+#endif  // CAFFE_TEST_BLOCKED_LAYOUT_UTIL_H_
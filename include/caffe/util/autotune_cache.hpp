@@ -0,0 +1,80 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_UTIL_AUTOTUNE_CACHE_HPP_
+#define CAFFE_UTIL_AUTOTUNE_CACHE_HPP_
+
+#include <map>
+#include <string>
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+/**
+ * @brief Persistent record of which implementation won an autotuning run.
+ *
+ * Entries map a key describing the tuned problem (layer geometry, data type,
+ * thread count and CPU model) to the name of the fastest implementation. They
+ * are kept in a text file, one "<choice> <key>" line each, which is read when
+ * the cache is created and appended to by Insert, so processes tuning into
+ * the same file share their results; the last line for a key wins. With an
+ * empty file name entries live only as long as the object.
+ */
+class AutotuneCache {
+ public:
+  explicit AutotuneCache(const string& filename);
+
+  // Returns whether key was tuned before, and its choice if so.
+  bool Find(const string& key, string* choice) const;
+  void Insert(const string& key, const string& choice);
+
+  const string& filename() const { return filename_; }
+
+  // Model name of the host CPU, as given by /proc/cpuinfo.
+  static const string& CpuModel();
+
+ private:
+  string filename_;
+  std::map<string, string> entries_;
+
+  DISABLE_COPY_AND_ASSIGN(AutotuneCache);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_AUTOTUNE_CACHE_HPP_
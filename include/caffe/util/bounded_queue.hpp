@@ -0,0 +1,129 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_UTIL_BOUNDED_QUEUE_HPP_
+#define CAFFE_UTIL_BOUNDED_QUEUE_HPP_
+
+#include <string>
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+// Number of polls a blocked push/pop spins before parking on a condition
+// variable. Parked threads remain interruptible like BlockingQueue waiters.
+const int kQueueSpinCount = 4000;
+
+/**
+ * @brief Bounded single-producer/single-consumer ring buffer.
+ *
+ * Unlike BlockingQueue, elements are handed over without taking a lock:
+ * the producer and consumer only publish their ring positions. Blocked
+ * calls spin for a while and then park, and a parked thread is only woken
+ * when the other side actually makes progress. push_n/pop_n move a whole
+ * batch of elements with a single publication.
+ */
+template<typename T>
+class SPSCQueue {
+ public:
+  explicit SPSCQueue(size_t capacity, int spin_count = kQueueSpinCount);
+
+  // Blocks while the queue is full.
+  void push(const T& t);
+  bool try_push(const T& t);
+  void push_n(const T* items, size_t n);
+
+  // This logs a message if the thread needs to be blocked
+  // useful for detecting e.g. when data feeding is too slow
+  T pop(const string& log_on_wait = "");
+  bool try_pop(T* t);
+  void pop_n(T* items, size_t n, const string& log_on_wait = "");
+
+  bool try_peek(T* t);
+  // Return element without removing it
+  T peek();
+
+  size_t size() const;
+  size_t capacity() const;
+
+ protected:
+  // Keeps the atomics and boost synchronization out of the header, for the
+  // same NVCC reasons as BlockingQueue.
+  class sync;
+
+  shared_ptr<sync> sync_;
+  const int spin_count_;
+
+DISABLE_COPY_AND_ASSIGN(SPSCQueue);
+};
+
+/**
+ * @brief Bounded multi-producer/multi-consumer queue with the same
+ *        interface and wait policy as SPSCQueue.
+ *
+ * Every slot carries a sequence number, so producers and consumers only
+ * contend on a compare-and-swap of the shared enqueue/dequeue positions.
+ */
+template<typename T>
+class MPMCQueue {
+ public:
+  explicit MPMCQueue(size_t capacity, int spin_count = kQueueSpinCount);
+
+  void push(const T& t);
+  bool try_push(const T& t);
+  void push_n(const T* items, size_t n);
+
+  T pop(const string& log_on_wait = "");
+  bool try_pop(T* t);
+  void pop_n(T* items, size_t n, const string& log_on_wait = "");
+
+  // Approximate while other threads are pushing or popping.
+  size_t size() const;
+  size_t capacity() const;
+
+ protected:
+  class sync;
+
+  shared_ptr<sync> sync_;
+  const int spin_count_;
+
+DISABLE_COPY_AND_ASSIGN(MPMCQueue);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_BOUNDED_QUEUE_HPP_
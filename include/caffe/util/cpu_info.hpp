@@ -40,10 +40,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/thread/thread.hpp>
 #include <sched.h>
+#include <stdint.h>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <set>
+#include <string>
 #include <vector>
 
 
@@ -57,6 +59,7 @@ struct Processor {
   unsigned coreId;
   unsigned cpuCores;
   unsigned speedMHz;
+  std::string modelName;
 
   Processor();
 };
@@ -91,6 +94,7 @@ class CollectionInterface {
  public:
   virtual ~CollectionInterface() {}
   virtual unsigned getProcessorSpeedMHz() = 0;
+  virtual const char *getProcessorModelName() = 0;
   virtual unsigned getTotalNumberOfSockets() = 0;
   virtual unsigned getTotalNumberOfCpuCores() = 0;
   virtual unsigned getNumberOfProcessors() = 0;
@@ -102,6 +106,7 @@ class Collection : public CollectionInterface {
   explicit Collection(CpuInfoInterface *cpuInfo);
 
   virtual unsigned getProcessorSpeedMHz();
+  virtual const char *getProcessorModelName();
   virtual unsigned getTotalNumberOfSockets();
   virtual unsigned getTotalNumberOfCpuCores();
   virtual unsigned getNumberOfProcessors();
@@ -175,6 +180,19 @@ class OpenMpManager {
 
 #endif  // _OPENMP
 
+// Limits the OpenMP teams the calling thread starts to numThreads threads,
+// if that is fewer than it would start, and returns the limit to hand to
+// restoreOpenMpThreads afterwards. A numThreads of 0 leaves it unchanged.
+int limitOpenMpThreads(int numThreads);
+void restoreOpenMpThreads(int numThreads);
+
+// Returns the nanoseconds all OpenMP threads together spent waiting in
+// barriers so far, or -1 if it isn't known. Measuring needs a build with
+// USE_OMPT and an OpenMP runtime implementing the OMPT tools interface,
+// such as the Intel or LLVM one. Those count workers that finish a
+// parallel region early as idle rather than waiting.
+int64_t getOpenMpBarrierWaitNs();
+
 }  // namespace cpu
 
 }  // namespace caffe
@@ -0,0 +1,99 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef USE_OPENCV
+#ifndef CAFFE_UTIL_DECODED_IMAGE_CACHE_HPP_
+#define CAFFE_UTIL_DECODED_IMAGE_CACHE_HPP_
+
+#include <opencv2/core/core.hpp>
+#include <stdint.h>
+
+#include <string>
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+/**
+ * @brief Cache of decoded 8-bit images in a memory-mapped file.
+ *
+ * The file lives in a directory given by the data layer and is named after
+ * a key describing what was decoded and how (source, resize parameters,
+ * color mode), so that every process on the host that reads the same
+ * source with the same parameters maps the same file. Images are filled in
+ * as they are first decoded and looked up by an id (a path or the encoded
+ * bytes). Lookups return a cv::Mat pointing into the mapping, without a
+ * copy. Once the file is full further images are simply not cached.
+ *
+ * Concurrent inserts from threads or processes are safe: slots are claimed
+ * with atomic operations on the shared mapping. Ids are matched on two
+ * independent 64-bit hashes, and a slot left half written by a process that
+ * died is taken over by the next insert of its id.
+ */
+class DecodedImageCache {
+ public:
+  DecodedImageCache(const string& dir, const string& key, size_t size_mb);
+  ~DecodedImageCache();
+
+  // Returns the cached image for id, or an empty Mat.
+  cv::Mat Find(const string& id) const;
+  // Stores img under id, unless it is already cached or the file is full.
+  void Insert(const string& id, const cv::Mat& img);
+
+  const string& filename() const { return filename_; }
+
+  static uint64_t Hash(const string& bytes);
+
+ private:
+  struct Header;
+  struct Slot;
+  struct Entry;
+
+  Slot* slots() const;
+
+  string filename_;
+  int fd_;
+  char* map_;
+  size_t map_size_;
+
+  DISABLE_COPY_AND_ASSIGN(DecodedImageCache);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_DECODED_IMAGE_CACHE_HPP_
+#endif  // USE_OPENCV
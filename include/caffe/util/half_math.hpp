@@ -0,0 +1,73 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_UTIL_HALF_MATH_HPP_
+#define CAFFE_UTIL_HALF_MATH_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace caffe {
+
+/**
+ * @brief 16-bit formats activations can be stored in between layers.
+ *
+ * FLOAT16 is IEEE binary16: 5 exponent bits, so values above 65504 become
+ * infinite and values below 2^-24 vanish. BFLOAT16 keeps the float exponent
+ * and the top 7 mantissa bits. Both round to the nearest even value.
+ */
+enum HalfFormat {
+  FLOAT16,
+  BFLOAT16
+};
+
+/**
+ * @brief y[i] = x[i] rounded to format. Uses F16C for FLOAT16 and
+ *        AVX512-BF16 for BFLOAT16 when the build targets them.
+ */
+template <typename Dtype>
+void caffe_cpu_to_half(const size_t n, const Dtype* x, HalfFormat format,
+    uint16_t* y);
+
+/// @brief y[i] = x[i] for x in format; exact.
+template <typename Dtype>
+void caffe_cpu_from_half(const size_t n, const uint16_t* x, HalfFormat format,
+    Dtype* y);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_HALF_MATH_HPP_
@@ -0,0 +1,119 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_UTIL_HOST_ALLOCATOR_HPP_
+#define CAFFE_UTIL_HOST_ALLOCATOR_HPP_
+
+#include <stdint.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "boost/thread/mutex.hpp"
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+struct HostAllocatorStats {
+  uint64_t allocations;  // calls to Allocate
+  uint64_t pool_hits;    // allocations served from a cached block
+  size_t bytes_in_use;
+  size_t peak_bytes;     // high-water mark of bytes_in_use
+  size_t bytes_cached;   // freed blocks kept for reuse
+  // Pages sampled after parallel first touch, by whether they were placed on
+  // the NUMA node of the thread that touched them.
+  uint64_t local_pages;
+  uint64_t remote_pages;
+};
+
+/**
+ * @brief Caching host allocator behind CaffeMallocHost.
+ *
+ * Sizes are rounded up to a size class (multiples of 64 bytes up to 1 KB,
+ * then four classes per power of two) and freed blocks are kept in per-node
+ * free lists, so that the buffers released and requested again by a
+ * Reshape are reused instead of going back to malloc. The cache is capped
+ * by the CAFFE_HOST_POOL_MB environment variable (default 1024, 0 disables
+ * caching).
+ *
+ * Large blocks are zeroed by all OpenMP threads with the same static split
+ * the compute loops use, so with threads bound by OpenMpManager each page is
+ * first touched, and placed, on the node of the thread that later works on
+ * it. Such blocks are cached in a shared list; smaller ones stay on the
+ * node of the thread that allocated them.
+ */
+class HostAllocator {
+ public:
+  static HostAllocator& Get();
+
+  void* Allocate(size_t size);
+  void Free(void* ptr);
+  // Zeroes size bytes of a block returned by Allocate.
+  void Zero(void* ptr, size_t size);
+  // Gives the pages within the first size bytes of a block returned by
+  // Allocate back to the system, bypassing the cache. The block stays
+  // allocated at the same address, its contents are undefined until written.
+  void Discard(void* ptr, size_t size);
+  // Releases all cached blocks.
+  void Trim();
+
+  HostAllocatorStats stats();
+  void LogStats();
+
+ private:
+  struct BlockHeader;
+  typedef std::pair<int, size_t> FreeListKey;  // node, size class
+
+  HostAllocator();
+
+  static size_t SizeClass(size_t size);
+  static int CurrentNode();
+  static void* RawAllocate(size_t size);
+  static void RawFree(void* ptr);
+
+  boost::mutex mutex_;
+  std::map<FreeListKey, std::vector<BlockHeader*> > free_lists_;
+  size_t max_cached_bytes_;
+  HostAllocatorStats stats_;
+
+  DISABLE_COPY_AND_ASSIGN(HostAllocator);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_HOST_ALLOCATOR_HPP_
@@ -119,7 +119,15 @@ void AdjustHue(const cv::Mat& in_img, const float delta, cv::Mat* out_img);
 void RandomOrderChannels(const cv::Mat& in_img, cv::Mat* out_img,
                          const float random_order_prob);
 
+// Applies the random brightness, contrast, saturation, hue and channel
+// order distortions. 8-bit BGR images go through a single fused pass that
+// draws the same random numbers as ApplyDistortChain; the result differs
+// from the chain only by the rounding of one HSV round trip instead of two.
 cv::Mat ApplyDistort(const cv::Mat& in_img, const DistortionParameter& param);
+
+// The distortions as a chain of the Random* functions above.
+cv::Mat ApplyDistortChain(const cv::Mat& in_img,
+                          const DistortionParameter& param);
 #endif  // USE_OPENCV
 
 }  // namespace caffe
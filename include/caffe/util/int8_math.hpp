@@ -0,0 +1,82 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_UTIL_INT8_MATH_HPP_
+#define CAFFE_UTIL_INT8_MATH_HPP_
+
+#include <stdint.h>
+
+namespace caffe {
+
+/**
+ * @brief Integer kernels backing the CAFFE engine's quantized inference path
+ *        on CPUs where MKL-DNN has no int8 primitive for the tensor rank.
+ *
+ * Scales follow QuantizationParameter: a real value x maps to round(x * scale).
+ * Activations are unsigned (u8, negative values saturate to 0), weights are
+ * symmetric signed (s8 in [-127, 127]) and products accumulate in s32.
+ */
+
+/// @brief y[i] = saturate_u8(round(x[i] * scale))
+template <typename Dtype>
+void caffe_cpu_quantize_u8(const int n, const Dtype* x, const float scale,
+    uint8_t* y);
+
+/// @brief y[i] = saturate_s8(round(x[i] * scale)), clamped to [-127, 127]
+template <typename Dtype>
+void caffe_cpu_quantize_s8(const int n, const Dtype* x, const float scale,
+    int8_t* y);
+
+/**
+ * @brief C = A * B for row-major A (M x K, s8), B (K x N, u8) and C (M x N,
+ *        s32). Parallel over output tiles unless called from within an
+ *        active OpenMP region.
+ */
+void caffe_cpu_gemm_s8u8s32(const int M, const int N, const int K,
+    const int8_t* A, const uint8_t* B, int32_t* C);
+
+/**
+ * @brief y[m][n] = x[m][n] * scale[m] + bias[m] for an M x N s32 matrix.
+ *        bias may be NULL.
+ */
+template <typename Dtype>
+void caffe_cpu_dequantize_s32(const int M, const int N, const int32_t* x,
+    const float* scale, const Dtype* bias, Dtype* y);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_INT8_MATH_HPP_
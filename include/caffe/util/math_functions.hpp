@@ -145,6 +145,12 @@ Dtype caffe_cpu_strided_dot(const long n, const Dtype* x, const int incx,
 template <typename Dtype>
 Dtype caffe_cpu_asum(const long n, const Dtype* x);
 
+// Writes softmax(x) of a contiguous row to y and returns the log-partition
+// max(x) + log(sum(exp(x - max(x)))), so log(y[i]) == x[i] - return value.
+// Long rows are split across threads when called outside a parallel region.
+template <typename Dtype>
+Dtype caffe_cpu_softmax(const long n, const Dtype* x, Dtype* y);
+
 // the branchless, type-safe version from
 // http://stackoverflow.com/questions/1903954/is-there-a-standard-sign-function-signum-sgn-in-c-c
 template<typename Dtype>
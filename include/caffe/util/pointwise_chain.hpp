@@ -0,0 +1,149 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_UTIL_POINTWISE_CHAIN_HPP_
+#define CAFFE_UTIL_POINTWISE_CHAIN_HPP_
+
+#include <string>
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+namespace caffe {
+
+/**
+ * @brief Applies a sequence of pointwise layers (ReLU, Power, Sigmoid,
+ *        Swish, per-channel Scale/Bias and Eltwise) in a single pass over
+ *        memory.
+ *
+ * The data is walked in cache sized tiles and every op of the chain is
+ * applied to a tile before moving to the next one, so a chain of k layers
+ * reads and writes its activations once instead of k times. Used by
+ * FusedPointwiseLayer and as the epilogue of ConvolutionLayer and
+ * InnerProductLayer (see Net::CompilationRulePointwiseFusion).
+ */
+template <typename Dtype>
+class PointwiseChain {
+ public:
+  PointwiseChain() : num_operands_(0), num_param_blobs_(0) {}
+
+  /**
+   * @brief Parses the ops of fused_param.
+   *
+   * @param input_name name of the chain input, i.e. the first bottom of the
+   *        fused layer.
+   * @param operand_names the remaining bottoms of the fused layer; Eltwise
+   *        inputs other than the running value must be one of these.
+   */
+  void Init(const FusedPointwiseParameter& fused_param,
+      const string& input_name, const vector<string>& operand_names);
+
+  /**
+   * @brief Parses the ops fused into a ConvolutionLayer/InnerProductLayer;
+   *        these must not have operands nor learned parameters.
+   */
+  void InitEpilogue(const FusedPointwiseParameter& fused_param);
+
+  /// @brief Creates and fills the Scale/Bias blobs of the chain.
+  void InitParamBlobs(int channels,
+      vector<shared_ptr<Blob<Dtype> > >* blobs) const;
+
+  /**
+   * @brief Computes output = chain(input) for data of shape
+   *        (outer, channels, inner). input may alias output.
+   *
+   * @param operands one pointer per operand bottom, same shape as input.
+   * @param params the Scale/Bias blobs, in the order of InitParamBlobs.
+   * @param parallel whether to split the work across OpenMP threads; pass
+   *        false from inside a parallel region.
+   */
+  void Forward(const Dtype* input, Dtype* output,
+      const vector<const Dtype*>& operands, const vector<const Dtype*>& params,
+      int outer, int channels, int inner, bool parallel = true) const;
+
+  /// @brief In-place variant for chains without operands and parameters.
+  void Forward(Dtype* data, int outer, int channels, int inner,
+      bool parallel = true) const {
+    Forward(data, data, vector<const Dtype*>(), vector<const Dtype*>(),
+        outer, channels, inner, parallel);
+  }
+
+  inline bool empty() const { return ops_.empty(); }
+  inline int num_ops() const { return ops_.size(); }
+  inline int num_operands() const { return num_operands_; }
+  inline int num_param_blobs() const { return num_param_blobs_; }
+
+  /// @brief Whether the layer can be part of a chain.
+  static bool IsPointwise(const LayerParameter& layer_param);
+  /// @brief Whether the layer can be fused as a conv/IP epilogue, i.e. it
+  ///        is unary and has no learned parameters.
+  static bool IsParameterFree(const LayerParameter& layer_param);
+
+ private:
+  enum OpType { RELU, POWER, SIGMOID, SWISH, SCALE, BIAS, ELTWISE };
+
+  struct Op {
+    OpType type;
+    // RELU: alpha = negative slope. POWER: (power, scale, shift).
+    // SWISH: alpha = beta.
+    Dtype alpha, beta, gamma;
+    // SCALE/BIAS: index of the first param blob, -1 if none. SCALE with
+    // bias_term sets bias_id too.
+    int param_id, bias_id;
+    // ELTWISE: operation, per-input operand index (-1 for the running
+    // value) and coefficient.
+    EltwiseParameter_EltwiseOp eltwise_op;
+    vector<int> inputs;
+    vector<Dtype> coeffs;
+    // The filler of each param blob owned by the op.
+    vector<FillerParameter> fillers;
+  };
+
+  void ApplyOp(const Op& op, const Dtype* src, Dtype* dst, int offset,
+      int count, int channel, const vector<const Dtype*>& operands,
+      const vector<const Dtype*>& params) const;
+
+  vector<Op> ops_;
+  int num_operands_;
+  int num_param_blobs_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_POINTWISE_CHAIN_HPP_
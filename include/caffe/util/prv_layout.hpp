@@ -0,0 +1,82 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAFFE_UTIL_PRV_LAYOUT_HPP_
+#define CAFFE_UTIL_PRV_LAYOUT_HPP_
+
+#include "caffe/blob.hpp"
+
+namespace caffe {
+
+// Helpers for reference layers to work on blobs an MKL-DNN layer left in
+// its private layout, instead of having SyncedMemory convert them to plain
+// NCHW and the next MKL-DNN layer convert them back. Without MKL-DNN they
+// always report plain data.
+
+// Returns true if blob's data is held in a private float layout without
+// padding, which element-wise layers can treat as count() plain values.
+template <typename Dtype>
+bool prv_data_elementwise(Blob<Dtype>* blob);
+
+// Returns true if blob's data is held in the same private layout as like's
+// and prv_data_elementwise(like) holds.
+template <typename Dtype>
+bool prv_layout_matches(Blob<Dtype>* blob, Blob<Dtype>* like);
+
+// Returns the channel block B if blob's data is held in the nChw8c or
+// nChw16c layout and its channels are a multiple of B, else 0. Every image
+// is then stored as C / B blocks of H x W x B values.
+template <typename Dtype>
+int prv_channel_block(Blob<Dtype>* blob);
+
+// Gives top private data in the layout of like's and returns it for
+// writing. top must have like's shape, or if like is channel blocked,
+// differ only in a number of channels that is a multiple of the block.
+// Returns NULL and leaves top alone otherwise.
+template <typename Dtype>
+Dtype* mutable_prv_data_like(Blob<Dtype>* top, Blob<Dtype>* like);
+
+// Points bottom_data and top_data at what an element-wise layer reads and
+// writes: the private data of bottom and of top in the same layout if
+// bottom has private data without padding, else the plain data.
+template <typename Dtype>
+void elementwise_data(Blob<Dtype>* bottom, Blob<Dtype>* top,
+    const Dtype** bottom_data, Dtype** top_data);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_PRV_LAYOUT_HPP_
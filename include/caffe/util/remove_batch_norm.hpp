@@ -52,9 +52,16 @@ void RecoverScaleFromBN(const LayerParameter& bn_layer_param, LayerParameter& sc
  */
 void MergeLayer(LayerParameter &layer1, const LayerParameter &layer2);
 
+/**
+ *  @brief Whether BatchNorm/Scale following this layer can be folded into its weights.
+ *  True for Convolution (2D and 3D), Deconvolution and InnerProduct with a single top.
+ */
+bool IsBNFoldableLayer(const LayerParameter& layer_param);
+
 /**
  *  @brief After removing the batch norm and scale layer after a convolution layer, to make the inference
- *  result correct, we must adjust convolution layer's weights and bias blobs
+ *  result correct, we must adjust convolution layer's weights and bias blobs.
+ *  conv_layer may be any layer accepted by IsBNFoldableLayer.
  */
 
 template <typename Dtype>
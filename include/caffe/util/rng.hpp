@@ -38,6 +38,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef CAFFE_RNG_CPP_HPP_
 #define CAFFE_RNG_CPP_HPP_
 
+#include <stdint.h>
+
 #include <algorithm>
 #include <iterator>
 
@@ -75,6 +77,77 @@ template <class RandomAccessIterator>
 inline void shuffle(RandomAccessIterator begin, RandomAccessIterator end) {
   shuffle(begin, end, caffe_rng());
 }
+
+/**
+ * @brief The Philox4x32-10 counter-based generator (Salmon et al.,
+ *        "Parallel random numbers: as easy as 1, 2, 3", SC'11).
+ *
+ * Block i of the stream of a key is a pure function of the key and i, so
+ * any part of a stream can be generated on its own: by several threads at
+ * once, in any order, with the same result.
+ */
+class Philox {
+ public:
+  Philox(uint32_t key0, uint32_t key1) {
+    key_[0] = key0;
+    key_[1] = key1;
+  }
+
+  /// Writes the four random words of block (counter, substream).
+  inline void operator()(uint64_t counter, uint32_t* out,
+                         uint64_t substream = 0) const {
+    uint32_t c0 = static_cast<uint32_t>(counter);
+    uint32_t c1 = static_cast<uint32_t>(counter >> 32);
+    uint32_t c2 = static_cast<uint32_t>(substream);
+    uint32_t c3 = static_cast<uint32_t>(substream >> 32);
+    uint32_t k0 = key_[0], k1 = key_[1];
+    for (int round = 0; round < 10; ++round) {
+      const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+      const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+      c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+      c1 = static_cast<uint32_t>(p1);
+      c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+      c3 = static_cast<uint32_t>(p0);
+      k0 += 0x9E3779B9u;
+      k1 += 0xBB67AE85u;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+
+ private:
+  uint32_t key_[2];
+};
+
+/// A Philox stream keyed by the next two draws of the global generator.
+inline Philox caffe_philox() {
+  rng_t* rng = caffe_rng();
+  const uint32_t key0 = (*rng)();
+  return Philox(key0, (*rng)());
+}
+
+/// Sequential reader over the blocks of a Philox stream.
+class PhiloxStream {
+ public:
+  explicit PhiloxStream(const Philox& philox)
+      : philox_(philox), counter_(0), next_(4) {}
+
+  uint32_t operator()() {
+    if (next_ == 4) {
+      philox_(counter_++, words_);
+      next_ = 0;
+    }
+    return words_[next_++];
+  }
+
+ private:
+  Philox philox_;
+  uint64_t counter_;
+  uint32_t words_[4];
+  int next_;
+};
 }  // namespace caffe
 
 #endif  // CAFFE_RNG_HPP_
@@ -35,7 +35,9 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
 #include <climits>
+#include <iterator>
 #include <vector>
 
 #include "caffe/blob.hpp"
@@ -70,8 +72,9 @@ void Blob<Dtype>::Reshape(const vector<int>& shape, bool reinitialize) {
 #endif
 
 #ifndef CPU_ONLY
-  if (!shape_data_ || shape_data_->size() < shape.size() * sizeof(int)) {
-    shape_data_.reset(new SyncedMemory(shape.size() * sizeof(int)));
+  if (!shape_data_) {
+    // Sized for any rank, so that later reshapes never reallocate it
+    shape_data_.reset(new SyncedMemory(kMaxBlobAxes * sizeof(int)));
   }
   int* shape_data = static_cast<int*>(shape_data_->mutable_cpu_data());
 #endif
@@ -92,10 +95,23 @@ void Blob<Dtype>::Reshape(const vector<int>& shape, bool reinitialize) {
   }
   // We restart sync objects when there was change of shape
   // requested count is bigger than current capacity
-  if (reinitialize && ((actual_reshaping == true) || (count_ > capacity_))) {
+  if (reinitialize && count_ > capacity_) {
     capacity_ = count_;
     data_.reset(new SyncedMemory(capacity_ * sizeof(Dtype)));
     diff_.reset(new SyncedMemory(capacity_ * sizeof(Dtype)));
+  } else if (reinitialize && actual_reshaping) {
+    // The buffers are large enough: restart them in place, unless another
+    // blob shares them and must keep seeing the old contents.
+    if (data_.unique()) {
+      data_->Recycle();
+    } else {
+      data_.reset(new SyncedMemory(capacity_ * sizeof(Dtype)));
+    }
+    if (diff_.unique()) {
+      diff_->Recycle();
+    } else {
+      diff_.reset(new SyncedMemory(capacity_ * sizeof(Dtype)));
+    }
   }
 }
 
@@ -267,6 +283,62 @@ void Blob<Dtype>::ShareDiff(const Blob& other) {
   diff_ = other.diff();
 }
 
+template <typename Dtype>
+void Blob<Dtype>::set_diff_row_sparse(bool sparse) {
+  if (!sparse) {
+    diff_rows_.reset();
+  } else if (!diff_rows_) {
+    CHECK_GE(num_axes(), 1) << "Row-sparse diff needs at least one axis";
+    // Rows written before this call are unknown, so start from a zero diff.
+    if (count_ > 0) {
+      caffe_set(count_, Dtype(0), mutable_cpu_diff());
+    }
+    diff_rows_.reset(new vector<int>());
+  }
+}
+
+template <typename Dtype>
+void Blob<Dtype>::AddDiffRows(const vector<int>& rows) {
+  CHECK(diff_rows_) << "Diff of this blob is not row-sparse";
+  if (diff_rows_->empty()) {
+    *diff_rows_ = rows;
+    return;
+  }
+  vector<int> merged;
+  merged.reserve(diff_rows_->size() + rows.size());
+  std::set_union(diff_rows_->begin(), diff_rows_->end(),
+                 rows.begin(), rows.end(), std::back_inserter(merged));
+  diff_rows_->swap(merged);
+}
+
+template <typename Dtype>
+void Blob<Dtype>::ClearSparseDiff() {
+  CHECK(diff_rows_) << "Diff of this blob is not row-sparse";
+  if (!diff_rows_->empty()) {
+    Dtype* diff = mutable_cpu_diff();
+    const int row_size = count(1);
+    const vector<int>& rows = *diff_rows_;
+#ifdef _OPENMP
+    #pragma omp parallel for if (rows.size() > 64)
+#endif
+    for (int i = 0; i < rows.size(); ++i) {
+      caffe_set(row_size, Dtype(0),
+                diff + static_cast<size_t>(rows[i]) * row_size);
+    }
+    diff_rows_->clear();
+  }
+}
+
+// Row-sparse diffs are only meaningful for parameter blobs.
+template <> void Blob<unsigned int>::set_diff_row_sparse(bool sparse) {
+  NOT_IMPLEMENTED;
+}
+template <> void Blob<bool>::set_diff_row_sparse(bool sparse) {
+  NOT_IMPLEMENTED;
+}
+template <> void Blob<unsigned int>::ClearSparseDiff() { NOT_IMPLEMENTED; }
+template <> void Blob<bool>::ClearSparseDiff() { NOT_IMPLEMENTED; }
+
 // The "update" method is used for parameter blobs in a Net, which are stored
 // as Blob<float> or Blob<double> -- hence we do not define it for
 // Blob<int> or Blob<unsigned int>.
@@ -291,8 +363,24 @@ void Blob<Dtype>::Update() {
           static_cast<Dtype*>(data_->mutable_prv_data()));
       break;
     }
+  case SyncedMemory::HEAD_AT_HALF:
   case SyncedMemory::HEAD_AT_CPU:
     // perform computation on CPU
+    if (diff_rows_) {
+      // only the rows touched by the last backward pass can change
+      const Dtype* diff = static_cast<const Dtype*>(diff_->cpu_data());
+      Dtype* data = static_cast<Dtype*>(data_->mutable_cpu_data());
+      const int row_size = count(1);
+      const vector<int>& rows = *diff_rows_;
+#ifdef _OPENMP
+      #pragma omp parallel for if (rows.size() > 64)
+#endif
+      for (int i = 0; i < rows.size(); ++i) {
+        const size_t offset = static_cast<size_t>(rows[i]) * row_size;
+        caffe_axpy<Dtype>(row_size, Dtype(-1), diff + offset, data + offset);
+      }
+      break;
+    }
     caffe_axpy<Dtype>(count_, Dtype(-1),
         static_cast<const Dtype*>(diff_->cpu_data()),
         static_cast<Dtype*>(data_->mutable_cpu_data()));
@@ -341,6 +429,7 @@ Dtype Blob<Dtype>::asum_data() const {
       }
   case SyncedMemory::HEAD_AT_PRV:
     return caffe_cpu_asum(prv_data_count(), prv_data());
+  case SyncedMemory::HEAD_AT_HALF:
   case SyncedMemory::HEAD_AT_CPU:
     return caffe_cpu_asum(count_, cpu_data());
   case SyncedMemory::HEAD_AT_GPU:
@@ -442,6 +531,7 @@ Dtype Blob<Dtype>::sumsq_data() const {
         sumsq = caffe_cpu_dot(prv_data_count(), data, data);
       }
       break;
+  case SyncedMemory::HEAD_AT_HALF:
   case SyncedMemory::HEAD_AT_CPU:
     data = cpu_data();
     sumsq = caffe_cpu_dot(count_, data, data);
@@ -542,6 +632,7 @@ void Blob<Dtype>::scale_data(Dtype scale_factor) {
         caffe_scal(prv_data_count(), scale_factor, data);
       }
       break;
+  case SyncedMemory::HEAD_AT_HALF:
   case SyncedMemory::HEAD_AT_CPU:
     data = mutable_cpu_data();
     caffe_scal(count_, scale_factor, data);
@@ -98,7 +98,8 @@ void GlobalInit(int* pargc, char*** pargv) {
 
 Caffe::Caffe()
     : random_generator_(), mode_(Caffe::CPU),
-      solver_count_(1), root_solver_(true), iter_size_(1) { }
+      solver_count_(1), root_solver_(true), iter_size_(1),
+      skip_param_fill_(false) { }
 
 Caffe::~Caffe() { }
 
@@ -151,7 +152,8 @@ void* Caffe::RNG::generator() {
 
 Caffe::Caffe()
     : cublas_handle_(NULL), curand_generator_(NULL), random_generator_(),
-    mode_(Caffe::CPU), solver_count_(1), root_solver_(true), iter_size_(1) {
+    mode_(Caffe::CPU), solver_count_(1), root_solver_(true), iter_size_(1),
+    skip_param_fill_(false) {
   // Try to create a cublas handler, and report an error if failed (but we will
   // keep the program running as one might just want to run CPU code).
   if (cublasCreate(&cublas_handle_) != CUBLAS_STATUS_SUCCESS) {
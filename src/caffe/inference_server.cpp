@@ -0,0 +1,309 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include "caffe/inference_server.hpp"
+#include "caffe/util/math_functions.hpp"
+
+namespace caffe {
+
+// Latencies kept for the percentiles of InferenceServer::stats.
+static const size_t kMaxLatencies = 100000;
+
+static double ElapsedMs(const boost::system_time& since) {
+  return (boost::get_system_time() - since).total_microseconds() / 1000.;
+}
+
+template <typename Dtype>
+void InferenceRequest<Dtype>::Wait() {
+  boost::mutex::scoped_lock lock(mutex_);
+  while (!done_) {
+    cond_.wait(lock);
+  }
+}
+
+template <typename Dtype>
+bool InferenceRequest<Dtype>::done() {
+  boost::mutex::scoped_lock lock(mutex_);
+  return done_;
+}
+
+template <typename Dtype>
+InferenceServer<Dtype>::InferenceServer(const NetParameter& param,
+    const string& weights, const Options& options)
+    : options_(options), sample_size_(0), mode_(Caffe::mode()), device_(0),
+      stop_(false) {
+  CHECK_GT(options_.num_workers, 0);
+  CHECK_GT(options_.max_batch_size, 0);
+  CHECK_GE(options_.latency_budget_ms, 0);
+  vector<int>& buckets = options_.batch_buckets;
+  if (buckets.empty()) {
+    for (int size = 1; size < options_.max_batch_size; size *= 2) {
+      buckets.push_back(size);
+    }
+  }
+  buckets.push_back(options_.max_batch_size);
+  std::sort(buckets.begin(), buckets.end());
+  buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+  buckets.erase(std::upper_bound(buckets.begin(), buckets.end(),
+                                 options_.max_batch_size), buckets.end());
+  CHECK_GT(buckets.front(), 0) << "Batch size buckets must be positive.";
+#ifndef CPU_ONLY
+  if (mode_ == Caffe::GPU) {
+    CUDA_CHECK(cudaGetDevice(&device_));
+  }
+#endif
+
+  NetParameter net_param(param);
+  net_param.mutable_state()->set_phase(TEST);
+  const bool skip_param_fill = Caffe::skip_param_fill();
+  for (int i = 0; i < options_.num_workers; ++i) {
+    // Only the first net gets weights of its own, the others share them.
+    Caffe::set_skip_param_fill(i > 0 || !weights.empty());
+    nets_.push_back(shared_ptr<Net<Dtype> >(new Net<Dtype>(net_param)));
+    Caffe::set_skip_param_fill(skip_param_fill);
+    if (i > 0) {
+      nets_[i]->ShareTrainedLayersWith(nets_[0].get());
+    } else if (!weights.empty()) {
+      nets_[0]->CopyTrainedLayersFrom(weights);
+    }
+  }
+  CHECK_EQ(nets_[0]->input_blobs().size(), 1)
+      << "Served nets take a single input blob.";
+  const Blob<Dtype>* input = nets_[0]->input_blobs()[0];
+  CHECK_GE(input->num_axes(), 1);
+  sample_shape_.assign(input->shape().begin() + 1, input->shape().end());
+  sample_size_ = input->count(1);
+
+  stats_.requests = 0;
+  stats_.batches = 0;
+  stats_.padded_samples = 0;
+  stats_.max_queue_depth = 0;
+  for (int i = 0; i < options_.num_workers; ++i) {
+    workers_.push_back(shared_ptr<boost::thread>(new boost::thread(
+        &InferenceServer<Dtype>::WorkerEntry, this, i)));
+  }
+}
+
+template <typename Dtype>
+InferenceServer<Dtype>::~InferenceServer() {
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    stop_ = true;
+  }
+  queue_cond_.notify_all();
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->join();
+  }
+}
+
+template <typename Dtype>
+shared_ptr<InferenceRequest<Dtype> > InferenceServer<Dtype>::Submit(
+    const vector<Dtype>& input) {
+  CHECK_EQ(static_cast<int>(input.size()), sample_size_) << "Wrong sample size.";
+  shared_ptr<InferenceRequest<Dtype> > request(
+      new InferenceRequest<Dtype>(input));
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    CHECK(!stop_) << "Server is stopping.";
+    request->submitted_ = boost::get_system_time();
+    request->queue_depth_ = queue_.size();
+    stats_.max_queue_depth =
+        std::max(stats_.max_queue_depth, request->queue_depth_);
+    queue_.push_back(request);
+  }
+  // Wakes a waiting worker as well as one collecting a batch.
+  queue_cond_.notify_all();
+  return request;
+}
+
+template <typename Dtype>
+int InferenceServer<Dtype>::Bucket(int batch_size) const {
+  return *std::lower_bound(options_.batch_buckets.begin(),
+                           options_.batch_buckets.end(), batch_size);
+}
+
+template <typename Dtype>
+bool InferenceServer<Dtype>::NextBatch(
+    vector<shared_ptr<InferenceRequest<Dtype> > >* batch) {
+  boost::mutex::scoped_lock lock(mutex_);
+  const int max_batch_size = options_.max_batch_size;
+  while (true) {
+    while (queue_.empty() && !stop_) {
+      queue_cond_.wait(lock);
+    }
+    if (queue_.empty()) {
+      return false;
+    }
+    const int queued = queue_.size();
+    if (!stop_ && queued < max_batch_size) {
+      // Wait for one more request only as long as the oldest one can still
+      // be answered within the budget by the bigger batch.
+      const std::map<int, double>::const_iterator forward =
+          forward_ms_.find(Bucket(queued + 1));
+      const double slack_ms = options_.latency_budget_ms -
+          (forward == forward_ms_.end() ? 0 : forward->second);
+      const boost::system_time deadline = queue_.front()->submitted_ +
+          boost::posix_time::microseconds(static_cast<int64_t>(
+              std::max(slack_ms, 0.) * 1000));
+      if (boost::get_system_time() < deadline) {
+        queue_cond_.timed_wait(lock, deadline);
+        continue;
+      }
+    }
+    const int batch_size = std::min(queued, max_batch_size);
+    batch->assign(queue_.begin(), queue_.begin() + batch_size);
+    queue_.erase(queue_.begin(), queue_.begin() + batch_size);
+    return true;
+  }
+}
+
+template <typename Dtype>
+void InferenceServer<Dtype>::Run(Net<Dtype>* net,
+    const vector<shared_ptr<InferenceRequest<Dtype> > >& batch) {
+  const boost::system_time start = boost::get_system_time();
+  const int batch_size = batch.size();
+  const int bucket = Bucket(batch_size);
+  for (int i = 0; i < batch_size; ++i) {
+    batch[i]->queue_ms_ = ElapsedMs(batch[i]->submitted_);
+  }
+
+  Blob<Dtype>* input = net->input_blobs()[0];
+  vector<int> shape(1, bucket);
+  shape.insert(shape.end(), sample_shape_.begin(), sample_shape_.end());
+  input->Reshape(shape);
+  net->Reshape();
+  Dtype* input_data = input->mutable_cpu_data();
+  for (int i = 0; i < batch_size; ++i) {
+    caffe_copy(sample_size_, &batch[i]->input_[0],
+               input_data + i * sample_size_);
+  }
+  caffe_set((bucket - batch_size) * sample_size_, Dtype(0),
+            input_data + batch_size * sample_size_);
+  net->Forward();
+  const double forward_ms = ElapsedMs(start);
+
+  // Outputs with the batch as first axis are split by sample, any other
+  // output goes to every request of the batch whole.
+  const vector<Blob<Dtype>*>& outputs = net->output_blobs();
+  for (int i = 0; i < batch_size; ++i) {
+    InferenceRequest<Dtype>& request = *batch[i];
+    boost::mutex::scoped_lock lock(request.mutex_);
+    request.outputs_.resize(outputs.size());
+    for (size_t j = 0; j < outputs.size(); ++j) {
+      const Blob<Dtype>* output = outputs[j];
+      const Dtype* output_data = output->cpu_data();
+      if (output->num_axes() > 0 && output->shape(0) == bucket) {
+        const int count = output->count(1);
+        request.outputs_[j].assign(output_data + i * count,
+                                   output_data + (i + 1) * count);
+      } else {
+        request.outputs_[j].assign(output_data,
+                                   output_data + output->count());
+      }
+    }
+    request.batch_size_ = batch_size;
+    request.latency_ms_ = ElapsedMs(request.submitted_);
+    request.done_ = true;
+    request.cond_.notify_all();
+  }
+
+  boost::mutex::scoped_lock lock(mutex_);
+  forward_ms_[bucket] = forward_ms;
+  stats_.batches++;
+  stats_.padded_samples += bucket - batch_size;
+  for (int i = 0; i < batch_size; ++i) {
+    if (latencies_.size() < kMaxLatencies) {
+      latencies_.push_back(batch[i]->latency_ms_);
+    } else {
+      latencies_[stats_.requests % kMaxLatencies] = batch[i]->latency_ms_;
+    }
+    stats_.requests++;
+  }
+}
+
+template <typename Dtype>
+void InferenceServer<Dtype>::WorkerEntry(int worker) {
+#ifndef CPU_ONLY
+  if (mode_ == Caffe::GPU) {
+    CUDA_CHECK(cudaSetDevice(device_));
+  }
+#endif
+  Caffe::set_mode(mode_);
+#ifdef _OPENMP
+  // The workers split the cores rather than each running a full team.
+  omp_set_num_threads(
+      std::max(1, omp_get_max_threads() / options_.num_workers));
+#endif
+  Net<Dtype>* net = nets_[worker].get();
+  vector<shared_ptr<InferenceRequest<Dtype> > > batch;
+  while (NextBatch(&batch)) {
+    Run(net, batch);
+  }
+}
+
+template <typename Dtype>
+InferenceServerStats InferenceServer<Dtype>::stats() {
+  boost::mutex::scoped_lock lock(mutex_);
+  InferenceServerStats stats = stats_;
+  stats.mean_batch_size =
+      stats.batches ? static_cast<double>(stats.requests) / stats.batches : 0;
+  stats.mean_latency_ms = 0;
+  stats.p50_latency_ms = 0;
+  stats.p99_latency_ms = 0;
+  if (!latencies_.empty()) {
+    vector<double> latencies(latencies_);
+    for (size_t i = 0; i < latencies.size(); ++i) {
+      stats.mean_latency_ms += latencies[i] / latencies.size();
+    }
+    std::sort(latencies.begin(), latencies.end());
+    stats.p50_latency_ms = latencies[latencies.size() / 2];
+    stats.p99_latency_ms = latencies[latencies.size() * 99 / 100];
+  }
+  return stats;
+}
+
+INSTANTIATE_CLASS(InferenceRequest);
+INSTANTIATE_CLASS(InferenceServer);
+
+}  // namespace caffe
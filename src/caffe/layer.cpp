@@ -36,10 +36,16 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <boost/thread.hpp>
+#include <algorithm>
 #include "caffe/layer.hpp"
+#include "caffe/util/cpu_info.hpp"
 
 namespace caffe {
 
+// Elements a thread should have to touch before a layer without learnable
+// parameters gets another thread
+static const size_t kLayerWorkPerThread = 32768;
+
 template <typename Dtype>
 void Layer<Dtype>::InitMutex() {
   forward_mutex_.reset(new boost::mutex());
@@ -59,6 +65,52 @@ void Layer<Dtype>::Unlock() {
   }
 }
 
+template <typename Dtype>
+int Layer<Dtype>::LimitThreads() {
+  return cpu::limitOpenMpThreads(num_threads_);
+}
+
+template <typename Dtype>
+void Layer<Dtype>::RestoreThreads(int num_threads) {
+  cpu::restoreOpenMpThreads(num_threads);
+}
+
+template <typename Dtype>
+void Layer<Dtype>::ReshapeIfChanged(const vector<Blob<Dtype>*>& bottom,
+    const vector<Blob<Dtype>*>& top) {
+  const int num_blobs = bottom.size() + top.size();
+  bool changed = !ReshapeDependsOnShapesOnly() ||
+      reshaped_shapes_.size() != static_cast<size_t>(num_blobs) ||
+      reshaped_phase_ != phase_;
+  for (int i = 0; i < num_blobs && !changed; ++i) {
+    const Blob<Dtype>* blob = i < bottom.size() ? bottom[i] :
+        top[i - bottom.size()];
+    changed = blob->shape() != reshaped_shapes_[i];
+  }
+  if (!changed) {
+    return;
+  }
+  Reshape(bottom, top);
+  reshaped_phase_ = phase_;
+  reshaped_shapes_.resize(num_blobs);
+  for (int i = 0; i < num_blobs; ++i) {
+    const Blob<Dtype>* blob = i < bottom.size() ? bottom[i] :
+        top[i - bottom.size()];
+    reshaped_shapes_[i] = blob->shape();
+  }
+  if (layer_param_.num_threads() == 0 && blobs_.empty()) {
+    size_t work = 0;
+    for (size_t i = 0; i < bottom.size(); ++i) {
+      work = std::max(work, bottom[i]->count());
+    }
+    for (size_t i = 0; i < top.size(); ++i) {
+      work = std::max(work, top[i]->count());
+    }
+    num_threads_ = static_cast<int>(std::max<size_t>(1,
+        (work + kLayerWorkPerThread - 1) / kLayerWorkPerThread));
+  }
+}
+
 INSTANTIATE_CLASS(Layer);
 
 }  // namespace caffe
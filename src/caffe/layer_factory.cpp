@@ -40,6 +40,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifdef WITH_PYTHON_LAYER
 #include <boost/python.hpp>
 #endif
+#include <algorithm>
 #include <string>
 
 #include "caffe/engine_parser.hpp"
@@ -56,6 +57,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/layers/softmax_layer.hpp"
 #include "caffe/layers/tanh_layer.hpp"
 #include "caffe/layers/deconv_layer.hpp"
+#include "caffe/layers/autotuned_conv_layer.hpp"
+#include "caffe/layers/winograd_conv_layer.hpp"
 #ifdef MKL2017_SUPPORTED
 #include "caffe/layers/mkl_layers.hpp"
 #endif
@@ -81,6 +84,22 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace caffe {
 
+#if defined(MKL2017_SUPPORTED) || defined(MKLDNN_SUPPORTED)
+// Whether conv_param allows 2 spatial axes: its fields either give values
+// for 2 axes, or hold at most one value each, which applies to any number.
+static bool AllowsTwoSpatialAxes(const ConvolutionParameter& conv_param) {
+  if (conv_param.has_kernel_h() || conv_param.has_kernel_w() ||
+      conv_param.has_pad_h() || conv_param.has_pad_w() ||
+      conv_param.has_stride_h() || conv_param.has_stride_w()) {
+    return true;
+  }
+  const int axes = std::max(
+      std::max(conv_param.kernel_size_size(), conv_param.pad_size()),
+      std::max(conv_param.stride_size(), conv_param.dilation_size()));
+  return axes <= 1 || axes == 2;
+}
+#endif
+
 // Get convolution layer according to engine.
 template <typename Dtype>
 shared_ptr<Layer<Dtype> > GetConvolutionLayer(
@@ -105,18 +124,29 @@ shared_ptr<Layer<Dtype> > GetConvolutionLayer(
     if (ep.isEngine("CAFFE")) {
       engine = ConvolutionParameter_Engine_CAFFE;
     }
+    // Layers Winograd cannot handle run on the CAFFE engine
+    else if (ep.isEngine("WINOGRAD")) {
+      engine = WinogradConvolutionLayer<Dtype>::IsEligible(conv_param) ?
+               ConvolutionParameter_Engine_WINOGRAD :
+               ConvolutionParameter_Engine_CAFFE;
+    }
 #ifdef USE_CUDNN
     else if (!use_dilation && ep.isEngine("CUDNN")) {
       engine = ConvolutionParameter_Engine_CUDNN;
     }
 #endif
 #ifdef MKL2017_SUPPORTED
-    else if (!use_dilation && ep.isEngine("MKL2017")) {
+    // Convolutions declared with another number of spatial axes run on the
+    // CAFFE engine. Net::Init does the same from the bottom's rank when the
+    // parameters leave it open.
+    else if (!use_dilation && ep.isEngine("MKL2017") &&
+             AllowsTwoSpatialAxes(conv_param)) {
       engine = ConvolutionParameter_Engine_MKL2017;
     }
 #endif
 #ifdef MKLDNN_SUPPORTED
-    else if (ep.isEngine("MKLDNN")) {
+    // MKLDNNConvolutionLayer is 4D only, like MKLConvolutionLayer
+    else if (ep.isEngine("MKLDNN") && AllowsTwoSpatialAxes(conv_param)) {
       engine = ConvolutionParameter_Engine_MKLDNN;
     }
 #endif
@@ -129,9 +159,28 @@ shared_ptr<Layer<Dtype> > GetConvolutionLayer(
       engine = ConvolutionParameter_Engine_CUDNN;
     }
 #endif
+    // The layer itself decides at Reshape whether Winograd pays off
+    if (engine == ConvolutionParameter_Engine_CAFFE &&
+        conv_param.auto_winograd() && !conv_param.autotune() &&
+        WinogradConvolutionLayer<Dtype>::IsEligible(conv_param)) {
+      return shared_ptr<Layer<Dtype> >(
+          new WinogradConvolutionLayer<Dtype>(param));
+    }
   }
   if (engine == ConvolutionParameter_Engine_CAFFE) {
+    if (conv_param.autotune()) {
+      return shared_ptr<Layer<Dtype> >(
+          new AutotunedConvolutionLayer<Dtype>(param));
+    }
     return shared_ptr<Layer<Dtype> >(new ConvolutionLayer<Dtype>(param));
+  } else if (engine == ConvolutionParameter_Engine_WINOGRAD) {
+    if (!WinogradConvolutionLayer<Dtype>::IsEligible(conv_param)) {
+      LOG(FATAL) << "Winograd supports only 3x3 or 3x3x3, stride 1, "
+                 << "ungrouped convolutions without dilation at Layer "
+                 << param.name();
+    }
+    return shared_ptr<Layer<Dtype> >(
+        new WinogradConvolutionLayer<Dtype>(param));
 #ifdef USE_CUDNN
   } else if (engine == ConvolutionParameter_Engine_CUDNN) {
     if (use_dilation) {
@@ -184,7 +233,11 @@ shared_ptr<Layer<Dtype> > GetDeconvolutionLayer(
       engine = ConvolutionParameter_Engine_CAFFE;
     }
 #ifdef MKL2017_SUPPORTED
-    else if (!use_dilation && ep.isEngine("MKL2017")) {
+    // Convolutions declared with another number of spatial axes run on the
+    // CAFFE engine. Net::Init does the same from the bottom's rank when the
+    // parameters leave it open.
+    else if (!use_dilation && ep.isEngine("MKL2017") &&
+             AllowsTwoSpatialAxes(conv_param)) {
       engine = ConvolutionParameter_Engine_MKL2017;
     }
 #endif
@@ -39,6 +39,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "caffe/layers/absval_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
@@ -54,8 +55,10 @@ template <typename Dtype>
 void AbsValLayer<Dtype>::Forward_cpu(
     const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
   const int count = top[0]->count();
-  Dtype* top_data = top[0]->mutable_cpu_data();
-  caffe_abs(count, bottom[0]->cpu_data(), top_data);
+  const Dtype* bottom_data;
+  Dtype* top_data;
+  elementwise_data(bottom[0], top[0], &bottom_data, &top_data);
+  caffe_abs(count, bottom_data, top_data);
 }
 
 template <typename Dtype>
@@ -1,6 +1,10 @@
+#include <algorithm>
 #include <functional>
 #include <utility>
 #include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "caffe/layers/accuracy_layer.hpp"
 #include "caffe/util/math_functions.hpp"
@@ -44,6 +48,28 @@ void AccuracyLayer<Dtype>::Reshape(
   }
 }
 
+// Counts the scores x[0], x[stride], ... x[(n - 1) * stride] that are not
+// below threshold, scanning in blocks the compiler can vectorize and stopping
+// as soon as the count exceeds limit.
+template <typename Dtype>
+static int count_not_below(const Dtype* x, const int n, const int stride,
+    const Dtype threshold, const int limit) {
+  static const int kBlockSize = 256;
+  int num = 0;
+  for (int k0 = 0; k0 < n && num <= limit; k0 += kBlockSize) {
+    const int k1 = std::min(n, k0 + kBlockSize);
+    int block_num = 0;
+#ifdef _OPENMP
+    #pragma omp simd reduction(+: block_num)
+#endif
+    for (int k = k0; k < k1; ++k) {
+      block_num += (x[k * stride] >= threshold);
+    }
+    num += block_num;
+  }
+  return num;
+}
+
 template <typename Dtype>
 void AccuracyLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
@@ -52,46 +78,56 @@ void AccuracyLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   const Dtype* bottom_label = bottom[1]->cpu_data();
   const int dim = bottom[0]->count() / outer_num_;
   const int num_labels = bottom[0]->shape(label_axis_);
+  Dtype* nums_data = NULL;
+  Dtype* per_class_data = NULL;
   if (top.size() > 1) {
-    caffe_set(nums_buffer_.count(), Dtype(0), nums_buffer_.mutable_cpu_data());
-    caffe_set(top[1]->count(), Dtype(0), top[1]->mutable_cpu_data());
+    nums_data = nums_buffer_.mutable_cpu_data();
+    per_class_data = top[1]->mutable_cpu_data();
+    caffe_set(nums_buffer_.count(), Dtype(0), nums_data);
+    caffe_set(top[1]->count(), Dtype(0), per_class_data);
   }
   int count = 0;
-  for (int i = 0; i < outer_num_; ++i) {
-    for (int j = 0; j < inner_num_; ++j) {
-      const int label_value =
-          static_cast<int>(bottom_label[i * inner_num_ + j]);
-      if (has_ignore_label_ && label_value == ignore_label_) {
-        continue;
-      }
-      DCHECK_GE(label_value, 0);
-      DCHECK_LT(label_value, num_labels);
-      if (top.size() > 1) ++nums_buffer_.mutable_cpu_data()[label_value];
-      const Dtype prob_of_true_class = bottom_data[i * dim
-                                                   + label_value * inner_num_
-                                                   + j];
-      int num_better_predictions = -1;  // true_class also counts as "better"
-      // Top-k accuracy
-      for (int k = 0; k < num_labels && num_better_predictions < top_k_; ++k) {
-        num_better_predictions +=
-          (bottom_data[i * dim + k * inner_num_ + j] >= prob_of_true_class);
-      }
-      // check if there are less than top_k_ predictions
-      if (num_better_predictions < top_k_) {
-        ++accuracy;
-        if (top.size() > 1) ++top[1]->mutable_cpu_data()[label_value];
+  const int num_samples = outer_num_ * inner_num_;
+#ifdef _OPENMP
+  #pragma omp parallel for reduction(+: accuracy, count) if(num_samples > 1)
+#endif
+  for (int s = 0; s < num_samples; ++s) {
+    const int i = s / inner_num_;
+    const int j = s % inner_num_;
+    const int label_value = static_cast<int>(bottom_label[s]);
+    if (has_ignore_label_ && label_value == ignore_label_) {
+      continue;
+    }
+    DCHECK_GE(label_value, 0);
+    DCHECK_LT(label_value, num_labels);
+    if (nums_data) {
+#ifdef _OPENMP
+      #pragma omp atomic
+#endif
+      nums_data[label_value] += 1;
+    }
+    const Dtype* scores = bottom_data + i * dim + j;
+    const Dtype prob_of_true_class = scores[label_value * inner_num_];
+    // Top-k accuracy; the true class itself is among the counted scores
+    if (count_not_below(scores, num_labels, inner_num_, prob_of_true_class,
+                        top_k_) <= top_k_) {
+      ++accuracy;
+      if (per_class_data) {
+#ifdef _OPENMP
+        #pragma omp atomic
+#endif
+        per_class_data[label_value] += 1;
       }
-      ++count;
     }
+    ++count;
   }
 
   // LOG(INFO) << "Accuracy: " << accuracy;
   top[0]->mutable_cpu_data()[0] = (count == 0) ? 0 : (accuracy / count);
   if (top.size() > 1) {
     for (int i = 0; i < top[1]->count(); ++i) {
-      top[1]->mutable_cpu_data()[i] =
-          nums_buffer_.cpu_data()[i] == 0 ? 0
-          : top[1]->cpu_data()[i] / nums_buffer_.cpu_data()[i];
+      per_class_data[i] =
+          nums_data[i] == 0 ? 0 : per_class_data[i] / nums_data[i];
     }
   }
   // Accuracy layer should not be used as a loss function.
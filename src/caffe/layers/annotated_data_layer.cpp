@@ -96,8 +96,8 @@ void AnnotatedDataLayer<Dtype>::DataLayerSetUp(
   // Reshape top[0] and prefetch_data according to the batch_size.
   top_shape[0] = batch_size;
   top[0]->Reshape(top_shape);
-  for (int i = 0; i < this->PREFETCH_COUNT; ++i) {
-    this->prefetch_[i].data_.Reshape(top_shape);
+  for (int i = 0; i < this->prefetch_.size(); ++i) {
+    this->prefetch_[i]->data_.Reshape(top_shape);
   }
   LOG(INFO) << "output data size: " << top[0]->num() << ","
       << top[0]->channels() << "," << top[0]->height() << ","
@@ -141,8 +141,8 @@ void AnnotatedDataLayer<Dtype>::DataLayerSetUp(
       label_shape[0] = batch_size;
     }
     top[1]->Reshape(label_shape);
-    for (int i = 0; i < this->PREFETCH_COUNT; ++i) {
-      this->prefetch_[i].label_.Reshape(label_shape);
+    for (int i = 0; i < this->prefetch_.size(); ++i) {
+      this->prefetch_[i]->label_.Reshape(label_shape);
     }
   }
 }
@@ -189,7 +189,14 @@ void AnnotatedDataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
 
   int num_bboxes = 0;
 
+  // Take the whole batch of serialized datums from the reader in one go;
+  // the buffers go back together once the sampling loop has parsed them.
+  vector<string*> datums(batch_size);
   trans_timer.Start();
+  timer.Start();
+  reader_.full().pop_n(&datums[0], batch_size, "Waiting for data");
+  timer.Stop();
+  read_time += timer.MicroSeconds();
 
 // Single loop was split into two loops. SSD samples patches in the first loop, and randomly
 // chooses a patch in the second loop. Sampling has to be done in the separate loop, before
@@ -200,15 +207,10 @@ void AnnotatedDataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
 #pragma omp single nowait
   {
     for (int item_id = 0; item_id < batch_size; ++item_id) {
-      timer.Start();
-      string* data = reader_.full().pop("Waiting for data");
-      timer.Stop();
-      read_time += timer.MicroSeconds();
-#pragma omp task firstprivate(item_id, data) shared(all_anno, expand_data, sampled_bboxes, have_samples)
+#pragma omp task firstprivate(item_id) shared(datums, all_anno, expand_data, sampled_bboxes, have_samples)
       {
         std::unique_ptr<AnnotatedDatum> anno_datum(new AnnotatedDatum());
-        anno_datum->ParseFromString(*data);
-        reader_.free().push(data);
+        anno_datum->ParseFromString(*datums[item_id]);
         std::unique_ptr<AnnotatedDatum> distort_datum(new AnnotatedDatum());
         boost::shared_ptr<AnnotatedDatum> expand_datum;
         if (transform_param.has_distort_param()) {
@@ -243,6 +245,7 @@ void AnnotatedDataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
       }
     }
 #pragma omp taskwait
+    reader_.free().push_n(&datums[0], batch_size);
     // RNG needs to be reinitialized because in some cases, when transform params are not set
     // RNG is a NULL.
     this->data_transformer_->ReinitRand();
@@ -416,13 +419,16 @@ void AnnotatedDataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
   map<int, vector<AnnotationGroup> > all_anno;
   int num_bboxes = 0;
 
+  vector<string*> datums(batch_size);
+  timer.Start();
+  reader_.full().pop_n(&datums[0], batch_size, "Waiting for data");
+  read_time += timer.MicroSeconds();
+
   for (int item_id = 0; item_id < batch_size; ++item_id) {
     timer.Start();
     // get a anno_datum
-    string* data = reader_.full().pop("Waiting for data");
     AnnotatedDatum anno_datum;
-    anno_datum.ParseFromString(*data);
-    reader_.free().push(data);
+    anno_datum.ParseFromString(*datums[item_id]);
     read_time += timer.MicroSeconds();
     timer.Start();
     AnnotatedDatum distort_datum;
@@ -532,6 +538,7 @@ void AnnotatedDataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
     }
     trans_time += timer.MicroSeconds();
   }
+  reader_.free().push_n(&datums[0], batch_size);
 
   // Store "rich" annotation if needed.
   if (this->output_labels_ && has_anno_type_) {
@@ -39,6 +39,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <functional>
 #include <utility>
 #include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "caffe/layers/argmax_layer.hpp"
 
@@ -103,30 +106,61 @@ void ArgMaxLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     axis_dist = 1;
   }
   int num = bottom[0]->count() / dim;
-  std::vector<std::pair<Dtype, int> > bottom_data_vector(dim);
-  for (int i = 0; i < num; ++i) {
-    for (int j = 0; j < dim; ++j) {
-      bottom_data_vector[j] = std::make_pair(
-        bottom_data[(i / axis_dist * dim + j) * axis_dist + i % axis_dist], j);
+  // Stores the j-th best (value, index) pair of instance i.
+  auto store = [&](int i, int j, Dtype value, int index) {
+    if (out_max_val_) {
+      if (has_axis_) {
+        // Produces max_val per axis
+        top_data[(i / axis_dist * top_k_ + j) * axis_dist + i % axis_dist]
+          = value;
+      } else {
+        // Produces max_ind and max_val
+        top_data[2 * i * top_k_ + j] = index;
+        top_data[2 * i * top_k_ + top_k_ + j] = value;
+      }
+    } else {
+      // Produces max_ind per axis
+      top_data[(i / axis_dist * top_k_ + j) * axis_dist + i % axis_dist]
+        = index;
     }
-    std::partial_sort(
-        bottom_data_vector.begin(), bottom_data_vector.begin() + top_k_,
-        bottom_data_vector.end(), std::greater<std::pair<Dtype, int> >());
-    for (int j = 0; j < top_k_; ++j) {
-      if (out_max_val_) {
-        if (has_axis_) {
-          // Produces max_val per axis
-          top_data[(i / axis_dist * top_k_ + j) * axis_dist + i % axis_dist]
-            = bottom_data_vector[j].first;
-        } else {
-          // Produces max_ind and max_val
-          top_data[2 * i * top_k_ + j] = bottom_data_vector[j].second;
-          top_data[2 * i * top_k_ + top_k_ + j] = bottom_data_vector[j].first;
+  };
+#ifdef _OPENMP
+  #pragma omp parallel if(num > 1)
+#endif
+  {
+    std::vector<std::pair<Dtype, int> > bottom_data_vector(
+        top_k_ > 1 ? dim : 0);
+#ifdef _OPENMP
+    #pragma omp for
+#endif
+    for (int i = 0; i < num; ++i) {
+      const Dtype* x = bottom_data + i / axis_dist * dim * axis_dist
+                       + i % axis_dist;
+      if (top_k_ == 1) {
+        // Vectorized max, then the last index holding it, which is the one
+        // partial_sort with std::greater on (value, index) pairs would pick
+        Dtype max_val = x[0];
+#ifdef _OPENMP
+        #pragma omp simd reduction(max: max_val)
+#endif
+        for (int j = 1; j < dim; ++j) {
+          max_val = x[j * axis_dist] > max_val ? x[j * axis_dist] : max_val;
         }
-      } else {
-        // Produces max_ind per axis
-        top_data[(i / axis_dist * top_k_ + j) * axis_dist + i % axis_dist]
-          = bottom_data_vector[j].second;
+        int max_ind = dim - 1;
+        while (max_ind > 0 && !(x[max_ind * axis_dist] == max_val)) {
+          --max_ind;
+        }
+        store(i, 0, max_val, max_ind);
+        continue;
+      }
+      for (int j = 0; j < dim; ++j) {
+        bottom_data_vector[j] = std::make_pair(x[j * axis_dist], j);
+      }
+      std::partial_sort(
+          bottom_data_vector.begin(), bottom_data_vector.begin() + top_k_,
+          bottom_data_vector.end(), std::greater<std::pair<Dtype, int> >());
+      for (int j = 0; j < top_k_; ++j) {
+        store(i, j, bottom_data_vector[j].first, bottom_data_vector[j].second);
       }
     }
   }
@@ -0,0 +1,177 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "caffe/layers/autotuned_conv_layer.hpp"
+#include "caffe/util/benchmark.hpp"
+
+namespace caffe {
+
+// Timed forward passes per candidate, after one untimed warm-up pass.
+static const int kAutotuneIterations = 3;
+
+template <typename Dtype>
+void AutotunedConvolutionLayer<Dtype>::LayerSetUp(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  WinogradConvolutionLayer<Dtype>::LayerSetUp(bottom, top);
+  direct_type_ = this->useAVX_t;
+  cache_.reset(new AutotuneCache(
+      this->layer_param_.convolution_param().autotune_cache()));
+  key_.clear();
+  choice_.clear();
+}
+
+template <typename Dtype>
+string AutotunedConvolutionLayer<Dtype>::TuningKey(
+    const vector<Blob<Dtype>*>& bottom) const {
+  std::ostringstream key;
+  key << "Convolution " << (sizeof(Dtype) == sizeof(float) ? "float" :
+                                                             "double")
+      << " input=" << bottom[0]->shape_string()
+      << " num_output=" << this->num_output_ << " group=" << this->group_;
+  const char* names[] = {"kernel", "stride", "pad", "dilation"};
+  const Blob<int>* params[] = {&this->kernel_shape_, &this->stride_,
+                               &this->pad_, &this->dilation_};
+  for (int p = 0; p < 4; ++p) {
+    key << " " << names[p] << "=";
+    for (int i = 0; i < this->num_spatial_axes_; ++i) {
+      key << (i ? "x" : "") << params[p]->cpu_data()[i];
+    }
+  }
+  key << " bottoms=" << bottom.size()
+      << " threads=" << this->num_of_threads_
+      << " cpu=" << AutotuneCache::CpuModel();
+  return key.str();
+}
+
+template <typename Dtype>
+vector<string> AutotunedConvolutionLayer<Dtype>::Candidates() const {
+  vector<string> candidates(1, "GEMM");
+  if (this->num_spatial_axes_ == 3 && direct_type_ != 0) {
+    candidates.push_back("DIRECT");
+  }
+  if (this->eligible_) {
+    candidates.push_back("WINOGRAD2");
+    if (this->num_spatial_axes_ == 2) {
+      candidates.push_back("WINOGRAD4");
+    }
+  }
+  return candidates;
+}
+
+template <typename Dtype>
+void AutotunedConvolutionLayer<Dtype>::Apply(const string& choice,
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  const int direct_type = choice == "DIRECT" ? direct_type_ : 0;
+  if (direct_type != this->useAVX_t) {
+    // ConvolutionLayer sets its buffers up for one of the two paths only.
+    this->useAVX_t = direct_type;
+    this->src_dims.clear();
+    ConvolutionLayer<Dtype>::Reshape(bottom, top);
+    this->srcsync = false;
+  }
+  const int tile = choice == "WINOGRAD2" ? 2 : choice == "WINOGRAD4" ? 4 : 0;
+  if (tile != 0 && tile != this->tile_out_[2]) {
+    this->SetTile(tile);
+  }
+  this->use_winograd_ = tile != 0;
+  this->ComputeNumTiles();
+  choice_ = choice;
+}
+
+template <typename Dtype>
+string AutotunedConvolutionLayer<Dtype>::Tune(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  const vector<string> candidates = Candidates();
+  string best = candidates[0];
+  if (candidates.size() == 1) {
+    return best;
+  }
+  float best_ms = 0;
+  CPUTimer timer;
+  for (int c = 0; c < candidates.size(); ++c) {
+    Apply(candidates[c], bottom, top);
+    this->Forward_cpu(bottom, top);
+    timer.Start();
+    for (int i = 0; i < kAutotuneIterations; ++i) {
+      this->Forward_cpu(bottom, top);
+    }
+    timer.Stop();
+    const float ms = timer.MilliSeconds() / kAutotuneIterations;
+    LOG(INFO) << this->layer_param_.name() << " autotuning: "
+              << candidates[c] << " " << ms << " ms";
+    if (c == 0 || ms < best_ms) {
+      best = candidates[c];
+      best_ms = ms;
+    }
+  }
+  return best;
+}
+
+template <typename Dtype>
+void AutotunedConvolutionLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  WinogradConvolutionLayer<Dtype>::Reshape(bottom, top);
+  // Quantized 3D layers have a single implementation, and the GPU path is
+  // ConvolutionLayer's.
+  if (this->quantize_3d_ || Caffe::mode() != Caffe::CPU) {
+    return;
+  }
+  const string key = TuningKey(bottom);
+  if (key != key_) {
+    key_ = key;
+    const vector<string> candidates = Candidates();
+    string choice;
+    if (!cache_->Find(key, &choice) ||
+        std::find(candidates.begin(), candidates.end(), choice) ==
+        candidates.end()) {
+      choice = Tune(bottom, top);
+      cache_->Insert(key, choice);
+      LOG(INFO) << this->layer_param_.name() << " autotuned to " << choice;
+    }
+    choice_ = choice;
+  }
+  Apply(choice_, bottom, top);
+}
+
+INSTANTIATE_CLASS(AutotunedConvolutionLayer);
+
+}  // namespace caffe
@@ -41,6 +41,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/filler.hpp"
 #include "caffe/layers/base_conv_layer.hpp"
 #include "caffe/util/im2col.hpp"
+#include "caffe/util/int8_math.hpp"
 #include "caffe/util/math_functions.hpp"
 
 #include "caffe/util/benchmark.hpp"
@@ -368,6 +369,38 @@ void BaseConvolutionLayer<Dtype>::forward_cpu_gemm(const Dtype* input,
   }
 }
 
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::forward_cpu_gemm_s8(const uint8_t* input,
+    const int8_t* weights, int32_t* output) {
+  CHECK_EQ(num_spatial_axes_, 3) << "Quantized CAFFE convolution is 3D only";
+  int tid = 0;
+#ifdef _OPENMP
+  tid = omp_get_thread_num() % num_of_threads_;
+#endif
+  size_t col_data_buffer_size = col_buffer_u8_mt_.size() / num_of_threads_;
+
+  const uint8_t* col_buff = input;
+  if (!is_1x1_) {
+    uint8_t* col_buff_mt = &col_buffer_u8_mt_[tid * col_data_buffer_size];
+    im3d2col_cpu(input, conv_in_channels_,
+        conv_input_shape_.cpu_data()[1], conv_input_shape_.cpu_data()[2],
+        conv_input_shape_.cpu_data()[3],
+        kernel_shape_.cpu_data()[0], kernel_shape_.cpu_data()[1],
+        kernel_shape_.cpu_data()[2],
+        pad_.cpu_data()[0], pad_.cpu_data()[1], pad_.cpu_data()[2],
+        stride_.cpu_data()[0], stride_.cpu_data()[1], stride_.cpu_data()[2],
+        dilation_.cpu_data()[0], dilation_.cpu_data()[1],
+        dilation_.cpu_data()[2], col_buff_mt);
+    col_buff = col_buff_mt;
+  }
+
+  for (int g = 0; g < group_; ++g) {
+    caffe_cpu_gemm_s8u8s32(conv_out_channels_ / group_, conv_out_spatial_dim_,
+        kernel_dim_, weights + weight_offset_ * g, col_buff + col_offset_ * g,
+        output + output_offset_ * g);
+  }
+}
+
 template <typename Dtype>
 void BaseConvolutionLayer<Dtype>::forward_cpu_bias(Dtype* output,
     const Dtype* bias) {
@@ -40,6 +40,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/filler.hpp"
 #include "caffe/layers/bias_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
@@ -110,6 +111,32 @@ void BiasLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) {
   const Dtype* bias_data =
       ((bottom.size() > 1) ? bottom[1] : this->blobs_[0].get())->cpu_data();
+  // Add per channel in the channel blocked layout an MKL-DNN layer left
+  int block = prv_channel_block(bottom[0]);
+  if (block > 0 && (outer_dim_ != bottom[0]->shape(0) ||
+                    bias_dim_ != bottom[0]->shape(1))) {
+    block = 0;
+  }
+  if (block > 0) {
+    const Dtype* bottom_data = bottom[0]->prv_data();
+    Dtype* top_data = mutable_prv_data_like(top[0], bottom[0]);
+    const int blocks = bias_dim_ / block;
+#ifdef _OPENMP
+    #pragma omp parallel for collapse(2)
+#endif
+    for (int n = 0; n < outer_dim_; ++n) {
+      for (int c = 0; c < blocks; ++c) {
+        const Dtype* bias = bias_data + c * block;
+        const int offset = (n * blocks + c) * inner_dim_ * block;
+        for (int i = 0; i < inner_dim_ * block; i += block) {
+          for (int b = 0; b < block; ++b) {
+            top_data[offset + i + b] = bottom_data[offset + i + b] + bias[b];
+          }
+        }
+      }
+    }
+    return;
+  }
   Dtype* top_data = top[0]->mutable_cpu_data();
   if (bottom[0] != top[0]) {
     const Dtype* bottom_data = bottom[0]->cpu_data();
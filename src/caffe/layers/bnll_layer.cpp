@@ -39,6 +39,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <vector>
 
 #include "caffe/layers/bnll_layer.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
@@ -47,8 +48,9 @@ const float kBNLL_THRESHOLD = 50.;
 template <typename Dtype>
 void BNLLLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
-  const Dtype* bottom_data = bottom[0]->cpu_data();
-  Dtype* top_data = top[0]->mutable_cpu_data();
+  const Dtype* bottom_data;
+  Dtype* top_data;
+  elementwise_data(bottom[0], top[0], &bottom_data, &top_data);
   const int count = bottom[0]->count();
   for (int i = 0; i < count; ++i) {
     top_data[i] = bottom_data[i] > 0 ?
@@ -43,6 +43,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "caffe/layers/concat_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
@@ -98,11 +99,24 @@ template <typename Dtype>
 void ConcatLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) {
   if (bottom.size() == 1) { return; }
-  Dtype* top_data = top[0]->mutable_cpu_data();
+  // Bottoms in the same channel blocked layout hold every image as whole
+  // channel blocks, so they concatenate along channels like plain ones.
+  int block = concat_axis_ == 1 ? prv_channel_block(bottom[0]) : 0;
+  for (int i = 1; block > 0 && i < bottom.size(); ++i) {
+    if (prv_channel_block(bottom[i]) != block) {
+      block = 0;
+    }
+  }
+  Dtype* top_data = block > 0 ? mutable_prv_data_like(top[0], bottom[0]) : NULL;
+  const bool prv = top_data != NULL;
+  if (!prv) {
+    top_data = top[0]->mutable_cpu_data();
+  }
   int offset_concat_axis = 0;
   const int top_concat_axis = top[0]->shape(concat_axis_);
   for (int i = 0; i < bottom.size(); ++i) {
-    const Dtype* bottom_data = bottom[i]->cpu_data();
+    const Dtype* bottom_data =
+        prv ? bottom[i]->prv_data() : bottom[i]->cpu_data();
     const int bottom_concat_axis = bottom[i]->shape(concat_axis_);
     const int offset_value = offset_concat_axis;
     offset_concat_axis += bottom_concat_axis;
@@ -35,6 +35,7 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cmath>
 #include <vector>
 #ifdef _OPENMP
 #include <omp.h>
@@ -43,6 +44,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "caffe/layers/conv_layer.hpp"
 #include "caffe/util/benchmark.hpp"
+#include "caffe/util/int8_math.hpp"
 #include "mkldnn.hpp"
 #include <stdio.h>
 
@@ -102,6 +104,43 @@ void ConvolutionLayer<Dtype>::LayerSetUp(const vector<Blob<Dtype>*>& bottom, con
     useAVX_t = 0;
   }
   src_dims.clear();
+
+  quantize_3d_ = false;
+  quantized_weight_mem_ = NULL;
+  if (this->num_spatial_axes_ == 3 && this->phase_ == TEST &&
+      this->layer_param_.has_quantization_param()) {
+    const QuantizationParameter& quant_param =
+        this->layer_param_.quantization_param();
+    scale_params_.clear();
+    if (quant_param.scale_in_size() > 0) {
+      scale_in_ = quant_param.scale_in(0);
+      for (int i = 0; i < quant_param.scale_params_size(); ++i) {
+        scale_params_.push_back(quant_param.scale_params(i));
+      }
+    } else {
+      CHECK_GT(quant_param.fl_layer_in_size(), 0)
+          << "Layer " << this->layer_param_.name()
+          << " has neither scale_in nor fl_layer_in";
+      scale_in_ = pow(2., quant_param.fl_layer_in(0));
+      for (int i = 0; i < quant_param.fl_params_size(); ++i) {
+        scale_params_.push_back(pow(2., quant_param.fl_params(i)));
+      }
+    }
+    CHECK(scale_params_.size() == 1 || scale_params_.size() == this->num_output_)
+        << "Layer " << this->layer_param_.name() << " needs 1 or num_output "
+        << "weight scales, got " << scale_params_.size();
+    CHECK_GT(scale_in_, 0);
+    for (int i = 0; i < scale_params_.size(); ++i) {
+      CHECK_GT(scale_params_[i], 0);
+    }
+    // The int8 GEMM replaces the f32 MKL-DNN slices for this layer
+    quantize_3d_ = true;
+    useAVX_t = 0;
+  }
+
+  if (this->layer_param_.has_fused_pointwise_param()) {
+    epilogue_.InitEpilogue(this->layer_param_.fused_pointwise_param());
+  }
 }
 
 template <typename Dtype>
@@ -521,6 +560,14 @@ void ConvolutionLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
     for (int i = 0; i < this->num_spatial_axes_ + 2; ++i) {
       src_dims.push_back(bottom_dims[i]);
     }
+    if (quantize_3d_) {
+      vector<Dtype>().swap(this->col_buffer_mt_);
+      this->col_buffer_u8_mt_.resize(this->col_buffer_mt_size);
+      weight_s8_.resize(this->blobs_[0]->count());
+      input_u8_.resize(this->bottom_dim_);
+      output_s32_.resize(this->top_dim_);
+      dequant_scale_.resize(this->num_output_);
+    }
     if (useAVX_t != 0) {
       try {
         this->col_buffer_.Reshape(1, 1, 1, 1);
@@ -583,6 +630,54 @@ void ConvolutionLayer<Dtype>::Forward_3D(const vector<Blob<Dtype>*>& bottom,
   }
 }
 
+template <typename Dtype>
+void ConvolutionLayer<Dtype>::QuantizeWeights() {
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+  const int weight_dim = this->blobs_[0]->count() / this->num_output_;
+  for (int o = 0; o < this->num_output_; ++o) {
+    const float scale_w = (scale_params_.size() == 1) ?
+                          scale_params_[0] : scale_params_[o];
+    caffe_cpu_quantize_s8(weight_dim, weight + o * weight_dim, scale_w,
+                          weight_s8_.data() + o * weight_dim);
+    dequant_scale_[o] = 1.f / (scale_in_ * scale_w);
+  }
+  quantized_weight_mem_ = this->blobs_[0]->data().get();
+  quantized_weight_version_ = quantized_weight_mem_->version();
+}
+
+template <typename Dtype>
+void ConvolutionLayer<Dtype>::Forward_3D_int8(const vector<Blob<Dtype>*>& bottom,
+                                              const vector<Blob<Dtype>*>& top) {
+  // Requantized only when weights were copied in after SetUp, folded by
+  // Net::CompileNet or shared from another net since the last call
+  const SyncedMemory* weight_mem = this->blobs_[0]->data().get();
+  if (weight_mem != quantized_weight_mem_ ||
+      weight_mem->version() != quantized_weight_version_) {
+    QuantizeWeights();
+  }
+  const Dtype* bias = this->bias_term_ ? this->blobs_[1]->cpu_data() : NULL;
+
+  // num_of_threads_ is 1 for 3D; the kernels parallelize internally
+  for (int i = 0; i < bottom.size(); ++i) {
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    Dtype* top_data = top[i]->mutable_cpu_data();
+    for (int n = 0; n < this->num_; ++n) {
+      caffe_cpu_quantize_u8(this->bottom_dim_,
+                            bottom_data + n * this->bottom_dim_, scale_in_,
+                            input_u8_.data());
+      this->forward_cpu_gemm_s8(input_u8_.data(), weight_s8_.data(),
+                                output_s32_.data());
+      caffe_cpu_dequantize_s32(this->num_output_, this->out_spatial_dim_,
+                               output_s32_.data(), dequant_scale_.data(), bias,
+                               top_data + n * this->top_dim_);
+      if (!epilogue_.empty()) {
+        epilogue_.Forward(top_data + n * this->top_dim_, 1,
+            this->num_output_, this->out_spatial_dim_);
+      }
+    }
+  }
+}
+
 template <typename Dtype>
 void ConvolutionLayer<Dtype>::Backward_data_3D(const vector<Blob<Dtype>*>& bottom,
                                                const vector<Blob<Dtype>*>& top) {
@@ -628,8 +723,16 @@ void ConvolutionLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   // If we have more threads available than batches to be prcessed then
   // we are wasting resources (lower batches than 36 on XeonE5)
   // So we instruct MKL
-  if (this->num_spatial_axes_ == 3 && useAVX_t != 0) {
+  if (quantize_3d_) {
+    Forward_3D_int8(bottom, top);
+  } else if (this->num_spatial_axes_ == 3 && useAVX_t != 0) {
     Forward_3D(bottom,top);
+    if (!epilogue_.empty()) {
+      for (int i = 0; i < top.size(); ++i) {
+        epilogue_.Forward(top[i]->mutable_cpu_data(), this->num_,
+            this->num_output_, this->out_spatial_dim_);
+      }
+    }
   } else {
     for (int i = 0; i < bottom.size(); ++i) {
       const Dtype* bottom_data = bottom[i]->cpu_data();
@@ -649,6 +752,11 @@ void ConvolutionLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
             const Dtype* bias = this->blobs_[1]->cpu_data();
             this->forward_cpu_bias(top_data + n * this->top_dim_, bias);
           }
+          if (!epilogue_.empty()) {
+            // Applied while the image is still in cache
+            epilogue_.Forward(top_data + n * this->top_dim_, 1,
+                this->num_output_, this->out_spatial_dim_, false);
+          }
         }
       }
     }
@@ -736,6 +844,8 @@ template <typename Dtype>
 void ConvolutionLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
                                            const vector<bool>& propagate_down,
                                            const vector<Blob<Dtype>*>& bottom) {
+  CHECK(epilogue_.empty()) << "Fused pointwise epilogue is forward only";
+  CHECK(!quantize_3d_) << "Quantized convolution is forward only";
 
   if (this->num_spatial_axes_ == 3 && useAVX_t != 0) {
     Backward_data_3D(bottom,top);
@@ -39,12 +39,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <opencv2/core/core.hpp>
 #endif  // USE_OPENCV
 #include <stdint.h>
+#include <sstream>
 #include <string>
 #include <vector>
 
 #include "caffe/data_transformer.hpp"
 #include "caffe/layers/data_layer.hpp"
 #include "caffe/util/benchmark.hpp"
+#include "caffe/util/decoded_image_cache.hpp"
+#include "caffe/util/io.hpp"
 
 namespace caffe {
 
@@ -63,6 +66,21 @@ template <typename Dtype>
 void DataLayer<Dtype>::DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) {
   const int batch_size = this->layer_param_.data_param().batch_size();
+  const string& cache_dir = this->layer_param_.data_param().decoded_cache_dir();
+  if (!cache_dir.empty()) {
+#ifdef USE_OPENCV
+    const TransformationParameter& transform_param =
+        this->layer_param_.transform_param();
+    std::ostringstream key;
+    key << "Data " << this->layer_param_.data_param().source() << " color="
+        << (transform_param.force_color() ? "color" :
+            transform_param.force_gray() ? "gray" : "native");
+    decoded_cache_.reset(new DecodedImageCache(cache_dir, key.str(),
+        this->layer_param_.data_param().decoded_cache_size_mb()));
+#else
+    LOG(FATAL) << "decoded_cache_dir requires OpenCV; compile with USE_OPENCV.";
+#endif  // USE_OPENCV
+  }
   // Read a data point, and use it to initialize the top blob.
   Datum datum;
   datum.ParseFromString(*(reader_.full().peek()));
@@ -74,8 +92,8 @@ void DataLayer<Dtype>::DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
   top_shape[0] = batch_size;
 
   top[0]->Reshape(top_shape);
-  for (int i = 0; i < this->PREFETCH_COUNT; ++i) {
-    this->prefetch_[i].data_.Reshape(top_shape);
+  for (int i = 0; i < this->prefetch_.size(); ++i) {
+    this->prefetch_[i]->data_.Reshape(top_shape);
   }
   LOG(INFO) << "output data size: " << top[0]->num() << ","
       << top[0]->channels() << "," << top[0]->height() << ","
@@ -84,12 +102,28 @@ void DataLayer<Dtype>::DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
   if (this->output_labels_) {
     vector<int> label_shape(1, batch_size);
     top[1]->Reshape(label_shape);
-    for (int i = 0; i < this->PREFETCH_COUNT; ++i) {
-      this->prefetch_[i].label_.Reshape(label_shape);
+    for (int i = 0; i < this->prefetch_.size(); ++i) {
+      this->prefetch_[i]->label_.Reshape(label_shape);
     }
   }
 }
 
+#ifdef USE_OPENCV
+template <typename Dtype>
+cv::Mat DataLayer<Dtype>::DecodeDatum(const Datum& datum) {
+  cv::Mat cached = decoded_cache_->Find(datum.data());
+  if (cached.data) {
+    return cached;
+  }
+  const TransformationParameter& param = this->layer_param_.transform_param();
+  cv::Mat cv_img = (param.force_color() || param.force_gray()) ?
+      DecodeDatumToCVMat(datum, param.force_color()) :
+      DecodeDatumToCVMatNative(datum);
+  decoded_cache_->Insert(datum.data(), cv_img);
+  return cv_img;
+}
+#endif  // USE_OPENCV
+
 // This function is called on prefetch thread
 template<typename Dtype>
 void DataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
@@ -126,30 +160,31 @@ void DataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
     top_label = batch->label_.mutable_cpu_data();
   }
 
+  // Take the whole batch of serialized datums from the reader in one go,
+  // and hand the buffers back together once they have been parsed.
+  vector<string*> datums(batch_size);
   trans_timer.Start();
+  timer.Start();
+  reader_.full().pop_n(&datums[0], batch_size, "Waiting for data");
+  timer.Stop();
+  read_time += timer.MicroSeconds();
 #ifdef _OPENMP
   #pragma omp parallel if (batch_size > 1)
   #pragma omp single nowait
 #endif
   for (int item_id = 0; item_id < batch_size; ++item_id) {
-    timer.Start();
-    // get a datum
-    string* data = (reader_.full().pop("Waiting for data"));
-    timer.Stop();
-    read_time += timer.MicroSeconds();
     // Apply data transformations (mirror, scale, crop...)
     int offset = batch->data_.offset(item_id);
 
 #ifdef _OPENMP
     PreclcRandomNumbers precalculated_rand_numbers;
     this->data_transformer_->GenerateRandNumbers(precalculated_rand_numbers);
-    #pragma omp task firstprivate(offset, precalculated_rand_numbers, data, item_id)
+    #pragma omp task firstprivate(offset, precalculated_rand_numbers, item_id)
 #endif
     {
       Datum datum;
-      datum.ParseFromString(*data);
-      (reader_.free()).push(data);  
-      // Copy label. We need to copy it before we release datum
+      datum.ParseFromString(*datums[item_id]);
+      // Copy label.
       if (this->output_labels_) {
         top_label[item_id] = datum.label();
       }
@@ -157,14 +192,29 @@ void DataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
       Blob<Dtype> tmp_data;
       tmp_data.Reshape(top_shape);
       tmp_data.set_cpu_data(top_data + offset);
-      this->data_transformer_->Transform(datum, &tmp_data,
-                                              precalculated_rand_numbers);
+      if (decoded_cache_ && datum.encoded()) {
+#ifdef USE_OPENCV
+        this->data_transformer_->Transform(DecodeDatum(datum), &tmp_data,
+                                                precalculated_rand_numbers);
+#endif  // USE_OPENCV
+      } else {
+        this->data_transformer_->Transform(datum, &tmp_data,
+                                                precalculated_rand_numbers);
+      }
 #else
       this->transformed_data_.set_cpu_data(top_data + offset);
-      this->data_transformer_->Transform(datum, &(this->transformed_data_));
+      if (decoded_cache_ && datum.encoded()) {
+#ifdef USE_OPENCV
+        this->data_transformer_->Transform(DecodeDatum(datum),
+                                           &(this->transformed_data_));
+#endif  // USE_OPENCV
+      } else {
+        this->data_transformer_->Transform(datum, &(this->transformed_data_));
+      }
 #endif
     }
   }
+  reader_.free().push_n(&datums[0], batch_size);
   trans_timer.Stop();
   batch_timer.Stop();
   // Due to multithreaded nature of transformation,
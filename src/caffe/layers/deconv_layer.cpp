@@ -35,12 +35,15 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
+#include <utility>
 #include <vector>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
 #include "caffe/layers/deconv_layer.hpp"
+#include "caffe/util/math_functions.hpp"
 
 namespace caffe {
 
@@ -61,10 +64,221 @@ void DeconvolutionLayer<Dtype>::compute_output_shape() {
   }
 }
 
+template <typename Dtype>
+bool DeconvolutionLayer<Dtype>::use_subpixel() {
+  if (!this->layer_param_.convolution_param().subpixel_deconv() ||
+      this->num_spatial_axes_ > 3) {
+    return false;
+  }
+  // Unit-stride deconvolutions have no scatter overlap to avoid and are
+  // better served by GEMM.
+  const int* stride_data = this->stride_.cpu_data();
+  for (int i = 0; i < this->num_spatial_axes_; ++i) {
+    if (stride_data[i] > 1) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Along one spatial axis, output y receives kernel tap k from input
+// x = (y + pad - k * dilation) / stride when that division is exact. Outputs
+// with the same phase y % stride therefore share one set of taps, and each
+// phase is an ordinary stride-1 convolution of the input with a slice of the
+// kernel: one GEMM per (image, phase) whose result is written, not
+// scatter-added, into the interleaved output.
+template <typename Dtype>
+void DeconvolutionLayer<Dtype>::forward_cpu_subpixel(const Dtype* bottom_data,
+    const Dtype* weight, const Dtype* bias, Dtype* top_data) {
+  // 1D and 2D are handled as 3D with leading singleton axes.
+  int in_shape[3] = {1, 1, 1};
+  int out_shape[3] = {1, 1, 1};
+  int kernel[3] = {1, 1, 1};
+  int stride[3] = {1, 1, 1};
+  int pad[3] = {0, 0, 0};
+  int dilation[3] = {1, 1, 1};
+  const int first_axis = 3 - this->num_spatial_axes_;
+  for (int i = 0; i < this->num_spatial_axes_; ++i) {
+    in_shape[first_axis + i] = this->input_shape(i + 1);
+    out_shape[first_axis + i] = this->output_shape_[i];
+    kernel[first_axis + i] = this->kernel_shape_.cpu_data()[i];
+    stride[first_axis + i] = this->stride_.cpu_data()[i];
+    pad[first_axis + i] = this->pad_.cpu_data()[i];
+    dilation[first_axis + i] = this->dilation_.cpu_data()[i];
+  }
+
+  // Per axis and phase: the phase length and its (tap, input shift) pairs.
+  vector<int> phase_size[3];
+  vector<vector<std::pair<int, int> > > phase_taps[3];
+  for (int a = 0; a < 3; ++a) {
+    phase_size[a].resize(stride[a]);
+    phase_taps[a].resize(stride[a]);
+    for (int r = 0; r < stride[a]; ++r) {
+      phase_size[a][r] = r < out_shape[a] ?
+          (out_shape[a] - r + stride[a] - 1) / stride[a] : 0;
+      for (int k = 0; k < kernel[a]; ++k) {
+        const int offset = r + pad[a] - k * dilation[a];
+        if (offset % stride[a] == 0) {
+          phase_taps[a][r].push_back(std::make_pair(k, offset / stride[a]));
+        }
+      }
+    }
+  }
+
+  const int out_channels = this->num_output_;
+  const int in_channels = this->channels_;
+  const int group_out = out_channels / this->group_;
+  const int group_in = in_channels / this->group_;
+  const int kernel_dim = kernel[0] * kernel[1] * kernel[2];
+  const int in_dim = in_shape[0] * in_shape[1] * in_shape[2];
+  const int out_dim = out_shape[0] * out_shape[1] * out_shape[2];
+  const int num_phases = stride[0] * stride[1] * stride[2];
+
+  // Gather the weight slice of every phase as a
+  // group_out x (group_in * phase taps) matrix per group.
+  vector<vector<Dtype> > phase_weight(num_phases);
+  size_t max_col_size = 0;
+  size_t max_out_size = 0;
+  for (int p = 0; p < num_phases; ++p) {
+    const int r[3] = {p / (stride[1] * stride[2]), (p / stride[2]) % stride[1],
+                      p % stride[2]};
+    const vector<std::pair<int, int> >& taps_d = phase_taps[0][r[0]];
+    const vector<std::pair<int, int> >& taps_h = phase_taps[1][r[1]];
+    const vector<std::pair<int, int> >& taps_w = phase_taps[2][r[2]];
+    const int num_taps = taps_d.size() * taps_h.size() * taps_w.size();
+    const int phase_dim =
+        phase_size[0][r[0]] * phase_size[1][r[1]] * phase_size[2][r[2]];
+    max_col_size = std::max(max_col_size,
+        static_cast<size_t>(group_in) * num_taps * phase_dim);
+    max_out_size = std::max(max_out_size,
+        static_cast<size_t>(group_out) * phase_dim);
+    phase_weight[p].resize(static_cast<size_t>(this->group_) * group_out *
+                           group_in * num_taps);
+    Dtype* packed = phase_weight[p].empty() ? NULL : &phase_weight[p][0];
+    for (int g = 0; g < this->group_; ++g) {
+      for (int co = 0; co < group_out; ++co) {
+        for (int ci = 0; ci < group_in; ++ci) {
+          const Dtype* w = weight +
+              ((g * group_in + ci) * group_out + co) * kernel_dim;
+          for (int td = 0; td < taps_d.size(); ++td) {
+            for (int th = 0; th < taps_h.size(); ++th) {
+              for (int tw = 0; tw < taps_w.size(); ++tw) {
+                *packed++ = w[(taps_d[td].first * kernel[1] +
+                               taps_h[th].first) * kernel[2] +
+                              taps_w[tw].first];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Every (image, phase) task writes a disjoint set of outputs.
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    vector<Dtype> col(max_col_size);
+    vector<Dtype> out(max_out_size);
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int i = 0; i < this->num_ * num_phases; ++i) {
+      const int n = i / num_phases;
+      const int p = i % num_phases;
+      const int r[3] = {p / (stride[1] * stride[2]),
+                        (p / stride[2]) % stride[1], p % stride[2]};
+      const vector<std::pair<int, int> >& taps_d = phase_taps[0][r[0]];
+      const vector<std::pair<int, int> >& taps_h = phase_taps[1][r[1]];
+      const vector<std::pair<int, int> >& taps_w = phase_taps[2][r[2]];
+      const int num_taps = taps_d.size() * taps_h.size() * taps_w.size();
+      const int size_d = phase_size[0][r[0]];
+      const int size_h = phase_size[1][r[1]];
+      const int size_w = phase_size[2][r[2]];
+      const int phase_dim = size_d * size_h * size_w;
+      if (phase_dim == 0) {
+        continue;
+      }
+      for (int g = 0; g < this->group_; ++g) {
+        if (num_taps > 0) {
+          // Gather the shifted input rows of every (channel, tap) pair,
+          // zero-filling whatever falls outside the input.
+          Dtype* col_row = &col[0];
+          for (int ci = 0; ci < group_in; ++ci) {
+            const Dtype* in_c =
+                bottom_data + (n * in_channels + g * group_in + ci) * in_dim;
+            for (int td = 0; td < taps_d.size(); ++td) {
+              for (int th = 0; th < taps_h.size(); ++th) {
+                for (int tw = 0; tw < taps_w.size(); ++tw) {
+                  const int shift_w = taps_w[tw].second;
+                  const int w_begin = std::min(std::max(0, -shift_w), size_w);
+                  const int w_end =
+                      std::max(std::min(size_w, in_shape[2] - shift_w), w_begin);
+                  for (int jd = 0; jd < size_d; ++jd) {
+                    const int xd = jd + taps_d[td].second;
+                    for (int jh = 0; jh < size_h; ++jh, col_row += size_w) {
+                      const int xh = jh + taps_h[th].second;
+                      if (xd < 0 || xd >= in_shape[0] ||
+                          xh < 0 || xh >= in_shape[1]) {
+                        std::fill(col_row, col_row + size_w, Dtype(0));
+                        continue;
+                      }
+                      const Dtype* in_row = in_c +
+                          (xd * in_shape[1] + xh) * in_shape[2] + shift_w;
+                      std::fill(col_row, col_row + w_begin, Dtype(0));
+                      std::copy(in_row + w_begin, in_row + w_end,
+                                col_row + w_begin);
+                      std::fill(col_row + w_end, col_row + size_w, Dtype(0));
+                    }
+                  }
+                }
+              }
+            }
+          }
+          caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, group_out,
+              phase_dim, group_in * num_taps, (Dtype)1.,
+              &phase_weight[p][0] +
+                  static_cast<size_t>(g) * group_out * group_in * num_taps,
+              &col[0], (Dtype)0., &out[0]);
+        } else {
+          std::fill(out.begin(), out.begin() + group_out * phase_dim,
+                    Dtype(0));
+        }
+        // Interleave the phase into the output, adding the bias.
+        for (int co = 0; co < group_out; ++co) {
+          const Dtype bias_value = bias ? bias[g * group_out + co] : Dtype(0);
+          const Dtype* src = &out[0] + co * phase_dim;
+          Dtype* dst = top_data +
+              (n * out_channels + g * group_out + co) * out_dim;
+          for (int jd = 0; jd < size_d; ++jd) {
+            for (int jh = 0; jh < size_h; ++jh, src += size_w) {
+              Dtype* dst_row = dst +
+                  ((r[0] + jd * stride[0]) * out_shape[1] +
+                   r[1] + jh * stride[1]) * out_shape[2] + r[2];
+              for (int jw = 0; jw < size_w; ++jw) {
+                dst_row[jw * stride[2]] = src[jw] + bias_value;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 template <typename Dtype>
 void DeconvolutionLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) {
   const Dtype* weight = this->blobs_[0]->cpu_data();
+  if (use_subpixel()) {
+    const Dtype* bias = this->bias_term_ ? this->blobs_[1]->cpu_data() : NULL;
+    for (int i = 0; i < bottom.size(); ++i) {
+      forward_cpu_subpixel(bottom[i]->cpu_data(), weight, bias,
+                           top[i]->mutable_cpu_data());
+    }
+    return;
+  }
   for (int i = 0; i < bottom.size(); ++i) {
     const Dtype* bottom_data = bottom[i]->cpu_data();
     Dtype* top_data = top[i]->mutable_cpu_data();
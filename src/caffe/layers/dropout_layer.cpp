@@ -41,6 +41,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "caffe/layers/dropout_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
@@ -67,8 +68,15 @@ void DropoutLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
 template <typename Dtype>
 void DropoutLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
-  const Dtype* bottom_data = bottom[0]->cpu_data();
-  Dtype* top_data = top[0]->mutable_cpu_data();
+  const Dtype* bottom_data;
+  Dtype* top_data;
+  if (this->phase_ == TRAIN) {
+    // The mask is kept in the plain layout Backward_cpu reads top_diff in
+    bottom_data = bottom[0]->cpu_data();
+    top_data = top[0]->mutable_cpu_data();
+  } else {
+    elementwise_data(bottom[0], top[0], &bottom_data, &top_data);
+  }
   unsigned int* mask = rand_vec_.mutable_cpu_data();
   const size_t count = bottom[0]->count();
   if (this->phase_ == TRAIN) {
@@ -85,6 +85,10 @@ void DummyDataLayer<Dtype>::LayerSetUp(const vector<Blob<Dtype>*>& bottom,
   // filled again.
   refill_.clear();
   fillers_.clear();
+  // The tops are data, not parameters that trained weights replace, so they
+  // are filled even while the net skips parameter fills.
+  const bool skip_param_fill = Caffe::skip_param_fill();
+  Caffe::set_skip_param_fill(false);
   if (num_data_filler <= 1) {
     FillerParameter filler_param;
     if (num_data_filler == 0) {
@@ -110,6 +114,7 @@ void DummyDataLayer<Dtype>::LayerSetUp(const vector<Blob<Dtype>*>& bottom,
           (strcmp(param.data_filler(i).type().c_str(), "constant") == 0);
     }
   }
+  Caffe::set_skip_param_fill(skip_param_fill);
   for (int i = 0; i < num_top; ++i) {
     if (legacy_dims) {
       const int num = (param.num_size() == 1) ? param.num(0) : param.num(i);
@@ -40,6 +40,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "caffe/layers/eltwise_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
@@ -87,19 +88,32 @@ void EltwiseLayer<Dtype>::Forward_cpu(
   const Dtype* bottom_data_a = NULL;
   const Dtype* bottom_data_b = NULL;
   const int count = top[0]->count();
-  Dtype* top_data = top[0]->mutable_cpu_data();
+  // Work in the private layout the bottoms share, if any. The MAX mask is
+  // indexed in the plain layout of the diffs, so it needs plain data to train.
+  bool prv = op_ != EltwiseParameter_EltwiseOp_MAX || this->phase_ == TEST;
+  for (int i = 0; prv && i < bottom.size(); ++i) {
+    prv = prv_layout_matches(bottom[i], bottom[0]);
+  }
+  Dtype* top_data = prv ? mutable_prv_data_like(top[0], bottom[0]) : NULL;
+  vector<const Dtype*> bottom_data(bottom.size());
+  for (int i = 0; i < bottom.size(); ++i) {
+    bottom_data[i] = top_data ? bottom[i]->prv_data() : bottom[i]->cpu_data();
+  }
+  if (!top_data) {
+    top_data = top[0]->mutable_cpu_data();
+  }
   switch (op_) {
   case EltwiseParameter_EltwiseOp_PROD:
-    caffe_mul(count, bottom[0]->cpu_data(), bottom[1]->cpu_data(), top_data);
+    caffe_mul(count, bottom_data[0], bottom_data[1], top_data);
     for (int i = 2; i < bottom.size(); ++i) {
-      caffe_mul(count, top_data, bottom[i]->cpu_data(), top_data);
+      caffe_mul(count, top_data, bottom_data[i], top_data);
     }
     break;
   case EltwiseParameter_EltwiseOp_SUM:
     caffe_set(count, Dtype(0), top_data);
     // TODO(shelhamer) does BLAS optimize to sum for coeff = 1?
     for (int i = 0; i < bottom.size(); ++i) {
-      caffe_axpy(count, coeffs_[i], bottom[i]->cpu_data(), top_data);
+      caffe_axpy(count, coeffs_[i], bottom_data[i], top_data);
     }
     break;
   case EltwiseParameter_EltwiseOp_MAX:
@@ -108,8 +122,8 @@ void EltwiseLayer<Dtype>::Forward_cpu(
     caffe_set(count, -1, mask);
     caffe_set(count, Dtype(-FLT_MAX), top_data);
     // bottom 0 & 1
-    bottom_data_a = bottom[0]->cpu_data();
-    bottom_data_b = bottom[1]->cpu_data();
+    bottom_data_a = bottom_data[0];
+    bottom_data_b = bottom_data[1];
     for (int idx = 0; idx < count; ++idx) {
       if (bottom_data_a[idx] > bottom_data_b[idx]) {
         top_data[idx] = bottom_data_a[idx];  // maxval
@@ -121,7 +135,7 @@ void EltwiseLayer<Dtype>::Forward_cpu(
     }
     // bottom 2++
     for (int blob_idx = 2; blob_idx < bottom.size(); ++blob_idx) {
-      bottom_data_b = bottom[blob_idx]->cpu_data();
+      bottom_data_b = bottom_data[blob_idx];
       for (int idx = 0; idx < count; ++idx) {
         if (bottom_data_b[idx] > top_data[idx]) {
           top_data[idx] = bottom_data_b[idx];  // maxval
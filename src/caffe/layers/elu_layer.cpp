@@ -39,14 +39,16 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <vector>
 
 #include "caffe/layers/elu_layer.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
 template <typename Dtype>
 void ELULayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
-  const Dtype* bottom_data = bottom[0]->cpu_data();
-  Dtype* top_data = top[0]->mutable_cpu_data();
+  const Dtype* bottom_data;
+  Dtype* top_data;
+  elementwise_data(bottom[0], top[0], &bottom_data, &top_data);
   const int count = bottom[0]->count();
   Dtype alpha = this->layer_param_.elu_param().alpha();
 #ifdef _OPENMP
@@ -35,6 +35,7 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
 #include <vector>
 
 #include "caffe/filler.hpp"
@@ -80,6 +81,8 @@ void EmbedLayer<Dtype>::LayerSetUp(const vector<Blob<Dtype>*>& bottom,
     }
   }  // parameter initialization
   this->param_propagate_down_.resize(this->blobs_.size(), true);
+  this->blobs_[0]->set_diff_row_sparse(
+      this->layer_param_.embed_param().sparse_gradient());
 }
 
 template <typename Dtype>
@@ -137,6 +140,16 @@ void EmbedLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
           << "non-integer input";
       caffe_axpy(N_, Dtype(1), top_diff + n * N_, weight_diff + index * N_);
     }
+    if (this->blobs_[0]->diff_rows()) {
+      // Record the looked-up rows so that only they get cleared and updated.
+      vector<int> rows(M_);
+      for (int n = 0; n < M_; ++n) {
+        rows[n] = static_cast<int>(bottom_data[n]);
+      }
+      std::sort(rows.begin(), rows.end());
+      rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+      this->blobs_[0]->AddDiffRows(rows);
+    }
   }
   if (bias_term_ && this->param_propagate_down_[1]) {
     const Dtype* top_diff = top[0]->cpu_diff();
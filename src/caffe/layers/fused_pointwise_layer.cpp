@@ -0,0 +1,102 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string>
+#include <vector>
+
+#include "caffe/layers/fused_pointwise_layer.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void FusedPointwiseLayer<Dtype>::LayerSetUp(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top) {
+  const LayerParameter& param = this->layer_param_;
+  CHECK(param.has_fused_pointwise_param())
+      << "FusedPointwise layer " << param.name() << " has no ops";
+  vector<string> operand_names(param.bottom().begin() + 1,
+      param.bottom().end());
+  chain_.Init(param.fused_pointwise_param(), param.bottom(0), operand_names);
+  if (this->blobs_.size() > 0) {
+    CHECK_EQ(this->blobs_.size(), chain_.num_param_blobs())
+        << "Incorrect number of weight blobs.";
+    LOG(INFO) << "Skipping parameter initialization";
+  } else {
+    const int channels = bottom[0]->num_axes() > 1 ? bottom[0]->shape(1) : 1;
+    chain_.InitParamBlobs(channels, &this->blobs_);
+  }
+  this->param_propagate_down_.resize(this->blobs_.size(), false);
+}
+
+template <typename Dtype>
+void FusedPointwiseLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top) {
+  for (int i = 1; i < bottom.size(); ++i) {
+    CHECK(bottom[i]->shape() == bottom[0]->shape())
+        << "All inputs of a fused Eltwise must have the same shape";
+  }
+  const int channels = bottom[0]->num_axes() > 1 ? bottom[0]->shape(1) : 1;
+  for (int i = 0; i < this->blobs_.size(); ++i) {
+    CHECK_EQ(this->blobs_[i]->count(), channels)
+        << "Fused Scale/Bias parameters must be per-channel";
+  }
+  top[0]->ReshapeLike(*bottom[0]);
+}
+
+template <typename Dtype>
+void FusedPointwiseLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  vector<const Dtype*> operands;
+  for (int i = 1; i < bottom.size(); ++i) {
+    operands.push_back(bottom[i]->cpu_data());
+  }
+  vector<const Dtype*> params;
+  for (int i = 0; i < this->blobs_.size(); ++i) {
+    params.push_back(this->blobs_[i]->cpu_data());
+  }
+  const Blob<Dtype>& input = *bottom[0];
+  const int outer = input.num_axes() > 0 ? input.shape(0) : 1;
+  const int channels = input.num_axes() > 1 ? input.shape(1) : 1;
+  const int inner = input.num_axes() > 2 ? input.count(2) : 1;
+  chain_.Forward(input.cpu_data(), top[0]->mutable_cpu_data(), operands,
+      params, outer, channels, inner);
+}
+
+INSTANTIATE_CLASS(FusedPointwiseLayer);
+REGISTER_LAYER_CLASS(FusedPointwise);
+
+}  // namespace caffe
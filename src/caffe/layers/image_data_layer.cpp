@@ -40,6 +40,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <fstream>  // NOLINT(readability/streams)
 #include <iostream>  // NOLINT(readability/streams)
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -48,6 +49,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/layers/base_data_layer.hpp"
 #include "caffe/layers/image_data_layer.hpp"
 #include "caffe/util/benchmark.hpp"
+#include "caffe/util/decoded_image_cache.hpp"
 #include "caffe/util/io.hpp"
 #include "caffe/util/math_functions.hpp"
 #include "caffe/util/rng.hpp"
@@ -77,6 +79,18 @@ void ImageDataLayer<Dtype>::DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
   CHECK((min_height == 0 && min_width == 0) ||
       (min_height > 0 && min_width > 0)) << "Current implementation requires "
       "min_height and min_width to be set at the same time.";
+  const string& cache_dir =
+      this->layer_param_.image_data_param().decoded_cache_dir();
+  if (!cache_dir.empty()) {
+    // Everything that changes the decoded pixels goes into the key.
+    std::ostringstream key;
+    key << "ImageData " << this->layer_param_.image_data_param().source()
+        << " root=" << root_folder << " size=" << new_height << "x"
+        << new_width << " min=" << min_height << "x" << min_width
+        << " color=" << is_color;
+    decoded_cache_.reset(new DecodedImageCache(cache_dir, key.str(),
+        this->layer_param_.image_data_param().decoded_cache_size_mb()));
+  }
 
   // Read the file with filenames and labels
   const string& source = this->layer_param_.image_data_param().source();
@@ -112,8 +126,7 @@ void ImageDataLayer<Dtype>::DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
     lines_id_ = skip;
   }
   // Read an image, and use it to initialize the top blob.
-  cv::Mat cv_img = ReadImageToCVMat(root_folder + lines_[lines_id_].first,
-                                    new_height, new_width, is_color, min_height, min_width);
+  cv::Mat cv_img = ReadImage(lines_[lines_id_].first);
 
   CHECK(cv_img.data) << "Could not load " << lines_[lines_id_].first;
   // Use data_transformer to infer the expected blob shape from a cv_image.
@@ -123,8 +136,8 @@ void ImageDataLayer<Dtype>::DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
   const int batch_size = this->layer_param_.image_data_param().batch_size();
   CHECK_GT(batch_size, 0) << "Positive batch size required";
   top_shape[0] = batch_size;
-  for (int i = 0; i < this->PREFETCH_COUNT; ++i) {
-    this->prefetch_[i].data_.Reshape(top_shape);
+  for (int i = 0; i < this->prefetch_.size(); ++i) {
+    this->prefetch_[i]->data_.Reshape(top_shape);
   }
   top[0]->Reshape(top_shape);
 
@@ -134,11 +147,29 @@ void ImageDataLayer<Dtype>::DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
   // label
   vector<int> label_shape(1, batch_size);
   top[1]->Reshape(label_shape);
-  for (int i = 0; i < this->PREFETCH_COUNT; ++i) {
-    this->prefetch_[i].label_.Reshape(label_shape);
+  for (int i = 0; i < this->prefetch_.size(); ++i) {
+    this->prefetch_[i]->label_.Reshape(label_shape);
   }
 }
 
+template <typename Dtype>
+cv::Mat ImageDataLayer<Dtype>::ReadImage(const string& filename) {
+  if (decoded_cache_) {
+    cv::Mat cached = decoded_cache_->Find(filename);
+    if (cached.data) {
+      return cached;
+    }
+  }
+  const ImageDataParameter& param = this->layer_param_.image_data_param();
+  cv::Mat cv_img = ReadImageToCVMat(param.root_folder() + filename,
+      param.new_height(), param.new_width(), param.is_color(),
+      param.min_height(), param.min_width());
+  if (decoded_cache_ && cv_img.data) {
+    decoded_cache_->Insert(filename, cv_img);
+  }
+  return cv_img;
+}
+
 template <typename Dtype>
 void ImageDataLayer<Dtype>::ShuffleImages() {
   caffe::rng_t* prefetch_rng =
@@ -157,19 +188,10 @@ void ImageDataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
   CHECK(this->transformed_data_.count());
   ImageDataParameter image_data_param = this->layer_param_.image_data_param();
   const int batch_size = image_data_param.batch_size();
-  const int new_height = image_data_param.new_height();
-  const int new_width = image_data_param.new_width();
-
-  const int min_height = image_data_param.min_height();
-  const int min_width  = image_data_param.min_width();
-
-  const bool is_color = image_data_param.is_color();
-  string root_folder = image_data_param.root_folder();
 
   // Reshape according to the first image of each batch
   // on single input batches allows for inputs of varying dimension.
-  cv::Mat cv_img = ReadImageToCVMat(root_folder + lines_[lines_id_].first,
-      new_height, new_width, is_color, min_height, min_width);
+  cv::Mat cv_img = ReadImage(lines_[lines_id_].first);
   CHECK(cv_img.data) << "Could not load " << lines_[lines_id_].first;
   // Use data_transformer to infer the expected blob shape from a cv_img.
   vector<int> top_shape = this->data_transformer_->InferBlobShape(cv_img);
@@ -193,8 +215,7 @@ void ImageDataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
     timer.Start();
     CHECK_GT(lines_size, lines_id_);
 #ifndef _OPENMP
-    cv::Mat cv_img = ReadImageToCVMat(root_folder + lines_[lines_id_].first,
-        new_height, new_width, is_color, min_height, min_width);
+    cv::Mat cv_img = ReadImage(lines_[lines_id_].first);
     CHECK(cv_img.data) << "Could not load " << lines_[lines_id_].first;
     read_time += timer.MicroSeconds();
     timer.Start();
@@ -214,8 +235,7 @@ void ImageDataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
     #pragma omp task firstprivate(offset, img_file_name, \
                                                     precalculated_rand_numbers)
     {
-        cv::Mat cv_img = ReadImageToCVMat(root_folder + img_file_name,
-            new_height, new_width, is_color);
+        cv::Mat cv_img = ReadImage(img_file_name);
         CHECK(cv_img.data) << "Could not load " << img_file_name;
 
         Blob<Dtype> tmp_data;
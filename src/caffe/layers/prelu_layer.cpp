@@ -42,6 +42,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "caffe/layers/neuron_layer.hpp"
 #include "caffe/layers/prelu_layer.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
@@ -103,13 +104,47 @@ void PReLULayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
 template <typename Dtype>
 void PReLULayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
-  const Dtype* bottom_data = bottom[0]->cpu_data();
-  Dtype* top_data = top[0]->mutable_cpu_data();
   const size_t count = bottom[0]->count();
   const int dim = bottom[0]->count(2);
   const int channels = bottom[0]->shape(1);
   const Dtype* slope_data = this->blobs_[0]->cpu_data();
 
+  // Apply the slopes per channel in the channel blocked layout an MKL-DNN
+  // layer left
+  const int block = prv_channel_block(bottom[0]);
+  if (block > 0) {
+    const Dtype* bottom_data = bottom[0]->prv_data();
+    if (bottom[0] == top[0]) {
+      // Backward_cpu reads bottom_memory_ through cpu_data, which converts it
+      caffe_copy(count, bottom_data,
+                 mutable_prv_data_like(&bottom_memory_, bottom[0]));
+    }
+    Dtype* top_data = mutable_prv_data_like(top[0], bottom[0]);
+    const int num = bottom[0]->shape(0);
+    const int blocks = channels / block;
+#ifdef _OPENMP
+    #pragma omp parallel for collapse(2)
+#endif
+    for (int n = 0; n < num; ++n) {
+      for (int c = 0; c < blocks; ++c) {
+        const size_t offset = (static_cast<size_t>(n) * blocks + c) *
+            dim * block;
+        for (int i = 0; i < dim * block; i += block) {
+          for (int b = 0; b < block; ++b) {
+            const Dtype slope = slope_data[channel_shared_ ? 0 : c * block + b];
+            const Dtype value = bottom_data[offset + i + b];
+            top_data[offset + i + b] = std::max(value, Dtype(0))
+                + slope * std::min(value, Dtype(0));
+          }
+        }
+      }
+    }
+    return;
+  }
+
+  const Dtype* bottom_data = bottom[0]->cpu_data();
+  Dtype* top_data = top[0]->mutable_cpu_data();
+
   // For in-place computation
   if (bottom[0] == top[0]) {
     caffe_copy(count, bottom_data, bottom_memory_.mutable_cpu_data());
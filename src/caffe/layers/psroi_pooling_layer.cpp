@@ -91,91 +91,91 @@ namespace caffe {
       bottom[1]->num(), output_dim_, pooled_height_, pooled_width_);
     mapping_channel_.Reshape(
       bottom[1]->num(), output_dim_, pooled_height_, pooled_width_);
+    roi_bins_.Reshape(
+      bottom[1]->num(), 2 * (pooled_height_ + pooled_width_), 1, 1);
+  }
+
+  // Computes the clipped [start, end) input range of every pooling bin along
+  // one spatial axis of an ROI.
+  template <typename Dtype>
+  static void PSROIPoolingBins(
+    const Dtype roi_start, const Dtype roi_end,
+    const Dtype spatial_scale,
+    const int pooled, const int size,
+    int* bin_start, int* bin_end) {
+      // [start, end) interval for spatial sampling
+      Dtype start = static_cast<Dtype>(round(roi_start)) * spatial_scale;
+      Dtype end = static_cast<Dtype>(round(roi_end) + 1.) * spatial_scale;
+      // Force too small ROIs to be 1x1
+      Dtype roi_size = max<Dtype>(end - start, 0.1);  // avoid 0
+      Dtype bin_size = roi_size / static_cast<Dtype>(pooled);
+      for (int p = 0; p < pooled; ++p) {
+        int pstart = floor(static_cast<Dtype>(p) * bin_size + start);
+        int pend = ceil(static_cast<Dtype>(p + 1) * bin_size + start);
+        // Clip to input boundaries
+        bin_start[p] = min(max(pstart, 0), size);
+        bin_end[p] = min(max(pend, 0), size);
+      }
   }
 
   template <typename Dtype>
   static void PSROIPoolingForward(
     const int num,
     const Dtype* bottom_data,
-    const Dtype spatial_scale,
     const int channels,
     const int height, const int width,
     const int pooled_height, const int pooled_width,
     const Dtype* bottom_rois,
+    const int* roi_bins,
     const int output_dim,
     const int group_size,
     Dtype* top_data,
     int* mapping_channel) {
-      // LOG(INFO) << "psroi pooling cpu_forward";
       int pixels = width * height;
+      int bins_per_roi = 2 * (pooled_height + pooled_width);
+#ifdef _OPENMP
+      #pragma omp parallel for schedule(static)
+#endif
+      for (int i = 0; i < num * output_dim; ++i) {
+        // per (roi, category)
+        int n = i / output_dim;
+        int ctop = i % output_dim;
+        int roi_batch_ind = bottom_rois[n * 5];
+        const int* hstart = roi_bins + n * bins_per_roi;
+        const int* hend = hstart + pooled_height;
+        const int* wstart = hend + pooled_height;
+        const int* wend = wstart + pooled_width;
+
+        int top_plane_offset = i * pooled_height * pooled_width;
+        for (int ph = 0; ph < pooled_height; ++ph) {
+          int top_row_offset = top_plane_offset + ph * pooled_width;
+          for (int pw = 0; pw < pooled_width; ++pw) {
+            int index = top_row_offset + pw;
+            // The output is in order (n, ctop, ph, pw)
+            bool is_empty = (hend[ph] <= hstart[ph]) || (wend[pw] <= wstart[pw]);
+            int c = (ctop * group_size + ph) * group_size + pw;
+
+            Dtype out_sum = 0;
+            const Dtype *current_bottom =
+              bottom_data + (roi_batch_ind * channels + c) * pixels;
+            for (int h = hstart[ph]; h < hend[ph]; ++h) {
+              const Dtype* row = current_bottom + h * width;
+              int w_begin = wstart[pw];
+              int w_end = wend[pw];
 #ifdef _OPENMP
-      #pragma omp parallel for
+              #pragma omp simd reduction(+: out_sum)
 #endif
-      for (int n = 0; n < num; ++n) {
-        // per roi
-        int roi_add = n * 5;
-        // [start, end) interval for spatial sampling
-        int roi_batch_ind = bottom_rois[roi_add];
-        Dtype roi_start_w =
-          static_cast<Dtype>(round(bottom_rois[roi_add + 1])) * spatial_scale;
-        Dtype roi_start_h =
-          static_cast<Dtype>(round(bottom_rois[roi_add + 2])) * spatial_scale;
-        Dtype roi_end_w =
-          static_cast<Dtype>(round(bottom_rois[roi_add + 3]) + 1.) * spatial_scale;
-        Dtype roi_end_h =
-          static_cast<Dtype>(round(bottom_rois[roi_add + 4]) + 1.) * spatial_scale;
-
-        // Force too small ROIs to be 1x1
-        Dtype roi_width = max<Dtype>(roi_end_w - roi_start_w, 0.1);  // avoid 0
-        Dtype roi_height = max<Dtype>(roi_end_h - roi_start_h, 0.1);
-
-        // Compute w and h at bottom
-        Dtype bin_size_h = roi_height / static_cast<Dtype>(pooled_height);
-        Dtype bin_size_w = roi_width / static_cast<Dtype>(pooled_width);
-
-        int top_roi_offset = n * output_dim * pooled_height * pooled_width;
-        for (int ctop = 0; ctop < output_dim; ++ctop) {
-          // per category
-          int top_plane_offset = top_roi_offset + ctop * pooled_height * pooled_width;
-          for (int ph = 0; ph < pooled_height; ++ph) {
-            int top_row_offset = top_plane_offset + ph * pooled_width;
-            for (int pw = 0; pw < pooled_width; ++pw) {
-              int index = top_row_offset + pw;
-              // The output is in order (n, ctop, ph, pw)
-              int hstart = floor(static_cast<Dtype>(ph) * bin_size_h + roi_start_h);
-              int wstart = floor(static_cast<Dtype>(pw) * bin_size_w + roi_start_w);
-              int hend = ceil(static_cast<Dtype>(ph + 1) * bin_size_h + roi_start_h);
-              int wend = ceil(static_cast<Dtype>(pw + 1) * bin_size_w + roi_start_w);
-              // Add roi offsets and clip to input boundaries
-              hstart = min(max(hstart, 0), height);
-              hend = min(max(hend, 0), height);
-              wstart = min(max(wstart, 0), width);
-              wend = min(max(wend, 0), width);
-
-              bool is_empty = (hend <= hstart) || (wend <= wstart);
-              int gw = pw;
-              int gh = ph;
-              int c = (ctop * group_size + gh) * group_size + gw;
-
-              Dtype out_sum = 0;
-              int bottom_base_offset = (roi_batch_ind * channels + c) * pixels;
-              const Dtype *current_bottom = bottom_data + bottom_base_offset;
-              for (int h = hstart; h < hend; ++h) {
-                int roi_row_offset = h * width;
-                for (int w = wstart; w < wend; ++w) {
-                  int bottom_index = roi_row_offset + w;
-                  out_sum += current_bottom[bottom_index];
-                }
+              for (int w = w_begin; w < w_end; ++w) {
+                out_sum += row[w];
               }
-
-              Dtype bin_area = (hend - hstart) * (wend - wstart);
-              top_data[index] = is_empty ? 0. : out_sum / bin_area;
-
-              mapping_channel[index] = c;
             }
+
+            Dtype bin_area = (hend[ph] - hstart[ph]) * (wend[pw] - wstart[pw]);
+            top_data[index] = is_empty ? 0. : out_sum / bin_area;
+            mapping_channel[index] = c;
           }
         }
-    }
+      }
   }
 
 
@@ -186,79 +186,78 @@ namespace caffe {
     const Dtype* bottom_rois = bottom[1]->cpu_data();
     Dtype* top_data = top[0]->mutable_cpu_data();
     int* mapping_channel_ptr = mapping_channel_.mutable_cpu_data();
-    int count = top[0]->count();
-    caffe_set(count, Dtype(0), top_data);
-    caffe_set(count, -1, mapping_channel_ptr);
-    
-    PSROIPoolingForward(bottom[1]->num(), bottom_data, spatial_scale_,
+    const int num_rois = bottom[1]->num();
+
+    // The bin boundaries only depend on the ROI, so build them once here
+    // instead of for every output element; backward reuses them.
+    int* roi_bins = roi_bins_.mutable_cpu_data();
+    const int bins_per_roi = roi_bins_.count(1);
+    for (int n = 0; n < num_rois; ++n) {
+      const Dtype* roi = bottom_rois + n * 5;
+      int* bins = roi_bins + n * bins_per_roi;
+      PSROIPoolingBins(roi[2], roi[4], spatial_scale_, pooled_height_,
+        height_, bins, bins + pooled_height_);
+      PSROIPoolingBins(roi[1], roi[3], spatial_scale_, pooled_width_,
+        width_, bins + 2 * pooled_height_,
+        bins + 2 * pooled_height_ + pooled_width_);
+    }
+
+    // Every output is written by PSROIPoolingForward, so top and the
+    // channel mapping need no separate initialization pass.
+    PSROIPoolingForward(num_rois, bottom_data,
       channels_, height_, width_, pooled_height_,
-      pooled_width_, bottom_rois, output_dim_, group_size_,
+      pooled_width_, bottom_rois, roi_bins, output_dim_, group_size_,
       top_data, mapping_channel_ptr);
   }
 
   template <typename Dtype>
     static void PSROIPoolingBackward(
-    const int num,
     const Dtype* top_diff,
-    const int* mapping_channel,
     const int num_rois,
-    const Dtype spatial_scale,
     const int channels,
     const int height, const int width,
     const int pooled_height, const int pooled_width,
     const int output_dim,
+    const int group_size,
     Dtype* bottom_diff,
-    const Dtype* bottom_rois) {
-	// LOG(INFO) << "psroipooling backward cpu";
+    const Dtype* bottom_rois,
+    const int* roi_bins) {
     int pixels = height * width;
+    int bins_per_roi = 2 * (pooled_height + pooled_width);
+    // Bottom channel c only receives gradient from output (ctop, ph, pw) of
+    // every ROI, so a thread owning c accumulates without atomics.
 #ifdef _OPENMP
-    #pragma omp parallel for
+    #pragma omp parallel for schedule(static)
 #endif
-    for (int i = 0; i < num; ++i) {
-      // The output is in order (n, ctop, ph, pw)
-      int pw = i % pooled_width;
-      int ph = (i / pooled_width) % pooled_height;
-      int n = i / pooled_width / pooled_height / output_dim;
-
-      // [start, end) interval for spatial sampling
-      int roi_add = n * 5;
-      int roi_batch_ind = bottom_rois[roi_add];
-      Dtype roi_start_w =
-        static_cast<Dtype>(round(bottom_rois[roi_add + 1])) * spatial_scale;
-      Dtype roi_start_h =
-        static_cast<Dtype>(round(bottom_rois[roi_add + 2])) * spatial_scale;
-      Dtype roi_end_w =
-        static_cast<Dtype>(round(bottom_rois[roi_add + 3]) + 1.) * spatial_scale;
-      Dtype roi_end_h =
-        static_cast<Dtype>(round(bottom_rois[roi_add + 4]) + 1.) * spatial_scale;
+    for (int c = 0; c < channels; ++c) {
+      int pw = c % group_size;
+      int ph = (c / group_size) % group_size;
+      int ctop = c / group_size / group_size;
+      for (int n = 0; n < num_rois; ++n) {
+        int roi_batch_ind = bottom_rois[n * 5];
+        const int* hstart = roi_bins + n * bins_per_roi;
+        const int* hend = hstart + pooled_height;
+        const int* wstart = hend + pooled_height;
+        const int* wend = wstart + pooled_width;
+        bool is_empty = (hend[ph] <= hstart[ph]) || (wend[pw] <= wstart[pw]);
+        if (is_empty) {
+          continue;
+        }
 
-      // Force too small ROIs to be 1x1
-      Dtype roi_width = max(roi_end_w - roi_start_w, (Dtype)0.1);  // avoid 0
-      Dtype roi_height = max(roi_end_h - roi_start_h, (Dtype)0.1);
-
-      // Compute w and h at bottom
-      Dtype bin_size_h = roi_height / static_cast<Dtype>(pooled_height);
-      Dtype bin_size_w = roi_width / static_cast<Dtype>(pooled_width);
-
-      int hstart = floor(static_cast<Dtype>(ph)* bin_size_h + roi_start_h);
-      int wstart = floor(static_cast<Dtype>(pw)* bin_size_w + roi_start_w);
-      int hend = ceil(static_cast<Dtype>(ph + 1) * bin_size_h + roi_start_h);
-      int wend = ceil(static_cast<Dtype>(pw + 1) * bin_size_w + roi_start_w);
-      // Add roi offsets and clip to input boundaries
-      hstart = min(max(hstart, 0), height);
-      hend = min(max(hend, 0), height);
-      wstart = min(max(wstart, 0), width);
-      wend = min(max(wend, 0), width);
-      bool is_empty = (hend <= hstart) || (wend <= wstart);
-
-      // Compute c at bottom
-      int c = mapping_channel[i];
-      Dtype* offset_bottom_diff = bottom_diff + (roi_batch_ind * channels + c) * pixels;
-      Dtype bin_area = (hend - hstart) * (wend - wstart);
-      Dtype diff_val = is_empty ? 0. : top_diff[i] / bin_area;
-      for (int h = hstart; h < hend; ++h) {
-        for (int w = wstart; w < wend; ++w) {
-          offset_bottom_diff[h * width + w] += diff_val;
+        int i = ((n * output_dim + ctop) * pooled_height + ph) * pooled_width + pw;
+        Dtype* offset_bottom_diff = bottom_diff + (roi_batch_ind * channels + c) * pixels;
+        Dtype bin_area = (hend[ph] - hstart[ph]) * (wend[pw] - wstart[pw]);
+        Dtype diff_val = top_diff[i] / bin_area;
+        for (int h = hstart[ph]; h < hend[ph]; ++h) {
+          Dtype* row = offset_bottom_diff + h * width;
+          int w_begin = wstart[pw];
+          int w_end = wend[pw];
+#ifdef _OPENMP
+          #pragma omp simd
+#endif
+          for (int w = w_begin; w < w_end; ++w) {
+            row[w] += diff_val;
+          }
         }
       }
     }
@@ -275,14 +274,11 @@ namespace caffe {
     const Dtype* top_diff = top[0]->cpu_diff();
     Dtype* bottom_diff = bottom[0]->mutable_cpu_diff();
     const int bottom_count = bottom[0]->count();
-    const int* mapping_channel_ptr = mapping_channel_.cpu_data();
     caffe_set(bottom[1]->count(), Dtype(0), bottom[1]->mutable_cpu_diff());
     caffe_set(bottom_count, Dtype(0), bottom_diff);
-    const int count = top[0]->count();
-    PSROIPoolingBackward(count, top_diff, mapping_channel_ptr,
-      top[0]->num(), spatial_scale_, channels_, height_, width_,
-      pooled_height_, pooled_width_, output_dim_, bottom_diff,
-      bottom_rois);
+    PSROIPoolingBackward(top_diff, top[0]->num(), channels_, height_, width_,
+      pooled_height_, pooled_width_, output_dim_, group_size_, bottom_diff,
+      bottom_rois, roi_bins_.cpu_data());
   }
 
 
@@ -114,6 +114,8 @@ void ROIPoolingLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
     width_ = bottom[0]->width();
     top[0]->Reshape(bottom[1]->shape(0), channels_, pooled_h_, pooled_w_);
     max_idx_.Reshape(bottom[1]->shape(0), channels_, pooled_h_, pooled_w_);
+    // A single d bin plus the h and w bins.
+    roi_bins_.Reshape(bottom[1]->shape(0), 2 * (1 + pooled_h_ + pooled_w_), 1, 1);
   } else {
     depth_ = bottom[0]->shape(2);
     height_ = bottom[0]->shape(3);
@@ -126,6 +128,30 @@ void ROIPoolingLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
     pooled_shape[4] = pooled_w_;
     top[0]->Reshape(pooled_shape);
     max_idx_.Reshape(pooled_shape);
+    roi_bins_.Reshape(bottom[1]->shape(0),
+                      2 * (pooled_d_ + pooled_h_ + pooled_w_), 1, 1);
+  }
+}
+
+// Computes the clipped [start, end) input range of every pooling bin along one
+// spatial axis of an ROI.
+template <typename Dtype>
+static void ComputeROIBins(const Dtype roi_start, const Dtype roi_end,
+                           const Dtype spatial_scale, const int pooled,
+                           const int size, int* bin_start, int* bin_end) {
+  const int start = round(roi_start * spatial_scale);
+  const int end = round(roi_end * spatial_scale);
+  const int roi_size = max(end - start + 1, 1);
+  const Dtype bin_size =
+      static_cast<Dtype>(roi_size) / static_cast<Dtype>(pooled);
+  for (int p = 0; p < pooled; ++p) {
+    // Compute pooling region for this output unit:
+    //  start (included) = floor(p * roi_size / pooled)
+    //  end (excluded) = ceil((p + 1) * roi_size / pooled)
+    const int pstart = static_cast<int>(floor(static_cast<Dtype>(p) * bin_size));
+    const int pend = static_cast<int>(ceil(static_cast<Dtype>(p + 1) * bin_size));
+    bin_start[p] = min(max(pstart + start, 0), size);
+    bin_end[p] = min(max(pend + start, 0), size);
   }
 }
 
@@ -135,170 +161,97 @@ void ROIPoolingLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   const Dtype* bottom_data = bottom[0]->cpu_data();
   const Dtype* bottom_rois = bottom[1]->cpu_data();
   // Number of ROIs
-  int num_rois = bottom[1]->shape(0);
-
-  int batch_size = bottom[0]->shape(0);
-  size_t top_count = top[0]->count();
+  const int num_rois = bottom[1]->shape(0);
+  const int roi_offset = bottom[1]->count(1);
+  const int batch_size = bottom[0]->shape(0);
+
+  // 2D pooling is handled as 3D pooling over a single slice.
+  const bool is_3d = (num_spatial_axes_ == 3);
+  const int depth = is_3d ? depth_ : 1;
+  const int pooled_d = is_3d ? pooled_d_ : 1;
+  const int spatial_dim = depth * height_ * width_;
+  const int pooled_dim = pooled_d * pooled_h_ * pooled_w_;
+  const int bins_per_roi = roi_bins_.count(1);
+
+  // The bin boundaries only depend on the ROI, so build them once here
+  // instead of for every (channel, bin) pair.
+  int* roi_bins = roi_bins_.mutable_cpu_data();
+  for (int n = 0; n < num_rois; ++n) {
+    const Dtype* roi = bottom_rois + n * roi_offset;
+    const int roi_batch_ind = roi[0];
+    CHECK_GE(roi_batch_ind, 0);
+    CHECK_LT(roi_batch_ind, batch_size);
+    int* bins = roi_bins + n * bins_per_roi;
+    if (is_3d) {
+      // ROI R = [batch_index d1 x1 y1 d2 x2 y2]
+      ComputeROIBins(roi[1], roi[4], spatial_scale_, pooled_d_, depth_,
+                     bins, bins + pooled_d_);
+      ComputeROIBins(roi[3], roi[6], spatial_scale_, pooled_h_, height_,
+                     bins + 2 * pooled_d_, bins + 2 * pooled_d_ + pooled_h_);
+      ComputeROIBins(roi[2], roi[5], spatial_scale_, pooled_w_, width_,
+                     bins + 2 * (pooled_d_ + pooled_h_),
+                     bins + 2 * (pooled_d_ + pooled_h_) + pooled_w_);
+    } else {
+      // ROI R = [batch_index x1 y1 x2 y2]
+      bins[0] = 0;
+      bins[1] = 1;
+      ComputeROIBins(roi[2], roi[4], spatial_scale_, pooled_h_, height_,
+                     bins + 2, bins + 2 + pooled_h_);
+      ComputeROIBins(roi[1], roi[3], spatial_scale_, pooled_w_, width_,
+                     bins + 2 + 2 * pooled_h_, bins + 2 + 2 * pooled_h_ + pooled_w_);
+    }
+  }
 
   Dtype* top_data = top[0]->mutable_cpu_data();
-  caffe_set(top_count, Dtype(-FLT_MAX), top_data);
   int* argmax_data = max_idx_.mutable_cpu_data();
-  caffe_set(top_count, -1, argmax_data);
-
-  if (num_spatial_axes_ == 2) {
-    int roi_offset = bottom[1]->offset(1);
-    size_t top_offset = top[0]->offset(1);
-    // For each ROI R = [batch_index x1 y1 x2 y2]: max pool over R
+  // Every output is written below, so top and argmax are filled in place
+  // without a separate initialization pass.
 #ifdef _OPENMP
-    #pragma omp parallel for
+  #pragma omp parallel for schedule(static)
 #endif
-    for (int n = 0; n < num_rois; ++n) {
-      Dtype* cur_top = top_data + n * top_offset;
-      int* cur_argmax = argmax_data + n * top_offset;
-      const Dtype* roi = bottom_rois + n * roi_offset;
-      int roi_batch_ind = roi[0];
-      int roi_start_w = round(roi[1] * spatial_scale_);
-      int roi_start_h = round(roi[2] * spatial_scale_);
-      int roi_end_w = round(roi[3] * spatial_scale_);
-      int roi_end_h = round(roi[4] * spatial_scale_);
-      CHECK_GE(roi_batch_ind, 0);
-      CHECK_LT(roi_batch_ind, batch_size);
-
-      int roi_height = max(roi_end_h - roi_start_h + 1, 1);
-      int roi_width = max(roi_end_w - roi_start_w + 1, 1);
-      const Dtype bin_size_h = static_cast<Dtype>(roi_height) / static_cast<Dtype>(pooled_h_);
-      const Dtype bin_size_w = static_cast<Dtype>(roi_width) / static_cast<Dtype>(pooled_w_);
-
-      const Dtype* batch_data = bottom_data + bottom[0]->offset(roi_batch_ind);
-
-      for (int c = 0; c < channels_; ++c) {
-        for (int ph = 0; ph < pooled_h_; ++ph) {
-          for (int pw = 0; pw < pooled_w_; ++pw) {
-            // Compute pooling region for this output unit:
-            //  start (included) = floor(ph * roi_height / pooled_h_)
-            //  end (excluded) = ceil((ph + 1) * roi_height / pooled_h_)
-            int hstart = static_cast<int>(floor(static_cast<Dtype>(ph) * bin_size_h));
-            int wstart = static_cast<int>(floor(static_cast<Dtype>(pw) * bin_size_w));
-            int hend = static_cast<int>(ceil(static_cast<Dtype>(ph + 1) * bin_size_h));
-            int wend = static_cast<int>(ceil(static_cast<Dtype>(pw + 1) * bin_size_w));
-
-            hstart = min(max(hstart + roi_start_h, 0), height_);
-            hend = min(max(hend + roi_start_h, 0), height_);
-            wstart = min(max(wstart + roi_start_w, 0), width_);
-            wend = min(max(wend + roi_start_w, 0), width_);
-
-            bool is_empty = (hend <= hstart) || (wend <= wstart);
-
-            const int pool_index = ph * pooled_w_ + pw;
-            if (is_empty) {
-              cur_top[pool_index] = 0;
-              cur_argmax[pool_index] = -1;
-              continue;
-            }
-
-            for (int h = hstart; h < hend; ++h) {
-              for (int w = wstart; w < wend; ++w) {
-                const int index = h * width_ + w;
-                if (batch_data[index] > cur_top[pool_index]) {
-                  cur_top[pool_index] = batch_data[index];
-                  cur_argmax[pool_index] = index;
-                }
-              }
-            }
+  for (int i = 0; i < num_rois * channels_; ++i) {
+    const int n = i / channels_;
+    const int c = i % channels_;
+    const int* dstart = roi_bins + n * bins_per_roi;
+    const int* dend = dstart + pooled_d;
+    const int* hstart = dend + pooled_d;
+    const int* hend = hstart + pooled_h_;
+    const int* wstart = hend + pooled_h_;
+    const int* wend = wstart + pooled_w_;
+    const int roi_batch_ind = bottom_rois[n * roi_offset];
+    const Dtype* batch_data =
+        bottom_data + (roi_batch_ind * channels_ + c) * spatial_dim;
+    Dtype* cur_top = top_data + i * pooled_dim;
+    int* cur_argmax = argmax_data + i * pooled_dim;
+
+    for (int pd = 0; pd < pooled_d; ++pd) {
+      for (int ph = 0; ph < pooled_h_; ++ph) {
+        for (int pw = 0; pw < pooled_w_; ++pw) {
+          const int pool_index = (pd * pooled_h_ + ph) * pooled_w_ + pw;
+          bool is_empty = (dend[pd] <= dstart[pd]) || (hend[ph] <= hstart[ph]) ||
+                          (wend[pw] <= wstart[pw]);
+          if (is_empty) {
+            cur_top[pool_index] = 0;
+            cur_argmax[pool_index] = -1;
+            continue;
           }
-        }
-
-        // Increment all data pointers by one channel
-        batch_data += bottom[0]->offset(0, 1);
-        cur_top += top[0]->offset(0, 1);
-        cur_argmax += max_idx_.offset(0, 1);
-      }
-    }
-  } else if (num_spatial_axes_ == 3) {
-    vector<int> roi_offset_vec(1, 0);
-    roi_offset_vec[0] = 1;
-    int roi_offset = bottom[1]->offset(roi_offset_vec);
 
-    vector<int> top_offset_vec(1, 0);
-    top_offset_vec[0] = 1;
-    size_t top_offset = top[0]->offset(top_offset_vec);
-
-#ifdef _OPENMP
-    #pragma omp parallel for
-#endif
-    for (int n = 0; n < num_rois; ++n) {
-      Dtype* cur_top = top_data + n * top_offset;
-      int* cur_argmax = argmax_data + n * top_offset;
-      const Dtype* roi = bottom_rois + n * roi_offset;
-      int roi_batch_ind = roi[0];
-      int roi_start_d = round(roi[1] * spatial_scale_);
-      int roi_start_w = round(roi[2] * spatial_scale_);
-      int roi_start_h = round(roi[3] * spatial_scale_);
-      int roi_end_d = round(roi[4] * spatial_scale_);
-      int roi_end_w = round(roi[5] * spatial_scale_);
-      int roi_end_h = round(roi[6] * spatial_scale_);
-      CHECK_GE(roi_batch_ind, 0);
-      CHECK_LT(roi_batch_ind, batch_size);
-
-      int roi_depth = max(roi_end_d - roi_start_d + 1, 1);
-      int roi_height = max(roi_end_h - roi_start_h + 1, 1);
-      int roi_width = max(roi_end_w - roi_start_w + 1, 1);
-      const Dtype bin_size_d = static_cast<Dtype>(roi_depth) / static_cast<Dtype>(pooled_d_);
-      const Dtype bin_size_h = static_cast<Dtype>(roi_height) / static_cast<Dtype>(pooled_h_);
-      const Dtype bin_size_w = static_cast<Dtype>(roi_width) / static_cast<Dtype>(pooled_w_);
-
-      vector<int> roi_batch_ind_offset(1, 0);
-      roi_batch_ind_offset[0] = roi_batch_ind;
-      const Dtype* batch_data = bottom_data + bottom[0]->offset(roi_batch_ind_offset);
-
-      for (int c = 0; c < channels_; ++c) {
-        for (int pd = 0; pd < pooled_d_; ++pd) {
-          for (int ph = 0; ph < pooled_h_; ++ph) {
-            for (int pw = 0; pw < pooled_w_; ++pw) {
-              int dstart = static_cast<int>(floor(static_cast<Dtype>(pd) * bin_size_d));
-              int hstart = static_cast<int>(floor(static_cast<Dtype>(ph) * bin_size_h));
-              int wstart = static_cast<int>(floor(static_cast<Dtype>(pw) * bin_size_w));
-              int dend = static_cast<int>(ceil(static_cast<Dtype>(pd + 1) * bin_size_d));
-              int hend = static_cast<int>(ceil(static_cast<Dtype>(ph + 1) * bin_size_h));
-              int wend = static_cast<int>(ceil(static_cast<Dtype>(pw + 1) * bin_size_w));
-
-              dstart = min(max(dstart + roi_start_d, 0), depth_);
-              dend = min(max(dend + roi_start_d, 0), depth_);
-              hstart = min(max(hstart + roi_start_h, 0), height_);
-              hend = min(max(hend + roi_start_h, 0), height_);
-              wstart = min(max(wstart + roi_start_w, 0), width_);
-              wend = min(max(wend + roi_start_w, 0), width_);
-
-              bool is_empty = (dend <= dstart) || (hend <= hstart) || (wend <= wstart);
-
-              const int pool_index = (pd * pooled_h_ + ph) * pooled_w_ + pw;
-              if (is_empty) {
-                cur_top[pool_index] = 0;
-                cur_argmax[pool_index] = -1;
-                continue;
-              }
-
-              for (int d = dstart; d < dend; ++d) {
-                for (int h = hstart; h < hend; ++h) {
-                  for (int w = wstart; w < wend; ++w) {
-                    const int index = (d * height_ + h) * width_ + w;
-                    if (batch_data[index] > cur_top[pool_index]) {
-                       cur_top[pool_index] = batch_data[index];
-                       cur_argmax[pool_index] = index;
-                    }
-                  }
+          Dtype maxval = -FLT_MAX;
+          int maxidx = -1;
+          for (int d = dstart[pd]; d < dend[pd]; ++d) {
+            for (int h = hstart[ph]; h < hend[ph]; ++h) {
+              const int row = (d * height_ + h) * width_;
+              for (int w = wstart[pw]; w < wend[pw]; ++w) {
+                if (batch_data[row + w] > maxval) {
+                  maxval = batch_data[row + w];
+                  maxidx = row + w;
                 }
               }
             }
           }
-	}
-
-        // Increment all data pointers by one channel
-        vector<int> offset_vec(2, 0);
-        offset_vec[1] = 1;
-        batch_data += bottom[0]->offset(offset_vec);
-        cur_top += top[0]->offset(offset_vec);
-        cur_argmax += max_idx_.offset(offset_vec);
+          cur_top[pool_index] = maxval;
+          cur_argmax[pool_index] = maxidx;
+        }
       }
     }
   }
@@ -318,48 +271,25 @@ void ROIPoolingLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   caffe_set(bottom[0]->count(), Dtype(0.), bottom_diff);
   const int* argmax_data = max_idx_.cpu_data();
   const int num_rois = top[0]->shape(0);
+  const int roi_offset = bottom[1]->count(1);
+  const int spatial_dim = bottom[0]->count(2);
+  const int pooled_dim = top[0]->count(2);
 
-  if (num_spatial_axes_ == 2) {
-    // Accumulate gradient over all ROIs
-    for (int roi_n = 0; roi_n < num_rois; ++roi_n) {
-      int roi_batch_ind = bottom_rois[roi_n * 5];
-      // Accumulate gradients over each bin in this ROI
+  // Each thread owns whole input channels and walks every ROI for them, so
+  // overlapping ROIs accumulate into bottom_diff without atomics.
 #ifdef _OPENMP
-      #pragma omp parallel for
+  #pragma omp parallel for schedule(static)
 #endif
-      for (int c = 0; c < channels_; ++c) {
-        for (int ph = 0; ph < pooled_h_; ++ph) {
-          for (int pw = 0; pw < pooled_w_; ++pw) {
-            int offset_top = ((roi_n * channels_ + c) * pooled_h_ + ph) * pooled_w_ + pw;
-            int argmax_index = argmax_data[offset_top];
-            if (argmax_index >= 0) {
-              int offset_bottom = (roi_batch_ind * channels_ + c) * height_ * width_ + argmax_index;
-              bottom_diff[offset_bottom] += top_diff[offset_top];
-            }
-          }
-        }
-      }
-    }
-  } else if (num_spatial_axes_ == 3) {
-     // Accumulate gradient over all ROIs
-    for (int roi_n = 0; roi_n < num_rois; ++roi_n) {
-      int roi_batch_ind = bottom_rois[roi_n * 7];
-      // Accumulate gradients over each bin in this ROI
-#ifdef _OPENMP
-      #pragma omp parallel for
-#endif
-      for (int c = 0; c < channels_; ++c) {
-        for (int pd = 0; pd < pooled_d_; ++pd) {
-          for (int ph = 0; ph < pooled_h_; ++ph) {
-            for (int pw = 0; pw < pooled_w_; ++pw) {
-              int offset_top = (((roi_n * channels_ + c) * pooled_d_ + pd) * pooled_h_ + ph) * pooled_w_ + pw;
-              int argmax_index = argmax_data[offset_top];
-              if (argmax_index >= 0) {
-                int offset_bottom = (roi_batch_ind * channels_ + c) * depth_ * height_ * width_ + argmax_index;
-                bottom_diff[offset_bottom] += top_diff[offset_top];
-              }
-            }
-          }
+  for (int c = 0; c < channels_; ++c) {
+    for (int n = 0; n < num_rois; ++n) {
+      const int roi_batch_ind = bottom_rois[n * roi_offset];
+      Dtype* cur_bottom_diff =
+          bottom_diff + (roi_batch_ind * channels_ + c) * spatial_dim;
+      const int offset_top = (n * channels_ + c) * pooled_dim;
+      for (int k = 0; k < pooled_dim; ++k) {
+        const int argmax_index = argmax_data[offset_top + k];
+        if (argmax_index >= 0) {
+          cur_bottom_diff[argmax_index] += top_diff[offset_top + k];
         }
       }
     }
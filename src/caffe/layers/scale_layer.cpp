@@ -42,6 +42,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/layer_factory.hpp"
 #include "caffe/layers/scale_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
@@ -153,6 +154,16 @@ void ScaleLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
 template <typename Dtype>
 void ScaleLayer<Dtype>::Forward_cpu(
     const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  // Scale per channel in the channel blocked layout an MKL-DNN layer left
+  int block = prv_channel_block(bottom[0]);
+  if (block > 0 && (outer_dim_ != bottom[0]->shape(0) ||
+                    scale_dim_ != bottom[0]->shape(1))) {
+    block = 0;
+  }
+  if (block > 0) {
+    ForwardBlocked_cpu(bottom, top, block);
+    return;
+  }
   const Dtype* bottom_data = bottom[0]->cpu_data();
   if (bottom[0] == top[0]) {
     // In-place computation; need to store bottom data before overwriting it.
@@ -178,6 +189,38 @@ void ScaleLayer<Dtype>::Forward_cpu(
   }
 }
 
+template <typename Dtype>
+void ScaleLayer<Dtype>::ForwardBlocked_cpu(const vector<Blob<Dtype>*>& bottom,
+    const vector<Blob<Dtype>*>& top, int block) {
+  const Dtype* bottom_data = bottom[0]->prv_data();
+  if (bottom[0] == top[0]) {
+    // Backward_cpu reads temp_ through cpu_data, which converts it back
+    caffe_copy(bottom[0]->count(), bottom_data,
+               mutable_prv_data_like(&temp_, bottom[0]));
+  }
+  const Dtype* scale_data =
+      ((bottom.size() > 1) ? bottom[1] : this->blobs_[0].get())->cpu_data();
+  Dtype* top_data = mutable_prv_data_like(top[0], bottom[0]);
+  const int blocks = scale_dim_ / block;
+#ifdef _OPENMP
+  #pragma omp parallel for collapse(2)
+#endif
+  for (int n = 0; n < outer_dim_; ++n) {
+    for (int c = 0; c < blocks; ++c) {
+      const Dtype* factor = scale_data + c * block;
+      const int offset = (n * blocks + c) * inner_dim_ * block;
+      for (int i = 0; i < inner_dim_ * block; i += block) {
+        for (int b = 0; b < block; ++b) {
+          top_data[offset + i + b] = bottom_data[offset + i + b] * factor[b];
+        }
+      }
+    }
+  }
+  if (bias_layer_) {
+    bias_layer_->Forward(bias_bottom_vec_, top);
+  }
+}
+
 template <typename Dtype>
 void ScaleLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
     const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom) {
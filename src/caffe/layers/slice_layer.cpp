@@ -40,6 +40,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "caffe/layers/slice_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
@@ -115,11 +116,20 @@ template <typename Dtype>
 void SliceLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) {
   if (top.size() == 1) { return; }
+  // A channel blocked bottom holds every image as whole channel blocks, so
+  // it slices along channels like a plain one into tops of whole blocks.
+  const int block = slice_axis_ == 1 ? prv_channel_block(bottom[0]) : 0;
+  bool prv = block > 0;
+  for (int i = 0; prv && i < top.size(); ++i) {
+    prv = top[i]->shape(slice_axis_) % block == 0;
+  }
   int offset_slice_axis = 0;
-  const Dtype* bottom_data = bottom[0]->cpu_data();
+  const Dtype* bottom_data =
+      prv ? bottom[0]->prv_data() : bottom[0]->cpu_data();
   const int bottom_slice_axis = bottom[0]->shape(slice_axis_);
   for (int i = 0; i < top.size(); ++i) {
-    Dtype* top_data = top[i]->mutable_cpu_data();
+    Dtype* top_data = prv ? mutable_prv_data_like(top[i], bottom[0]) :
+        top[i]->mutable_cpu_data();
     const int top_slice_axis = top[i]->shape(slice_axis_);
     for (int n = 0; n < num_slices_; ++n) {
       const int top_offset = n * top_slice_axis * slice_size_;
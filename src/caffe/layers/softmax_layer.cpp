@@ -37,6 +37,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
 #include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "caffe/layers/softmax_layer.hpp"
 #include "caffe/util/math_functions.hpp"
@@ -71,35 +74,14 @@ void SoftmaxLayer<Dtype>::Forward_cpu_fast_case(
   Dtype *top_base = top[0]->mutable_cpu_data();
   const Dtype *bottom_base = bottom[0]->cpu_data();
 
+  // Spread rows over threads when there are enough of them; otherwise run
+  // rows one by one and let caffe_cpu_softmax split each long row.
 #ifdef _OPENMP
-  #pragma omp parallel for
+  #pragma omp parallel for if(outer_num_ >= omp_get_max_threads())
 #endif
   for (int i = 0; i < outer_num_; ++i) {
-    const Dtype* bottom_data = bottom_base + i * dim;
-    Dtype *top_data = top_base + i * channels;
-
-    Dtype scale_data = bottom_data[0];
-    for (int j = 1; j < channels; ++j) {
-        scale_data = std::max(scale_data, bottom_data[j]);
-    }
-
-    // subtraction
-    for (int j = 0; j < channels; j++) {
-      top_data[j] = bottom_data[j] - scale_data;
-    }
-
-    // exponentiation
-    // FIXME_valgrind: caffe_exp<Dtype>(dim, top_data, top_data);
-    caffe_exp<Dtype>(dim, top_data, top_data);
-
-    // sum after exp
-    scale_data = top_data[0];
-    for (int j = 1; j < channels; j++) {
-      scale_data += top_data[j];
-    }
-
-    // division
-    caffe_scal(dim, Dtype(1) / scale_data, top_data);
+    caffe_cpu_softmax<Dtype>(channels, bottom_base + i * dim,
+                             top_base + i * channels);
   }
 }
 
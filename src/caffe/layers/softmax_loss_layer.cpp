@@ -38,6 +38,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <algorithm>
 #include <cfloat>
 #include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "caffe/layers/softmax_loss_layer.hpp"
 #include "caffe/util/math_functions.hpp"
@@ -123,9 +126,59 @@ Dtype SoftmaxWithLossLayer<Dtype>::get_normalizer(
   return std::max(Dtype(1.0), normalizer);
 }
 
+template <typename Dtype>
+void SoftmaxWithLossLayer<Dtype>::Forward_cpu_fused(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  const Dtype* bottom_data = bottom[0]->cpu_data();
+  const Dtype* label = bottom[1]->cpu_data();
+  const Dtype* weights = (bottom.size() == 3) ? bottom[2]->cpu_data() : NULL;
+  Dtype* prob_data = prob_.mutable_cpu_data();
+  const int channels = prob_.shape(softmax_axis_);
+  // Same clamping as log(max(FLT_MIN, min(p, 1 - FLT_MIN))), but taken from
+  // the log-partition so an underflowed probability loses no precision.
+  const Dtype min_log_prob = log(Dtype(FLT_MIN));
+  Dtype loss = 0;
+  Dtype weighted_sum = 0;
+  int count = 0;
+
+#ifdef _OPENMP
+  #pragma omp parallel for reduction(+: loss, weighted_sum, count) \
+      if(outer_num_ >= omp_get_max_threads())
+#endif
+  for (int i = 0; i < outer_num_; ++i) {
+    const Dtype log_z = caffe_cpu_softmax<Dtype>(channels,
+        bottom_data + i * channels, prob_data + i * channels);
+    const int label_value = static_cast<int>(label[i]);
+    if (has_ignore_label_ && label_value == ignore_label_) {
+      continue;
+    }
+    DCHECK_GE(label_value, 0);
+    DCHECK_LT(label_value, channels);
+    const Dtype log_prob = std::min(Dtype(0), std::max(min_log_prob,
+        bottom_data[i * channels + label_value] - log_z));
+    const Dtype weight = weights ? weights[i] : Dtype(1);
+    loss -= weight * log_prob;
+    weighted_sum += weight;
+    ++count;
+  }
+
+  if (weights) {
+    top[0]->mutable_cpu_data()[0] = loss / weighted_sum;
+  } else {
+    top[0]->mutable_cpu_data()[0] = loss / get_normalizer(normalization_, count);
+  }
+  if (top.size() == 2) {
+    top[1]->ShareData(prob_);
+  }
+}
+
 template <typename Dtype>
 void SoftmaxWithLossLayer<Dtype>::Forward_cpu(
     const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  if (inner_num_ == 1) {
+    Forward_cpu_fused(bottom, top);
+    return;
+  }
   // The forward pass computes the softmax prob values.
   softmax_layer_->Forward(softmax_bottom_vec_, softmax_top_vec_);
   const Dtype* prob_data = prob_.cpu_data();
@@ -39,6 +39,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "caffe/layers/spatial_dropout_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 
 namespace caffe {
@@ -67,13 +68,39 @@ void SpatialDropoutLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
 template <typename Dtype>
 void SpatialDropoutLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
-  const Dtype* bottom_data = bottom[0]->cpu_data();
-  Dtype* top_data = top[0]->mutable_cpu_data();
   unsigned int* mask = rand_vec_.mutable_cpu_data();
   const int num = bottom[0]->shape(0);
   const int channel = bottom[0]->shape(1);
   size_t spatial_dim = bottom[0]->count() / (num * channel);
+  // The mask is per channel, so it is the same in any layout
+  const int block = this->phase_ == TRAIN ? prv_channel_block(bottom[0]) : 0;
+  if (block > 0) {
+    const Dtype* bottom_data = bottom[0]->prv_data();
+    Dtype* top_data = mutable_prv_data_like(top[0], bottom[0]);
+    caffe_rng_bernoulli(num * channel, 1. - threshold_, mask);
+    const int blocks = channel / block;
+#ifdef _OPENMP
+    #pragma omp parallel for collapse(2)
+#endif
+    for (int i = 0; i < num; ++i) {
+      for (int c = 0; c < blocks; ++c) {
+        const unsigned int* channel_mask = mask + i * channel + c * block;
+        const size_t offset = (i * blocks + c) * spatial_dim * block;
+        for (size_t k = 0; k < spatial_dim * block; k += block) {
+          for (int b = 0; b < block; ++b) {
+            top_data[offset + k + b] = channel_mask[b] == 1 ?
+                bottom_data[offset + k + b] * scale_ : Dtype(0);
+          }
+        }
+      }
+    }
+    return;
+  }
+  const Dtype* bottom_data;
+  Dtype* top_data;
   if (this->phase_ == TRAIN) {
+    bottom_data = bottom[0]->cpu_data();
+    top_data = top[0]->mutable_cpu_data();
     // Create random numbers
     caffe_rng_bernoulli(num * channel, 1. - threshold_, mask);
 #ifdef _OPENMP
@@ -90,6 +117,7 @@ void SpatialDropoutLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       }
     }
   } else {
+    elementwise_data(bottom[0], top[0], &bottom_data, &top_data);
     caffe_copy(bottom[0]->count(), bottom_data, top_data);
   }
 }
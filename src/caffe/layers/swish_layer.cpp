@@ -3,6 +3,7 @@
 
 #include "caffe/layers/swish_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 namespace caffe {
 
@@ -28,15 +29,23 @@ void SwishLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
 template <typename Dtype>
 void SwishLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
-  const Dtype* bottom_data = bottom[0]->cpu_data();
-  Dtype* sigmoid_input_data = sigmoid_input_->mutable_cpu_data();
-  Dtype* top_data = top[0]->mutable_cpu_data();
+  // The sigmoid runs in the layout of bottom too, and keeps it for its
+  // output. Backward_cpu reads that through cpu_data, which converts it back.
+  const bool prv = prv_data_elementwise(bottom[0]);
+  const Dtype* bottom_data;
+  Dtype* sigmoid_input_data;
+  elementwise_data(bottom[0], sigmoid_input_.get(), &bottom_data,
+                   &sigmoid_input_data);
   const int count = bottom[0]->count();
   Dtype beta = this->layer_param_.swish_param().beta();
   caffe_copy(count, bottom_data, sigmoid_input_data);
   caffe_scal(count, beta, sigmoid_input_data);
   sigmoid_layer_->Forward(sigmoid_bottom_vec_, sigmoid_top_vec_);
-  caffe_mul(count, bottom_data, sigmoid_output_->cpu_data(), top_data);
+  Dtype* top_data = prv ? mutable_prv_data_like(top[0], bottom[0]) :
+      top[0]->mutable_cpu_data();
+  caffe_mul(count, bottom_data,
+      prv ? sigmoid_output_->prv_data() : sigmoid_output_->cpu_data(),
+      top_data);
 }
 
 template <typename Dtype>
@@ -0,0 +1,455 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include "caffe/engine_parser.hpp"
+#include "caffe/layers/winograd_conv_layer.hpp"
+#include "caffe/util/math_functions.hpp"
+
+namespace caffe {
+
+// Tiles transformed together; their GEMMs are (num_output x channels) times
+// (channels x kWinogradTileBlock).
+static const int kWinogradTileBlock = 64;
+// The DEFAULT engine only switches to Winograd when both channel counts
+// reach this, so the tile transforms are amortized by the GEMMs.
+static const int kWinogradMinAutoChannels = 16;
+
+// 1D Winograd matrices of F(m, 3), from Lavin & Gray, "Fast Algorithms for
+// Convolutional Neural Networks": input transform B^T ((m + 2) x (m + 2)),
+// filter transform G ((m + 2) x 3) and output transform A^T (m x (m + 2)).
+static const double kInputTransform2[4 * 4] = {
+  1,  0, -1,  0,
+  0,  1,  1,  0,
+  0, -1,  1,  0,
+  0,  1,  0, -1};
+static const double kFilterTransform2[4 * 3] = {
+  1,    0,   0,
+  0.5,  0.5, 0.5,
+  0.5, -0.5, 0.5,
+  0,    0,   1};
+static const double kOutputTransform2[2 * 4] = {
+  1, 1,  1,  0,
+  0, 1, -1, -1};
+static const double kInputTransform4[6 * 6] = {
+  4,  0, -5,  0, 1, 0,
+  0, -4, -4,  1, 1, 0,
+  0,  4, -4, -1, 1, 0,
+  0, -2, -1,  2, 1, 0,
+  0,  2, -1, -2, 1, 0,
+  0,  4,  0, -5, 0, 1};
+static const double kFilterTransform4[6 * 3] = {
+  1. / 4,        0,       0,
+  -1. / 6,  -1. / 6, -1. / 6,
+  -1. / 6,   1. / 6, -1. / 6,
+  1. / 24,  1. / 12,  1. / 6,
+  1. / 24, -1. / 12,  1. / 6,
+  0,              0,       1};
+static const double kOutputTransform4[4 * 6] = {
+  1, 1,  1, 1,  1, 0,
+  0, 1, -1, 2, -2, 0,
+  0, 1,  1, 4,  4, 0,
+  0, 1, -1, 8, -8, 1};
+
+// out = mat (out_len x dims[axis]) applied along axis `axis` of the
+// row-major dims[0] x dims[1] x dims[2] array `in`.
+template <typename Dtype>
+static void ApplyAlongAxis(const Dtype* in, const int dims[3], int axis,
+    const Dtype* mat, int out_len, Dtype* out) {
+  int outer = 1;
+  for (int a = 0; a < axis; ++a) {
+    outer *= dims[a];
+  }
+  int inner = 1;
+  for (int a = axis + 1; a < 3; ++a) {
+    inner *= dims[a];
+  }
+  const int in_len = dims[axis];
+  for (int o = 0; o < outer; ++o) {
+    for (int i = 0; i < out_len; ++i) {
+      Dtype* dst = out + (o * out_len + i) * inner;
+      std::fill(dst, dst + inner, Dtype(0));
+      for (int j = 0; j < in_len; ++j) {
+        const Dtype coef = mat[i * in_len + j];
+        if (coef == Dtype(0)) {
+          continue;
+        }
+        const Dtype* src = in + (o * in_len + j) * inner;
+        for (int s = 0; s < inner; ++s) {
+          dst[s] += coef * src[s];
+        }
+      }
+    }
+  }
+}
+
+// Applies one matrix per non-singleton axis, turning a dims array into a
+// rows-sized one; returns whichever of the two buffers holds the result.
+template <typename Dtype>
+static Dtype* TransformTile(const vector<Dtype>* mats, const int* rows,
+    int dims[3], Dtype* buffer, Dtype* scratch) {
+  for (int a = 0; a < 3; ++a) {
+    if (mats[a].size() == 1) {
+      continue;
+    }
+    ApplyAlongAxis(buffer, dims, a, &mats[a][0], rows[a], scratch);
+    dims[a] = rows[a];
+    std::swap(buffer, scratch);
+  }
+  return buffer;
+}
+
+template <typename Dtype>
+bool WinogradConvolutionLayer<Dtype>::IsEligible(
+    const ConvolutionParameter& conv_param) {
+  if (conv_param.group() != 1) {
+    return false;
+  }
+  if (conv_param.has_kernel_h() || conv_param.has_kernel_w()) {
+    if (conv_param.kernel_h() != 3 || conv_param.kernel_w() != 3) {
+      return false;
+    }
+  } else {
+    if (conv_param.kernel_size_size() == 0) {
+      return false;
+    }
+    for (int i = 0; i < conv_param.kernel_size_size(); ++i) {
+      if (conv_param.kernel_size(i) != 3) {
+        return false;
+      }
+    }
+  }
+  if (conv_param.has_stride_h() || conv_param.has_stride_w()) {
+    if (conv_param.stride_h() != 1 || conv_param.stride_w() != 1) {
+      return false;
+    }
+  }
+  for (int i = 0; i < conv_param.stride_size(); ++i) {
+    if (conv_param.stride(i) != 1) {
+      return false;
+    }
+  }
+  for (int i = 0; i < conv_param.dilation_size(); ++i) {
+    if (conv_param.dilation(i) != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::LayerSetUp(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::LayerSetUp(bottom, top);
+  const ConvolutionParameter& conv_param =
+      this->layer_param_.convolution_param();
+  forced_ = conv_param.engine() == ConvolutionParameter_Engine_WINOGRAD ||
+      (this->layer_param_.engine() != "" &&
+       EngineParser(this->layer_param_.engine()).isEngine("WINOGRAD"));
+
+  const int num_axes = this->num_spatial_axes_;
+  eligible_ = (num_axes == 2 || num_axes == 3) && this->group_ == 1;
+  for (int i = 0; eligible_ && i < num_axes; ++i) {
+    eligible_ = this->kernel_shape_.cpu_data()[i] == 3 &&
+                this->stride_.cpu_data()[i] == 1 &&
+                this->dilation_.cpu_data()[i] == 1;
+  }
+  if (forced_ && !eligible_) {
+    LOG(FATAL) << "Winograd engine supports only 3x3 or 3x3x3, stride 1, "
+               << "ungrouped convolutions without dilation at Layer "
+               << this->layer_param_.name();
+  }
+
+  int tile = conv_param.winograd_tile();
+  if (!forced_) {
+    tile = 2;
+  } else if (tile == 0) {
+    tile = num_axes == 2 ? 4 : 2;
+  }
+  CHECK(tile == 2 || tile == 4) << "winograd_tile must be 2 or 4";
+  SetTile(tile);
+  use_winograd_ = false;
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::SetTile(int tile) {
+  const int num_axes = this->num_spatial_axes_;
+  const double* input_transform = tile == 2 ? kInputTransform2 :
+                                              kInputTransform4;
+  const double* filter_transform = tile == 2 ? kFilterTransform2 :
+                                               kFilterTransform4;
+  const double* output_transform = tile == 2 ? kOutputTransform2 :
+                                               kOutputTransform4;
+  // 2D runs as 3D over a singleton depth axis with identity transforms.
+  for (int a = 0; a < 3; ++a) {
+    const bool singleton = a < 3 - num_axes;
+    tile_out_[a] = singleton ? 1 : tile;
+    tile_in_[a] = singleton ? 1 : tile + 2;
+    const int in_size = tile_in_[a] * tile_in_[a];
+    const int filter_size = tile_in_[a] * (singleton ? 1 : 3);
+    const int out_size = tile_out_[a] * tile_in_[a];
+    input_transform_[a].assign(in_size, Dtype(1));
+    filter_transform_[a].assign(filter_size, Dtype(1));
+    output_transform_[a].assign(out_size, Dtype(1));
+    if (!singleton) {
+      std::copy(input_transform, input_transform + in_size,
+                input_transform_[a].begin());
+      std::copy(filter_transform, filter_transform + filter_size,
+                filter_transform_[a].begin());
+      std::copy(output_transform, output_transform + out_size,
+                output_transform_[a].begin());
+    }
+  }
+  // The cached filters were transformed for the previous tile size
+  weight_mem_ = NULL;
+  weight_version_ = 0;
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::Reshape(bottom, top);
+  // The int8 3D path, when configured, takes precedence. Left to itself the
+  // DEFAULT engine also keeps the MKL-DNN 3D path and small layers.
+  use_winograd_ = eligible_ && !this->quantize_3d_ && (forced_ ||
+      (this->channels_ >= kWinogradMinAutoChannels &&
+       this->num_output_ >= kWinogradMinAutoChannels &&
+       this->useAVX_t == 0));
+  ComputeNumTiles();
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::ComputeNumTiles() {
+  const int first_axis = 3 - this->num_spatial_axes_;
+  for (int a = 0; a < 3; ++a) {
+    const int out_dim = a < first_axis ? 1 : this->output_shape_[a - first_axis];
+    num_tiles_[a] = (out_dim + tile_out_[a] - 1) / tile_out_[a];
+  }
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::TransformWeights() {
+  const int first_axis = 3 - this->num_spatial_axes_;
+  int kernel[3] = {1, 1, 1};
+  for (int a = first_axis; a < 3; ++a) {
+    kernel[a] = this->kernel_shape_.cpu_data()[a - first_axis];
+  }
+  const int kernel_size = kernel[0] * kernel[1] * kernel[2];
+  const int tile_size = tile_in_[0] * tile_in_[1] * tile_in_[2];
+  const int filters = this->num_output_ * this->channels_;
+  transformed_weight_.resize(static_cast<size_t>(tile_size) * filters);
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    vector<Dtype> buffer(tile_size);
+    vector<Dtype> scratch(tile_size);
+#ifdef _OPENMP
+    #pragma omp for
+#endif
+    for (int i = 0; i < filters; ++i) {
+      std::copy(weight + i * kernel_size, weight + (i + 1) * kernel_size,
+                buffer.begin());
+      int dims[3] = {kernel[0], kernel[1], kernel[2]};
+      const Dtype* transformed = TransformTile(filter_transform_, tile_in_,
+                                               dims, &buffer[0], &scratch[0]);
+      for (int e = 0; e < tile_size; ++e) {
+        transformed_weight_[static_cast<size_t>(e) * filters + i] =
+            transformed[e];
+      }
+    }
+  }
+  weight_mem_ = this->blobs_[0]->data().get();
+  weight_version_ = weight_mem_->version();
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::ForwardWinograd(const Dtype* bottom_data,
+    const Dtype* bias, Dtype* top_data) {
+  const int first_axis = 3 - this->num_spatial_axes_;
+  int in_shape[3] = {1, 1, 1};
+  int out_shape[3] = {1, 1, 1};
+  int pad[3] = {0, 0, 0};
+  for (int a = first_axis; a < 3; ++a) {
+    in_shape[a] = this->input_shape(a - first_axis + 1);
+    out_shape[a] = this->output_shape_[a - first_axis];
+    pad[a] = this->pad_.cpu_data()[a - first_axis];
+  }
+  const int channels = this->channels_;
+  const int num_output = this->num_output_;
+  const int tile_size = tile_in_[0] * tile_in_[1] * tile_in_[2];
+  const int num_tiles = num_tiles_[0] * num_tiles_[1] * num_tiles_[2];
+  const int num_blocks = (num_tiles + kWinogradTileBlock - 1) /
+                         kWinogradTileBlock;
+  const int in_plane = in_shape[1] * in_shape[2];
+  const int out_plane = out_shape[1] * out_shape[2];
+  const int in_dim = in_shape[0] * in_plane;
+  const int out_dim = out_shape[0] * out_plane;
+  const size_t filters = static_cast<size_t>(num_output) * channels;
+
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    vector<Dtype> input_tiles(
+        static_cast<size_t>(tile_size) * channels * kWinogradTileBlock);
+    vector<Dtype> output_tiles(
+        static_cast<size_t>(tile_size) * num_output * kWinogradTileBlock);
+    vector<Dtype> buffer(tile_size);
+    vector<Dtype> scratch(tile_size);
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int task = 0; task < this->num_ * num_blocks; ++task) {
+      const int n = task / num_blocks;
+      const int first_tile = (task % num_blocks) * kWinogradTileBlock;
+      const int count = std::min(kWinogradTileBlock, num_tiles - first_tile);
+      const Dtype* input = bottom_data + n * this->bottom_dim_;
+      Dtype* output = top_data + n * this->top_dim_;
+
+      // Input transform: V[e][c][b] = (B^T d B)[e] for tile b, channel c.
+      for (int b = 0; b < count; ++b) {
+        const int tile = first_tile + b;
+        const int origin[3] = {
+            tile / (num_tiles_[1] * num_tiles_[2]) * tile_out_[0] - pad[0],
+            (tile / num_tiles_[2]) % num_tiles_[1] * tile_out_[1] - pad[1],
+            tile % num_tiles_[2] * tile_out_[2] - pad[2]};
+        const int x_begin = std::min(std::max(0, -origin[2]), tile_in_[2]);
+        const int x_end = std::max(
+            std::min(tile_in_[2], in_shape[2] - origin[2]), x_begin);
+        for (int c = 0; c < channels; ++c) {
+          const Dtype* input_c = input + c * in_dim;
+          Dtype* row = &buffer[0];
+          for (int i = 0; i < tile_in_[0]; ++i) {
+            const int z = origin[0] + i;
+            for (int j = 0; j < tile_in_[1]; ++j, row += tile_in_[2]) {
+              const int y = origin[1] + j;
+              if (z < 0 || z >= in_shape[0] || y < 0 || y >= in_shape[1]) {
+                std::fill(row, row + tile_in_[2], Dtype(0));
+                continue;
+              }
+              const Dtype* src = input_c + z * in_plane + y * in_shape[2] +
+                                 origin[2];
+              std::fill(row, row + x_begin, Dtype(0));
+              std::copy(src + x_begin, src + x_end, row + x_begin);
+              std::fill(row + x_end, row + tile_in_[2], Dtype(0));
+            }
+          }
+          int dims[3] = {tile_in_[0], tile_in_[1], tile_in_[2]};
+          const Dtype* transformed = TransformTile(input_transform_, tile_in_,
+              dims, &buffer[0], &scratch[0]);
+          for (int e = 0; e < tile_size; ++e) {
+            input_tiles[(static_cast<size_t>(e) * channels + c) * count + b] =
+                transformed[e];
+          }
+        }
+      }
+
+      // One GEMM per tile element: M[e] = U[e] V[e].
+      for (int e = 0; e < tile_size; ++e) {
+        caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, num_output, count,
+            channels, (Dtype)1., &transformed_weight_[e * filters],
+            &input_tiles[static_cast<size_t>(e) * channels * count],
+            (Dtype)0., &output_tiles[static_cast<size_t>(e) * num_output * count]);
+      }
+
+      // Output transform: Y = A^T M A, cropped to the output and biased.
+      for (int b = 0; b < count; ++b) {
+        const int tile = first_tile + b;
+        const int origin[3] = {
+            tile / (num_tiles_[1] * num_tiles_[2]) * tile_out_[0],
+            (tile / num_tiles_[2]) % num_tiles_[1] * tile_out_[1],
+            tile % num_tiles_[2] * tile_out_[2]};
+        const int valid[3] = {
+            std::min(tile_out_[0], out_shape[0] - origin[0]),
+            std::min(tile_out_[1], out_shape[1] - origin[1]),
+            std::min(tile_out_[2], out_shape[2] - origin[2])};
+        for (int k = 0; k < num_output; ++k) {
+          for (int e = 0; e < tile_size; ++e) {
+            buffer[e] = output_tiles[
+                (static_cast<size_t>(e) * num_output + k) * count + b];
+          }
+          int dims[3] = {tile_in_[0], tile_in_[1], tile_in_[2]};
+          const Dtype* result = TransformTile(output_transform_, tile_out_,
+              dims, &buffer[0], &scratch[0]);
+          const Dtype bias_value = bias ? bias[k] : Dtype(0);
+          Dtype* output_k = output + k * out_dim;
+          for (int i = 0; i < valid[0]; ++i) {
+            for (int j = 0; j < valid[1]; ++j) {
+              const Dtype* src = result + (i * tile_out_[1] + j) * tile_out_[2];
+              Dtype* dst = output_k + (origin[0] + i) * out_plane +
+                           (origin[1] + j) * out_shape[2] + origin[2];
+              for (int l = 0; l < valid[2]; ++l) {
+                dst[l] = src[l] + bias_value;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  if (!use_winograd_) {
+    ConvolutionLayer<Dtype>::Forward_cpu(bottom, top);
+    return;
+  }
+  const SyncedMemory* weight_mem = this->blobs_[0]->data().get();
+  if (weight_mem != weight_mem_ || weight_mem->version() != weight_version_) {
+    TransformWeights();
+  }
+  const Dtype* bias = this->bias_term_ ? this->blobs_[1]->cpu_data() : NULL;
+  for (int i = 0; i < bottom.size(); ++i) {
+    ForwardWinograd(bottom[i]->cpu_data(), bias, top[i]->mutable_cpu_data());
+    if (!this->epilogue_.empty()) {
+      this->epilogue_.Forward(top[i]->mutable_cpu_data(), this->num_,
+          this->num_output_, this->out_spatial_dim_);
+    }
+  }
+  // The MKL-DNN 3D backward must reorder the inputs itself.
+  this->srcsync = false;
+}
+
+INSTANTIATE_CLASS(WinogradConvolutionLayer);
+
+}  // namespace caffe
@@ -198,6 +198,7 @@ void MKLMemoryDescriptorBase<Dtype>::convert_from_prv(void* cpu_ptr) {
   PERFORMANCE_MEASUREMENT_BEGIN();
   status = dnnExecute<Dtype>(this->convert_from_int, convert_resources);
   PERFORMANCE_MEASUREMENT_END_STATIC("mkl_conversion");
+  PrvMemDescr::count_conversion();
 
   CHECK_EQ(status, 0) << "Conversion from prv failed with status " << status;
 }
@@ -218,6 +219,7 @@ void MKLMemoryDescriptorBase<Dtype>::convert_to_prv(void* cpu_ptr) {
   PERFORMANCE_MEASUREMENT_BEGIN();
   status = dnnExecute<Dtype>(this->convert_to_int, convert_resources);
   PERFORMANCE_MEASUREMENT_END_STATIC("mkl_conversion");
+  PrvMemDescr::count_conversion();
 
   CHECK_EQ(status, 0) << "Conversion from prv failed with status " << status;
 }
@@ -263,6 +265,7 @@ void MKLMemoryDescriptorBase<Dtype>::convert_from_other(
   PERFORMANCE_MEASUREMENT_BEGIN();
   status = dnnExecute<Dtype>(convert, convert_resources);
   PERFORMANCE_MEASUREMENT_END_STATIC("mkl_conversion");
+  PrvMemDescr::count_conversion();
 
   CHECK_EQ(status, 0) << "Conversion from other failed with status "
                       << status;
@@ -306,6 +309,7 @@ Dtype* MKLMemoryDescriptor<Dtype, is_diff>::get_converted_prv(
       PERFORMANCE_MEASUREMENT_BEGIN();
       status = dnnExecute<Dtype>(this->convert_to_int, convert_resources);
       PERFORMANCE_MEASUREMENT_END_STATIC("mkl_conversion");
+      PrvMemDescr::count_conversion();
 
       CHECK_EQ(status, 0) << "Conversion failed with status " << status;
 
@@ -377,6 +381,7 @@ Dtype* MKLMemoryDescriptor<Dtype, is_diff>::get_converted_prv(
           PERFORMANCE_MEASUREMENT_BEGIN();
           status = dnnExecute<Dtype>(this->convert_to_int, convert_resources);
           PERFORMANCE_MEASUREMENT_END_STATIC("mkl_conversion");
+          PrvMemDescr::count_conversion();
 
           CHECK_EQ(status, 0) << "Conversion failed with status " << status;
 
@@ -392,6 +397,7 @@ Dtype* MKLMemoryDescriptor<Dtype, is_diff>::get_converted_prv(
           PERFORMANCE_MEASUREMENT_BEGIN();
           status = dnnExecute<Dtype>(this->convert_prv2prv, convert_resources);
           PERFORMANCE_MEASUREMENT_END_STATIC("mkl_conversion");
+          PrvMemDescr::count_conversion();
 
           CHECK_EQ(status, 0) << "Conversion failed with status " << status;
         }
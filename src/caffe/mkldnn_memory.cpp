@@ -307,6 +307,7 @@ void MKLDNNMemoryDescriptor<Dtype, is_diff>::convert_to_prv(void* cpu_ptr)
     PERFORMANCE_MEASUREMENT_BEGIN();
     this->_reorder_usr2prv.submit();
     PERFORMANCE_MEASUREMENT_END_STATIC("mkldnn_conversion");
+    PrvMemDescr::count_conversion();
 }
 #ifdef CO_SIM
 template <typename Dtype, bool is_diff>
@@ -385,6 +386,7 @@ void MKLDNNMemoryDescriptor<Dtype, is_diff>::convert_from_prv(void* cpu_ptr)
     PERFORMANCE_MEASUREMENT_BEGIN();
     this->_reorder_prv2usr.submit();
     PERFORMANCE_MEASUREMENT_END_STATIC("mkldnn_conversion");
+    PrvMemDescr::count_conversion();
 }
 
 template <typename Dtype, bool is_diff>
@@ -424,6 +426,7 @@ void MKLDNNMemoryDescriptor<Dtype, is_diff>::convert_from_extprv(shared_ptr<prim
     PERFORMANCE_MEASUREMENT_BEGIN();
     this->_reorder_extprv2prv.submit();
     PERFORMANCE_MEASUREMENT_END_STATIC("mkldnn_conversion");
+    PrvMemDescr::count_conversion();
 }
 
 
@@ -35,7 +35,13 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <stdint.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <map>
 #include <set>
 #include <string>
@@ -45,17 +51,27 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "hdf5.h"
 
 #include "boost/algorithm/string.hpp"
+#include "boost/lexical_cast.hpp"
 
 #include "caffe/common.hpp"
+#include "caffe/engine_parser.hpp"
 #include "caffe/layer.hpp"
+#ifdef MKL2017_SUPPORTED
+#include "caffe/layers/mkl_layers.hpp"
+#endif
+#ifdef MKLDNN_SUPPORTED
+#include "caffe/layers/mkldnn_layers.hpp"
+#endif
 #include "caffe/net.hpp"
 #include "caffe/parallel.hpp"
 #include "caffe/proto/caffe.pb.h"
 #include "caffe/util/cpu_info.hpp"
 #include "caffe/util/hdf5.hpp"
 #include "caffe/util/insert_splits.hpp"
+#include "caffe/util/io.hpp"
 #include "caffe/util/math_functions.hpp"
 #include "caffe/util/performance.hpp"
+#include "caffe/util/pointwise_chain.hpp"
 #include "caffe/util/upgrade_proto.hpp"
 
 #include "caffe/test/test_caffe_main.hpp"
@@ -106,6 +122,70 @@ namespace caffe {
 
 #endif /* CAFFE_PER_LAYER_TIMINGS */
 
+// What CompileNetParameter makes of a net depends on: the format tag, to be
+// bumped with every change to FilterNet, InsertSplits, CompileNet or one of
+// its rules that changes their output; the Caffe version and the compiler;
+// and the build options below. Identical builds share their caches.
+static const char kCompiledNetBuild[] = "compiled-net-v1"
+#ifdef CAFFE_VERSION
+    " caffe-" AS_STRING(CAFFE_VERSION)
+#endif
+    " " __VERSION__
+#ifdef USE_MKL2017_AS_DEFAULT_ENGINE
+    " mkl2017-default"
+#endif
+#ifdef USE_MKLDNN_AS_DEFAULT_ENGINE
+    " mkldnn-default"
+#endif
+#ifdef DISABLE_BN_FOLDING
+    " no-bn-folding"
+#endif
+#ifdef DISABLE_CONV_RELU_FUSION
+    " no-conv-relu-fusion"
+#endif
+#ifdef DISABLE_BN_RELU_FUSION
+    " no-bn-relu-fusion"
+#endif
+#ifdef DISABLE_CONV_SUM_FUSION
+    " no-conv-sum-fusion"
+#endif
+#ifdef DISABLE_SPARSE
+    " no-sparse"
+#endif
+#ifdef DISABLE_POINTWISE_FUSION
+    " no-pointwise-fusion"
+#endif
+    "";
+
+// File of the compiled form of param in the directory named by
+// CAFFE_COMPILED_NET_CACHE, or "" when there is none. The name is a 64-bit
+// FNV-1a hash of the serialized parameter, which carries its state and
+// engine, and of kCompiledNetBuild, so each file only depends on its
+// source and caches of several processes or hosts can be merged.
+// Parameters with weights in them are not cached.
+template <typename Dtype>
+static string CompiledNetCacheFile(const NetParameter& param) {
+  const char* dir = getenv("CAFFE_COMPILED_NET_CACHE");
+  if (dir == NULL || *dir == '\0') {
+    return "";
+  }
+  for (int i = 0; i < param.layer_size(); ++i) {
+    if (param.layer(i).blobs_size() > 0) {
+      return "";
+    }
+  }
+  const string key = param.SerializeAsString() + kCompiledNetBuild +
+      (sizeof(Dtype) == sizeof(float) ? " float" : " double");
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < key.size(); ++i) {
+    hash = (hash ^ static_cast<unsigned char>(key[i])) * 1099511628211ULL;
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.compiled_net",
+           static_cast<unsigned long long>(hash));  // NOLINT(runtime/int)
+  return string(dir) + "/" + name;
+}
+
 template <typename Dtype>
 Net<Dtype>::Net(const NetParameter& param, const Net* root_net)
     : root_net_(root_net) {
@@ -155,34 +235,21 @@ void Net<Dtype>::Init(const NetParameter& in_param) {
 
   // Set phase from the state.
   phase_ = in_param.state().phase();
-  // Filter layers based on their include/exclude rules and
-  // the current NetState.
-  NetParameter filtered_param;
-  FilterNet(in_param, &filtered_param);
-
-  // Backward compatibility for obsolete compile-time flags
-#ifdef USE_MKL2017_AS_DEFAULT_ENGINE
-  if (filtered_param.engine() == "") {
-    filtered_param.set_engine("MKL2017");
+  NetParameter param;
+  CompiledNet compiled;
+  const string cache_file = CompiledNetCacheFile<Dtype>(in_param);
+  const bool cache_hit = !cache_file.empty() &&
+      access(cache_file.c_str(), R_OK) == 0 &&
+      ReadProtoFromBinaryFile(cache_file, &compiled);
+  if (cache_hit) {
+    LOG_IF(INFO, Caffe::root_solver())
+        << "Using compiled net " << cache_file;
+    param.Swap(compiled.mutable_param());
+    uncompiled_param_.Swap(compiled.mutable_uncompiled_param());
+    engine_name_ = param.engine();
+  } else {
+    CompileNetParameter(in_param, &param);
   }
-#endif
-
-#ifdef USE_MKLDNN_AS_DEFAULT_ENGINE
-  if (filtered_param.engine() == "")
-    filtered_param.set_engine("MKLDNN");
-#endif
-  engine_name_ = filtered_param.engine();
-
-  NetParameter& param = filtered_param;
-  // Create a copy of filtered_param with splits added where necessary.
-  NetParameter param_with_splits;
-  InsertSplits(param, &param_with_splits);
-  param = param_with_splits;
-
-  NetParameter compiled_param;
-  // Transform Net (merge layers etc.) improve computational performance
-  CompileNet(param, &compiled_param);
-  param = compiled_param;
   this->bn_scale_remove_ = param.compile_net_state().bn_scale_remove();
   this->bn_scale_merge_ = param.compile_net_state().bn_scale_merge();
   int kept_bn_layers_num = param.compile_net_state().kept_bn_layers_size();
@@ -190,13 +257,6 @@ void Net<Dtype>::Init(const NetParameter& in_param) {
     this->kept_bn_layers_.push_back(param.compile_net_state().kept_bn_layers(idx));
   }
 
-  NetParameter param_with_stats_batch_size;
-  if (param.has_bn_stats_batch_size()) {
-    ApplyBnStatsBatchSize(param, &param_with_stats_batch_size);
-    param = param_with_stats_batch_size;
-  }
-
-
   // Printing processed model
   if (Caffe::root_solver()) {
     LOG(INFO) << "Initializing net from parameters: " << std::endl;
@@ -239,7 +299,25 @@ void Net<Dtype>::Init(const NetParameter& in_param) {
         }
       }
     }
-    
+    // MKL2017 and MKL-DNN convolutions are 2D only. The layer factory sees
+    // just the parameters, so convolutions over bottoms of another rank are
+    // sent to the CAFFE engine here.
+    if (layer_param.type() == "Convolution" && layer_param.bottom_size() > 0 &&
+        layer_param.convolution_param().engine() ==
+        ConvolutionParameter_Engine_DEFAULT &&
+        blob_name_to_idx.count(layer_param.bottom(0))) {
+      EngineParser ep(layer_param.engine());
+      const Blob<Dtype>& bottom =
+          *blobs_[blob_name_to_idx[layer_param.bottom(0)]];
+      const int axis = bottom.CanonicalAxisIndex(
+          layer_param.convolution_param().axis());
+      if ((ep.isEngine("MKLDNN") || ep.isEngine("MKL2017")) &&
+          bottom.num_axes() - axis - 1 != 2) {
+        param.mutable_layer(layer_id)->mutable_convolution_param()->set_engine(
+            ConvolutionParameter_Engine_CAFFE);
+      }
+    }
+
     if (layer_param.propagate_down_size() > 0) {
       CHECK_EQ(layer_param.propagate_down_size(),
           layer_param.bottom_size())
@@ -449,7 +527,58 @@ void Net<Dtype>::Init(const NetParameter& in_param) {
     layer_names_index_[layer_names_[layer_id]] = layer_id;
   }
   ShareWeights();
+  // The fillers of all params were skipped: remember which ones the trained
+  // weights have to cover, see FillUnloadedParams.
+  unloaded_params_.clear();
+  if (Caffe::skip_param_fill()) {
+    unloaded_params_.resize(layers_.size());
+    for (size_t i = 0; i < layers_.size(); ++i) {
+      unloaded_params_[i].assign(layers_[i]->blobs().size(), true);
+    }
+  }
+  layer_forward_conversions_.assign(layers_.size(), 0);
+  InitHalfStorage(param);
   debug_info_ = param.debug_info();
+
+  // Record the compiled parameter, now with the engine and phase of every
+  // layer resolved, for the next construction of this net. A cached one is
+  // rewritten if the layers no longer produce the shapes recorded with it.
+  if (!cache_file.empty() && Caffe::root_solver()) {
+    const int num_blobs = blobs_.size();
+    bool shapes_match = cache_hit && compiled.blob_shape_size() == num_blobs;
+    for (int i = 0; shapes_match && i < num_blobs; ++i) {
+      const BlobShape& shape = compiled.blob_shape(i);
+      shapes_match = shape.dim_size() == blobs_[i]->num_axes();
+      for (int j = 0; shapes_match && j < shape.dim_size(); ++j) {
+        shapes_match = shape.dim(j) == blobs_[i]->shape(j);
+      }
+    }
+    if (!shapes_match) {
+      LOG_IF(WARNING, cache_hit) << "Compiled net " << cache_file
+          << " does not match the layers any more, rewriting it";
+      compiled.Clear();
+      compiled.mutable_param()->CopyFrom(param);
+      compiled.mutable_uncompiled_param()->CopyFrom(uncompiled_param_);
+      for (int i = 0; i < num_blobs; ++i) {
+        BlobShape* shape = compiled.add_blob_shape();
+        for (int j = 0; j < blobs_[i]->num_axes(); ++j) {
+          shape->add_dim(blobs_[i]->shape(j));
+        }
+      }
+      // Write aside and rename, so that concurrent readers and writers of
+      // the same file only ever see a complete one.
+      const string temp_file =
+          cache_file + "." + boost::lexical_cast<string>(getpid());
+      std::ofstream output(temp_file.c_str(),
+                           std::ios::out | std::ios::trunc | std::ios::binary);
+      const bool written = output && compiled.SerializeToOstream(&output);
+      output.close();
+      if (!written || rename(temp_file.c_str(), cache_file.c_str()) != 0) {
+        LOG(WARNING) << "Could not write compiled net " << cache_file;
+        remove(temp_file.c_str());
+      }
+    }
+  }
   
 
   // LOG(ERROR) << "init done with time_info " << time_info_;
@@ -461,6 +590,54 @@ void Net<Dtype>::Init(const NetParameter& in_param) {
   LOG_IF(INFO, Caffe::root_solver()) << "Network initialization done.";
 }
 
+template <typename Dtype>
+void Net<Dtype>::CompileNetParameter(const NetParameter& in_param,
+    NetParameter* param_compiled) {
+  // Filter layers based on their include/exclude rules and
+  // the current NetState.
+  NetParameter filtered_param;
+  FilterNet(in_param, &filtered_param);
+
+  // Backward compatibility for obsolete compile-time flags
+#ifdef USE_MKL2017_AS_DEFAULT_ENGINE
+  if (filtered_param.engine() == "") {
+    filtered_param.set_engine("MKL2017");
+  }
+#endif
+
+#ifdef USE_MKLDNN_AS_DEFAULT_ENGINE
+  if (filtered_param.engine() == "")
+    filtered_param.set_engine("MKLDNN");
+#endif
+  engine_name_ = filtered_param.engine();
+
+  NetParameter& param = filtered_param;
+  // Create a copy of filtered_param with splits added where necessary.
+  NetParameter param_with_splits;
+  InsertSplits(param, &param_with_splits);
+  param = param_with_splits;
+
+  NetParameter compiled_param;
+  // Transform Net (merge layers etc.) improve computational performance
+  CompileNet(param, &compiled_param);
+  if (compiled_param.compile_net_state().bn_scale_remove()) {
+    // Keep the pre-compile topology: weights stored per layer (HDF5) have
+    // to be folded against it when they are loaded.
+    uncompiled_param_.CopyFrom(param);
+    for (int i = 0; i < uncompiled_param_.layer_size(); ++i) {
+      uncompiled_param_.mutable_layer(i)->clear_blobs();
+    }
+  }
+  param = compiled_param;
+
+  NetParameter param_with_stats_batch_size;
+  if (param.has_bn_stats_batch_size()) {
+    ApplyBnStatsBatchSize(param, &param_with_stats_batch_size);
+    param = param_with_stats_batch_size;
+  }
+  param_compiled->Swap(&param);
+}
+
 template <typename Dtype>
 void Net<Dtype>::SetPhase(Phase phase) {
   // set all layers
@@ -511,11 +688,13 @@ void Net<Dtype>::CompileNet(const NetParameter& param,
   #define COMPILE_BN_RELU_FUSION_INDEX 3
   #define COMPILE_SPARSE_INDEX 5
   #define COMPILE_CONV_SUM_FUSION_INDEX 6
+  #define COMPILE_POINTWISE_FUSION_INDEX 7
   int i, current = 0;
   NetParameter param_temp[2];
   void (*CompileRules[]) (const NetParameter& param, NetParameter* param_compiled) =
     {RemoveBNScale<Dtype>, CompilationRuleRemoveScale, CompilationRuleConvReluFusion,
-    CompilationRuleFuseBnRelu, CompilationRuleBNInplace, CompilationRuleSparse, CompilationRuleConvSumFusion};
+    CompilationRuleFuseBnRelu, CompilationRuleBNInplace, CompilationRuleSparse, CompilationRuleConvSumFusion,
+    CompilationRulePointwiseFusion};
 
   bool disabled[NUM_OF_RULES] = {false};
 
@@ -534,6 +713,9 @@ void Net<Dtype>::CompileNet(const NetParameter& param,
 #ifdef DISABLE_SPARSE
   disabled[COMPILE_SPARSE_INDEX] = true;
 #endif
+#ifdef DISABLE_POINTWISE_FUSION
+  disabled[COMPILE_POINTWISE_FUSION_INDEX] = true;
+#endif
 
   param_temp[current].CopyFrom(param);
   for (i = 0; i < NUM_OF_RULES; i++)
@@ -550,6 +732,7 @@ void Net<Dtype>::CompileNet(const NetParameter& param,
   #undef COMPILE_BN_RELU_FUSION_INDEX
   #undef DISABLE_SPARSE_INDEX
   #undef COMPILE_CONV_SUM_FUSION_INDEX
+  #undef COMPILE_POINTWISE_FUSION_INDEX
 }
 
 template <typename Dtype>
@@ -908,6 +1091,158 @@ void Net<Dtype>::CompilationRuleConvSumFusion(const NetParameter& param,
   return;
 }
 
+// Whether the layer runs on the reference CAFFE engine rather than on
+// MKL2017, MKLDNN or CUDNN. Layers without an engine choice always do.
+static bool IsCaffeEngineLayer(const LayerParameter& layer_param,
+                               const NetParameter& param) {
+  const string& engine = layer_param.engine() != "" ?
+                         layer_param.engine() : param.engine();
+  const bool caffe_engine = engine == "" ||
+                            engine.compare(0, 5, "CAFFE") == 0;
+  const string& type = layer_param.type();
+  if (type == "Convolution") {
+    const ConvolutionParameter_Engine e =
+        layer_param.convolution_param().engine();
+    // WINOGRAD is a CPU forward path of the CAFFE engine
+    return e == ConvolutionParameter_Engine_CAFFE ||
+           e == ConvolutionParameter_Engine_WINOGRAD ||
+           (e == ConvolutionParameter_Engine_DEFAULT &&
+            (caffe_engine || engine.compare(0, 8, "WINOGRAD") == 0));
+  } else if (type == "InnerProduct") {
+    const InnerProductParameter_Engine e =
+        layer_param.inner_product_param().engine();
+    return e == InnerProductParameter_Engine_CAFFE ||
+           (e == InnerProductParameter_Engine_DEFAULT && caffe_engine);
+  } else if (type == "ReLU") {
+    const ReLUParameter_Engine e = layer_param.relu_param().engine();
+    return e == ReLUParameter_Engine_CAFFE ||
+           (e == ReLUParameter_Engine_DEFAULT && caffe_engine);
+  } else if (type == "Sigmoid") {
+    const SigmoidParameter_Engine e = layer_param.sigmoid_param().engine();
+    return e == SigmoidParameter_Engine_CAFFE ||
+           (e == SigmoidParameter_Engine_DEFAULT && caffe_engine);
+  } else if (type == "Eltwise") {
+    const EltwiseParameter_Engine e = layer_param.eltwise_param().engine();
+    return e == EltwiseParameter_Engine_CAFFE ||
+           (e == EltwiseParameter_Engine_DEFAULT && caffe_engine);
+  }
+  return true;
+}
+
+template <typename Dtype>
+void Net<Dtype>::CompilationRulePointwiseFusion(const NetParameter& param,
+                                       NetParameter* param_compiled) {
+  // Fused layers are forward only, so only apply this rule for inference
+  // on CPU
+  if (param.state().phase() != TEST || param.force_backward() ||
+      Caffe::mode() != Caffe::CPU) {
+    param_compiled->CopyFrom(param);
+    return;
+  }
+
+  for (int i = 0; i < param.layer_size(); ++i) {
+    const LayerParameter& layer_param = param.layer(i);
+    const bool is_fusable = layer_param.loss_weight_size() == 0 &&
+        PointwiseChain<Dtype>::IsPointwise(layer_param) &&
+        IsCaffeEngineLayer(layer_param, param);
+    // Conv/IP of the CAFFE engine take parameter-free ops as an epilogue
+    // applied right after their GEMM
+    const bool is_epilogue = !is_fusable &&
+        (layer_param.type() == "Convolution" ||
+         layer_param.type() == "InnerProduct") &&
+        layer_param.bottom_size() == 1 && layer_param.top_size() == 1 &&
+        IsCaffeEngineLayer(layer_param, param);
+    if (!is_fusable && !is_epilogue) {
+      param_compiled->add_layer()->CopyFrom(layer_param);
+      continue;
+    }
+
+    // Grow the chain while the next layer is pointwise and is the only
+    // consumer of the current value (or updates it in place)
+    string current_blob = layer_param.top(0);
+    int last = i;
+    while (last + 1 < param.layer_size()) {
+      const LayerParameter& next = param.layer(last + 1);
+      if (next.loss_weight_size() != 0 ||
+          !PointwiseChain<Dtype>::IsPointwise(next) ||
+          !IsCaffeEngineLayer(next, param) ||
+          (is_epilogue && !PointwiseChain<Dtype>::IsParameterFree(next)) ||
+          std::find(next.bottom().begin(), next.bottom().end(),
+                    current_blob) == next.bottom().end()) {
+        break;
+      }
+      // An Eltwise can not read the chain input again, it would become a
+      // duplicated bottom of the fused layer
+      if (!is_epilogue && next.type() == "Eltwise" &&
+          std::find(next.bottom().begin(), next.bottom().end(),
+                    layer_param.bottom(0)) != next.bottom().end() &&
+          layer_param.bottom(0) != current_blob) {
+        break;
+      }
+      if (next.top(0) != current_blob) {
+        std::vector<const LayerParameter*> consumer_layer_params;
+        GetBlobConsumers(consumer_layer_params, current_blob, param,
+                         last + 1);
+        if (consumer_layer_params.size() != 1) {
+          break;
+        }
+      }
+      current_blob = next.top(0);
+      ++last;
+    }
+    if (last == i) {
+      param_compiled->add_layer()->CopyFrom(layer_param);
+      continue;
+    }
+
+    LayerParameter* fused_layer_param = param_compiled->add_layer();
+    int first_op = i;
+    if (is_epilogue) {
+      fused_layer_param->CopyFrom(layer_param);
+      first_op = i + 1;
+    } else {
+      fused_layer_param->set_name(layer_param.name());
+      fused_layer_param->set_type("FusedPointwise");
+      if (layer_param.has_phase()) {
+        fused_layer_param->set_phase(layer_param.phase());
+      }
+      for (int j = 0; j < layer_param.bottom_size(); ++j) {
+        fused_layer_param->add_bottom(layer_param.bottom(j));
+      }
+      fused_layer_param->add_top(layer_param.top(0));
+    }
+    FusedPointwiseParameter* fused_param =
+        fused_layer_param->mutable_fused_pointwise_param();
+    string running_blob = is_epilogue ? layer_param.top(0) :
+                                        layer_param.bottom(0);
+    for (int k = first_op; k <= last; ++k) {
+      const LayerParameter& op_param = param.layer(k);
+      LayerParameter* op = fused_param->add_op();
+      op->CopyFrom(op_param);
+      op->clear_blobs();
+      // Scale/Bias blobs are kept by the fused layer, in op order
+      for (int j = 0; j < op_param.blobs_size(); ++j) {
+        fused_layer_param->add_blobs()->CopyFrom(op_param.blobs(j));
+      }
+      // Other inputs of a fused Eltwise become extra bottoms
+      for (int j = 0; j < op_param.bottom_size(); ++j) {
+        const string& bottom_name = op_param.bottom(j);
+        if (bottom_name != running_blob &&
+            std::find(fused_layer_param->bottom().begin() + 1,
+                      fused_layer_param->bottom().end(), bottom_name) ==
+            fused_layer_param->bottom().end()) {
+          fused_layer_param->add_bottom(bottom_name);
+        }
+      }
+      running_blob = op_param.top(0);
+      LOG_IF(INFO, Caffe::root_solver()) << "Fused layer "
+          << op_param.name() << " into " << fused_layer_param->name();
+    }
+    fused_layer_param->set_top(0, current_blob);
+    i = last;
+  }
+}
+
 template <typename Dtype>
 void Net<Dtype>::CompilationRuleSparse(const NetParameter& param,
                                        NetParameter* param_compiled) {
@@ -1331,53 +1666,29 @@ vector<Dtype> Net<Dtype>::FindMax(Blob<Dtype>* blob, bool is_single) {
   const Dtype* data = blob->cpu_data();
   int cnt = blob->count();
   vector<Dtype> max_vals;
-  Dtype max_val = (Dtype)(-10);
 
-  int index = 0;
-  if(blob->shape().size() == 4) {
-    if(is_single) {
-      max_vals = vector<Dtype>(1, Dtype(-10));
-      for (int i = 0; i < cnt; ++i) {
-        max_val = std::max(max_val, (Dtype)fabs(data[i]));
-      }
-      max_vals.at(0) = max_val;
-    } else { // output_channel * input_channel * kernel_height * kernel_width
-      int height = blob->shape(2);
-      int width = blob->shape(3);
-      int channel = blob->shape(0);
-      max_vals = vector<Dtype>(channel, Dtype(-10));
-      int step = blob->shape(1) * height * width;
-      for (int i = 0; i < cnt; ++i) {
-        if((i + 1) % step == 0) {
-          max_vals.at(index) = std::max(max_val, (Dtype)fabs(data[i]));
-          ++index;
-        } else {
-          max_val = std::max(max_val, (Dtype)fabs(data[i]));
-        }
-      }
+  if (is_single || blob->num_axes() < 2) {
+    Dtype max_val = (Dtype)(-10);
+    for (int i = 0; i < cnt; ++i) {
+      max_val = std::max(max_val, (Dtype)fabs(data[i]));
     }
+    max_vals.push_back(max_val);
   } else {
-    if(is_single) {
-      max_vals = vector<Dtype>(1, Dtype(-10));
-      for (int i = 0; i < cnt; ++i) {
-        max_val = std::max(max_val, (Dtype)fabs(data[i]));
-      }
-      max_vals.at(0) = max_val;
-    } else { // output_channel * input_channel
-      int channel = blob->shape(0);
-      max_vals = vector<Dtype>(channel, Dtype(-10));
-      int step = blob->shape(1);
-      for (int i = 0; i < cnt; ++i) {
-        if((i + 1) % step == 0) {
-          max_vals.at(index) = std::max(max_val, (Dtype)fabs(data[i]));
-          ++index;
-        } else {
-          max_val = std::max(max_val, (Dtype)fabs(data[i]));
-        }
+    // output_channel * input_channel * kernel spatial dims, for any number
+    // of spatial axes (4D and 5D convolution weights alike)
+    int channel = blob->shape(0);
+    int step = blob->count(1);
+    max_vals = vector<Dtype>(channel, Dtype(-10));
+    for (int c = 0; c < channel; ++c) {
+      const Dtype* channel_data = data + c * step;
+      Dtype max_val = (Dtype)(-10);
+      for (int i = 0; i < step; ++i) {
+        max_val = std::max(max_val, (Dtype)fabs(channel_data[i]));
       }
+      max_vals[c] = max_val;
     }
   }
-  
+
   return max_vals;
 }
 
@@ -1590,6 +1901,110 @@ void Net<Dtype>::AppendParam(const NetParameter& param, const int layer_id,
   }
 }
 
+// Whether the layer runs on MKL2017 or MKLDNN. Their primitives wrap the CPU
+// buffers of plain bottoms and tops once and keep using them without asking
+// the blobs for the data again.
+template <typename Dtype>
+static bool IsMklLayer(Layer<Dtype>* layer) {
+#ifdef MKLDNN_SUPPORTED
+  if (dynamic_cast<MKLDNNLayer<Dtype>*>(layer)) {
+    return true;
+  }
+#endif
+#ifdef MKL2017_SUPPORTED
+  if (dynamic_cast<MKLConvolutionLayer<Dtype>*>(layer) ||
+      dynamic_cast<MKLDeconvolutionLayer<Dtype>*>(layer) ||
+      dynamic_cast<MKLLRNLayer<Dtype>*>(layer) ||
+      dynamic_cast<MKLPoolingLayer<Dtype>*>(layer) ||
+      dynamic_cast<MKLReLULayer<Dtype>*>(layer) ||
+      dynamic_cast<MKLConcatLayer<Dtype>*>(layer) ||
+      dynamic_cast<MKLBatchNormLayer<Dtype>*>(layer) ||
+      dynamic_cast<MKLSplitLayer<Dtype>*>(layer) ||
+      dynamic_cast<MKLEltwiseLayer<Dtype>*>(layer)) {
+    return true;
+  }
+#endif
+  return false;
+}
+
+template <typename Dtype>
+void Net<Dtype>::InitHalfStorage(const NetParameter& param) {
+  half_storage_blob_ids_.assign(layers_.size(), vector<int>());
+  if (param.activation_storage() == NetParameter_ActivationStorage_FULL) {
+    return;
+  }
+  half_format_ =
+      param.activation_storage() == NetParameter_ActivationStorage_FLOAT16 ?
+      FLOAT16 : BFLOAT16;
+  // Blobs sharing their data, like the tops of Split, Flatten and Reshape
+  // layers with their bottoms, are planned as one.
+  map<SyncedMemory*, int> storage_ids;
+  vector<int> storage_of_blob(blobs_.size());
+  vector<int> blob_of_storage;
+  vector<bool> storage_allowed;
+  vector<vector<int> > storage_uses;
+  for (size_t blob_id = 0; blob_id < blobs_.size(); ++blob_id) {
+    SyncedMemory* data = blobs_[blob_id]->data().get();
+    map<SyncedMemory*, int>::iterator it = storage_ids.find(data);
+    if (it == storage_ids.end()) {
+      const int storage = blob_of_storage.size();
+      it = storage_ids.insert(std::make_pair(data, storage)).first;
+      blob_of_storage.push_back(blob_id);
+      storage_allowed.push_back(data != NULL);
+      storage_uses.push_back(vector<int>());
+    }
+    storage_of_blob[blob_id] = it->second;
+  }
+  // The caller reads and writes inputs and outputs directly
+  for (size_t i = 0; i < net_input_blob_indices_.size(); ++i) {
+    storage_allowed[storage_of_blob[net_input_blob_indices_[i]]] = false;
+  }
+  for (size_t i = 0; i < net_output_blob_indices_.size(); ++i) {
+    storage_allowed[storage_of_blob[net_output_blob_indices_[i]]] = false;
+  }
+  for (int layer_id = 0; layer_id < static_cast<int>(layers_.size());
+       ++layer_id) {
+    const bool half_storage = layers_[layer_id]->layer_param().half_storage();
+    const bool mkl_layer = IsMklLayer(layers_[layer_id].get());
+    vector<int> blob_ids(bottom_id_vecs_[layer_id]);
+    blob_ids.insert(blob_ids.end(), top_id_vecs_[layer_id].begin(),
+        top_id_vecs_[layer_id].end());
+    for (size_t i = 0; i < blob_ids.size(); ++i) {
+      const int storage = storage_of_blob[blob_ids[i]];
+      if (mkl_layer ||
+          (!half_storage && i >= bottom_id_vecs_[layer_id].size())) {
+        storage_allowed[storage] = false;
+      }
+      if (storage_uses[storage].empty() ||
+          storage_uses[storage].back() != layer_id) {
+        storage_uses[storage].push_back(layer_id);
+      }
+    }
+  }
+  // When training, the last forward use waits for the forward and backward
+  // of all later layers before its own backward reads the data again.
+  const int min_wait = param.activation_storage_min_wait();
+  const int num_layers = layers_.size();
+  int num_stored = 0;
+  for (size_t storage = 0; storage < storage_uses.size(); ++storage) {
+    const vector<int>& uses = storage_uses[storage];
+    bool stored = false;
+    for (size_t i = 0; storage_allowed[storage] && i < uses.size(); ++i) {
+      const int wait = i + 1 < uses.size() ? uses[i + 1] - uses[i] - 1 :
+          phase_ == TRAIN ? 2 * (num_layers - 1 - uses[i]) : -1;
+      if (wait > 0 && wait >= min_wait) {
+        half_storage_blob_ids_[uses[i]].push_back(blob_of_storage[storage]);
+        stored = true;
+      }
+    }
+    num_stored += stored;
+  }
+  LOG_IF(INFO, Caffe::root_solver()) << "Storing " << num_stored
+      << " activations as "
+      << NetParameter_ActivationStorage_Name(param.activation_storage())
+      << " while they wait for at least " << min_wait << " layers";
+}
+
 template <typename Dtype>
 Dtype Net<Dtype>::ForwardFromTo(int start, int end) {
   CHECK_GE(start, 0);
@@ -1598,9 +2013,15 @@ Dtype Net<Dtype>::ForwardFromTo(int start, int end) {
   for (int i = start; i <= end; ++i) {
     LAYER_TIMING_START(forward, i);
     PERFORMANCE_MEASUREMENT_BEGIN();
+    const uint64_t conversions = PrvMemDescr::conversions();
 
     Dtype layer_loss = layers_[i]->Forward(bottom_vecs_[i], top_vecs_[i]);
 
+    layer_forward_conversions_[i] = PrvMemDescr::conversions() - conversions;
+    for (size_t j = 0; j < half_storage_blob_ids_[i].size(); ++j) {
+      blobs_[half_storage_blob_ids_[i][j]]->data()->template
+          store_half<Dtype>(half_format_);
+    }
     PERFORMANCE_MEASUREMENT_END((std::string("FW_") + layer_names_[i]).c_str());
     LAYER_TIMING_STOP(forward, i);
 
@@ -1686,6 +2107,12 @@ void Net<Dtype>::ForwardDebugInfo(const int layer_id) {
         << ", param blob " << blob_name
         << " data: " << data_abs_val_mean;
   }
+  if (layer_forward_conversions_[layer_id] > 0) {
+    LOG_IF(INFO, Caffe::root_solver())
+        << "    [Forward] "
+        << "Layer " << layer_names_[layer_id]
+        << ", layout conversions: " << layer_forward_conversions_[layer_id];
+  }
 }
 
 template <typename Dtype>
@@ -1789,8 +2216,54 @@ void Net<Dtype>::ShareTrainedLayersWith(const Net* other) {
           << source_blob->shape_string() << "; target param shape is "
           << target_blobs[j]->shape_string();
       target_blobs[j]->ShareData(*source_blob);
+      MarkParamLoaded(target_layer_id, j);
     }
   }
+  FillUnloadedParams();
+}
+
+template <typename Dtype>
+void Net<Dtype>::CopyTrainedLayersFrom(const Net* other) {
+  if (this->bn_scale_remove_) {
+    // Folded BN/scale weights already go through a serialized copy.
+    ShareTrainedLayersWith(other);
+    return;
+  }
+  int num_source_layers = other->layers().size();
+  for (int i = 0; i < num_source_layers; ++i) {
+    Layer<Dtype>* source_layer = other->layers()[i].get();
+    const string& source_layer_name = other->layer_names()[i];
+    int target_layer_id = 0;
+    while (target_layer_id != layer_names_.size() &&
+        layer_names_[target_layer_id] != source_layer_name) {
+      ++target_layer_id;
+    }
+    if (target_layer_id == layer_names_.size()) {
+      DLOG(INFO) << "Ignoring source layer " << source_layer_name;
+      continue;
+    }
+    DLOG(INFO) << "Copying source layer " << source_layer_name;
+    vector<shared_ptr<Blob<Dtype> > >& target_blobs =
+        layers_[target_layer_id]->blobs();
+    CHECK_EQ(target_blobs.size(), source_layer->blobs().size())
+        << "Incompatible number of blobs for layer " << source_layer_name;
+    for (int j = 0; j < target_blobs.size(); ++j) {
+      Blob<Dtype>* source_blob = source_layer->blobs()[j].get();
+      CHECK(target_blobs[j]->shape() == source_blob->shape())
+          << "Cannot copy param " << j << " weights from layer '"
+          << source_layer_name << "'; shape mismatch.  Source param shape is "
+          << source_blob->shape_string() << "; target param shape is "
+          << target_blobs[j]->shape_string();
+      if (target_blobs[j]->data() == source_blob->data()) {
+        // Still shared from an earlier ShareTrainedLayersWith: detach.
+        Blob<Dtype> detached(source_blob->shape());
+        target_blobs[j]->ShareData(detached);
+      }
+      target_blobs[j]->CopyFrom(*source_blob);
+      MarkParamLoaded(target_layer_id, j);
+    }
+  }
+  FillUnloadedParams();
 }
 
 template <typename Dtype>
@@ -1825,7 +2298,7 @@ void Net<Dtype>::Backward() {
 template <typename Dtype>
 void Net<Dtype>::Reshape() {
   for (int i = 0; i < layers_.size(); ++i) {
-    layers_[i]->Reshape(bottom_vecs_[i], top_vecs_[i]);
+    layers_[i]->ReshapeIfChanged(bottom_vecs_[i], top_vecs_[i]);
   }
 }
 
@@ -1875,8 +2348,10 @@ void Net<Dtype>::CopyTrainedLayersFrom(const NetParameter& param_inp) {
       }
       const bool kReshape = false;
       target_blobs[j]->FromProto(source_layer.blobs(j), kReshape);
+      MarkParamLoaded(target_layer_id, j);
     }
   }
+  FillUnloadedParams();
 }
 
 template <typename Dtype>
@@ -1904,6 +2379,39 @@ void Net<Dtype>::CopyTrainedLayersFromHDF5(const string trained_filename) {
   CHECK_GE(file_hid, 0) << "Couldn't open " << trained_filename;
   hid_t data_hid = H5Gopen2(file_hid, "data", H5P_DEFAULT);
   CHECK_GE(data_hid, 0) << "Error reading weights from " << trained_filename;
+  if (this->bn_scale_remove_) {
+    // BatchNorm/Scale have been folded into their producers, so the raw
+    // blobs can't be copied one by one. Attach them to the pre-compile
+    // topology and let CopyTrainedLayersFrom fold them in memory.
+    NetParameter param;
+    param.CopyFrom(uncompiled_param_);
+    for (int i = 0; i < param.layer_size(); ++i) {
+      LayerParameter* layer_param = param.mutable_layer(i);
+      if (!H5Lexists(data_hid, layer_param->name().c_str(), H5P_DEFAULT)) {
+        continue;
+      }
+      hid_t layer_hid = H5Gopen2(data_hid, layer_param->name().c_str(),
+          H5P_DEFAULT);
+      CHECK_GE(layer_hid, 0)
+          << "Error reading weights from " << trained_filename;
+      for (int j = 0; ; ++j) {
+        ostringstream oss;
+        oss << j;
+        if (!H5Lexists(layer_hid, oss.str().c_str(), H5P_DEFAULT)) {
+          break;
+        }
+        Blob<Dtype> blob;
+        hdf5_load_nd_dataset(layer_hid, oss.str().c_str(), 0, kMaxBlobAxes,
+            &blob);
+        blob.ToProto(layer_param->add_blobs());
+      }
+      H5Gclose(layer_hid);
+    }
+    H5Gclose(data_hid);
+    H5Fclose(file_hid);
+    CopyTrainedLayersFrom(param);
+    return;
+  }
   int num_layers = hdf5_get_num_links(data_hid);
   for (int i = 0; i < num_layers; ++i) {
     string source_layer_name = hdf5_get_name_by_idx(data_hid, i);
@@ -1940,11 +2448,59 @@ void Net<Dtype>::CopyTrainedLayersFromHDF5(const string trained_filename) {
       }
       hdf5_load_nd_dataset(layer_hid, dataset_name.c_str(), 0, kMaxBlobAxes,
           target_blobs[j].get());
+      MarkParamLoaded(target_layer_id, j);
     }
     H5Gclose(layer_hid);
   }
   H5Gclose(data_hid);
   H5Fclose(file_hid);
+  FillUnloadedParams();
+}
+
+template <typename Dtype>
+void Net<Dtype>::FillUnloadedParams() {
+  if (unloaded_params_.empty()) {
+    return;
+  }
+  const bool skip_param_fill = Caffe::skip_param_fill();
+  Caffe::set_skip_param_fill(false);
+  for (size_t i = 0; i < layers_.size(); ++i) {
+    // Shared params hold the data of their owner, which is filled instead.
+    vector<int> unloaded;
+    for (size_t j = 0; j < unloaded_params_[i].size(); ++j) {
+      if (unloaded_params_[i][j] &&
+          param_owners_[param_id_vecs_[i][j]] == -1) {
+        unloaded.push_back(j);
+      }
+    }
+    if (unloaded.empty()) {
+      continue;
+    }
+    LOG(INFO) << "Filling " << unloaded.size() << " params of layer "
+        << layer_names_[i] << " not covered by the trained weights";
+    // Set up a fresh copy of the layer on blobs of the same shapes, so that
+    // its fillers see the same fan-in and fan-out.
+    shared_ptr<Layer<Dtype> > layer =
+        LayerRegistry<Dtype>::CreateLayer(layers_[i]->layer_param());
+    vector<shared_ptr<Blob<Dtype> > > scratch;
+    vector<Blob<Dtype>*> bottom, top;
+    for (size_t k = 0; k < bottom_vecs_[i].size(); ++k) {
+      scratch.push_back(shared_ptr<Blob<Dtype> >(
+          new Blob<Dtype>(bottom_vecs_[i][k]->shape())));
+      bottom.push_back(scratch.back().get());
+    }
+    for (size_t k = 0; k < top_vecs_[i].size(); ++k) {
+      scratch.push_back(shared_ptr<Blob<Dtype> >(new Blob<Dtype>()));
+      top.push_back(scratch.back().get());
+    }
+    layer->SetUp(bottom, top);
+    for (size_t k = 0; k < unloaded.size(); ++k) {
+      layers_[i]->blobs()[unloaded[k]]->CopyFrom(
+          *layer->blobs()[unloaded[k]]);
+    }
+  }
+  Caffe::set_skip_param_fill(skip_param_fill);
+  unloaded_params_.clear();
 }
 
 template <typename Dtype>
@@ -2036,7 +2592,10 @@ void Net<Dtype>::ClearParamDiffs(int learnable_param_id) {
   Blob<Dtype>* blob = learnable_params_[learnable_param_id];
   switch (Caffe::mode()) {
   case Caffe::CPU:
-      if (blob->prv_diff()) {
+      if (blob->diff_rows()) {
+        blob->ClearSparseDiff();
+      }
+      else if (blob->prv_diff()) {
         caffe_set(blob->prv_diff_count(), static_cast<Dtype>(0),
                   blob->mutable_prv_diff());
       }
@@ -2069,8 +2628,17 @@ template <typename Dtype>
 void Net<Dtype>::ShareWeights() {
   for (int i = 0; i < params_.size(); ++i) {
     if (param_owners_[i] < 0) { continue; }
-    params_[i]->ShareData(*params_[param_owners_[i]]);
-    params_[i]->ShareDiff(*params_[param_owners_[i]]);
+    Blob<Dtype>* owner = params_[param_owners_[i]].get();
+    if (params_[i]->diff_rows() || owner->diff_rows()) {
+      // The rows touched through one of the sharing layers are not visible
+      // through the other blob, so shared parameters keep a dense diff.
+      LOG(INFO) << "Sharing parameter " << param_display_names_[i]
+                << ": falling back to a dense gradient";
+      params_[i]->set_diff_row_sparse(false);
+      owner->set_diff_row_sparse(false);
+    }
+    params_[i]->ShareData(*owner);
+    params_[i]->ShareDiff(*owner);
   }
 }
 
@@ -44,18 +44,37 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <vector>
 
 #include <numeric>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
+#include "boost/atomic.hpp"
 #include "boost/bind.hpp"
+#include "boost/thread.hpp"
 #include "caffe/solver.hpp"
 #include "caffe/util/bbox_util.hpp"
 #include "caffe/util/format.hpp"
 #include "caffe/util/hdf5.hpp"
 #include "caffe/util/io.hpp"
+#include "caffe/util/math_functions.hpp"
 #include "caffe/util/performance.hpp"
 #include "caffe/util/upgrade_proto.hpp"
 
 namespace caffe {
 
+template <typename Dtype>
+class Solver<Dtype>::AsyncTest {
+ public:
+  AsyncTest() : done_(false), train_threads_(1) {}
+
+  shared_ptr<boost::thread> thread_;
+  // Set by the test thread when it finishes, so that training can pick up
+  // the reserved cores without blocking on a join.
+  boost::atomic<bool> done_;
+  // OpenMP threads training ran with before cores were reserved.
+  int train_threads_;
+};
+
 template<typename Dtype>
 void Solver<Dtype>::SetActionFunction(ActionCallback func) {
   action_request_function_ = func;
@@ -74,7 +93,8 @@ template <typename Dtype>
 Solver<Dtype>::Solver(const SolverParameter& param, const Solver* root_solver)
     : net_(), callbacks_(), root_solver_(root_solver),
       requested_early_exit_(false),
-      forward_backward_(boost::bind(&Solver<Dtype>::ForwardBackward, this)) {
+      forward_backward_(boost::bind(&Solver<Dtype>::ForwardBackward, this)),
+      test_iter_(0) {
   Init(param);
   Caffe::set_iter_size(param_.iter_size());
 }
@@ -83,7 +103,8 @@ template <typename Dtype>
 Solver<Dtype>::Solver(const string& param_file, const Solver* root_solver)
     : net_(), callbacks_(), root_solver_(root_solver),
       requested_early_exit_(false),
-      forward_backward_(boost::bind(&Solver<Dtype>::ForwardBackward, this)) {
+      forward_backward_(boost::bind(&Solver<Dtype>::ForwardBackward, this)),
+      test_iter_(0) {
   SolverParameter param;
   ReadSolverParamsFromTextFileOrDie(param_file, &param);
   Init(param);
@@ -101,6 +122,8 @@ void Solver<Dtype>::Init(const SolverParameter& param) {
     << std::endl << param_.DebugString();
 
   CHECK_GE(param_.average_loss(), 1) << "average_loss should be non-negative.";
+  CHECK_GT(param_.test_async_threads(), 0)
+      << "test_async_threads should be positive.";
   if (Caffe::root_solver() && param_.random_seed() >= 0) {
     Caffe::set_random_seed(param_.random_seed());
   }
@@ -115,6 +138,11 @@ void Solver<Dtype>::Init(const SolverParameter& param) {
 
 }
 
+template <typename Dtype>
+Solver<Dtype>::~Solver() {
+  FinishAsyncTest(true);
+}
+
 template <typename Dtype>
 void Solver<Dtype>::InitTrainNet() {
   const int num_train_nets = param_.has_net() + param_.has_net_param() +
@@ -273,13 +301,21 @@ void Solver<Dtype>::Step(int iters) {
   smoothed_loss_ = 0;
 
   while (iter_ < stop_iter) {
+    if (async_test_ && async_test_->done_) {
+      FinishAsyncTest(false);
+    }
     if (param_.test_interval() && iter_ % param_.test_interval() == 0
         && (iter_ > 0 || param_.test_initialization())
         && Caffe::root_solver()) {
-      TestAll();
-      if (requested_early_exit_) {
-        // Break out of the while loop because stop was requested while testing.
-        break;
+      if (param_.test_async()) {
+        StartAsyncTest();
+      } else {
+        TestAll();
+        if (requested_early_exit_) {
+          // Break out of the while loop because stop was requested while
+          // testing.
+          break;
+        }
       }
     }
 
@@ -370,6 +406,9 @@ void Solver<Dtype>::Step(int iters) {
       break;
     }
   }
+  // Report the last asynchronous test pass before returning to the caller,
+  // unless training was stopped.
+  FinishAsyncTest(requested_early_exit_);
 
 #ifdef CAFFE_PER_LAYER_TIMINGS
   net_->ResetTimers();
@@ -432,9 +471,13 @@ void Solver<Dtype>::Solve(const char* resume_file) {
 
 template <typename Dtype>
 void Solver<Dtype>::TestAll() {
+  FinishAsyncTest(false);
+  test_iter_ = iter_;
   for (int test_net_id = 0;
        test_net_id < test_nets_.size() && !requested_early_exit_;
        ++test_net_id) {
+    CHECK_NOTNULL(test_nets_[test_net_id].get())->
+        ShareTrainedLayersWith(net_.get());
     if (param_.eval_type() == "classification") {
       TestClassification(test_net_id);
     } else if (param_.eval_type() == "detection") {
@@ -445,31 +488,119 @@ void Solver<Dtype>::TestAll() {
   }
 }
 
+template <typename Dtype>
+void Solver<Dtype>::StartAsyncTest() {
+  if (async_test_) {
+    LOG(WARNING) << "Test pass of iteration " << test_iter_
+                 << " is still running at iteration " << iter_
+                 << "; waiting for it. Consider a larger test_interval.";
+    FinishAsyncTest(false);
+  }
+  // The test nets get a private copy of the weights, so training may keep
+  // updating net_ while they run.
+  test_iter_ = iter_;
+  for (int test_net_id = 0; test_net_id < test_nets_.size(); ++test_net_id) {
+    CHECK_NOTNULL(test_nets_[test_net_id].get())->
+        CopyTrainedLayersFrom(net_.get());
+  }
+  async_test_.reset(new AsyncTest());
+  int test_threads = param_.test_async_threads();
+#ifdef _OPENMP
+  // Split the cores between training and testing for the pass.
+  async_test_->train_threads_ = omp_get_max_threads();
+  test_threads = std::min(test_threads,
+      std::max(async_test_->train_threads_ - 1, 1));
+  omp_set_num_threads(
+      std::max(async_test_->train_threads_ - test_threads, 1));
+#endif
+  LOG(INFO) << "Iteration " << iter_ << ", starting asynchronous test on "
+            << test_threads << " thread(s)";
+
+  int device = 0;
+#ifndef CPU_ONLY
+  CUDA_CHECK(cudaGetDevice(&device));
+#endif
+  const Caffe::Brew mode = Caffe::mode();
+  const int rand_seed = caffe_rng_rand();
+  const int solver_count = Caffe::solver_count();
+  AsyncTest* async_test = async_test_.get();
+  async_test->thread_.reset(new boost::thread([=]() {
+#ifndef CPU_ONLY
+    CUDA_CHECK(cudaSetDevice(device));
+#endif
+    Caffe::set_mode(mode);
+    Caffe::set_random_seed(rand_seed);
+    Caffe::set_solver_count(solver_count);
+    Caffe::set_root_solver(true);
+#ifdef _OPENMP
+    omp_set_num_threads(test_threads);
+#endif
+    CPUTimer timer;
+    timer.Start();
+    try {
+      for (int test_net_id = 0; test_net_id < test_nets_.size();
+           ++test_net_id) {
+        if (param_.eval_type() == "classification") {
+          TestClassification(test_net_id);
+        } else if (param_.eval_type() == "detection") {
+          TestDetection(test_net_id);
+        } else {
+          LOG(FATAL) << "Unknown evaluation type: " << param_.eval_type();
+        }
+      }
+      LOG(INFO) << "Iteration " << test_iter_ << ", asynchronous test done in "
+                << timer.MilliSeconds() << " ms";
+    } catch (boost::thread_interrupted&) {
+      LOG(INFO) << "Test interrupted.";
+    }
+    async_test->done_ = true;
+  }));
+}
+
+template <typename Dtype>
+void Solver<Dtype>::FinishAsyncTest(bool interrupt) {
+  if (!async_test_) {
+    return;
+  }
+  if (interrupt) {
+    async_test_->thread_->interrupt();
+  }
+  async_test_->thread_->join();
+#ifdef _OPENMP
+  omp_set_num_threads(async_test_->train_threads_);
+#endif
+  async_test_.reset();
+}
+
 template <typename Dtype>
 void Solver<Dtype>::TestClassification(const int test_net_id) {
   CHECK(Caffe::root_solver());
-  LOG(INFO) << "Iteration " << iter_
+  LOG(INFO) << "Iteration " << test_iter_
             << ", Testing net (#" << test_net_id << ")";
-  CHECK_NOTNULL(test_nets_[test_net_id].get())->
-      ShareTrainedLayersWith(net_.get());
   vector<Dtype> test_score;
   vector<int> test_score_output_id;
   const shared_ptr<Net<Dtype> >& test_net = test_nets_[test_net_id];
   Dtype loss = 0;
   for (int i = 0; i < param_.test_iter(test_net_id); ++i) {
-    SolverAction::Enum request = GetRequestedAction();
-    // Check to see if stoppage of testing/training has been requested.
-    while (request != SolverAction::NONE) {
-        if (SolverAction::SNAPSHOT == request) {
-          Snapshot();
-        } else if (SolverAction::STOP == request) {
-          requested_early_exit_ = true;
-        }
-        request = GetRequestedAction();
-    }
-    if (requested_early_exit_) {
-      // break out of test loop.
-      break;
+    if (async_test_) {
+      // Requests are served by the training loop, which interrupts this
+      // thread to stop testing.
+      boost::this_thread::interruption_point();
+    } else {
+      SolverAction::Enum request = GetRequestedAction();
+      // Check to see if stoppage of testing/training has been requested.
+      while (request != SolverAction::NONE) {
+          if (SolverAction::SNAPSHOT == request) {
+            Snapshot();
+          } else if (SolverAction::STOP == request) {
+            requested_early_exit_ = true;
+          }
+          request = GetRequestedAction();
+      }
+      if (requested_early_exit_) {
+        // break out of test loop.
+        break;
+      }
     }
 
     Dtype iter_loss;
@@ -496,7 +627,7 @@ void Solver<Dtype>::TestClassification(const int test_net_id) {
       }
     }
   }
-  if (requested_early_exit_) {
+  if (!async_test_ && requested_early_exit_) {
     LOG(INFO)     << "Test interrupted.";
     return;
   }
@@ -523,29 +654,33 @@ void Solver<Dtype>::TestClassification(const int test_net_id) {
 template <typename Dtype>
 void Solver<Dtype>::TestDetection(const int test_net_id) {
   CHECK(Caffe::root_solver());
-  LOG(INFO) << "Iteration " << iter_
+  LOG(INFO) << "Iteration " << test_iter_
             << ", Testing net (#" << test_net_id << ")";
-  CHECK_NOTNULL(test_nets_[test_net_id].get())->
-      ShareTrainedLayersWith(net_.get());
   map<int, map<int, vector<pair<float, int> > > > all_true_pos;
   map<int, map<int, vector<pair<float, int> > > > all_false_pos;
   map<int, map<int, int> > all_num_pos;
   const shared_ptr<Net<Dtype> >& test_net = test_nets_[test_net_id];
   Dtype loss = 0;
   for (int i = 0; i < param_.test_iter(test_net_id); ++i) {
-    SolverAction::Enum request = GetRequestedAction();
-    // Check to see if stoppage of testing/training has been requested.
-    while (request != SolverAction::NONE) {
-        if (SolverAction::SNAPSHOT == request) {
-          Snapshot();
-        } else if (SolverAction::STOP == request) {
-          requested_early_exit_ = true;
-        }
-        request = GetRequestedAction();
-    }
-    if (requested_early_exit_) {
-      // break out of test loop.
-      break;
+    if (async_test_) {
+      // Requests are served by the training loop, which interrupts this
+      // thread to stop testing.
+      boost::this_thread::interruption_point();
+    } else {
+      SolverAction::Enum request = GetRequestedAction();
+      // Check to see if stoppage of testing/training has been requested.
+      while (request != SolverAction::NONE) {
+          if (SolverAction::SNAPSHOT == request) {
+            Snapshot();
+          } else if (SolverAction::STOP == request) {
+            requested_early_exit_ = true;
+          }
+          request = GetRequestedAction();
+      }
+      if (requested_early_exit_) {
+        // break out of test loop.
+        break;
+      }
     }
 
     Dtype iter_loss;
@@ -583,7 +718,7 @@ void Solver<Dtype>::TestDetection(const int test_net_id) {
       }
     }
   }
-  if (requested_early_exit_) {
+  if (!async_test_ && requested_early_exit_) {
     LOG(INFO)     << "Test interrupted.";
     return;
   }
@@ -143,6 +143,33 @@ void AdaDeltaSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
   }
 }
 
+template <typename Dtype>
+void AdaDeltaSolver<Dtype>::FusedUpdate(
+    const typename SGDSolver<Dtype>::FusedState& state, int param_id,
+    Dtype rate, int begin, int end) {
+  const RegularizedGradient<Dtype> gradient =
+      this->GetRegularizedGradient(param_id);
+  const Dtype local_rate = rate * this->net_->params_lr()[param_id];
+  const Dtype delta = this->param_.delta();
+  const Dtype momentum = this->param_.momentum();
+  Dtype* data = state.data;
+  Dtype* diff = state.diff;
+  Dtype* history = state.history;
+  Dtype* update_history = state.history2;
+#ifdef _OPENMP
+  #pragma omp simd
+#endif
+  for (int i = begin; i < end; ++i) {
+    Dtype g = gradient(data[i], diff[i]);
+    history[i] = momentum * history[i] + (Dtype(1) - momentum) * g * g;
+    g *= std::sqrt((update_history[i] + delta) / (history[i] + delta));
+    update_history[i] = momentum * update_history[i] +
+        (Dtype(1) - momentum) * g * g;
+    diff[i] = local_rate * g;
+    data[i] -= diff[i];
+  }
+}
+
 INSTANTIATE_CLASS(AdaDeltaSolver);
 REGISTER_SOLVER_CLASS(AdaDelta);
 
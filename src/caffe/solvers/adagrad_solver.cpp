@@ -101,6 +101,28 @@ void AdaGradSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
   }
 }
 
+template <typename Dtype>
+void AdaGradSolver<Dtype>::FusedUpdate(
+    const typename SGDSolver<Dtype>::FusedState& state, int param_id,
+    Dtype rate, int begin, int end) {
+  const RegularizedGradient<Dtype> gradient =
+      this->GetRegularizedGradient(param_id);
+  const Dtype local_rate = rate * this->net_->params_lr()[param_id];
+  const Dtype delta = this->param_.delta();
+  Dtype* data = state.data;
+  Dtype* diff = state.diff;
+  Dtype* history = state.history;
+#ifdef _OPENMP
+  #pragma omp simd
+#endif
+  for (int i = begin; i < end; ++i) {
+    const Dtype g = gradient(data[i], diff[i]);
+    history[i] += g * g;
+    diff[i] = local_rate * g / (std::sqrt(history[i]) + delta);
+    data[i] -= diff[i];
+  }
+}
+
 INSTANTIATE_CLASS(AdaGradSolver);
 REGISTER_SOLVER_CLASS(AdaGrad);
 
@@ -125,6 +125,73 @@ void AdamSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
   }
 }
 
+template <typename Dtype>
+void AdamSolver<Dtype>::ComputeSparseUpdateValue(int param_id, Dtype rate) {
+  Blob<Dtype>* param = this->net_->learnable_params()[param_id];
+  const vector<int>& rows = *param->diff_rows();
+  const int row_size = param->count(1);
+  const Dtype local_rate = rate * this->net_->params_lr()[param_id];
+  const Dtype beta1 = this->param_.momentum();
+  const Dtype beta2 = this->param_.momentum2();
+  const Dtype eps_hat = this->param_.delta();
+
+  const int t = this->iter_ + 1;
+  const Dtype correction = std::sqrt(Dtype(1) - pow(beta2, t)) /
+      (Dtype(1.) - pow(beta1, t));
+  const Dtype step = local_rate * correction;
+
+  // Lazy Adam: only the moments of rows with a gradient are decayed and
+  // updated, the bias correction still follows the global iteration.
+  size_t update_history_offset = this->net_->learnable_params().size();
+  Dtype* m = this->history_[param_id]->mutable_cpu_data();
+  Dtype* v = this->history_[param_id + update_history_offset]
+      ->mutable_cpu_data();
+  Dtype* diff = param->mutable_cpu_diff();
+#ifdef _OPENMP
+  #pragma omp parallel for if (rows.size() > 64)
+#endif
+  for (int i = 0; i < rows.size(); ++i) {
+    const size_t offset = static_cast<size_t>(rows[i]) * row_size;
+    for (int j = 0; j < row_size; ++j) {
+      const Dtype g = diff[offset + j];
+      m[offset + j] = beta1 * m[offset + j] + (Dtype(1) - beta1) * g;
+      v[offset + j] = beta2 * v[offset + j] + (Dtype(1) - beta2) * g * g;
+      diff[offset + j] = step * m[offset + j] /
+          (std::sqrt(v[offset + j]) + eps_hat);
+    }
+  }
+}
+
+template <typename Dtype>
+void AdamSolver<Dtype>::FusedUpdate(
+    const typename SGDSolver<Dtype>::FusedState& state, int param_id,
+    Dtype rate, int begin, int end) {
+  const RegularizedGradient<Dtype> gradient =
+      this->GetRegularizedGradient(param_id);
+  const Dtype local_rate = rate * this->net_->params_lr()[param_id];
+  const Dtype beta1 = this->param_.momentum();
+  const Dtype beta2 = this->param_.momentum2();
+  const Dtype eps_hat = this->param_.delta();
+  const int t = this->iter_ + 1;
+  const Dtype correction = std::sqrt(Dtype(1) - pow(beta2, t)) /
+      (Dtype(1.) - pow(beta1, t));
+  const Dtype step = local_rate * correction;
+  Dtype* data = state.data;
+  Dtype* diff = state.diff;
+  Dtype* m = state.history;
+  Dtype* v = state.history2;
+#ifdef _OPENMP
+  #pragma omp simd
+#endif
+  for (int i = begin; i < end; ++i) {
+    const Dtype g = gradient(data[i], diff[i]);
+    m[i] = beta1 * m[i] + (Dtype(1) - beta1) * g;
+    v[i] = beta2 * v[i] + (Dtype(1) - beta2) * g * g;
+    diff[i] = step * m[i] / (std::sqrt(v[i]) + eps_hat);
+    data[i] -= diff[i];
+  }
+}
+
 INSTANTIATE_CLASS(AdamSolver);
 REGISTER_SOLVER_CLASS(Adam);
 
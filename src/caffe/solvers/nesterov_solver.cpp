@@ -93,6 +93,30 @@ void NesterovSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
   }
 }
 
+template <typename Dtype>
+void NesterovSolver<Dtype>::FusedUpdate(
+    const typename SGDSolver<Dtype>::FusedState& state, int param_id,
+    Dtype rate, int begin, int end) {
+  const RegularizedGradient<Dtype> gradient =
+      this->GetRegularizedGradient(param_id);
+  const Dtype local_rate = rate * this->net_->params_lr()[param_id];
+  const Dtype momentum = this->param_.momentum();
+  Dtype* data = state.data;
+  Dtype* diff = state.diff;
+  Dtype* history = state.history;
+#ifdef _OPENMP
+  #pragma omp simd
+#endif
+  for (int i = begin; i < end; ++i) {
+    const Dtype history_prev = history[i];
+    history[i] = local_rate * gradient(data[i], diff[i]) +
+        momentum * history[i];
+    // step back then over step
+    diff[i] = (Dtype(1) + momentum) * history[i] - momentum * history_prev;
+    data[i] -= diff[i];
+  }
+}
+
 INSTANTIATE_CLASS(NesterovSolver);
 REGISTER_SOLVER_CLASS(Nesterov);
 
@@ -87,15 +87,15 @@ void RMSPropSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
       this->history_[param_id]->cpu_data(),
       this->update_[param_id]->mutable_cpu_data());
 
-    // add delta
-    caffe_add_scalar(net_params[param_id]->count(),
-      delta, this->update_[param_id]->mutable_cpu_data());
-
     // prepare update
     caffe_powx(net_params[param_id]->count(),
       this->update_[param_id]->cpu_data(), Dtype(0.5),
       this->update_[param_id]->mutable_cpu_data());
 
+    // add delta
+    caffe_add_scalar(net_params[param_id]->count(),
+      delta, this->update_[param_id]->mutable_cpu_data());
+
     caffe_div(net_params[param_id]->count(),
       diff_ptr, this->update_[param_id]->cpu_data(),
       this->update_[param_id]->mutable_cpu_data());
@@ -125,6 +125,29 @@ void RMSPropSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
   }
 }
 
+template <typename Dtype>
+void RMSPropSolver<Dtype>::FusedUpdate(
+    const typename SGDSolver<Dtype>::FusedState& state, int param_id,
+    Dtype rate, int begin, int end) {
+  const RegularizedGradient<Dtype> gradient =
+      this->GetRegularizedGradient(param_id);
+  const Dtype local_rate = rate * this->net_->params_lr()[param_id];
+  const Dtype delta = this->param_.delta();
+  const Dtype rms_decay = this->param_.rms_decay();
+  Dtype* data = state.data;
+  Dtype* diff = state.diff;
+  Dtype* history = state.history;
+#ifdef _OPENMP
+  #pragma omp simd
+#endif
+  for (int i = begin; i < end; ++i) {
+    const Dtype g = gradient(data[i], diff[i]);
+    history[i] = rms_decay * history[i] + (Dtype(1) - rms_decay) * g * g;
+    diff[i] = local_rate * g / (std::sqrt(history[i]) + delta);
+    data[i] -= diff[i];
+  }
+}
+
 INSTANTIATE_CLASS(RMSPropSolver);
 REGISTER_SOLVER_CLASS(RMSProp);
 
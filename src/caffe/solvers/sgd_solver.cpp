@@ -35,6 +35,7 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -233,13 +234,114 @@ void SGDSolver<Dtype>::ApplyUpdate() {
     LAYER_UPDATE_TIMING_STOP(i);
   }
 #else
+  vector<int> fused_param_ids;
   for (int param_id = 0; param_id < this->net_->learnable_params().size();
        ++param_id) {
-    ApplyUpdate(param_id);
+    if (UseFusedUpdate(param_id)) {
+      fused_param_ids.push_back(param_id);
+    } else {
+      ApplyUpdate(param_id);
+    }
+  }
+  if (fused_param_ids.size()) {
+    ApplyFusedUpdates(fused_param_ids, GetLearningRate());
   }
 #endif
 }
 
+// Elements per work item of the fused update; parameters are cut into
+// chunks of this size so that small and large ones balance across threads.
+static const int kFusedUpdateChunk = 16384;
+
+template <typename Dtype>
+bool SGDSolver<Dtype>::UseFusedUpdate(int param_id) {
+  if (!this->param_.fused_update() || Caffe::mode() != Caffe::CPU ||
+      !SupportsFusedUpdate()) {
+    return false;
+  }
+  Blob<Dtype>* param = this->net_->learnable_params()[param_id];
+  // Zero learning rates, row-sparse gradients and MKL private layouts are
+  // handled by ApplyUpdate(param_id).
+  return this->net_->params_lr()[param_id] != 0 && !param->diff_rows() &&
+      !param->prv_diff() && !param->prv_data();
+}
+
+template <typename Dtype>
+RegularizedGradient<Dtype> SGDSolver<Dtype>::GetRegularizedGradient(
+    int param_id) const {
+  RegularizedGradient<Dtype> gradient;
+  gradient.scale = Dtype(1) / this->param_.iter_size();
+  gradient.decay = this->param_.weight_decay() *
+      this->net_->params_weight_decay()[param_id];
+  const string& regularization_type = this->param_.regularization_type();
+  if (gradient.decay && regularization_type != "L1" &&
+      regularization_type != "L2") {
+    LOG(FATAL) << "Unknown regularization type: " << regularization_type;
+  }
+  gradient.l1 = regularization_type == "L1";
+  return gradient;
+}
+
+template <typename Dtype>
+void SGDSolver<Dtype>::ApplyFusedUpdates(const vector<int>& param_ids,
+    Dtype rate) {
+  CHECK(Caffe::root_solver());
+  const vector<Blob<Dtype>*>& net_params = this->net_->learnable_params();
+  const size_t num_params = net_params.size();
+  vector<FusedState> states(param_ids.size());
+  vector<std::pair<int, int> > chunks;
+  for (int i = 0; i < param_ids.size(); ++i) {
+    const int param_id = param_ids[i];
+    states[i].data = net_params[param_id]->mutable_cpu_data();
+    states[i].diff = net_params[param_id]->mutable_cpu_diff();
+    states[i].history = history_[param_id]->mutable_cpu_data();
+    states[i].history2 = history_.size() > num_params ?
+        history_[num_params + param_id]->mutable_cpu_data() : NULL;
+    for (int begin = 0; begin < net_params[param_id]->count();
+         begin += kFusedUpdateChunk) {
+      chunks.push_back(std::make_pair(i, begin));
+    }
+  }
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) if (chunks.size() > 1)
+#endif
+  for (int c = 0; c < chunks.size(); ++c) {
+    const int i = chunks[c].first;
+    const int param_id = param_ids[i];
+    const int begin = chunks[c].second;
+    const int end = std::min(begin + kFusedUpdateChunk,
+                             static_cast<int>(net_params[param_id]->count()));
+    FusedUpdate(states[i], param_id, rate, begin, end);
+  }
+}
+
+template <typename Dtype>
+void SGDSolver<Dtype>::FusedUpdate(const FusedState& state, int param_id,
+    Dtype rate, int begin, int end) {
+  const RegularizedGradient<Dtype> gradient = GetRegularizedGradient(param_id);
+  const Dtype local_rate = rate * this->net_->params_lr()[param_id];
+  Dtype momentum = this->param_.momentum();
+  if (this->param_.warmup_iter() > 0 &&
+      this->iter_ < this->param_.warmup_iter()) {
+    // Momentum correction during warmup stage
+    Dtype prev_rate = GetWarmUpLR(this->iter_ - 1, this->param_.warmup_iter(),
+                                  this->param_.warmup_start_lr());
+    momentum = momentum * (rate / prev_rate);
+  }
+  Dtype* data = state.data;
+  Dtype* diff = state.diff;
+  Dtype* history = state.history;
+#ifdef _OPENMP
+  #pragma omp simd
+#endif
+  for (int i = begin; i < end; ++i) {
+    history[i] = local_rate * gradient(data[i], diff[i]) +
+        momentum * history[i];
+    diff[i] = history[i];
+    data[i] -= history[i];
+  }
+}
+
 template <typename Dtype>
 void SGDSolver<Dtype>::ApplyUpdate(int param_id) {
   CHECK(Caffe::root_solver());
@@ -253,6 +355,13 @@ void SGDSolver<Dtype>::ApplyUpdate(int param_id) {
     return;
   }
 
+  if (UseSparseUpdate(param_id)) {
+    SparseNormalizeRegularize(param_id);
+    ComputeSparseUpdateValue(param_id, rate);
+    this->net_->learnable_params()[param_id]->Update();
+    return;
+  }
+
 #ifdef ENABLE_SGD_FUSION
   if ((Caffe::mode() == Caffe::CPU) && (this->type() == string("SGD")))
   {
@@ -601,6 +710,91 @@ void SGDSolver<Dtype>::Regularize(int param_id) {
   }
 }
 
+template <typename Dtype>
+bool SGDSolver<Dtype>::UseSparseUpdate(int param_id) {
+  Blob<Dtype>* param = this->net_->learnable_params()[param_id];
+  if (!param->diff_rows()) { return false; }
+  bool supported = (Caffe::mode() == Caffe::CPU) && SupportsSparseUpdate();
+#ifdef USE_MLSL
+  // diffs reduced across nodes are no longer limited to the local rows
+  supported = supported && !mn::is_multinode();
+#endif
+  if (!supported) {
+    // The dense update writes every row of the diff, so stop tracking rows.
+    LOG(INFO) << this->type() << " solver: using a dense gradient for "
+              << "row-sparse parameter " << param_id;
+    param->set_diff_row_sparse(false);
+  }
+  return supported;
+}
+
+template <typename Dtype>
+void SGDSolver<Dtype>::SparseNormalizeRegularize(int param_id) {
+  Blob<Dtype>* param = this->net_->learnable_params()[param_id];
+  const vector<int>& rows = *param->diff_rows();
+  const int row_size = param->count(1);
+  const Dtype accum_normalization = Dtype(1.) / this->param_.iter_size();
+  const string& regularization_type = this->param_.regularization_type();
+  const Dtype local_decay = this->param_.weight_decay() *
+      this->net_->params_weight_decay()[param_id];
+  if (local_decay) {
+    CHECK(regularization_type == "L2" || regularization_type == "L1")
+        << "Unknown regularization type: " << regularization_type;
+  }
+  const bool l1 = (regularization_type == "L1");
+  const Dtype* data = param->cpu_data();
+  Dtype* diff = param->mutable_cpu_diff();
+
+#ifdef _OPENMP
+  #pragma omp parallel for if (rows.size() > 64)
+#endif
+  for (int i = 0; i < rows.size(); ++i) {
+    const size_t offset = static_cast<size_t>(rows[i]) * row_size;
+    const Dtype* w = data + offset;
+    Dtype* g = diff + offset;
+    if (this->param_.iter_size() > 1) {
+      for (int j = 0; j < row_size; ++j) { g[j] *= accum_normalization; }
+    }
+    if (local_decay) {
+      for (int j = 0; j < row_size; ++j) {
+        g[j] += local_decay * (l1 ? Dtype(caffe_sign(w[j])) : w[j]);
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+void SGDSolver<Dtype>::ComputeSparseUpdateValue(int param_id, Dtype rate) {
+  Blob<Dtype>* param = this->net_->learnable_params()[param_id];
+  const vector<int>& rows = *param->diff_rows();
+  const int row_size = param->count(1);
+  Dtype momentum = this->param_.momentum();
+  const Dtype local_rate = rate * GetLocalRate(param_id);
+
+  if (this->param_.warmup_iter() > 0 &&
+      this->iter_ < this->param_.warmup_iter()) {
+    // Momentum correction during warmup stage
+    Dtype prev_rate = GetWarmUpLR(this->iter_ - 1, this->param_.warmup_iter(),
+                                  this->param_.warmup_start_lr());
+    momentum = momentum * (rate / prev_rate);
+  }
+  // Lazy momentum: history of rows without a gradient is left untouched.
+  Dtype* history = history_[param_id]->mutable_cpu_data();
+  Dtype* diff = param->mutable_cpu_diff();
+#ifdef _OPENMP
+  #pragma omp parallel for if (rows.size() > 64)
+#endif
+  for (int i = 0; i < rows.size(); ++i) {
+    const size_t offset = static_cast<size_t>(rows[i]) * row_size;
+    Dtype* h = history + offset;
+    Dtype* g = diff + offset;
+    for (int j = 0; j < row_size; ++j) {
+      h[j] = local_rate * g[j] + momentum * h[j];
+      g[j] = h[j];
+    }
+  }
+}
+
 #ifndef CPU_ONLY
 template <typename Dtype>
 void sgd_update_gpu(int N, Dtype* g, Dtype* h, Dtype momentum,
@@ -35,15 +35,29 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <boost/atomic.hpp>
+
 #include "caffe/common.hpp"
 #include "caffe/syncedmem.hpp"
 #include "caffe/util/math_functions.hpp"
 
 namespace caffe {
+
+static boost::atomic<uint64_t> prv_conversions(0);
+
+uint64_t PrvMemDescr::conversions() {
+  return prv_conversions;
+}
+
+void PrvMemDescr::count_conversion() {
+  ++prv_conversions;
+}
+
 SyncedMemory::~SyncedMemory() {
   if (cpu_ptr_ && own_cpu_data_) {
     CaffeFreeHost(cpu_ptr_, cpu_malloc_use_cuda_);
   }
+  HostAllocator::Get().Free(half_ptr_);
 
 #ifndef CPU_ONLY
   if (gpu_ptr_ && own_gpu_data_) {
@@ -61,8 +75,15 @@ SyncedMemory::~SyncedMemory() {
 inline void SyncedMemory::to_cpu() {
   switch (head_) {
   case UNINITIALIZED:
-    CaffeMallocHost(&cpu_ptr_, size_, &cpu_malloc_use_cuda_);
-    caffe_memset(size_, 0, cpu_ptr_);
+    if (cpu_ptr_ == NULL) {
+      CaffeMallocHost(&cpu_ptr_, size_, &cpu_malloc_use_cuda_);
+    }
+    if (cpu_malloc_use_cuda_) {
+      caffe_memset(size_, 0, cpu_ptr_);
+    } else {
+      // Parallel first touch places the pages next to the threads using them
+      HostAllocator::Get().Zero(cpu_ptr_, size_);
+    }
     head_ = HEAD_AT_CPU;
     own_cpu_data_ = true;
     break;
@@ -88,6 +109,21 @@ inline void SyncedMemory::to_cpu() {
     prv_descriptor_->on_to_cpu();
     head_ = SYNCED_PRV;
     break;
+  case HEAD_AT_HALF: {
+    // Refills the pages store_half discarded, at the same address
+    const size_t count =
+        size_ / (half_double_ ? sizeof(double) : sizeof(float));
+    if (half_double_) {
+      caffe_cpu_from_half(count, static_cast<const uint16_t*>(half_ptr_),
+          half_format_, static_cast<double*>(cpu_ptr_));
+    } else {
+      caffe_cpu_from_half(count, static_cast<const uint16_t*>(half_ptr_),
+          half_format_, static_cast<float*>(cpu_ptr_));
+    }
+    HostAllocator::Get().Discard(half_ptr_, count * sizeof(uint16_t));
+    head_ = HEAD_AT_CPU;
+  }
+    break;
   case SYNCED_PRV:
   case HEAD_AT_CPU:
   case SYNCED:
@@ -99,13 +135,16 @@ inline void SyncedMemory::to_gpu() {
 #ifndef CPU_ONLY
   switch (head_) {
   case UNINITIALIZED:
-    CUDA_CHECK(cudaGetDevice(&gpu_device_));
-    CUDA_CHECK(cudaMalloc(&gpu_ptr_, size_));
+    if (gpu_ptr_ == NULL) {
+      CUDA_CHECK(cudaGetDevice(&gpu_device_));
+      CUDA_CHECK(cudaMalloc(&gpu_ptr_, size_));
+    }
     caffe_gpu_memset(size_, 0, gpu_ptr_);
     head_ = HEAD_AT_GPU;
     own_gpu_data_ = true;
     break;
   case HEAD_AT_PRV:
+  case HEAD_AT_HALF:
     to_cpu();
   case HEAD_AT_CPU:
     if (gpu_ptr_ == NULL) {
@@ -140,6 +179,7 @@ void SyncedMemory::set_cpu_data(void* data) {
   cpu_ptr_ = data;
   head_ = HEAD_AT_CPU;
   own_cpu_data_ = false;
+  ++version_;
 }
 
 const void* SyncedMemory::gpu_data() {
@@ -169,6 +209,7 @@ void SyncedMemory::set_gpu_data(void* data) {
   gpu_ptr_ = data;
   head_ = HEAD_AT_GPU;
   own_gpu_data_ = false;
+  ++version_;
 #else
   NO_GPU;
 #endif
@@ -178,6 +219,7 @@ void* SyncedMemory::mutable_cpu_data() {
   boost::mutex::scoped_lock lock(mtx);
   to_cpu();
   head_ = HEAD_AT_CPU;
+  ++version_;
   return cpu_ptr_;
 }
 
@@ -186,6 +228,7 @@ void* SyncedMemory::mutable_gpu_data() {
 #ifndef CPU_ONLY
   to_gpu();
   head_ = HEAD_AT_GPU;
+  ++version_;
   return gpu_ptr_;
 #else
   NO_GPU;
@@ -209,8 +252,50 @@ void SyncedMemory::async_gpu_push(const cudaStream_t& stream) {
 }
 #endif
 
+template <typename Dtype>
+void SyncedMemory::store_half(HalfFormat format) {
+  boost::mutex::scoped_lock lock(mtx);
+  if (head_ != HEAD_AT_CPU || !own_cpu_data_ || cpu_malloc_use_cuda_ ||
+      prv_descriptor_) {
+    return;
+  }
+  const size_t count = size_ / sizeof(Dtype);
+  if (half_ptr_ == NULL) {
+    half_ptr_ = HostAllocator::Get().Allocate(count * sizeof(uint16_t));
+  }
+  caffe_cpu_to_half(count, static_cast<const Dtype*>(cpu_ptr_), format,
+      static_cast<uint16_t*>(half_ptr_));
+  // Layers may keep the address of the data, so only its pages are released
+  HostAllocator::Get().Discard(cpu_ptr_, size_);
+  half_format_ = format;
+  half_double_ = sizeof(Dtype) == sizeof(double);
+  head_ = HEAD_AT_HALF;
+}
+
+template void SyncedMemory::store_half<float>(HalfFormat format);
+template void SyncedMemory::store_half<double>(HalfFormat format);
+
+void SyncedMemory::Recycle() {
+  boost::mutex::scoped_lock lock(mtx);
+  if (!own_cpu_data_) {
+    cpu_ptr_ = NULL;
+  }
+#ifndef CPU_ONLY
+  if (!own_gpu_data_) {
+    gpu_ptr_ = NULL;
+  }
+#endif
+  prv_descriptor_.reset();
+  own_prv_data_ = false;
+  head_ = UNINITIALIZED;
+  ++version_;
+}
+
 void SyncedMemory::set_prv_descriptor(shared_ptr<PrvMemDescr> descriptor,
         bool same_data) {
+  if (head_ == HEAD_AT_HALF) {
+    to_cpu();
+  }
   // If it wasn't synced before, it won't be now.
   if (descriptor == NULL) {
     if (head_ != UNINITIALIZED)
@@ -237,18 +322,27 @@ const void* SyncedMemory::prv_data() {
 
 void* SyncedMemory::mutable_prv_data() {
   CHECK(prv_descriptor_.get());
+  if (head_ == HEAD_AT_HALF) {
+    to_cpu();
+  }
   if (head_ == HEAD_AT_CPU) {
     prv_descriptor_->convert_to_prv(cpu_ptr_);
   }
   head_ = HEAD_AT_PRV;
+  ++version_;
   return prv_descriptor_->prv_ptr();
 }
 
 void SyncedMemory::swap(shared_ptr<SyncedMemory> other) {
   std::swap(other->cpu_ptr_, this->cpu_ptr_);
+  std::swap(other->half_ptr_, this->half_ptr_);
+  std::swap(other->half_format_, this->half_format_);
+  std::swap(other->half_double_, this->half_double_);
   std::swap(other->head_, this->head_);
   std::swap(other->own_cpu_data_, this->own_cpu_data_);
   std::swap(other->own_prv_data_, this->own_prv_data_);
   std::swap(other->prv_descriptor_, this->prv_descriptor_);
+  ++other->version_;
+  ++version_;
 }
 }  // namespace caffe
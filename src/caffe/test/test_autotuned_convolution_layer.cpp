@@ -0,0 +1,142 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/layer_factory.hpp"
+#include "caffe/layers/autotuned_conv_layer.hpp"
+#include "caffe/layers/conv_layer.hpp"
+#include "caffe/util/io.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+class AutotunedConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  AutotunedConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 16, 7, 9)),
+        blob_top_(new Blob<Dtype>()),
+        blob_top_ref_(new Blob<Dtype>()) {
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    blob_top_ref_vec_.push_back(blob_top_ref_);
+    MakeTempFilename(&cache_file_);
+  }
+  virtual ~AutotunedConvolutionLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete blob_top_ref_;
+  }
+
+  LayerParameter AutotuneParam(int stride) {
+    LayerParameter layer_param;
+    layer_param.set_type("Convolution");
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->add_kernel_size(3);
+    convolution_param->add_pad(1);
+    convolution_param->add_stride(stride);
+    convolution_param->set_num_output(16);
+    convolution_param->set_autotune(true);
+    convolution_param->set_autotune_cache(cache_file_);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  // Checks the layer's output against ConvolutionLayer with its weights.
+  void CheckAgainstGEMM(const LayerParameter& layer_param,
+      Layer<Dtype>* layer) {
+    layer->Forward(blob_bottom_vec_, blob_top_vec_);
+    ConvolutionLayer<Dtype> reference(layer_param);
+    reference.SetUp(blob_bottom_vec_, blob_top_ref_vec_);
+    reference.blobs()[0]->CopyFrom(*layer->blobs()[0]);
+    reference.blobs()[1]->CopyFrom(*layer->blobs()[1]);
+    reference.Forward(blob_bottom_vec_, blob_top_ref_vec_);
+    ASSERT_EQ(blob_top_->count(), blob_top_ref_->count());
+    for (int i = 0; i < blob_top_->count(); ++i) {
+      EXPECT_NEAR(blob_top_->cpu_data()[i], blob_top_ref_->cpu_data()[i],
+                  1e-3);
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const blob_top_ref_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> blob_top_ref_vec_;
+  string cache_file_;
+};
+
+TYPED_TEST_CASE(AutotunedConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(AutotunedConvolutionLayerTest, TestFactory) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->AutotuneParam(1);
+  shared_ptr<Layer<Dtype> > layer =
+      LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_TRUE(
+      dynamic_cast<AutotunedConvolutionLayer<Dtype>*>(layer.get()) != NULL);
+  layer_param.mutable_convolution_param()->set_autotune(false);
+  layer = LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_TRUE(
+      dynamic_cast<AutotunedConvolutionLayer<Dtype>*>(layer.get()) == NULL);
+}
+
+TYPED_TEST(AutotunedConvolutionLayerTest, TestTuneAndRecord) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->AutotuneParam(1);
+  AutotunedConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_FALSE(layer.choice().empty());
+  this->CheckAgainstGEMM(layer_param, &layer);
+
+  std::ifstream file(this->cache_file_.c_str());
+  string line;
+  ASSERT_TRUE(std::getline(file, line));
+  EXPECT_EQ(line, layer.choice() + " " + layer.tuning_key());
+  EXPECT_FALSE(std::getline(file, line));
+
+  // A second layer with the same shape reuses the result without timing.
+  AutotuneCache cache(this->cache_file_);
+  const string forced = layer.choice() == "WINOGRAD4" ? "GEMM" : "WINOGRAD4";
+  cache.Insert(layer.tuning_key(), forced);
+  AutotunedConvolutionLayer<Dtype> cached_layer(layer_param);
+  cached_layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(cached_layer.choice(), forced);
+  this->CheckAgainstGEMM(layer_param, &cached_layer);
+}
+
+TYPED_TEST(AutotunedConvolutionLayerTest, TestReshapeRetunes) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->AutotuneParam(1);
+  AutotunedConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  const string key = layer.tuning_key();
+  this->blob_bottom_->Reshape(1, 16, 10, 6);
+  layer.Reshape(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_NE(layer.tuning_key(), key);
+  this->CheckAgainstGEMM(layer_param, &layer);
+}
+
+TYPED_TEST(AutotunedConvolutionLayerTest, TestSingleCandidate) {
+  typedef TypeParam Dtype;
+  // Strided convolutions have nothing but GEMM to choose from.
+  LayerParameter layer_param = this->AutotuneParam(2);
+  AutotunedConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(layer.choice(), "GEMM");
+  this->CheckAgainstGEMM(layer_param, &layer);
+}
+
+}  // namespace caffe
@@ -35,6 +35,7 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
 #include <map>
 #include <utility>
 #include <vector>
@@ -774,6 +775,49 @@ TEST_F(CPUBBoxUtilTest, TestMatchBBoxLableAllPerPredictionEx) {
   EXPECT_NEAR(match_overlaps[5], 0., eps);
 }
 
+TEST_F(CPUBBoxUtilTest, TestMatchBBoxRandomOverlaps) {
+  const int num_gt = 5;
+  const int num_pred = 300;
+  vector<float> coords(4 * (num_gt + num_pred));
+  caffe_rng_uniform<float>(coords.size(), 0, 0.7, &coords[0]);
+  vector<NormalizedBBox> gt_bboxes(num_gt);
+  vector<NormalizedBBox> pred_bboxes(num_pred);
+  for (int i = 0; i < num_gt + num_pred; ++i) {
+    NormalizedBBox& bbox = i < num_gt ? gt_bboxes[i] : pred_bboxes[i - num_gt];
+    bbox.set_xmin(coords[4 * i]);
+    bbox.set_ymin(coords[4 * i + 1]);
+    bbox.set_xmax(coords[4 * i] + 0.3 * coords[4 * i + 2] + 0.01);
+    bbox.set_ymax(coords[4 * i + 1] + 0.3 * coords[4 * i + 3] + 0.01);
+  }
+
+  vector<int> match_indices;
+  vector<float> match_overlaps;
+  MatchBBox(gt_bboxes, pred_bboxes, -1,
+            MultiBoxLossParameter_MatchType_PER_PREDICTION, 0.2, false,
+            &match_indices, &match_overlaps);
+
+  ASSERT_EQ(match_indices.size(), num_pred);
+  int num_matches = 0;
+  for (int i = 0; i < num_pred; ++i) {
+    float max_overlap = 0;
+    for (int j = 0; j < num_gt; ++j) {
+      float overlap = JaccardOverlap(pred_bboxes[i], gt_bboxes[j]);
+      if (overlap > 1e-6) {
+        max_overlap = std::max(max_overlap, overlap);
+      }
+    }
+    if (match_indices[i] > -1) {
+      ++num_matches;
+      EXPECT_EQ(JaccardOverlap(pred_bboxes[i], gt_bboxes[match_indices[i]]),
+                match_overlaps[i]);
+    } else {
+      EXPECT_LT(max_overlap, 0.2);
+      EXPECT_EQ(max_overlap, match_overlaps[i]);
+    }
+  }
+  EXPECT_GE(num_matches, num_gt);
+}
+
 TEST_F(CPUBBoxUtilTest, TestGetGroundTruth) {
   const int num_gt = 4;
   Blob<float> gt_blob(1, 1, num_gt, 8);
@@ -45,6 +45,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/filler.hpp"
 #include "caffe/layers/bias_layer.hpp"
 
+#include "caffe/test/test_blocked_layout_util.hpp"
 #include "caffe/test/test_caffe_main.hpp"
 #include "caffe/test/test_gradient_check_util.hpp"
 
@@ -501,4 +502,13 @@ TYPED_TEST(BiasLayerTest, TestGradientBiasAxis2) {
       this->blob_top_vec_);
 }
 
+#ifdef MKLDNN_SUPPORTED
+TEST(BiasLayerBlockedLayoutTest, TestForward) {
+  LayerParameter layer_param;
+  layer_param.mutable_bias_param()->mutable_filler()->set_type("uniform");
+  BlockedLayoutChecker checker;
+  checker.CheckForward<BiasLayer<float> >(layer_param);
+}
+#endif  // MKLDNN_SUPPORTED
+
 }  // namespace caffe
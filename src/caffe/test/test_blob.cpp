@@ -42,6 +42,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/blob.hpp"
 #include "caffe/common.hpp"
 #include "caffe/filler.hpp"
+#include "caffe/util/prv_layout.hpp"
 
 #include "caffe/test/test_caffe_main.hpp"
 
@@ -88,6 +89,25 @@ TYPED_TEST(BlobSimpleTest, TestReshape) {
   EXPECT_EQ(this->blob_->count(), 120);
 }
 
+TYPED_TEST(BlobSimpleTest, TestReshapeKeepsBuffer) {
+  typedef TypeParam Dtype;
+  this->blob_->Reshape(2, 3, 4, 5);
+  Dtype* data = this->blob_->mutable_cpu_data();
+  data[0] = 1;
+  // A smaller shape reuses the buffer and restarts it zeroed.
+  this->blob_->Reshape(1, 3, 4, 6);
+  EXPECT_EQ(this->blob_->count(), 72);
+  EXPECT_EQ(data, this->blob_->cpu_data());
+  EXPECT_EQ(0, this->blob_->cpu_data()[0]);
+  // A buffer shared with another blob is not touched.
+  Blob<Dtype> other(1, 3, 4, 6);
+  other.ShareData(*this->blob_);
+  this->blob_->mutable_cpu_data()[0] = 2;
+  this->blob_->Reshape(2, 3, 4, 5);
+  EXPECT_EQ(2, other.cpu_data()[0]);
+  EXPECT_NE(other.cpu_data(), this->blob_->cpu_data());
+}
+
 TYPED_TEST(BlobSimpleTest, TestReshapeZero) {
   vector<int> shape(2);
   shape[0] = 0;
@@ -149,6 +169,20 @@ TYPED_TEST(BlobSimpleTest, TestLegacyBlobProtoShapeEquals) {
   EXPECT_FALSE(this->blob_->ShapeEquals(blob_proto));
 }
 
+TYPED_TEST(BlobSimpleTest, TestPlainDataLayout) {
+  Blob<TypeParam> top(2, 3, 4, 5);
+  const uint64_t conversions = PrvMemDescr::conversions();
+  EXPECT_FALSE(prv_data_elementwise(this->blob_preshaped_));
+  EXPECT_EQ(prv_channel_block(this->blob_preshaped_), 0);
+  EXPECT_TRUE(mutable_prv_data_like(&top, this->blob_preshaped_) == NULL);
+  const TypeParam* bottom_data;
+  TypeParam* top_data;
+  elementwise_data(this->blob_preshaped_, &top, &bottom_data, &top_data);
+  EXPECT_EQ(bottom_data, this->blob_preshaped_->cpu_data());
+  EXPECT_EQ(top_data, top.cpu_data());
+  EXPECT_EQ(PrvMemDescr::conversions(), conversions);
+}
+
 template <typename TypeParam>
 class BlobMathTest : public MultiDeviceTest<TypeParam> {
   typedef typename TypeParam::Dtype Dtype;
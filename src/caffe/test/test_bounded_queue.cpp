@@ -0,0 +1,151 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/thread.hpp>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/util/bounded_queue.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+template <typename Queue>
+class BoundedQueueTest : public ::testing::Test {};
+
+typedef ::testing::Types<SPSCQueue<int>, MPMCQueue<int> > QueueTypes;
+TYPED_TEST_CASE(BoundedQueueTest, QueueTypes);
+
+TYPED_TEST(BoundedQueueTest, TestFIFOAndCapacity) {
+  TypeParam queue(3);
+  EXPECT_EQ(3, queue.capacity());
+  EXPECT_TRUE(queue.try_push(1));
+  EXPECT_TRUE(queue.try_push(2));
+  EXPECT_TRUE(queue.try_push(3));
+  EXPECT_FALSE(queue.try_push(4));
+  EXPECT_EQ(3, queue.size());
+  int value = 0;
+  EXPECT_TRUE(queue.try_pop(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(2, queue.pop());
+  EXPECT_EQ(3, queue.pop());
+  EXPECT_FALSE(queue.try_pop(&value));
+  EXPECT_EQ(0, queue.size());
+}
+
+TYPED_TEST(BoundedQueueTest, TestBulkWrapAround) {
+  TypeParam queue(5);
+  vector<int> in(4), out(4);
+  for (int round = 0; round < 10; ++round) {
+    for (int i = 0; i < in.size(); ++i) {
+      in[i] = round * 10 + i;
+    }
+    queue.push_n(&in[0], in.size());
+    queue.pop_n(&out[0], out.size());
+    EXPECT_EQ(in, out);
+  }
+  EXPECT_EQ(0, queue.size());
+}
+
+template <typename Queue>
+static void ProduceRange(Queue* queue, int begin, int end, int chunk) {
+  vector<int> items;
+  for (int i = begin; i < end; ++i) {
+    items.push_back(i);
+    if (items.size() == chunk || i + 1 == end) {
+      queue->push_n(&items[0], items.size());
+      items.clear();
+    }
+  }
+}
+
+TYPED_TEST(BoundedQueueTest, TestBulkLargerThanCapacity) {
+  // A batch larger than the ring is streamed through it in pieces while
+  // the consumer drains it.
+  const int count = 1000;
+  TypeParam queue(7, 10);
+  boost::thread producer(&ProduceRange<TypeParam>, &queue, 0, count, count);
+  vector<int> out(count);
+  queue.pop_n(&out[0], count);
+  producer.join();
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(i, out[i]);
+  }
+}
+
+TEST(MPMCQueueTest, TestConcurrentProducersAndConsumers) {
+  const int num_producers = 3;
+  const int per_producer = 2000;
+  const int total = num_producers * per_producer;
+  MPMCQueue<int> queue(16, 10);
+  boost::thread_group producers;
+  for (int p = 0; p < num_producers; ++p) {
+    producers.create_thread(boost::bind(&ProduceRange<MPMCQueue<int> >,
+        &queue, p * per_producer, (p + 1) * per_producer, 5));
+  }
+  vector<int> seen(total, 0);
+  vector<int> first(total / 2), second(total / 2);
+  boost::thread consumer(boost::bind(&MPMCQueue<int>::pop_n, &queue,
+      &second[0], second.size(), ""));
+  queue.pop_n(&first[0], first.size());
+  consumer.join();
+  producers.join_all();
+  for (int i = 0; i < first.size(); ++i) {
+    ++seen[first[i]];
+    ++seen[second[i]];
+  }
+  for (int i = 0; i < total; ++i) {
+    EXPECT_EQ(1, seen[i]) << "item " << i;
+  }
+}
+
+TEST(SPSCQueueTest, TestPeek) {
+  SPSCQueue<int> queue(2);
+  int value = 0;
+  EXPECT_FALSE(queue.try_peek(&value));
+  queue.push(7);
+  EXPECT_TRUE(queue.try_peek(&value));
+  EXPECT_EQ(7, value);
+  EXPECT_EQ(7, queue.peek());
+  EXPECT_EQ(1, queue.size());
+  EXPECT_EQ(7, queue.pop());
+}
+
+}  // namespace caffe
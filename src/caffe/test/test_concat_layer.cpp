@@ -44,6 +44,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/filler.hpp"
 #include "caffe/layers/concat_layer.hpp"
 
+#include "caffe/test/test_blocked_layout_util.hpp"
 #include "caffe/test/test_caffe_main.hpp"
 #include "caffe/test/test_gradient_check_util.hpp"
 
@@ -241,4 +242,13 @@ TYPED_TEST(ConcatLayerTest, TestGradientChannelsBottomOneOnly) {
     this->blob_top_vec_, 1);
 }
 
+#ifdef MKLDNN_SUPPORTED
+TEST(ConcatLayerBlockedLayoutTest, TestForwardChannels) {
+  LayerParameter layer_param;
+  BlockedLayoutChecker checker;
+  checker.CheckForward<ConcatLayer<float> >(layer_param,
+      {{2, 16, 3, 4}, {2, 8, 3, 4}}, 1);
+}
+#endif  // MKLDNN_SUPPORTED
+
 }  // namespace caffe
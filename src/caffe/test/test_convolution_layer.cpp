@@ -35,6 +35,8 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -496,6 +498,84 @@ TYPED_TEST(ConvolutionLayerTest, TestDilated3DConvolution) {
   }
 }
 
+TYPED_TEST(ConvolutionLayerTest, TestQuantized3DConvolution) {
+  typedef typename TypeParam::Dtype Dtype;
+  if (Caffe::mode() != Caffe::CPU) {
+    return;
+  }
+  vector<int> bottom_shape(5);
+  bottom_shape[0] = 2;
+  bottom_shape[1] = 3;
+  bottom_shape[2] = 5;
+  bottom_shape[3] = 6;
+  bottom_shape[4] = 4;
+  this->blob_bottom_->Reshape(bottom_shape);
+  // u8 activations: non-negative inputs
+  FillerParameter filler_param;
+  filler_param.set_min(0);
+  filler_param.set_max(1);
+  UniformFiller<Dtype> filler(filler_param);
+  filler.Fill(this->blob_bottom_);
+  LayerParameter layer_param;
+  layer_param.set_phase(TEST);
+  ConvolutionParameter* convolution_param =
+      layer_param.mutable_convolution_param();
+  convolution_param->add_kernel_size(3);
+  convolution_param->add_pad(1);
+  convolution_param->add_stride(2);
+  convolution_param->set_num_output(4);
+  convolution_param->mutable_weight_filler()->set_type("gaussian");
+  convolution_param->mutable_bias_filler()->set_type("gaussian");
+  const float scale_in = 255.f;
+  const float scale_params[] = {127.f, 64.f, 100.f, 32.f};
+  QuantizationParameter* quant_param = layer_param.mutable_quantization_param();
+  quant_param->add_scale_in(scale_in);
+  for (int i = 0; i < 4; ++i) {
+    quant_param->add_scale_params(scale_params[i]);
+  }
+  shared_ptr<Layer<Dtype> > layer(
+      new ConvolutionLayer<Dtype>(layer_param));
+  layer->SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  // The second pass changes the weights, which must be quantized again
+  for (int pass = 0; pass < 2; ++pass) {
+    if (pass == 1) {
+      caffe_scal(layer->blobs()[0]->count(), Dtype(-0.5),
+          layer->blobs()[0]->mutable_cpu_data());
+    }
+    layer->Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+
+    // Reference: float convolution of the quantize-dequantized operands, which
+    // the integer path reproduces up to float rounding.
+    Blob<Dtype> bottom_q;
+    bottom_q.CopyFrom(*this->blob_bottom_, false, true);
+    Dtype* bottom_q_data = bottom_q.mutable_cpu_data();
+    for (int i = 0; i < bottom_q.count(); ++i) {
+      Dtype q = std::nearbyint(bottom_q_data[i] * scale_in);
+      bottom_q_data[i] =
+          std::min(std::max(q, Dtype(0)), Dtype(255)) / scale_in;
+    }
+    vector<shared_ptr<Blob<Dtype> > > weights_q;
+    weights_q.push_back(shared_ptr<Blob<Dtype> >(new Blob<Dtype>()));
+    weights_q.push_back(layer->blobs()[1]);
+    weights_q[0]->CopyFrom(*layer->blobs()[0], false, true);
+    const int weight_dim = weights_q[0]->count() / 4;
+    Dtype* weight_q_data = weights_q[0]->mutable_cpu_data();
+    for (int i = 0; i < weights_q[0]->count(); ++i) {
+      const float scale_w = scale_params[i / weight_dim];
+      Dtype q = std::nearbyint(weight_q_data[i] * scale_w);
+      weight_q_data[i] =
+          std::min(std::max(q, Dtype(-127)), Dtype(127)) / scale_w;
+    }
+    caffe_conv(&bottom_q, convolution_param, weights_q,
+        this->MakeReferenceTop(this->blob_top_));
+    const Dtype* top_data = this->blob_top_->cpu_data();
+    const Dtype* ref_top_data = this->ref_blob_top_->cpu_data();
+    for (int i = 0; i < this->blob_top_->count(); ++i) {
+      EXPECT_NEAR(top_data[i], ref_top_data[i], 1e-4);
+    }
+  }
+}
+
 TYPED_TEST(ConvolutionLayerTest, Test1x1Convolution) {
   typedef typename TypeParam::Dtype Dtype;
   LayerParameter layer_param;
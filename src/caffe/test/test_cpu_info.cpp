@@ -35,6 +35,10 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "gtest/gtest.h"
 
 #include "caffe/util/cpu_info.hpp"
@@ -98,6 +102,7 @@ TEST(CpuInfo, isProcessorStructureInitialized) {
   EXPECT_EQ(processor.coreId, 0);
   EXPECT_EQ(processor.cpuCores, 0);
   EXPECT_EQ(processor.speedMHz, 0);
+  EXPECT_TRUE(processor.modelName.empty());
 }
 
 TEST(CpuInfo, testCpuInfoForEmptyInput) {
@@ -224,6 +229,17 @@ TEST(CpuInfo, testCollectionForSpeed) {
   EXPECT_EQ(collection.getNumberOfProcessors(), 88);
 }
 
+TEST(CpuInfo, testCollectionForModelName) {
+  CpuInfoContent cpuInfoContent("Intel(R) Xeon(R) CPU E5-2699 v4 @ 2.20GHz",
+                                 2,
+                                 2,
+                                 1);
+  CpuInfo cpuInfo(cpuInfoContent.getContent());
+  Collection collection(&cpuInfo);
+  EXPECT_STREQ(collection.getProcessorModelName(),
+               "Intel(R) Xeon(R) CPU E5-2699 v4 @ 2.20GHz");
+}
+
 TEST(CpuInfo, testCollectionForSpeedInGhz1) {
   CpuInfoContent cpuInfoContent("xxx @ 4.80GHz", 1, 1, 1);
   CpuInfo cpuInfo(cpuInfoContent.getContent());
@@ -266,6 +282,33 @@ TEST(CpuInfo, testCollectionForSpeedRecognitionMhz) {
   EXPECT_EQ(collection.getProcessorSpeedMHz(), 2400);
 }
 
+#ifdef _OPENMP
+
+TEST(CpuInfo, testLimitOpenMpThreads) {
+  const int maxThreads = omp_get_max_threads();
+  const int limit = limitOpenMpThreads(1);
+  if (maxThreads > 1) {
+    EXPECT_EQ(limit, maxThreads);
+    EXPECT_EQ(omp_get_max_threads(), 1);
+    int teamSize = 0;
+    #pragma omp parallel
+    {
+      #pragma omp master
+      teamSize = omp_get_num_threads();
+    }
+    EXPECT_EQ(teamSize, 1);
+  } else {
+    EXPECT_EQ(limit, 0);
+  }
+  restoreOpenMpThreads(limit);
+  EXPECT_EQ(omp_get_max_threads(), maxThreads);
+  EXPECT_EQ(limitOpenMpThreads(0), 0);
+  EXPECT_EQ(limitOpenMpThreads(maxThreads + 1), 0);
+  EXPECT_EQ(omp_get_max_threads(), maxThreads);
+}
+
+#endif  // _OPENMP
+
 }  // namespace cpu
 }  // namespace caffe
 
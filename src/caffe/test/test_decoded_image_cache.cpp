@@ -0,0 +1,136 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef USE_OPENCV
+#include <opencv2/core/core.hpp>
+
+#include <cstring>
+#include <string>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/util/decoded_image_cache.hpp"
+#include "caffe/util/io.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class DecodedImageCacheTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    MakeTempDir(&dir_);
+  }
+
+  virtual void TearDown() {
+    boost::filesystem::remove_all(dir_);
+  }
+
+  // An image whose pixels all differ from those of another seed
+  static cv::Mat MakeImage(int rows, int cols, int type, int seed) {
+    cv::Mat img(rows, cols, type);
+    for (size_t i = 0; i < img.total() * img.elemSize(); ++i) {
+      img.data[i] = static_cast<uchar>(i * 7 + seed);
+    }
+    return img;
+  }
+
+  static bool SameImage(const cv::Mat& a, const cv::Mat& b) {
+    return a.rows == b.rows && a.cols == b.cols && a.type() == b.type() &&
+        memcmp(a.data, b.data, a.total() * a.elemSize()) == 0;
+  }
+
+  string dir_;
+};
+
+TEST_F(DecodedImageCacheTest, TestInsertFind) {
+  DecodedImageCache cache(dir_, "test", 4);
+  const cv::Mat a = MakeImage(10, 20, CV_8UC3, 1);
+  const cv::Mat b = MakeImage(7, 5, CV_8UC1, 2);
+  EXPECT_FALSE(cache.Find("a").data);
+  cache.Insert("a", a);
+  cache.Insert("b", b);
+  EXPECT_TRUE(SameImage(a, cache.Find("a")));
+  EXPECT_TRUE(SameImage(b, cache.Find("b")));
+  EXPECT_FALSE(cache.Find("c").data);
+  // A second insert of an id keeps the first image
+  cache.Insert("a", b);
+  EXPECT_TRUE(SameImage(a, cache.Find("a")));
+}
+
+TEST_F(DecodedImageCacheTest, TestReopen) {
+  const cv::Mat a = MakeImage(16, 16, CV_8UC3, 3);
+  string filename;
+  {
+    DecodedImageCache cache(dir_, "test", 4);
+    cache.Insert("a", a);
+    filename = cache.filename();
+  }
+  // Images outlive the cache object, and other keys use other files
+  DecodedImageCache cache(dir_, "test", 4);
+  EXPECT_EQ(filename, cache.filename());
+  EXPECT_TRUE(SameImage(a, cache.Find("a")));
+  DecodedImageCache other(dir_, "other", 4);
+  EXPECT_NE(filename, other.filename());
+  EXPECT_FALSE(other.Find("a").data);
+}
+
+TEST_F(DecodedImageCacheTest, TestFull) {
+  // 1 MB holds three of these images, less the slot table
+  DecodedImageCache cache(dir_, "test", 1);
+  const cv::Mat img = MakeImage(512, 512, CV_8UC1, 4);
+  int cached = 0;
+  for (; cached < 8; ++cached) {
+    const string id = format_int(cached);
+    cache.Insert(id, img);
+    if (!cache.Find(id).data) {
+      break;
+    }
+  }
+  EXPECT_EQ(3, cached);
+  // Images cached before the file filled up are still there
+  for (int i = 0; i < cached; ++i) {
+    EXPECT_TRUE(SameImage(img, cache.Find(format_int(i))));
+  }
+  cache.Insert("small", MakeImage(2, 2, CV_8UC1, 5));
+  EXPECT_FALSE(cache.Find("small").data);
+}
+
+}  // namespace caffe
+#endif  // USE_OPENCV
@@ -309,6 +309,59 @@ TYPED_TEST(DeconvolutionLayerTest, TestNDAgainst2D) {
   }
 }
 
+TYPED_TEST(DeconvolutionLayerTest, TestSubpixelAgainstGEMM) {
+  typedef typename TypeParam::Dtype Dtype;
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  for (int num_axes = 2; num_axes <= 3; ++num_axes) {
+    vector<int> bottom_shape(2 + num_axes, 5);
+    bottom_shape[0] = 2;
+    bottom_shape[1] = 4;
+    bottom_shape[num_axes + 1] = 7;
+    this->blob_bottom_->Reshape(bottom_shape);
+    filler.Fill(this->blob_bottom_);
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->add_kernel_size(4);
+    convolution_param->add_stride(2);
+    convolution_param->add_pad(1);
+    if (num_axes == 3) {
+      // Uneven stride, kernel and dilation per axis.
+      convolution_param->add_kernel_size(3);
+      convolution_param->add_kernel_size(5);
+      convolution_param->add_stride(1);
+      convolution_param->add_stride(3);
+      convolution_param->add_pad(0);
+      convolution_param->add_pad(2);
+      convolution_param->add_dilation(1);
+      convolution_param->add_dilation(2);
+      convolution_param->add_dilation(1);
+    }
+    convolution_param->set_num_output(6);
+    convolution_param->set_group(2);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    DeconvolutionLayer<Dtype> subpixel_layer(layer_param);
+    subpixel_layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+    subpixel_layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+    Blob<Dtype> subpixel_result;
+    subpixel_result.CopyFrom(*this->blob_top_, false, true);
+
+    convolution_param->set_subpixel_deconv(false);
+    DeconvolutionLayer<Dtype> gemm_layer(layer_param);
+    gemm_layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+    gemm_layer.blobs()[0]->CopyFrom(*subpixel_layer.blobs()[0]);
+    gemm_layer.blobs()[1]->CopyFrom(*subpixel_layer.blobs()[1]);
+    gemm_layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+    ASSERT_EQ(subpixel_result.count(), this->blob_top_->count());
+    for (int i = 0; i < subpixel_result.count(); ++i) {
+      EXPECT_NEAR(subpixel_result.cpu_data()[i],
+                  this->blob_top_->cpu_data()[i], 1e-4);
+    }
+  }
+}
+
 TYPED_TEST(DeconvolutionLayerTest, TestGradient3D) {
   typedef typename TypeParam::Dtype Dtype;
   vector<int> bottom_shape(5);
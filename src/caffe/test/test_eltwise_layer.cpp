@@ -45,6 +45,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/filler.hpp"
 #include "caffe/layers/eltwise_layer.hpp"
 
+#include "caffe/test/test_blocked_layout_util.hpp"
 #include "caffe/test/test_caffe_main.hpp"
 #include "caffe/test/test_gradient_check_util.hpp"
 
@@ -243,4 +244,23 @@ TYPED_TEST(EltwiseLayerTest, TestMaxGradient) {
       this->blob_top_vec_);
 }
 
+#ifdef MKLDNN_SUPPORTED
+TEST(EltwiseLayerBlockedLayoutTest, TestForward) {
+  const vector<vector<int> > shapes(2, {2, 16, 3, 4});
+  LayerParameter layer_param;
+  layer_param.set_phase(TEST);
+  EltwiseParameter* eltwise_param = layer_param.mutable_eltwise_param();
+  eltwise_param->set_operation(EltwiseParameter_EltwiseOp_SUM);
+  eltwise_param->add_coeff(1);
+  eltwise_param->add_coeff(-0.5);
+  BlockedLayoutChecker checker;
+  checker.CheckForward<EltwiseLayer<float> >(layer_param, shapes, 1);
+  eltwise_param->clear_coeff();
+  eltwise_param->set_operation(EltwiseParameter_EltwiseOp_PROD);
+  checker.CheckForward<EltwiseLayer<float> >(layer_param, shapes, 1);
+  eltwise_param->set_operation(EltwiseParameter_EltwiseOp_MAX);
+  checker.CheckForward<EltwiseLayer<float> >(layer_param, shapes, 1);
+}
+#endif  // MKLDNN_SUPPORTED
+
 }  // namespace caffe
@@ -212,4 +212,66 @@ TYPED_TEST(EmbedLayerTest, TestGradientWithBias) {
       this->blob_top_vec_, -2);
 }
 
+TYPED_TEST(EmbedLayerTest, TestSparseGradient) {
+  typedef typename TypeParam::Dtype Dtype;
+  // Only the CPU backward pass records the touched rows.
+  if (Caffe::mode() != Caffe::CPU) { return; }
+  LayerParameter layer_param;
+  EmbedParameter* embed_param = layer_param.mutable_embed_param();
+  const int kNumOutput = 10;
+  const int kInputDim = 5;
+  embed_param->set_num_output(kNumOutput);
+  embed_param->set_input_dim(kInputDim);
+  embed_param->set_bias_term(false);
+  embed_param->set_sparse_gradient(true);
+  embed_param->mutable_weight_filler()->set_type("uniform");
+  embed_param->mutable_weight_filler()->set_min(-10);
+  embed_param->mutable_weight_filler()->set_max(10);
+  EmbedLayer<Dtype> layer(layer_param);
+  this->blob_bottom_->mutable_cpu_data()[0] = 4;
+  this->blob_bottom_->mutable_cpu_data()[1] = 2;
+  this->blob_bottom_->mutable_cpu_data()[2] = 2;
+  this->blob_bottom_->mutable_cpu_data()[3] = 3;
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  Blob<Dtype>* weight = layer.blobs()[0].get();
+  ASSERT_TRUE(weight->diff_rows() != NULL);
+  EXPECT_EQ(0, weight->diff_rows()->size());
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(this->blob_top_);
+  caffe_copy(this->blob_top_->count(), this->blob_top_->cpu_data(),
+             this->blob_top_->mutable_cpu_diff());
+  vector<bool> propagate_down(1, false);
+  layer.Backward(this->blob_top_vec_, propagate_down, this->blob_bottom_vec_);
+  const vector<int>& rows = *weight->diff_rows();
+  ASSERT_EQ(3, rows.size());
+  EXPECT_EQ(2, rows[0]);
+  EXPECT_EQ(3, rows[1]);
+  EXPECT_EQ(4, rows[2]);
+  const Dtype* top_diff = this->blob_top_->cpu_diff();
+  for (int j = 0; j < kNumOutput; ++j) {
+    EXPECT_EQ(0, weight->cpu_diff()[0 * kNumOutput + j]);
+    EXPECT_EQ(0, weight->cpu_diff()[1 * kNumOutput + j]);
+    EXPECT_NEAR(top_diff[1 * kNumOutput + j] + top_diff[2 * kNumOutput + j],
+                weight->cpu_diff()[2 * kNumOutput + j], 1e-5);
+    EXPECT_EQ(top_diff[3 * kNumOutput + j],
+              weight->cpu_diff()[3 * kNumOutput + j]);
+    EXPECT_EQ(top_diff[0 * kNumOutput + j],
+              weight->cpu_diff()[4 * kNumOutput + j]);
+  }
+  // Update and clear only visit the recorded rows.
+  vector<Dtype> expected(weight->count());
+  for (int i = 0; i < weight->count(); ++i) {
+    expected[i] = weight->cpu_data()[i] - weight->cpu_diff()[i];
+  }
+  weight->Update();
+  for (int i = 0; i < weight->count(); ++i) {
+    EXPECT_EQ(expected[i], weight->cpu_data()[i]);
+  }
+  weight->ClearSparseDiff();
+  EXPECT_EQ(0, weight->diff_rows()->size());
+  EXPECT_EQ(0, weight->asum_diff());
+}
+
 }  // namespace caffe
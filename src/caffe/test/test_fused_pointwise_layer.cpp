@@ -0,0 +1,243 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/text_format.h"
+
+#include "gtest/gtest.h"
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/layers/bias_layer.hpp"
+#include "caffe/layers/eltwise_layer.hpp"
+#include "caffe/layers/fused_pointwise_layer.hpp"
+#include "caffe/layers/power_layer.hpp"
+#include "caffe/layers/relu_layer.hpp"
+#include "caffe/layers/scale_layer.hpp"
+#include "caffe/layers/sigmoid_layer.hpp"
+#include "caffe/layers/swish_layer.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+class FusedPointwiseLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  FusedPointwiseLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 3, 4, 5)),
+        blob_operand_(new Blob<Dtype>(2, 3, 4, 5)),
+        blob_top_(new Blob<Dtype>()) {
+    Caffe::set_random_seed(1701);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+  }
+  virtual ~FusedPointwiseLayerTest() {
+    delete blob_bottom_;
+    delete blob_operand_;
+    delete blob_top_;
+  }
+
+  void FillBottoms(const vector<int>& shape) {
+    blob_bottom_->Reshape(shape);
+    blob_operand_->Reshape(shape);
+    FillerParameter filler_param;
+    filler_param.set_min(-2);
+    filler_param.set_max(2);
+    UniformFiller<Dtype> filler(filler_param);
+    filler.Fill(blob_bottom_);
+    filler.Fill(blob_operand_);
+  }
+
+  static shared_ptr<Layer<Dtype> > CreateReferenceLayer(
+      const LayerParameter& param) {
+    const string& type = param.type();
+    Layer<Dtype>* layer = NULL;
+    if (type == "ReLU") {
+      layer = new ReLULayer<Dtype>(param);
+    } else if (type == "Power") {
+      layer = new PowerLayer<Dtype>(param);
+    } else if (type == "Sigmoid") {
+      layer = new SigmoidLayer<Dtype>(param);
+    } else if (type == "Swish") {
+      layer = new SwishLayer<Dtype>(param);
+    } else if (type == "Scale") {
+      layer = new ScaleLayer<Dtype>(param);
+    } else if (type == "Bias") {
+      layer = new BiasLayer<Dtype>(param);
+    } else if (type == "Eltwise") {
+      layer = new EltwiseLayer<Dtype>(param);
+    }
+    CHECK(layer) << "Unknown layer type " << type;
+    return shared_ptr<Layer<Dtype> >(layer);
+  }
+
+  // Runs the fused layer with bottoms 'x' and 'y', then the original layers
+  // one at a time with the same parameters, and compares the outputs.
+  void CheckForward(const string& proto) {
+    LayerParameter layer_param;
+    CHECK(google::protobuf::TextFormat::ParseFromString(proto, &layer_param));
+    if (layer_param.bottom_size() > 1) {
+      blob_bottom_vec_.push_back(blob_operand_);
+    }
+    FusedPointwiseLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    FillerParameter filler_param;
+    filler_param.set_min(-1);
+    filler_param.set_max(1);
+    UniformFiller<Dtype> filler(filler_param);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      filler.Fill(layer.blobs()[i].get());
+    }
+    Blob<Dtype> input;
+    input.CopyFrom(*blob_bottom_, false, true);
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+
+    std::map<string, shared_ptr<Blob<Dtype> > > blobs;
+    blobs[layer_param.bottom(0)].reset(new Blob<Dtype>());
+    blobs[layer_param.bottom(0)]->CopyFrom(input, false, true);
+    if (layer_param.bottom_size() > 1) {
+      blobs[layer_param.bottom(1)].reset(new Blob<Dtype>());
+      blobs[layer_param.bottom(1)]->CopyFrom(*blob_operand_, false, true);
+    }
+    int param_id = 0;
+    const FusedPointwiseParameter& fused_param =
+        layer_param.fused_pointwise_param();
+    for (int i = 0; i < fused_param.op_size(); ++i) {
+      const LayerParameter& op_param = fused_param.op(i);
+      vector<Blob<Dtype>*> bottom, top;
+      for (int j = 0; j < op_param.bottom_size(); ++j) {
+        bottom.push_back(blobs[op_param.bottom(j)].get());
+      }
+      if (!blobs[op_param.top(0)]) {
+        blobs[op_param.top(0)].reset(new Blob<Dtype>());
+      }
+      top.push_back(blobs[op_param.top(0)].get());
+      shared_ptr<Layer<Dtype> > op_layer = CreateReferenceLayer(op_param);
+      op_layer->SetUp(bottom, top);
+      for (int j = 0; j < op_layer->blobs().size(); ++j) {
+        op_layer->blobs()[j]->CopyFrom(*layer.blobs()[param_id++]);
+      }
+      op_layer->Forward(bottom, top);
+    }
+    EXPECT_EQ(param_id, layer.blobs().size());
+
+    const Blob<Dtype>& expected = *blobs[layer_param.top(0)];
+    ASSERT_EQ(expected.shape(), blob_top_->shape());
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_data()[i], blob_top_->cpu_data()[i], 1e-4);
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_operand_;
+  Blob<Dtype>* const blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+};
+
+TYPED_TEST_CASE(FusedPointwiseLayerTest, TestDtypes);
+
+const char* const kFusedPointwiseChain =
+    "name: 'fused' type: 'FusedPointwise' "
+    "bottom: 'x' bottom: 'y' top: 'f' "
+    "fused_pointwise_param { "
+    "  op { name: 'scale' type: 'Scale' bottom: 'x' top: 'a' "
+    "       scale_param { bias_term: true } } "
+    "  op { name: 'relu' type: 'ReLU' bottom: 'a' top: 'b' "
+    "       relu_param { negative_slope: 0.1 } } "
+    "  op { name: 'sum' type: 'Eltwise' bottom: 'b' bottom: 'y' top: 'c' "
+    "       eltwise_param { operation: SUM coeff: 1 coeff: -0.5 } } "
+    "  op { name: 'power' type: 'Power' bottom: 'c' top: 'd' "
+    "       power_param { power: 2 scale: 0.5 shift: 1 } } "
+    "  op { name: 'sigmoid' type: 'Sigmoid' bottom: 'd' top: 'e' } "
+    "  op { name: 'swish' type: 'Swish' bottom: 'e' top: 'f' "
+    "       swish_param { beta: 1.5 } } "
+    "} ";
+
+TYPED_TEST(FusedPointwiseLayerTest, TestSetUp) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param;
+  CHECK(google::protobuf::TextFormat::ParseFromString(kFusedPointwiseChain,
+      &layer_param));
+  this->blob_bottom_vec_.push_back(this->blob_operand_);
+  FusedPointwiseLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(this->blob_bottom_->shape(), this->blob_top_->shape());
+  // Scale weights default to 1, its bias to 0
+  ASSERT_EQ(2, layer.blobs().size());
+  for (int i = 0; i < layer.blobs().size(); ++i) {
+    ASSERT_EQ(3, layer.blobs()[i]->count());
+    for (int c = 0; c < 3; ++c) {
+      EXPECT_EQ(Dtype(i == 0 ? 1 : 0), layer.blobs()[i]->cpu_data()[c]);
+    }
+  }
+}
+
+TYPED_TEST(FusedPointwiseLayerTest, TestForward) {
+  this->FillBottoms(this->blob_bottom_->shape());
+  this->CheckForward(kFusedPointwiseChain);
+}
+
+TYPED_TEST(FusedPointwiseLayerTest, TestForward5DLargeRows) {
+  // Rows longer than a tile are split across tiles
+  vector<int> shape(5);
+  shape[0] = 2; shape[1] = 3; shape[2] = 4; shape[3] = 30; shape[4] = 40;
+  this->FillBottoms(shape);
+  this->CheckForward(kFusedPointwiseChain);
+}
+
+TYPED_TEST(FusedPointwiseLayerTest, TestForwardInPlace) {
+  this->FillBottoms(this->blob_bottom_->shape());
+  this->CheckForward(
+      "name: 'fused' type: 'FusedPointwise' "
+      "bottom: 'x' bottom: 'y' top: 'p' "
+      "fused_pointwise_param { "
+      "  op { name: 'relu' type: 'ReLU' bottom: 'x' top: 'x' } "
+      "  op { name: 'bias' type: 'Bias' bottom: 'x' top: 'x' } "
+      "  op { name: 'max' type: 'Eltwise' bottom: 'y' bottom: 'x' top: 'm' "
+      "       eltwise_param { operation: MAX } } "
+      "  op { name: 'prod' type: 'Eltwise' bottom: 'm' bottom: 'y' top: 'p' "
+      "       eltwise_param { operation: PROD } } "
+      "} ");
+}
+
+}  // namespace caffe
@@ -0,0 +1,128 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdint.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/util/half_math.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class HalfMathTest : public ::testing::Test {
+ protected:
+  uint16_t ToHalf(float value, HalfFormat format) {
+    uint16_t h;
+    caffe_cpu_to_half(1, &value, format, &h);
+    return h;
+  }
+  float FromHalf(uint16_t h, HalfFormat format) {
+    float value;
+    caffe_cpu_from_half(1, &h, format, &value);
+    return value;
+  }
+};
+
+TEST_F(HalfMathTest, TestFloat16Rounding) {
+  EXPECT_EQ(ToHalf(1.f, FLOAT16), 0x3c00);
+  EXPECT_EQ(ToHalf(-2.f, FLOAT16), 0xc000);
+  EXPECT_EQ(ToHalf(1.f / 3, FLOAT16), 0x3555);
+  EXPECT_EQ(ToHalf(65504.f, FLOAT16), 0x7bff);
+  EXPECT_EQ(ToHalf(65520.f, FLOAT16), 0x7c00);
+  EXPECT_EQ(ToHalf(std::ldexp(1.f, -24), FLOAT16), 0x0001);
+  EXPECT_EQ(ToHalf(std::ldexp(1.f, -25), FLOAT16), 0x0000);
+  EXPECT_EQ(ToHalf(std::ldexp(3.f, -25), FLOAT16), 0x0002);
+  // Ties go to the even neighbour
+  EXPECT_EQ(ToHalf(1.f + std::ldexp(1.f, -11), FLOAT16), 0x3c00);
+  EXPECT_EQ(ToHalf(1.f + std::ldexp(3.f, -11), FLOAT16), 0x3c02);
+  const uint16_t nan =
+      ToHalf(std::numeric_limits<float>::quiet_NaN(), FLOAT16);
+  EXPECT_EQ(nan & 0x7c00, 0x7c00);
+  EXPECT_NE(nan & 0x3ff, 0);
+}
+
+TEST_F(HalfMathTest, TestBFloat16Rounding) {
+  EXPECT_EQ(ToHalf(1.f, BFLOAT16), 0x3f80);
+  EXPECT_EQ(ToHalf(1.f / 3, BFLOAT16), 0x3eab);
+  EXPECT_EQ(ToHalf(-3.f, BFLOAT16), 0xc040);
+  EXPECT_EQ(ToHalf(1.f + std::ldexp(1.f, -8), BFLOAT16), 0x3f80);
+  EXPECT_EQ(ToHalf(1.f + std::ldexp(3.f, -8), BFLOAT16), 0x3f82);
+  EXPECT_TRUE(std::isnan(FromHalf(
+      ToHalf(std::numeric_limits<float>::quiet_NaN(), BFLOAT16), BFLOAT16)));
+}
+
+TEST_F(HalfMathTest, TestFloat16RoundTrip) {
+  // Every value but NaN converts back to the same 16 bits
+  std::vector<uint16_t> h(1 << 16), back(1 << 16);
+  std::vector<float> values(1 << 16);
+  for (int i = 0; i < (1 << 16); ++i) {
+    h[i] = i;
+  }
+  caffe_cpu_from_half(h.size(), &h[0], FLOAT16, &values[0]);
+  caffe_cpu_to_half(values.size(), &values[0], FLOAT16, &back[0]);
+  for (int i = 0; i < (1 << 16); ++i) {
+    if (!std::isnan(values[i])) {
+      EXPECT_EQ(back[i], h[i]);
+    }
+  }
+  EXPECT_EQ(values[0x3c00], 1.f);
+  EXPECT_EQ(values[0x0001], std::ldexp(1.f, -24));
+  EXPECT_EQ(values[0xfc00], -std::numeric_limits<float>::infinity());
+}
+
+TEST_F(HalfMathTest, TestDouble) {
+  const int count = 100000;
+  std::vector<double> x(count), y(count);
+  std::vector<uint16_t> h(count);
+  for (int i = 0; i < count; ++i) {
+    x[i] = (i - count / 2) / 1024.;
+  }
+  for (int format = FLOAT16; format <= BFLOAT16; ++format) {
+    caffe_cpu_to_half(count, &x[0], static_cast<HalfFormat>(format), &h[0]);
+    caffe_cpu_from_half(count, &h[0], static_cast<HalfFormat>(format), &y[0]);
+    for (int i = 0; i < count; ++i) {
+      EXPECT_NEAR(y[i], x[i], std::fabs(x[i]) / 128);
+    }
+  }
+}
+
+}  // namespace caffe
@@ -0,0 +1,87 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/util/host_allocator.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class HostAllocatorTest : public ::testing::Test {};
+
+TEST_F(HostAllocatorTest, TestAlignmentAndZero) {
+  HostAllocator& allocator = HostAllocator::Get();
+  const size_t sizes[] = {0, 1, 100, 3000, 70000, 3 << 20};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    char* ptr = static_cast<char*>(allocator.Allocate(sizes[i]));
+    ASSERT_TRUE(ptr);
+    EXPECT_EQ(static_cast<uintptr_t>(0),
+              reinterpret_cast<uintptr_t>(ptr) % 64);
+    memset(ptr, 1, sizes[i]);  // NOLINT(caffe/alt_fn)
+    allocator.Zero(ptr, sizes[i]);
+    for (size_t j = 0; j < sizes[i]; ++j) {
+      ASSERT_EQ(0, ptr[j]);
+    }
+    allocator.Free(ptr);
+  }
+}
+
+TEST_F(HostAllocatorTest, TestReuse) {
+  HostAllocator& allocator = HostAllocator::Get();
+  const HostAllocatorStats before = allocator.stats();
+  // Large blocks share one free list whatever node the thread runs on.
+  void* ptr = allocator.Allocate(5 << 20);
+  allocator.Free(ptr);
+  // A slightly smaller request falls into the same size class.
+  void* again = allocator.Allocate((5 << 20) - 1000);
+  EXPECT_EQ(ptr, again);
+  const HostAllocatorStats after = allocator.stats();
+  EXPECT_EQ(before.allocations + 2, after.allocations);
+  EXPECT_EQ(before.pool_hits + 1, after.pool_hits);
+  EXPECT_GE(after.peak_bytes, static_cast<size_t>(5 << 20));
+  allocator.Free(again);
+  allocator.Trim();
+  EXPECT_EQ(static_cast<size_t>(0), allocator.stats().bytes_cached);
+}
+
+}  // namespace caffe
@@ -35,6 +35,8 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cstdlib>
+
 #include "gtest/gtest.h"
 
 #include "caffe/common.hpp"
@@ -129,6 +131,54 @@ TEST_F(ImTransformsTest, TestApplyResize) {
   CHECK_EQ(out_img.cols, 30);
   CHECK_EQ(out_img.rows, 30);
 }
+
+TEST_F(ImTransformsTest, TestApplyDistort) {
+  cv::Mat in_img(20, 30, CV_8UC3);
+  for (int y = 0; y < in_img.rows; ++y) {
+    for (int x = 0; x < in_img.cols * 3; ++x) {
+      in_img.ptr<uchar>(y)[x] = (y * 37 + x * 11) % 256;
+    }
+  }
+  DistortionParameter param;
+  // No distortion hands back the input.
+  cv::Mat out_img = ApplyDistort(in_img, param);
+  EXPECT_EQ(out_img.data, in_img.data);
+
+  param.set_brightness_prob(1);
+  param.set_brightness_delta(32);
+  param.set_contrast_prob(1);
+  param.set_contrast_lower(0.5);
+  param.set_contrast_upper(1.5);
+  param.set_saturation_prob(1);
+  param.set_saturation_lower(0.5);
+  param.set_saturation_upper(1.5);
+  param.set_hue_prob(1);
+  param.set_hue_delta(18);
+  param.set_random_order_prob(0.5);
+  for (int seed = 1701; seed < 1721; ++seed) {
+    // The channel order is shuffled with std::rand
+    Caffe::set_random_seed(seed);
+    srand(seed);
+    cv::Mat chain_img = ApplyDistortChain(in_img, param);
+    Caffe::set_random_seed(seed);
+    srand(seed);
+    out_img = ApplyDistort(in_img, param);
+    ASSERT_EQ(out_img.size(), chain_img.size());
+    ASSERT_EQ(out_img.type(), chain_img.type());
+    // The chain rounds to 8-bit HSV once more between saturation and hue,
+    // which moves a few values by more than 1.
+    int num_off = 0;
+    for (int y = 0; y < in_img.rows; ++y) {
+      for (int x = 0; x < in_img.cols * 3; ++x) {
+        const int diff =
+            abs(out_img.ptr<uchar>(y)[x] - chain_img.ptr<uchar>(y)[x]);
+        EXPECT_LE(diff, 16);
+        num_off += diff > 1;
+      }
+    }
+    EXPECT_LE(num_off, in_img.rows * in_img.cols * 3 / 100) << "seed " << seed;
+  }
+}
 #endif  // USE_OPENCV
 
 }  // namespace caffe
@@ -0,0 +1,153 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string>
+#include <vector>
+
+#include "google/protobuf/text_format.h"
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/inference_server.hpp"
+#include "caffe/net.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+class InferenceServerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  InferenceServerTest() {
+    const string proto =
+        "name: 'ServedNet' "
+        "layer { "
+        "  name: 'data' "
+        "  type: 'Input' "
+        "  top: 'data' "
+        "  input_param { shape { dim: 1 dim: 3 dim: 2 } } "
+        "} "
+        "layer { "
+        "  name: 'ip' "
+        "  type: 'InnerProduct' "
+        "  bottom: 'data' "
+        "  top: 'ip' "
+        "  inner_product_param { "
+        "    num_output: 4 "
+        "    weight_filler { type: 'gaussian' } "
+        "    bias_filler { type: 'gaussian' } "
+        "  } "
+        "} ";
+    CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param_));
+  }
+
+  vector<Dtype> Sample(int i) {
+    vector<Dtype> sample(6);
+    for (int j = 0; j < sample.size(); ++j) {
+      sample[j] = Dtype(i * 6 + j) / 10;
+    }
+    return sample;
+  }
+
+  NetParameter param_;
+};
+
+TYPED_TEST_CASE(InferenceServerTest, TestDtypes);
+
+TYPED_TEST(InferenceServerTest, TestMatchesSingleForward) {
+  typename InferenceServer<TypeParam>::Options options;
+  options.num_workers = 2;
+  options.max_batch_size = 4;
+  options.latency_budget_ms = 5;
+  InferenceServer<TypeParam> server(this->param_, "", options);
+  EXPECT_EQ(6, server.sample_size());
+  vector<shared_ptr<InferenceRequest<TypeParam> > > requests;
+  for (int i = 0; i < 10; ++i) {
+    requests.push_back(server.Submit(this->Sample(i)));
+  }
+  Net<TypeParam> reference(this->param_);
+  reference.ShareTrainedLayersWith(server.net(0));
+  for (int i = 0; i < requests.size(); ++i) {
+    requests[i]->Wait();
+    ASSERT_EQ(1, requests[i]->outputs().size());
+    const vector<TypeParam>& output = requests[i]->outputs()[0];
+    ASSERT_EQ(4, output.size());
+    const vector<TypeParam> sample = this->Sample(i);
+    std::copy(sample.begin(), sample.end(),
+              reference.input_blobs()[0]->mutable_cpu_data());
+    const TypeParam* expected = reference.Forward()[0]->cpu_data();
+    for (int j = 0; j < output.size(); ++j) {
+      EXPECT_NEAR(expected[j], output[j], 1e-4);
+    }
+    EXPECT_LE(requests[i]->queue_ms(), requests[i]->latency_ms());
+  }
+  EXPECT_EQ(10, server.stats().requests);
+}
+
+TYPED_TEST(InferenceServerTest, TestBatchesAndPads) {
+  typename InferenceServer<TypeParam>::Options options;
+  options.max_batch_size = 8;
+  options.latency_budget_ms = 300;
+  InferenceServer<TypeParam> server(this->param_, "", options);
+  // Eight requests fill a batch well within the budget.
+  vector<shared_ptr<InferenceRequest<TypeParam> > > requests;
+  for (int i = 0; i < 8; ++i) {
+    requests.push_back(server.Submit(this->Sample(i)));
+  }
+  for (int i = 0; i < requests.size(); ++i) {
+    requests[i]->Wait();
+    EXPECT_EQ(8, requests[i]->batch_size());
+    EXPECT_EQ(i, requests[i]->queue_depth());
+  }
+  // Three requests are sent off at the budget, padded to a batch of four.
+  requests.clear();
+  for (int i = 0; i < 3; ++i) {
+    requests.push_back(server.Submit(this->Sample(i)));
+  }
+  for (int i = 0; i < requests.size(); ++i) {
+    requests[i]->Wait();
+    EXPECT_EQ(3, requests[i]->batch_size());
+  }
+  const InferenceServerStats stats = server.stats();
+  EXPECT_EQ(11, stats.requests);
+  EXPECT_EQ(2, stats.batches);
+  EXPECT_EQ(1, stats.padded_samples);
+  EXPECT_EQ(7, stats.max_queue_depth);
+}
+
+}  // namespace caffe
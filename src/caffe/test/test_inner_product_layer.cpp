@@ -35,6 +35,7 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -281,6 +282,55 @@ TYPED_TEST(InnerProductLayerTest, TestForwardNoBatch) {
   }
 }
 
+TYPED_TEST(InnerProductLayerTest, TestForwardFusedEpilogue) {
+  typedef typename TypeParam::Dtype Dtype;
+  if (Caffe::mode() != Caffe::CPU) {
+    return;  // Pointwise epilogues are only fused for CPU inference
+  }
+  this->blob_bottom_vec_.push_back(this->blob_bottom_);
+  LayerParameter layer_param;
+  InnerProductParameter* inner_product_param =
+      layer_param.mutable_inner_product_param();
+  inner_product_param->set_num_output(10);
+  inner_product_param->mutable_weight_filler()->set_type("uniform");
+  inner_product_param->mutable_bias_filler()->set_type("uniform");
+  inner_product_param->mutable_bias_filler()->set_min(-1);
+  inner_product_param->mutable_bias_filler()->set_max(1);
+  shared_ptr<InnerProductLayer<Dtype> > layer(
+      new InnerProductLayer<Dtype>(layer_param));
+  layer->SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer->Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  Blob<Dtype> expected;
+  expected.CopyFrom(*this->blob_top_, false, true);
+
+  // ReLU (negative_slope 0.1) followed by Power (y = 2x + 0.5)
+  LayerParameter* relu_param =
+      layer_param.mutable_fused_pointwise_param()->add_op();
+  relu_param->set_type("ReLU");
+  relu_param->add_bottom("ip");
+  relu_param->add_top("ip");
+  relu_param->mutable_relu_param()->set_negative_slope(0.1);
+  LayerParameter* power_param =
+      layer_param.mutable_fused_pointwise_param()->add_op();
+  power_param->set_type("Power");
+  power_param->add_bottom("ip");
+  power_param->add_top("out");
+  power_param->mutable_power_param()->set_scale(2);
+  power_param->mutable_power_param()->set_shift(0.5);
+  shared_ptr<InnerProductLayer<Dtype> > fused_layer(
+      new InnerProductLayer<Dtype>(layer_param));
+  fused_layer->SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  for (int i = 0; i < layer->blobs().size(); ++i) {
+    fused_layer->blobs()[i]->CopyFrom(*layer->blobs()[i]);
+  }
+  fused_layer->Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  for (int i = 0; i < expected.count(); ++i) {
+    const Dtype x = expected.cpu_data()[i];
+    const Dtype relu = std::max(x, Dtype(0)) + 0.1 * std::min(x, Dtype(0));
+    EXPECT_NEAR(2 * relu + 0.5, this->blob_top_->cpu_data()[i], 1e-5);
+  }
+}
+
 TYPED_TEST(InnerProductLayerTest, TestGradient) {
   typedef typename TypeParam::Dtype Dtype;
   this->blob_bottom_vec_.push_back(this->blob_bottom_);
@@ -44,6 +44,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/blob.hpp"
 #include "caffe/common.hpp"
 #include "caffe/filler.hpp"
+#include "caffe/util/int8_math.hpp"
 #include "caffe/util/math_functions.hpp"
 
 #include "caffe/test/test_caffe_main.hpp"
@@ -156,6 +157,30 @@ TYPED_TEST(CPUMathFunctionsTest, TestCopy) {
   }
 }
 
+TYPED_TEST(CPUMathFunctionsTest, TestGemmS8U8S32) {
+  // Sizes that leave partial row blocks, column panels and K steps
+  const int M = 6, N = 150, K = 29;
+  vector<int8_t> A(M * K);
+  vector<uint8_t> B(K * N);
+  for (int i = 0; i < M * K; ++i) {
+    A[i] = static_cast<int8_t>(caffe_rng_rand() % 255 - 127);
+  }
+  for (int i = 0; i < K * N; ++i) {
+    B[i] = static_cast<uint8_t>(caffe_rng_rand() % 256);
+  }
+  vector<int32_t> C(M * N);
+  caffe_cpu_gemm_s8u8s32(M, N, K, &A[0], &B[0], &C[0]);
+  for (int m = 0; m < M; ++m) {
+    for (int n = 0; n < N; ++n) {
+      int32_t expected = 0;
+      for (int k = 0; k < K; ++k) {
+        expected += A[m * K + k] * static_cast<int32_t>(B[k * N + n]);
+      }
+      EXPECT_EQ(expected, C[m * N + n]);
+    }
+  }
+}
+
 #ifndef CPU_ONLY
 
 template <typename Dtype>
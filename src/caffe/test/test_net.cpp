@@ -35,10 +35,12 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cstdlib>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "boost/filesystem.hpp"
 #include "google/protobuf/text_format.h"
 
 #include "gtest/gtest.h"
@@ -46,6 +48,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/common.hpp"
 #include "caffe/filler.hpp"
 #include "caffe/net.hpp"
+#include "caffe/util/half_math.hpp"
 #include "caffe/util/io.hpp"
 #include "caffe/util/math_functions.hpp"
 
@@ -906,6 +909,92 @@ TYPED_TEST(NetTest, TestHasBlob) {
   EXPECT_TRUE(this->net_->has_blob("top_loss"));
 }
 
+TYPED_TEST(NetTest, TestCompiledNetCache) {
+  string cache_dir;
+  MakeTempDir(&cache_dir);
+  setenv("CAFFE_COMPILED_NET_CACHE", cache_dir.c_str(), 1);
+  // The first net compiles and records itself, the second one is read back.
+  this->InitTinyNet();
+  vector<string> layer_names = this->net_->layer_names();
+  const vector<string> blob_names = this->net_->blob_names();
+  vector<vector<int> > blob_shapes;
+  for (size_t i = 0; i < this->net_->blobs().size(); ++i) {
+    blob_shapes.push_back(this->net_->blobs()[i]->shape());
+  }
+  vector<string> files;
+  for (boost::filesystem::directory_iterator it(cache_dir);
+       it != boost::filesystem::directory_iterator(); ++it) {
+    files.push_back(it->path().string());
+  }
+  ASSERT_EQ(1u, files.size());
+  // Rename a layer in the recorded net: only a net read from the file has it.
+  CompiledNet compiled;
+  ASSERT_TRUE(ReadProtoFromBinaryFile(files[0], &compiled));
+  for (int i = 0; i < compiled.param().layer_size(); ++i) {
+    if (compiled.param().layer(i).name() == "innerproduct") {
+      compiled.mutable_param()->mutable_layer(i)->set_name("innerproduct_c");
+    }
+  }
+  WriteProtoToBinaryFile(compiled, files[0]);
+  for (size_t i = 0; i < layer_names.size(); ++i) {
+    if (layer_names[i] == "innerproduct") {
+      layer_names[i] = "innerproduct_c";
+    }
+  }
+  this->InitTinyNet();
+  unsetenv("CAFFE_COMPILED_NET_CACHE");
+  EXPECT_EQ(layer_names, this->net_->layer_names());
+  EXPECT_EQ(blob_names, this->net_->blob_names());
+  ASSERT_EQ(blob_shapes.size(), this->net_->blobs().size());
+  for (size_t i = 0; i < blob_shapes.size(); ++i) {
+    EXPECT_EQ(blob_shapes[i], this->net_->blobs()[i]->shape());
+  }
+}
+
+TYPED_TEST(NetTest, TestSkipParamFill) {
+  typedef typename TypeParam::Dtype Dtype;
+  Caffe::set_skip_param_fill(true);
+  this->InitTinyNet();
+  Caffe::set_skip_param_fill(false);
+  const Blob<Dtype>* weights = this->net_->layer_by_name("innerproduct")
+      ->blobs()[0].get();
+  EXPECT_EQ(0, weights->asum_data());
+  // DummyData fills data, not parameters, so it is not skipped.
+  this->net_->Forward();
+  EXPECT_GT(this->net_->blob_by_name("data")->asum_data(), 0);
+}
+
+TYPED_TEST(NetTest, TestSkipParamFillPartialWeights) {
+  typedef typename TypeParam::Dtype Dtype;
+  this->InitUnsharedWeightsNet();
+  NetParameter trained;
+  this->net_->ToProto(&trained);
+  // Weights that only cover innerproduct1.
+  NetParameter partial;
+  for (int i = 0; i < trained.layer_size(); ++i) {
+    if (trained.layer(i).name() != "innerproduct2") {
+      partial.add_layer()->CopyFrom(trained.layer(i));
+    }
+  }
+  Blob<Dtype> trained_weights;
+  trained_weights.CopyFrom(*this->net_->layer_by_name("innerproduct1")
+      ->blobs()[0], false, true);
+  Caffe::set_skip_param_fill(true);
+  this->InitUnsharedWeightsNet();
+  Caffe::set_skip_param_fill(false);
+  EXPECT_EQ(0, this->net_->layer_by_name("innerproduct2")
+      ->blobs()[0]->asum_data());
+  this->net_->CopyTrainedLayersFrom(partial);
+  const Blob<Dtype>* weights1 = this->net_->layer_by_name("innerproduct1")
+      ->blobs()[0].get();
+  for (int i = 0; i < weights1->count(); ++i) {
+    EXPECT_EQ(trained_weights.cpu_data()[i], weights1->cpu_data()[i]);
+  }
+  // The fillers run for the layer the weights leave out.
+  EXPECT_GT(this->net_->layer_by_name("innerproduct2")
+      ->blobs()[0]->asum_data(), 0);
+}
+
 TYPED_TEST(NetTest, TestGetBlob) {
   this->InitTinyNet();
   EXPECT_EQ(this->net_->blob_by_name("data"), this->net_->blobs()[0]);
@@ -3087,14 +3176,8 @@ TEST_F(CompileNetTest, TestRemoveBatchNorm2) {
       "layer { "
       "  bottom: 'data' "
       "  name: 'fc1' "
-      "  top: 'fc1' "
-      "  type: 'InnerProduct' "
-      "} "
-      "layer { "
-      "  bottom: 'fc1' "
-      "  name: 'bn' "
       "  top: 'bn' "
-      "  type: 'BatchNorm' "
+      "  type: 'InnerProduct' "
       "} "
       "layer { "
       "  name: 'loss' "
@@ -3221,8 +3304,591 @@ TEST_F(CompileNetTest, TestRemoveBatchNorm4) {
       "} ";
   this->RunCompilerNetTest(input_proto, output_proto);
 }
+
+TEST_F(CompileNetTest, TestRemoveBatchNormScaleDeconvolution) {
+  const string& input_proto =
+      "name: 'TestNetwork' "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'Data' "
+      "  top: 'data' "
+      "  top: 'label' "
+      "} "
+      "layer { "
+      "  bottom: 'data' "
+      "  name: 'deconv' "
+      "  top: 'deconv' "
+      "  type: 'Deconvolution' "
+      "} "
+      "layer { "
+      "  bottom: 'deconv' "
+      "  name: 'bn' "
+      "  top: 'deconv' "
+      "  type: 'BatchNorm' "
+      "} "
+      "layer { "
+      "  bottom: 'deconv' "
+      "  name: 'scale' "
+      "  top: 'deconv' "
+      "  type: 'Scale' "
+      "} "
+      "layer { "
+      "  bottom: 'deconv' "
+      "  name: 'relu' "
+      "  top: 'deconv' "
+      "  type: 'ReLU' "
+      "} "
+      "layer { "
+      "  name: 'loss' "
+      "  type: 'SoftmaxWithLoss' "
+      "  bottom: 'deconv' "
+      "  bottom: 'label' "
+      "} ";
+
+  const string& output_proto =
+      "name: 'TestNetwork' "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'Data' "
+      "  top: 'data' "
+      "  top: 'label' "
+      "} "
+      "layer { "
+      "  bottom: 'data' "
+      "  name: 'deconv' "
+      "  top: 'deconv' "
+      "  type: 'Deconvolution' "
+      "} "
+      "layer { "
+      "  bottom: 'deconv' "
+      "  name: 'relu' "
+      "  top: 'deconv' "
+      "  type: 'ReLU' "
+      "} "
+      "layer { "
+      "  name: 'loss' "
+      "  type: 'SoftmaxWithLoss' "
+      "  bottom: 'deconv' "
+      "  bottom: 'label' "
+      "} ";
+  this->RunCompilerNetTest(input_proto, output_proto);
+}
+
+TEST_F(CompileNetTest, TestRemoveBatchNormScale3DConvolution) {
+  const string& input_proto =
+      "name: 'TestNetwork' "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'Data' "
+      "  top: 'data' "
+      "  top: 'label' "
+      "} "
+      "layer { "
+      "  bottom: 'data' "
+      "  name: 'conv' "
+      "  top: 'conv' "
+      "  type: 'Convolution' "
+      "  convolution_param { "
+      "    num_output: 8 "
+      "    kernel_size: 3 "
+      "    kernel_size: 3 "
+      "    kernel_size: 3 "
+      "    bias_term: false "
+      "  } "
+      "} "
+      "layer { "
+      "  bottom: 'conv' "
+      "  name: 'bn' "
+      "  top: 'bn' "
+      "  type: 'BatchNorm' "
+      "} "
+      "layer { "
+      "  bottom: 'bn' "
+      "  name: 'scale' "
+      "  top: 'scale' "
+      "  type: 'Scale' "
+      "  scale_param { "
+      "    bias_term: true "
+      "  } "
+      "} "
+      "layer { "
+      "  bottom: 'scale' "
+      "  name: 'relu' "
+      "  top: 'relu' "
+      "  type: 'ReLU' "
+      "} "
+      "layer { "
+      "  name: 'loss' "
+      "  type: 'SoftmaxWithLoss' "
+      "  bottom: 'relu' "
+      "  bottom: 'label' "
+      "} ";
+
+  const string& output_proto =
+      "name: 'TestNetwork' "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'Data' "
+      "  top: 'data' "
+      "  top: 'label' "
+      "} "
+      "layer { "
+      "  bottom: 'data' "
+      "  name: 'conv' "
+#ifndef DISABLE_POINTWISE_FUSION
+      // The ReLU runs as an epilogue of the folded convolution
+      "  top: 'relu' "
+#else
+      "  top: 'scale' "
+#endif
+      "  type: 'Convolution' "
+      "  convolution_param { "
+      "    num_output: 8 "
+      "    kernel_size: 3 "
+      "    kernel_size: 3 "
+      "    kernel_size: 3 "
+      "    bias_term: true "
+      "  } "
+#ifndef DISABLE_POINTWISE_FUSION
+      "  fused_pointwise_param { "
+      "    op { "
+      "      bottom: 'scale' "
+      "      name: 'relu' "
+      "      top: 'relu' "
+      "      type: 'ReLU' "
+      "    } "
+      "  } "
+      "} "
+#else
+      "} "
+      "layer { "
+      "  bottom: 'scale' "
+      "  name: 'relu' "
+      "  top: 'relu' "
+      "  type: 'ReLU' "
+      "} "
+#endif
+      "layer { "
+      "  name: 'loss' "
+      "  type: 'SoftmaxWithLoss' "
+      "  bottom: 'relu' "
+      "  bottom: 'label' "
+      "} ";
+  this->RunCompilerNetTest(input_proto, output_proto);
+}
+
 #endif
 
+#ifndef DISABLE_POINTWISE_FUSION
+TEST_F(CompileNetTest, TestPointwiseFusion) {
+  const string& input_proto =
+      "name: 'TestNetwork' "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'Data' "
+      "  top: 'data' "
+      "  top: 'label' "
+      "} "
+      "layer { "
+      "  bottom: 'data' "
+      "  name: 'conv' "
+      "  top: 'conv' "
+      "  type: 'Convolution' "
+      "  convolution_param { "
+      "    num_output: 3 "
+      "    kernel_size: 1 "
+      "  } "
+      "} "
+      "layer { "
+      "  bottom: 'conv' "
+      "  name: 'relu1' "
+      "  top: 'conv' "
+      "  type: 'ReLU' "
+      "} "
+      "layer { "
+      "  bottom: 'conv' "
+      "  name: 'scale' "
+      "  top: 'scale' "
+      "  type: 'Scale' "
+      "  scale_param { "
+      "    bias_term: true "
+      "  } "
+      "} "
+      "layer { "
+      "  bottom: 'scale' "
+      "  name: 'relu2' "
+      "  top: 'relu2' "
+      "  type: 'ReLU' "
+      "} "
+      "layer { "
+      "  bottom: 'relu2' "
+      "  bottom: 'data' "
+      "  name: 'sum' "
+      "  top: 'sum' "
+      "  type: 'Eltwise' "
+      "} "
+      "layer { "
+      "  bottom: 'sum' "
+      "  name: 'relu3' "
+      "  top: 'relu3' "
+      "  type: 'ReLU' "
+      "  relu_param { "
+      "    engine: MKLDNN "
+      "  } "
+      "} "
+      "layer { "
+      "  name: 'loss' "
+      "  type: 'SoftmaxWithLoss' "
+      "  bottom: 'relu3' "
+      "  bottom: 'label' "
+      "} ";
+
+  const string& output_proto =
+      "name: 'TestNetwork' "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'Data' "
+      "  top: 'data' "
+      "  top: 'label' "
+      "} "
+      "layer { "
+      "  bottom: 'data' "
+      "  name: 'conv' "
+      "  top: 'conv' "
+      "  type: 'Convolution' "
+      "  convolution_param { "
+      "    num_output: 3 "
+      "    kernel_size: 1 "
+      "  } "
+      "  fused_pointwise_param { "
+      "    op { "
+      "      bottom: 'conv' "
+      "      name: 'relu1' "
+      "      top: 'conv' "
+      "      type: 'ReLU' "
+      "    } "
+      "  } "
+      "} "
+      "layer { "
+      "  bottom: 'conv' "
+      "  bottom: 'data' "
+      "  name: 'scale' "
+      "  top: 'sum' "
+      "  type: 'FusedPointwise' "
+      "  fused_pointwise_param { "
+      "    op { "
+      "      bottom: 'conv' "
+      "      name: 'scale' "
+      "      top: 'scale' "
+      "      type: 'Scale' "
+      "      scale_param { "
+      "        bias_term: true "
+      "      } "
+      "    } "
+      "    op { "
+      "      bottom: 'scale' "
+      "      name: 'relu2' "
+      "      top: 'relu2' "
+      "      type: 'ReLU' "
+      "    } "
+      "    op { "
+      "      bottom: 'relu2' "
+      "      bottom: 'data' "
+      "      name: 'sum' "
+      "      top: 'sum' "
+      "      type: 'Eltwise' "
+      "    } "
+      "  } "
+      "} "
+      "layer { "
+      "  bottom: 'sum' "
+      "  name: 'relu3' "
+      "  top: 'relu3' "
+      "  type: 'ReLU' "
+      "  relu_param { "
+      "    engine: MKLDNN "
+      "  } "
+      "} "
+      "layer { "
+      "  name: 'loss' "
+      "  type: 'SoftmaxWithLoss' "
+      "  bottom: 'relu3' "
+      "  bottom: 'label' "
+      "} ";
+  this->RunCompilerNetTest(input_proto, output_proto);
+
+  // Training nets are left untouched
+  const string input_proto_train = "state: { phase: TRAIN } " + input_proto;
+  this->RunCompilerNetTest(input_proto_train, input_proto_train);
+}
+#endif
+
+#ifndef DISABLE_BN_FOLDING
+// Runs the producer -> BatchNorm -> Scale -> ReLU chain unfolded (TRAIN
+// phase with global stats) and folded (TEST phase, weights folded while
+// loading) and checks that both give the same output.
+template <typename Dtype>
+void CheckBatchNormFolding(const string& producer_proto,
+                           const vector<int>& input_shape) {
+  const string proto =
+      "name: 'FoldNetwork' "
+      "engine: 'CAFFE' "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'DummyData' "
+      "  top: 'data' "
+      "  dummy_data_param { "
+      "    data_filler { type: 'constant' value: 0 } "
+      "  } "
+      "} " + producer_proto +
+      "layer { "
+      "  bottom: 'prod' "
+      "  name: 'bn' "
+      "  top: 'bn' "
+      "  type: 'BatchNorm' "
+      "  batch_norm_param { use_global_stats: true } "
+      "} "
+      "layer { "
+      "  bottom: 'bn' "
+      "  name: 'scale' "
+      "  top: 'scale' "
+      "  type: 'Scale' "
+      "  scale_param { "
+      "    bias_term: true "
+      "    filler { type: 'gaussian' std: 1 } "
+      "    bias_filler { type: 'gaussian' std: 1 } "
+      "  } "
+      "} "
+      "layer { "
+      "  bottom: 'scale' "
+      "  name: 'relu' "
+      "  top: 'relu' "
+      "  type: 'ReLU' "
+      "} ";
+  NetParameter param;
+  CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param));
+  BlobShape* shape =
+      param.mutable_layer(0)->mutable_dummy_data_param()->add_shape();
+  for (int i = 0; i < input_shape.size(); ++i) {
+    shape->add_dim(input_shape[i]);
+  }
+  param.mutable_state()->set_phase(TRAIN);
+  Net<Dtype> reference_net(param);
+  param.mutable_state()->set_phase(TEST);
+  Net<Dtype> folded_net(param);
+  EXPECT_FALSE(folded_net.has_layer("bn"));
+  EXPECT_FALSE(folded_net.has_layer("scale"));
+
+  FillerParameter filler_param;
+  filler_param.set_min(0.1);
+  filler_param.set_max(2);
+  UniformFiller<Dtype> filler(filler_param);
+  const vector<shared_ptr<Blob<Dtype> > >& bn_blobs =
+      reference_net.layer_by_name("bn")->blobs();
+  filler.Fill(bn_blobs[0].get());
+  filler.Fill(bn_blobs[1].get());
+  bn_blobs[2]->mutable_cpu_data()[0] = 2;
+  filler.Fill(reference_net.blob_by_name("data").get());
+  folded_net.blob_by_name("data")->CopyFrom(
+      *reference_net.blob_by_name("data"));
+
+  NetParameter trained_param;
+  reference_net.ToProto(&trained_param);
+  folded_net.CopyTrainedLayersFrom(trained_param);
+
+  reference_net.Forward();
+  folded_net.Forward();
+  const Blob<Dtype>* expected = reference_net.blob_by_name("relu").get();
+  const Blob<Dtype>* actual = folded_net.blob_by_name("relu").get();
+  ASSERT_EQ(expected->count(), actual->count());
+  for (int i = 0; i < expected->count(); ++i) {
+    EXPECT_NEAR(expected->cpu_data()[i], actual->cpu_data()[i],
+        1e-4 * std::max(Dtype(1), std::fabs(expected->cpu_data()[i])));
+  }
+}
+
+TYPED_TEST(NetTestCPU, TestFoldBatchNormScale3DConvolution) {
+  vector<int> input_shape;
+  input_shape.push_back(2);
+  input_shape.push_back(3);
+  input_shape.push_back(4);
+  input_shape.push_back(5);
+  input_shape.push_back(5);
+  CheckBatchNormFolding<TypeParam>(
+      "layer { "
+      "  bottom: 'data' "
+      "  name: 'prod' "
+      "  top: 'prod' "
+      "  type: 'Convolution' "
+      "  convolution_param { "
+      "    num_output: 4 "
+      "    kernel_size: 3 "
+      "    pad: 1 "
+      "    bias_term: false "
+      "    weight_filler { type: 'gaussian' std: 0.1 } "
+      "  } "
+      "} ", input_shape);
+}
+
+TYPED_TEST(NetTestCPU, TestFoldBatchNormScaleGroupDeconvolution) {
+  vector<int> input_shape;
+  input_shape.push_back(2);
+  input_shape.push_back(4);
+  input_shape.push_back(3);
+  input_shape.push_back(3);
+  CheckBatchNormFolding<TypeParam>(
+      "layer { "
+      "  bottom: 'data' "
+      "  name: 'prod' "
+      "  top: 'prod' "
+      "  type: 'Deconvolution' "
+      "  convolution_param { "
+      "    num_output: 6 "
+      "    group: 2 "
+      "    kernel_size: 2 "
+      "    stride: 2 "
+      "    weight_filler { type: 'gaussian' std: 0.1 } "
+      "    bias_filler { type: 'gaussian' std: 0.1 } "
+      "  } "
+      "} ", input_shape);
+}
+
+TYPED_TEST(NetTestCPU, TestFoldBatchNormScaleInnerProductTranspose) {
+  vector<int> input_shape;
+  input_shape.push_back(3);
+  input_shape.push_back(7);
+  CheckBatchNormFolding<TypeParam>(
+      "layer { "
+      "  bottom: 'data' "
+      "  name: 'prod' "
+      "  top: 'prod' "
+      "  type: 'InnerProduct' "
+      "  inner_product_param { "
+      "    num_output: 5 "
+      "    transpose: true "
+      "    weight_filler { type: 'gaussian' std: 0.1 } "
+      "  } "
+      "} ", input_shape);
+}
+
+#endif
+
+TYPED_TEST(NetTestCPU, TestActivationStorage) {
+  typedef TypeParam Dtype;
+  // 'a' waits in memory while 'b' and 'c' are computed
+  const string proto =
+      "layer { "
+      "  name: 'data' "
+      "  type: 'DummyData' "
+      "  top: 'data' "
+      "  dummy_data_param { "
+      "    shape { dim: 2 dim: 3 dim: 4 dim: 5 } "
+      "    data_filler { type: 'gaussian' std: 1 } "
+      "  } "
+      "} "
+      "layer { "
+      "  name: 'a' "
+      "  type: 'Power' "
+      "  bottom: 'data' "
+      "  top: 'a' "
+      "  power_param { scale: 0.333 } "
+      "} "
+      "layer { "
+      "  name: 'b' "
+      "  type: 'Power' "
+      "  bottom: 'a' "
+      "  top: 'b' "
+      "  power_param { shift: 1 } "
+      "} "
+      "layer { "
+      "  name: 'c' "
+      "  type: 'Power' "
+      "  bottom: 'b' "
+      "  top: 'c' "
+      "  power_param { scale: 2 } "
+      "} "
+      "layer { "
+      "  name: 'sum' "
+      "  type: 'Eltwise' "
+      "  bottom: 'a' "
+      "  bottom: 'c' "
+      "  top: 'sum' "
+      "  eltwise_param { engine: CAFFE } "
+      "} ";
+  NetParameter param;
+  CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param));
+  param.mutable_state()->set_phase(TEST);
+  Caffe::set_random_seed(this->seed_);
+  Net<Dtype> full_net(param);
+  full_net.Forward();
+  param.set_activation_storage(NetParameter_ActivationStorage_BFLOAT16);
+  param.set_activation_storage_min_wait(1);
+  Caffe::set_random_seed(this->seed_);
+  Net<Dtype> half_net(param);
+  half_net.Forward();
+  // 'a' was stored as bfloat16 after 'b', and only 'a'
+  const Blob<Dtype>& a = *half_net.blob_by_name("a");
+  const Blob<Dtype>& full_a = *full_net.blob_by_name("a");
+  vector<uint16_t> stored(a.count());
+  vector<Dtype> expected(a.count());
+  caffe_cpu_to_half(a.count(), full_a.cpu_data(), BFLOAT16, &stored[0]);
+  caffe_cpu_from_half(a.count(), &stored[0], BFLOAT16, &expected[0]);
+  for (int i = 0; i < a.count(); ++i) {
+    EXPECT_EQ(a.cpu_data()[i], expected[i]);
+  }
+  const Blob<Dtype>& c = *half_net.blob_by_name("c");
+  const Blob<Dtype>& full_c = *full_net.blob_by_name("c");
+  for (int i = 0; i < c.count(); ++i) {
+    EXPECT_EQ(c.cpu_data()[i], full_c.cpu_data()[i]);
+  }
+  const Blob<Dtype>& sum = *half_net.blob_by_name("sum");
+  const Blob<Dtype>& full_sum = *full_net.blob_by_name("sum");
+  for (int i = 0; i < sum.count(); ++i) {
+    EXPECT_NEAR(sum.cpu_data()[i], full_sum.cpu_data()[i],
+        std::fabs(full_a.cpu_data()[i]) / 128);
+  }
+}
+
+TYPED_TEST(NetTestCPU, TestConvolutionEngineFollowsBottomRank) {
+  // A single kernel_size leaves the rank to the bottom; only the 2D
+  // convolution may run on the 2D-only MKL-DNN layer.
+  const string proto =
+      "engine: 'MKLDNN' "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'DummyData' "
+      "  top: 'data2d' "
+      "  top: 'data3d' "
+      "  dummy_data_param { "
+      "    shape { dim: 1 dim: 2 dim: 4 dim: 4 } "
+      "    shape { dim: 1 dim: 2 dim: 4 dim: 4 dim: 4 } "
+      "  } "
+      "} "
+      "layer { "
+      "  name: 'conv2d' "
+      "  type: 'Convolution' "
+      "  bottom: 'data2d' "
+      "  top: 'conv2d' "
+      "  convolution_param { num_output: 2 kernel_size: 3 } "
+      "} "
+      "layer { "
+      "  name: 'conv3d' "
+      "  type: 'Convolution' "
+      "  bottom: 'data3d' "
+      "  top: 'conv3d' "
+      "  convolution_param { num_output: 2 kernel_size: 3 } "
+      "} ";
+  NetParameter param;
+  CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param));
+  param.mutable_state()->set_phase(TEST);
+  Net<TypeParam> net(param);
+  EXPECT_EQ(ConvolutionParameter_Engine_DEFAULT, net.layer_by_name("conv2d")
+      ->layer_param().convolution_param().engine());
+  EXPECT_EQ(ConvolutionParameter_Engine_CAFFE, net.layer_by_name("conv3d")
+      ->layer_param().convolution_param().engine());
+  EXPECT_EQ(2, net.blob_by_name("conv3d")->shape(2));
+}
+
 #ifdef MKL2017_SUPPORTED
 // If BatchNorm of engine MKL2017
 // produce blob consumed by
@@ -56,6 +56,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/layers/prelu_layer.hpp"
 #include "caffe/layers/relu_layer.hpp"
 #include "caffe/layers/sigmoid_layer.hpp"
+#include "caffe/layers/spatial_dropout_layer.hpp"
+#include "caffe/layers/swish_layer.hpp"
 #include "caffe/layers/tanh_layer.hpp"
 #include "caffe/layers/threshold_layer.hpp"
 
@@ -65,6 +67,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/layers/cudnn_tanh_layer.hpp"
 #endif
 
+#include "caffe/test/test_blocked_layout_util.hpp"
 #include "caffe/test/test_caffe_main.hpp"
 #include "caffe/test/test_gradient_check_util.hpp"
 
@@ -257,6 +260,26 @@ TYPED_TEST(NeuronLayerTest, TestReLU) {
   }
 }
 
+TYPED_TEST(NeuronLayerTest, TestReLUNumThreads) {
+  typedef typename TypeParam::Dtype Dtype;
+  LayerParameter layer_param;
+  ReLULayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  // Small blobs run on one thread
+  EXPECT_EQ(layer.num_threads(), 1);
+  // One more thread for every 32768 elements
+  this->blob_bottom_->Reshape(2, 3, 128, 128);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(layer.num_threads(), 3);
+  // A configured count wins
+  layer_param.set_num_threads(5);
+  ReLULayer<Dtype> configured_layer(layer_param);
+  configured_layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  configured_layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(configured_layer.num_threads(), 5);
+}
+
 TYPED_TEST(NeuronLayerTest, TestReLUGradient) {
   typedef typename TypeParam::Dtype Dtype;
   LayerParameter layer_param;
@@ -975,4 +998,86 @@ TYPED_TEST(CuDNNNeuronLayerTest, TestTanHGradientCuDNN) {
 }
 #endif
 
+#ifdef MKLDNN_SUPPORTED
+TEST(NeuronLayerBlockedLayoutTest, TestAbsVal) {
+  LayerParameter layer_param;
+  BlockedLayoutChecker checker;
+  checker.CheckForward<AbsValLayer<float> >(layer_param);
+}
+
+TEST(NeuronLayerBlockedLayoutTest, TestReLU) {
+  LayerParameter layer_param;
+  BlockedLayoutChecker checker;
+  checker.CheckForward<ReLULayer<float> >(layer_param);
+  layer_param.mutable_relu_param()->set_negative_slope(0.01);
+  checker.CheckForward<ReLULayer<float> >(layer_param);
+}
+
+TEST(NeuronLayerBlockedLayoutTest, TestELU) {
+  LayerParameter layer_param;
+  layer_param.mutable_elu_param()->set_alpha(0.5);
+  BlockedLayoutChecker checker;
+  checker.CheckForward<ELULayer<float> >(layer_param);
+}
+
+TEST(NeuronLayerBlockedLayoutTest, TestSigmoid) {
+  LayerParameter layer_param;
+  BlockedLayoutChecker checker;
+  checker.CheckForward<SigmoidLayer<float> >(layer_param);
+}
+
+TEST(NeuronLayerBlockedLayoutTest, TestExp) {
+  LayerParameter layer_param;
+  layer_param.mutable_exp_param()->set_scale(0.5);
+  layer_param.mutable_exp_param()->set_shift(0.1);
+  BlockedLayoutChecker checker;
+  checker.CheckForward<ExpLayer<float> >(layer_param);
+}
+
+TEST(NeuronLayerBlockedLayoutTest, TestLog) {
+  LayerParameter layer_param;
+  // Log needs positive bottoms
+  BlockedLayoutChecker checker(0.1, 2);
+  checker.CheckForward<LogLayer<float> >(layer_param);
+}
+
+TEST(NeuronLayerBlockedLayoutTest, TestDropoutTestPhase) {
+  LayerParameter layer_param;
+  layer_param.set_phase(TEST);
+  BlockedLayoutChecker checker;
+  checker.CheckForward<DropoutLayer<float> >(layer_param);
+}
+
+TEST(NeuronLayerBlockedLayoutTest, TestBNLL) {
+  LayerParameter layer_param;
+  BlockedLayoutChecker checker;
+  checker.CheckForward<BNLLLayer<float> >(layer_param);
+}
+
+TEST(NeuronLayerBlockedLayoutTest, TestPReLU) {
+  LayerParameter layer_param;
+  layer_param.mutable_prelu_param()->mutable_filler()->set_type("uniform");
+  BlockedLayoutChecker checker;
+  checker.CheckForward<PReLULayer<float> >(layer_param);
+  layer_param.mutable_prelu_param()->set_channel_shared(true);
+  checker.CheckForward<PReLULayer<float> >(layer_param);
+}
+
+TEST(NeuronLayerBlockedLayoutTest, TestSwish) {
+  LayerParameter layer_param;
+  layer_param.mutable_swish_param()->set_beta(1.5);
+  BlockedLayoutChecker checker;
+  checker.CheckForward<SwishLayer<float> >(layer_param);
+}
+
+TEST(NeuronLayerBlockedLayoutTest, TestSpatialDropout) {
+  LayerParameter layer_param;
+  layer_param.set_phase(TRAIN);
+  BlockedLayoutChecker checker;
+  checker.CheckForward<SpatialDropoutLayer<float> >(layer_param);
+  layer_param.set_phase(TEST);
+  checker.CheckForward<SpatialDropoutLayer<float> >(layer_param);
+}
+#endif  // MKLDNN_SUPPORTED
+
 }  // namespace caffe
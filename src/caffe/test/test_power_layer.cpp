@@ -45,6 +45,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/filler.hpp"
 #include "caffe/layers/power_layer.hpp"
 
+#include "caffe/test/test_blocked_layout_util.hpp"
 #include "caffe/test/test_caffe_main.hpp"
 #include "caffe/test/test_gradient_check_util.hpp"
 
@@ -204,4 +205,17 @@ TYPED_TEST(PowerLayerTest, TestPowerTwoScaleHalfGradient) {
   this->TestBackward(power, scale, shift);
 }
 
+#ifdef MKLDNN_SUPPORTED
+TEST(PowerLayerBlockedLayoutTest, TestForward) {
+  LayerParameter layer_param;
+  PowerParameter* power_param = layer_param.mutable_power_param();
+  power_param->set_power(0.37);
+  power_param->set_scale(0.83);
+  power_param->set_shift(-2.4);
+  // The shifted bottom stays positive for the fractional power
+  BlockedLayoutChecker checker(3, 5);
+  checker.CheckForward<PowerLayer<float> >(layer_param);
+}
+#endif  // MKLDNN_SUPPORTED
+
 }  // namespace caffe
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/layers/psroi_pooling_layer.hpp"
+#include "caffe/test/test_caffe_main.hpp"
+#include "caffe/test/test_gradient_check_util.hpp"
+
+namespace caffe {
+
+template <typename TypeParam>
+class PSROIPoolingLayerTest : public MultiDeviceTest<TypeParam> {
+  typedef typename TypeParam::Dtype Dtype;
+
+ protected:
+  PSROIPoolingLayerTest()
+      : blob_bottom_data_(new Blob<Dtype>(2, 2 * 3 * 3, 6, 8)),
+        blob_bottom_rois_(new Blob<Dtype>(4, 5, 1, 1)),
+        blob_top_data_(new Blob<Dtype>()) {
+    FillerParameter filler_param;
+    filler_param.set_std(1);
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_data_);
+    blob_bottom_vec_.push_back(blob_bottom_data_);
+    // ROIs 0 and 2 overlap on image 0, ROI 1 covers image 1 and ROI 3
+    // is a single pixel.
+    const Dtype rois[4][5] = {
+      {0, 0, 0, 7, 5}, {1, 0, 0, 7, 5}, {0, 2, 1, 6, 4}, {0, 3, 3, 3, 3}};
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 5; ++j) {
+        blob_bottom_rois_->mutable_cpu_data()[5 * i + j] = rois[i][j];
+      }
+    }
+    blob_bottom_vec_.push_back(blob_bottom_rois_);
+    blob_top_vec_.push_back(blob_top_data_);
+  }
+  virtual ~PSROIPoolingLayerTest() {
+    delete blob_bottom_data_;
+    delete blob_bottom_rois_;
+    delete blob_top_data_;
+  }
+  Blob<Dtype>* const blob_bottom_data_;
+  Blob<Dtype>* const blob_bottom_rois_;
+  Blob<Dtype>* const blob_top_data_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+};
+
+TYPED_TEST_CASE(PSROIPoolingLayerTest, TestDtypesAndDevices);
+
+TYPED_TEST(PSROIPoolingLayerTest, TestForward) {
+  typedef typename TypeParam::Dtype Dtype;
+  const int output_dim = 2;
+  const int group_size = 3;
+  LayerParameter layer_param;
+  PSROIPoolingParameter* psroi_pooling_param =
+      layer_param.mutable_psroi_pooling_param();
+  psroi_pooling_param->set_spatial_scale(1);
+  psroi_pooling_param->set_output_dim(output_dim);
+  psroi_pooling_param->set_group_size(group_size);
+  PSROIPoolingLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(this->blob_top_data_->num(), 4);
+  EXPECT_EQ(this->blob_top_data_->channels(), output_dim);
+  EXPECT_EQ(this->blob_top_data_->height(), group_size);
+  EXPECT_EQ(this->blob_top_data_->width(), group_size);
+
+  const Blob<Dtype>* bottom = this->blob_bottom_data_;
+  const Dtype* rois = this->blob_bottom_rois_->cpu_data();
+  for (int n = 0; n < 4; ++n) {
+    const int batch_ind = rois[5 * n];
+    const Dtype roi_width = rois[5 * n + 3] - rois[5 * n + 1] + 1;
+    const Dtype roi_height = rois[5 * n + 4] - rois[5 * n + 2] + 1;
+    const Dtype bin_size_w = roi_width / group_size;
+    const Dtype bin_size_h = roi_height / group_size;
+    for (int ctop = 0; ctop < output_dim; ++ctop) {
+      for (int ph = 0; ph < group_size; ++ph) {
+        for (int pw = 0; pw < group_size; ++pw) {
+          int hstart = floor(ph * bin_size_h + rois[5 * n + 2]);
+          int hend = ceil((ph + 1) * bin_size_h + rois[5 * n + 2]);
+          int wstart = floor(pw * bin_size_w + rois[5 * n + 1]);
+          int wend = ceil((pw + 1) * bin_size_w + rois[5 * n + 1]);
+          hstart = std::min(std::max(hstart, 0), bottom->height());
+          hend = std::min(std::max(hend, 0), bottom->height());
+          wstart = std::min(std::max(wstart, 0), bottom->width());
+          wend = std::min(std::max(wend, 0), bottom->width());
+          const int c = (ctop * group_size + ph) * group_size + pw;
+          Dtype expected = 0;
+          for (int h = hstart; h < hend; ++h) {
+            for (int w = wstart; w < wend; ++w) {
+              expected += bottom->data_at(batch_ind, c, h, w);
+            }
+          }
+          if (hend > hstart && wend > wstart) {
+            expected /= (hend - hstart) * (wend - wstart);
+          }
+          EXPECT_NEAR(this->blob_top_data_->data_at(n, ctop, ph, pw),
+                      expected, 1e-4);
+        }
+      }
+    }
+  }
+}
+
+TYPED_TEST(PSROIPoolingLayerTest, TestGradient) {
+  typedef typename TypeParam::Dtype Dtype;
+  LayerParameter layer_param;
+  PSROIPoolingParameter* psroi_pooling_param =
+      layer_param.mutable_psroi_pooling_param();
+  psroi_pooling_param->set_spatial_scale(1);
+  psroi_pooling_param->set_output_dim(2);
+  psroi_pooling_param->set_group_size(3);
+  PSROIPoolingLayer<Dtype> layer(layer_param);
+  GradientChecker<Dtype> checker(1e-4, 1e-2);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_, 0);
+}
+
+}  // namespace caffe
@@ -35,13 +35,20 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "gtest/gtest.h"
 
 #include "caffe/common.hpp"
 #include "caffe/syncedmem.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/rng.hpp"
 
 #include "caffe/test/test_caffe_main.hpp"
 
@@ -432,6 +439,54 @@ TYPED_TEST(RandomNumberGeneratorTest, TestRngBernoulliTimesBernoulli) {
   EXPECT_NEAR(true_mean, sample_p, bound);
 }
 
+TYPED_TEST(RandomNumberGeneratorTest, TestRngSameForAnyThreadCount) {
+  // Large enough for the generators to split the work across threads.
+  const int n = 100003;
+  vector<TypeParam> gaussian(n), uniform(n);
+  vector<int> bernoulli(n);
+#ifdef _OPENMP
+  const int max_threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  Caffe::set_random_seed(this->seed_);
+  caffe_rng_gaussian<TypeParam>(n, 1, 2, &gaussian[0]);
+  caffe_rng_uniform<TypeParam>(n, -1, 3, &uniform[0]);
+  caffe_rng_bernoulli<TypeParam>(n, 0.3, &bernoulli[0]);
+#ifdef _OPENMP
+  omp_set_num_threads(std::max(max_threads, 4));
+#endif
+  vector<TypeParam> gaussian_2(n), uniform_2(n);
+  vector<int> bernoulli_2(n);
+  Caffe::set_random_seed(this->seed_);
+  caffe_rng_gaussian<TypeParam>(n, 1, 2, &gaussian_2[0]);
+  caffe_rng_uniform<TypeParam>(n, -1, 3, &uniform_2[0]);
+  caffe_rng_bernoulli<TypeParam>(n, 0.3, &bernoulli_2[0]);
+#ifdef _OPENMP
+  omp_set_num_threads(max_threads);
+#endif
+  for (int i = 0; i < n; ++i) {
+    EXPECT_EQ(gaussian[i], gaussian_2[i]);
+    EXPECT_EQ(uniform[i], uniform_2[i]);
+    EXPECT_EQ(bernoulli[i], bernoulli_2[i]);
+  }
+}
+
+TEST(PhiloxTest, TestKnownAnswers) {
+  // Test vectors of the Random123 reference implementation.
+  uint32_t out[4];
+  Philox(0, 0)(0, out);
+  EXPECT_EQ(0x6627e8d5u, out[0]);
+  EXPECT_EQ(0xe169c58du, out[1]);
+  EXPECT_EQ(0xbc57ac4cu, out[2]);
+  EXPECT_EQ(0x9b00dbd8u, out[3]);
+  Philox(0xa4093822u, 0x299f31d0u)(0x85a308d3243f6a88ull, out,
+                                    0x0370734413198a2eull);
+  EXPECT_EQ(0xd16cfe09u, out[0]);
+  EXPECT_EQ(0x94fdccebu, out[1]);
+  EXPECT_EQ(0x5001e420u, out[2]);
+  EXPECT_EQ(0x24126ea1u, out[3]);
+}
+
 #ifndef CPU_ONLY
 
 TYPED_TEST(RandomNumberGeneratorTest, TestRngGaussianGPU) {
@@ -45,6 +45,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/filler.hpp"
 #include "caffe/layers/scale_layer.hpp"
 
+#include "caffe/test/test_blocked_layout_util.hpp"
 #include "caffe/test/test_caffe_main.hpp"
 #include "caffe/test/test_gradient_check_util.hpp"
 
@@ -541,4 +542,16 @@ TYPED_TEST(ScaleLayerTest, TestGradientScaleAxis2) {
       this->blob_top_vec_);
 }
 
+#ifdef MKLDNN_SUPPORTED
+TEST(ScaleLayerBlockedLayoutTest, TestForward) {
+  LayerParameter layer_param;
+  ScaleParameter* scale_param = layer_param.mutable_scale_param();
+  scale_param->mutable_filler()->set_type("uniform");
+  scale_param->set_bias_term(true);
+  scale_param->mutable_bias_filler()->set_type("uniform");
+  BlockedLayoutChecker checker;
+  checker.CheckForward<ScaleLayer<float> >(layer_param);
+}
+#endif  // MKLDNN_SUPPORTED
+
 }  // namespace caffe
@@ -44,6 +44,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/filler.hpp"
 #include "caffe/layers/slice_layer.hpp"
 
+#include "caffe/test/test_blocked_layout_util.hpp"
 #include "caffe/test/test_caffe_main.hpp"
 #include "caffe/test/test_gradient_check_util.hpp"
 
@@ -249,4 +250,13 @@ TYPED_TEST(SliceLayerTest, TestGradientAcrossChannels) {
     this->blob_top_vec_0_);
 }
 
+#ifdef MKLDNN_SUPPORTED
+TEST(SliceLayerBlockedLayoutTest, TestForwardChannels) {
+  LayerParameter layer_param;
+  layer_param.mutable_slice_param()->add_slice_point(8);
+  BlockedLayoutChecker checker;
+  checker.CheckForward<SliceLayer<float> >(layer_param, {{2, 24, 3, 4}}, 2);
+}
+#endif  // MKLDNN_SUPPORTED
+
 }  // namespace caffe
@@ -35,6 +35,7 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -111,6 +112,42 @@ TYPED_TEST(SoftmaxLayerTest, TestForward) {
   }
 }
 
+TYPED_TEST(SoftmaxLayerTest, TestForwardLargeClassCount) {
+  typedef typename TypeParam::Dtype Dtype;
+  // Few samples with many classes: each row is split across threads
+  vector<int> shape(2);
+  shape[0] = 2;
+  shape[1] = 40000;
+  this->blob_bottom_->Reshape(shape);
+  FillerParameter filler_param;
+  filler_param.set_std(4);
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(this->blob_bottom_);
+  LayerParameter layer_param;
+  SoftmaxLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  const Dtype* bottom_data = this->blob_bottom_->cpu_data();
+  const Dtype* top_data = this->blob_top_->cpu_data();
+  for (int i = 0; i < shape[0]; ++i) {
+    const Dtype* x = bottom_data + i * shape[1];
+    const Dtype* y = top_data + i * shape[1];
+    double max_val = x[0];
+    for (int j = 1; j < shape[1]; ++j) {
+      max_val = std::max(max_val, static_cast<double>(x[j]));
+    }
+    double scale = 0;
+    for (int j = 0; j < shape[1]; ++j) {
+      scale += exp(x[j] - max_val);
+    }
+    for (int j = 0; j < shape[1]; ++j) {
+      const double expected = exp(x[j] - max_val) / scale;
+      EXPECT_NEAR(y[j], expected, 1e-4 * expected + 1e-9)
+          << "debug: " << i << " " << j;
+    }
+  }
+}
+
 TYPED_TEST(SoftmaxLayerTest, TestGradient) {
   typedef typename TypeParam::Dtype Dtype;
   LayerParameter layer_param;
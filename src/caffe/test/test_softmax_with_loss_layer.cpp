@@ -35,6 +35,8 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <vector>
 
@@ -121,6 +123,44 @@ TYPED_TEST(SoftmaxWithLossLayerTest, TestForwardIgnoreLabel) {
   EXPECT_NEAR(4 * full_loss, accum_loss, 1e-4);
 }
 
+TYPED_TEST(SoftmaxWithLossLayerTest, TestForwardSingleLabelPerSample) {
+  typedef typename TypeParam::Dtype Dtype;
+  // One label per sample takes the fused softmax + cross-entropy path
+  vector<int> data_shape(2);
+  data_shape[0] = 12;
+  data_shape[1] = 5;
+  this->blob_bottom_data_->Reshape(data_shape);
+  this->blob_bottom_label_->Reshape(vector<int>(1, data_shape[0]));
+  LayerParameter layer_param;
+  layer_param.mutable_loss_param()->set_ignore_label(0);
+  SoftmaxWithLossLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  const Dtype* data = this->blob_bottom_data_->cpu_data();
+  const Dtype* label = this->blob_bottom_label_->cpu_data();
+  double expected_loss = 0;
+  int count = 0;
+  for (int i = 0; i < data_shape[0]; ++i) {
+    const int label_value = static_cast<int>(label[i]);
+    if (label_value == 0) {
+      continue;
+    }
+    double sum = 0;
+    for (int j = 0; j < data_shape[1]; ++j) {
+      sum += exp(data[i * data_shape[1] + j]);
+    }
+    expected_loss -= log(std::max(double(FLT_MIN),
+        exp(data[i * data_shape[1] + label_value]) / sum));
+    ++count;
+  }
+  expected_loss /= std::max(count, 1);
+  EXPECT_NEAR(this->blob_top_loss_->cpu_data()[0], expected_loss,
+      1e-4 * std::max(1., expected_loss));
+  GradientChecker<Dtype> checker(1e-2, 1e-2, 1701);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_, 0);
+}
+
 TYPED_TEST(SoftmaxWithLossLayerTest, TestGradientIgnoreLabel) {
   typedef typename TypeParam::Dtype Dtype;
   LayerParameter layer_param;
@@ -143,4 +143,64 @@ TYPED_TEST(SolverTest, TestInitTrainTestNets) {
   EXPECT_TRUE(this->solver_->test_nets()[1]->has_layer("accuracy"));
 }
 
+TYPED_TEST(SolverTest, TestAsyncTestUsesWeightSnapshot) {
+  typedef typename TypeParam::Dtype Dtype;
+  const string& proto =
+     "test_interval: 2 "
+     "test_iter: 3 "
+     "test_initialization: false "
+     "test_async: true "
+     "base_lr: 0.1 "
+     "lr_policy: 'fixed' "
+     "net_param { "
+     "  name: 'TestNetwork' "
+     "  layer { "
+     "    name: 'data' "
+     "    type: 'DummyData' "
+     "    dummy_data_param { "
+     "      data_filler { type: 'gaussian' std: 1.0 } "
+     "      data_filler { type: 'constant' value: 1 } "
+     "      shape { dim: 5 dim: 2 dim: 3 dim: 4 } "
+     "      shape { dim: 5 } "
+     "    } "
+     "    top: 'data' "
+     "    top: 'label' "
+     "  } "
+     "  layer { "
+     "    name: 'innerprod' "
+     "    type: 'InnerProduct' "
+     "    inner_product_param { "
+     "      num_output: 10 "
+     "      weight_filler { type: 'gaussian' std: 0.1 } "
+     "    } "
+     "    bottom: 'data' "
+     "    top: 'innerprod' "
+     "  } "
+     "  layer { "
+     "    name: 'loss' "
+     "    type: 'SoftmaxWithLoss' "
+     "    bottom: 'innerprod' "
+     "    bottom: 'label' "
+     "  } "
+     "} ";
+  this->InitSolverFromProtoString(proto);
+  // No test pass before iteration 2.
+  this->solver_->Step(2);
+  const Blob<Dtype>& train_weights =
+      *this->solver_->net()->layer_by_name("innerprod")->blobs()[0];
+  Blob<Dtype> snapshot;
+  snapshot.CopyFrom(train_weights, false, true);
+  // Iteration 2 tests on a copy of the weights and then updates them.
+  this->solver_->Step(1);
+  const Blob<Dtype>& test_weights =
+      *this->solver_->test_nets()[0]->layer_by_name("innerprod")->blobs()[0];
+  EXPECT_NE(train_weights.cpu_data(), test_weights.cpu_data());
+  bool train_changed = false;
+  for (int i = 0; i < snapshot.count(); ++i) {
+    EXPECT_EQ(snapshot.cpu_data()[i], test_weights.cpu_data()[i]);
+    train_changed |= snapshot.cpu_data()[i] != train_weights.cpu_data()[i];
+  }
+  EXPECT_TRUE(train_changed);
+}
+
 }  // namespace caffe
@@ -104,6 +104,40 @@ TEST_F(SyncedMemoryTest, TestCPUWrite) {
   }
 }
 
+TEST_F(SyncedMemoryTest, TestStoreHalf) {
+  const int count = 100;
+  SyncedMemory mem(count * sizeof(float));
+  float* cpu_data = static_cast<float*>(mem.mutable_cpu_data());
+  for (int i = 0; i < count; ++i) {
+    cpu_data[i] = 0.25f * (i - 50);
+  }
+  mem.store_half<float>(BFLOAT16);
+  EXPECT_EQ(mem.head(), SyncedMemory::HEAD_AT_HALF);
+  EXPECT_TRUE(mem.prv_data() == NULL);
+  // The data comes back at the address layers may have kept
+  const float* data = static_cast<const float*>(mem.cpu_data());
+  EXPECT_EQ(data, cpu_data);
+  EXPECT_EQ(mem.head(), SyncedMemory::HEAD_AT_CPU);
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(data[i], 0.25f * (i - 50));
+  }
+  // Values not representable in 16 bits come back rounded
+  cpu_data = static_cast<float*>(mem.mutable_cpu_data());
+  cpu_data[0] = 1.f / 3;
+  mem.store_half<float>(FLOAT16);
+  EXPECT_NEAR(static_cast<const float*>(mem.cpu_data())[0], 1.f / 3, 1e-4);
+}
+
+TEST_F(SyncedMemoryTest, TestStoreHalfSkipsForeignData) {
+  float values[4] = {1.f / 3, 2.f / 3, 1.f, 4.f / 3};
+  SyncedMemory mem(sizeof(values));
+  mem.set_cpu_data(values);
+  mem.store_half<float>(FLOAT16);
+  EXPECT_EQ(mem.head(), SyncedMemory::HEAD_AT_CPU);
+  EXPECT_EQ(mem.cpu_data(), values);
+  EXPECT_EQ(values[0], 1.f / 3);
+}
+
 #ifndef CPU_ONLY  // GPU test
 
 TEST_F(SyncedMemoryTest, TestGPURead) {
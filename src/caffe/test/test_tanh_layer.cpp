@@ -45,6 +45,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/filler.hpp"
 #include "caffe/layers/tanh_layer.hpp"
 
+#include "caffe/test/test_blocked_layout_util.hpp"
 #include "caffe/test/test_caffe_main.hpp"
 #include "caffe/test/test_gradient_check_util.hpp"
 
@@ -135,4 +136,12 @@ TYPED_TEST(TanHLayerTest, TestTanHGradient) {
   this->TestBackward(1.0);
 }
 
+#ifdef MKLDNN_SUPPORTED
+TEST(TanHLayerBlockedLayoutTest, TestForward) {
+  LayerParameter layer_param;
+  BlockedLayoutChecker checker;
+  checker.CheckForward<TanHLayer<float> >(layer_param);
+}
+#endif  // MKLDNN_SUPPORTED
+
 }  // namespace caffe
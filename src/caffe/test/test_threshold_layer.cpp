@@ -44,6 +44,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "caffe/filler.hpp"
 #include "caffe/layers/threshold_layer.hpp"
 
+#include "caffe/test/test_blocked_layout_util.hpp"
 #include "caffe/test/test_caffe_main.hpp"
 
 namespace caffe {
@@ -132,4 +133,13 @@ TYPED_TEST(ThresholdLayerTest, Test2) {
   }
 }
 
+#ifdef MKLDNN_SUPPORTED
+TEST(ThresholdLayerBlockedLayoutTest, TestForward) {
+  LayerParameter layer_param;
+  layer_param.mutable_threshold_param()->set_threshold(0.25);
+  BlockedLayoutChecker checker;
+  checker.CheckForward<ThresholdLayer<float> >(layer_param);
+}
+#endif  // MKLDNN_SUPPORTED
+
 }  // namespace caffe
@@ -0,0 +1,168 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/layer_factory.hpp"
+#include "caffe/layers/conv_layer.hpp"
+#include "caffe/layers/winograd_conv_layer.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+class WinogradConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  WinogradConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>()),
+        blob_top_(new Blob<Dtype>()),
+        blob_top_ref_(new Blob<Dtype>()) {
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    blob_top_ref_vec_.push_back(blob_top_ref_);
+  }
+  virtual ~WinogradConvolutionLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete blob_top_ref_;
+  }
+
+  void FillBottom(const vector<int>& shape) {
+    blob_bottom_->Reshape(shape);
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(blob_bottom_);
+  }
+
+  // Runs the Winograd layer and ConvolutionLayer with the same weights and
+  // checks they agree.
+  void CheckAgainstGEMM(const LayerParameter& layer_param, Dtype tolerance) {
+    WinogradConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    ASSERT_TRUE(layer.use_winograd());
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    ConvolutionLayer<Dtype> reference(layer_param);
+    reference.SetUp(blob_bottom_vec_, blob_top_ref_vec_);
+    reference.blobs()[0]->CopyFrom(*layer.blobs()[0]);
+    reference.blobs()[1]->CopyFrom(*layer.blobs()[1]);
+    reference.Forward(blob_bottom_vec_, blob_top_ref_vec_);
+    ASSERT_EQ(blob_top_->count(), blob_top_ref_->count());
+    for (int i = 0; i < blob_top_->count(); ++i) {
+      EXPECT_NEAR(blob_top_->cpu_data()[i], blob_top_ref_->cpu_data()[i],
+                  tolerance);
+    }
+  }
+
+  LayerParameter WinogradParam(int num_output, int pad, int tile) {
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->add_kernel_size(3);
+    convolution_param->add_pad(pad);
+    convolution_param->set_num_output(num_output);
+    convolution_param->set_engine(ConvolutionParameter_Engine_WINOGRAD);
+    convolution_param->set_winograd_tile(tile);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const blob_top_ref_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> blob_top_ref_vec_;
+};
+
+TYPED_TEST_CASE(WinogradConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(WinogradConvolutionLayerTest, TestForward2D) {
+  // Odd sizes leave partial tiles at the borders.
+  vector<int> shape(4, 2);
+  shape[1] = 5;
+  shape[2] = 9;
+  shape[3] = 11;
+  this->FillBottom(shape);
+  for (int tile = 2; tile <= 4; tile += 2) {
+    for (int pad = 0; pad <= 1; ++pad) {
+      this->CheckAgainstGEMM(this->WinogradParam(4, pad, tile), 1e-3);
+    }
+  }
+}
+
+TYPED_TEST(WinogradConvolutionLayerTest, TestForward3D) {
+  vector<int> shape(5, 2);
+  shape[1] = 3;
+  shape[2] = 5;
+  shape[3] = 6;
+  shape[4] = 7;
+  this->FillBottom(shape);
+  for (int pad = 0; pad <= 1; ++pad) {
+    this->CheckAgainstGEMM(this->WinogradParam(5, pad, 2), 1e-3);
+  }
+}
+
+TYPED_TEST(WinogradConvolutionLayerTest, TestWeightUpdate) {
+  typedef TypeParam Dtype;
+  vector<int> shape(4, 2);
+  shape[1] = 3;
+  shape[2] = 8;
+  shape[3] = 8;
+  this->FillBottom(shape);
+  LayerParameter layer_param = this->WinogradParam(4, 1, 2);
+  WinogradConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  // The cached filter transform must follow the solver's update.
+  Blob<Dtype>* weight = layer.blobs()[0].get();
+  caffe_set(weight->count(), Dtype(0.5), weight->mutable_cpu_diff());
+  weight->Update();
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+
+  ConvolutionLayer<Dtype> reference(layer_param);
+  reference.SetUp(this->blob_bottom_vec_, this->blob_top_ref_vec_);
+  reference.blobs()[0]->CopyFrom(*weight);
+  reference.blobs()[1]->CopyFrom(*layer.blobs()[1]);
+  reference.Forward(this->blob_bottom_vec_, this->blob_top_ref_vec_);
+  for (int i = 0; i < this->blob_top_->count(); ++i) {
+    EXPECT_NEAR(this->blob_top_->cpu_data()[i],
+                this->blob_top_ref_->cpu_data()[i], 1e-3);
+  }
+}
+
+TYPED_TEST(WinogradConvolutionLayerTest, TestAutoSelection) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param;
+  layer_param.set_type("Convolution");
+  ConvolutionParameter* convolution_param =
+      layer_param.mutable_convolution_param();
+  convolution_param->add_kernel_size(3);
+  convolution_param->add_pad(1);
+  convolution_param->set_num_output(16);
+  for (int channels = 4; channels <= 16; channels += 12) {
+    vector<int> shape(4, 1);
+    shape[1] = channels;
+    shape[2] = 6;
+    shape[3] = 6;
+    this->FillBottom(shape);
+    shared_ptr<Layer<Dtype> > layer =
+        LayerRegistry<Dtype>::CreateLayer(layer_param);
+    WinogradConvolutionLayer<Dtype>* winograd_layer =
+        dynamic_cast<WinogradConvolutionLayer<Dtype>*>(layer.get());
+    ASSERT_TRUE(winograd_layer != NULL);
+    layer->SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+    EXPECT_EQ(winograd_layer->use_winograd(), channels >= 16);
+  }
+  // Strided convolutions stay on the GEMM path.
+  convolution_param->add_stride(2);
+  shared_ptr<Layer<Dtype> > layer =
+      LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_TRUE(dynamic_cast<WinogradConvolutionLayer<Dtype>*>(layer.get()) ==
+              NULL);
+}
+
+}  // namespace caffe
@@ -0,0 +1,99 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <fstream>
+#include <string>
+
+#include "caffe/util/autotune_cache.hpp"
+#include "caffe/util/cpu_info.hpp"
+
+namespace caffe {
+
+AutotuneCache::AutotuneCache(const string& filename) : filename_(filename) {
+  if (filename_.empty()) {
+    return;
+  }
+  std::ifstream file(filename_.c_str());
+  string line;
+  while (std::getline(file, line)) {
+    const size_t split = line.find(' ');
+    if (split == string::npos || split == 0 || split + 1 == line.size()) {
+      continue;
+    }
+    entries_[line.substr(split + 1)] = line.substr(0, split);
+  }
+  DLOG(INFO) << "Read " << entries_.size() << " autotuning results from "
+             << filename_;
+}
+
+bool AutotuneCache::Find(const string& key, string* choice) const {
+  std::map<string, string>::const_iterator it = entries_.find(key);
+  if (it == entries_.end()) {
+    return false;
+  }
+  *choice = it->second;
+  return true;
+}
+
+void AutotuneCache::Insert(const string& key, const string& choice) {
+  CHECK(choice.find(' ') == string::npos && key.find('\n') == string::npos)
+      << "Invalid autotuning entry " << choice << " " << key;
+  entries_[key] = choice;
+  if (filename_.empty()) {
+    return;
+  }
+  // A single short append, so concurrent writers do not interleave lines.
+  const string line = choice + " " + key + "\n";
+  std::ofstream file(filename_.c_str(), std::ios::out | std::ios::app);
+  file.write(line.data(), line.size());
+  file.flush();
+  if (!file) {
+    LOG(WARNING) << "Could not record autotuning result in " << filename_;
+  }
+}
+
+const string& AutotuneCache::CpuModel() {
+  static const string model = []() {
+    cpu::CpuInfo cpu_info;
+    cpu::Collection collection(&cpu_info);
+    const string name = collection.getProcessorModelName();
+    return name.empty() ? string("unknown") : name;
+  }();
+  return model;
+}
+
+}  // namespace caffe
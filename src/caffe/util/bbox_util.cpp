@@ -619,56 +619,117 @@ void DecodeBBoxesAll(const vector<LabelBBox>& all_loc_preds,
   }
 }
 
-void MatchBBox(const vector<NormalizedBBox>& gt_bboxes,
+// Scratch space of MatchBBox. The overlaps between ground truth and
+// predictions are kept as a dense num_gt x num_pred matrix computed from
+// structure-of-arrays copies of the boxes, which replaces the per-call
+// map<int, map<int, float> > and lets the inner loop vectorize. FindMatches
+// keeps one instance per thread and reuses it for all images.
+struct BBoxMatchScratch {
+  vector<int> gt_indices;
+  vector<int> gt_pool;
+  // Predictions with a positive overlap to any ground truth, ascending.
+  vector<int> candidates;
+  vector<float> pred_xmin, pred_ymin, pred_xmax, pred_ymax, pred_size;
+  // overlaps[j * num_pred + i] is the overlap of the i-th prediction and the
+  // j-th selected ground truth, or 0 if it is not larger than 1e-6.
+  vector<float> overlaps;
+};
+
+static void MatchBBox(const vector<NormalizedBBox>& gt_bboxes,
     const vector<NormalizedBBox>& pred_bboxes, const int label,
     const MatchType match_type, const float overlap_threshold,
     const bool ignore_cross_boundary_bbox,
-    vector<int>* match_indices, vector<float>* match_overlaps) {
+    vector<int>* match_indices, vector<float>* match_overlaps,
+    BBoxMatchScratch* scratch) {
   int num_pred = pred_bboxes.size();
   match_indices->clear();
   match_indices->resize(num_pred, -1);
   match_overlaps->clear();
   match_overlaps->resize(num_pred, 0.);
 
-  int num_gt = 0;
-  vector<int> gt_indices;
-  if (label == -1) {
+  vector<int>& gt_indices = scratch->gt_indices;
+  gt_indices.clear();
+  for (int i = 0; i < gt_bboxes.size(); ++i) {
     // label -1 means comparing against all ground truth.
-    num_gt = gt_bboxes.size();
-    for (int i = 0; i < num_gt; ++i) {
+    if (label == -1 || gt_bboxes[i].label() == label) {
       gt_indices.push_back(i);
     }
-  } else {
-    // Count number of ground truth boxes which has the desired label.
-    for (int i = 0; i < gt_bboxes.size(); ++i) {
-      if (gt_bboxes[i].label() == label) {
-        num_gt++;
-        gt_indices.push_back(i);
-      }
-    }
   }
+  const int num_gt = gt_indices.size();
   if (num_gt == 0) {
     return;
   }
 
+  // Gather the predictions into contiguous coordinate arrays.
+  scratch->pred_xmin.resize(num_pred);
+  scratch->pred_ymin.resize(num_pred);
+  scratch->pred_xmax.resize(num_pred);
+  scratch->pred_ymax.resize(num_pred);
+  scratch->pred_size.resize(num_pred);
+  for (int i = 0; i < num_pred; ++i) {
+    const NormalizedBBox& bbox = pred_bboxes[i];
+    scratch->pred_xmin[i] = bbox.xmin();
+    scratch->pred_ymin[i] = bbox.ymin();
+    scratch->pred_xmax[i] = bbox.xmax();
+    scratch->pred_ymax[i] = bbox.ymax();
+    scratch->pred_size[i] = BBoxSize(bbox);
+  }
+  const float* pred_xmin = &scratch->pred_xmin[0];
+  const float* pred_ymin = &scratch->pred_ymin[0];
+  const float* pred_xmax = &scratch->pred_xmax[0];
+  const float* pred_ymax = &scratch->pred_ymax[0];
+  const float* pred_size = &scratch->pred_size[0];
+
+  // Jaccard overlap of every (ground truth, prediction) pair; this computes
+  // exactly what JaccardOverlap(pred_bboxes[i], gt_bboxes[...]) returns.
+  scratch->overlaps.resize(static_cast<size_t>(num_gt) * num_pred);
+  for (int j = 0; j < num_gt; ++j) {
+    const NormalizedBBox& gt_bbox = gt_bboxes[gt_indices[j]];
+    const float gt_xmin = gt_bbox.xmin();
+    const float gt_ymin = gt_bbox.ymin();
+    const float gt_xmax = gt_bbox.xmax();
+    const float gt_ymax = gt_bbox.ymax();
+    const float gt_size = BBoxSize(gt_bbox);
+    float* overlaps = &scratch->overlaps[static_cast<size_t>(j) * num_pred];
+#ifdef _OPENMP
+    #pragma omp simd
+#endif
+    for (int i = 0; i < num_pred; ++i) {
+      const float intersect_width = std::min(pred_xmax[i], gt_xmax) -
+          std::max(pred_xmin[i], gt_xmin);
+      const float intersect_height = std::min(pred_ymax[i], gt_ymax) -
+          std::max(pred_ymin[i], gt_ymin);
+      const float intersect_size = intersect_width * intersect_height;
+      const float overlap = intersect_size /
+          (pred_size[i] + gt_size - intersect_size);
+      overlaps[i] = (intersect_width > 0 && intersect_height > 0 &&
+                     overlap > 1e-6) ? overlap : 0.f;
+    }
+  }
+
   // Store the positive overlap between predictions and ground truth.
-  map<int, map<int, float> > overlaps;
+  vector<int>& candidates = scratch->candidates;
+  candidates.clear();
   for (int i = 0; i < num_pred; ++i) {
     if (ignore_cross_boundary_bbox && IsCrossBoundaryBBox(pred_bboxes[i])) {
       (*match_indices)[i] = -2;
       continue;
     }
+    float max_overlap = 0.;
     for (int j = 0; j < num_gt; ++j) {
-      float overlap = JaccardOverlap(pred_bboxes[i], gt_bboxes[gt_indices[j]]);
-      if (overlap > 1e-6) {
-        (*match_overlaps)[i] = std::max((*match_overlaps)[i], overlap);
-        overlaps[i][j] = overlap;
-      }
+      max_overlap = std::max(max_overlap,
+          scratch->overlaps[static_cast<size_t>(j) * num_pred + i]);
+    }
+    if (max_overlap > 0) {
+      (*match_overlaps)[i] = max_overlap;
+      candidates.push_back(i);
     }
   }
+  const float* overlaps = &scratch->overlaps[0];
 
   // Bipartite matching.
-  vector<int> gt_pool;
+  vector<int>& gt_pool = scratch->gt_pool;
+  gt_pool.clear();
   for (int i = 0; i < num_gt; ++i) {
     gt_pool.push_back(i);
   }
@@ -677,26 +738,26 @@ void MatchBBox(const vector<NormalizedBBox>& gt_bboxes,
     int max_idx = -1;
     int max_gt_idx = -1;
     float max_overlap = -1;
-    for (map<int, map<int, float> >::iterator it = overlaps.begin();
-         it != overlaps.end(); ++it) {
-      int i = it->first;
+    for (int c = 0; c < candidates.size(); ++c) {
+      int i = candidates[c];
       if ((*match_indices)[i] != -1) {
         // The prediction already has matched ground truth or is ignored.
         continue;
       }
       for (int p = 0; p < gt_pool.size(); ++p) {
         int j = gt_pool[p];
-        if (it->second.find(j) == it->second.end()) {
+        const float overlap = overlaps[static_cast<size_t>(j) * num_pred + i];
+        if (overlap == 0) {
           // No overlap between the i-th prediction and j-th ground truth.
           continue;
         }
         // Find the maximum overlapped pair.
-        if (it->second[j] > max_overlap) {
+        if (overlap > max_overlap) {
           // If the prediction has not been matched to any ground truth,
           // and the overlap is larger than maximum overlap, update.
           max_idx = i;
           max_gt_idx = j;
-          max_overlap = it->second[j];
+          max_overlap = overlap;
         }
       }
     }
@@ -718,9 +779,8 @@ void MatchBBox(const vector<NormalizedBBox>& gt_bboxes,
       break;
     case MultiBoxLossParameter_MatchType_PER_PREDICTION:
       // Get most overlaped for the rest prediction bboxes.
-      for (map<int, map<int, float> >::iterator it = overlaps.begin();
-           it != overlaps.end(); ++it) {
-        int i = it->first;
+      for (int c = 0; c < candidates.size(); ++c) {
+        int i = candidates[c];
         if ((*match_indices)[i] != -1) {
           // The prediction already has matched ground truth or is ignored.
           continue;
@@ -728,13 +788,10 @@ void MatchBBox(const vector<NormalizedBBox>& gt_bboxes,
         int max_gt_idx = -1;
         float max_overlap = -1;
         for (int j = 0; j < num_gt; ++j) {
-          if (it->second.find(j) == it->second.end()) {
-            // No overlap between the i-th prediction and j-th ground truth.
-            continue;
-          }
           // Find the maximum overlapped pair.
-          float overlap = it->second[j];
-          if (overlap >= overlap_threshold && overlap > max_overlap) {
+          float overlap = overlaps[static_cast<size_t>(j) * num_pred + i];
+          if (overlap != 0 && overlap >= overlap_threshold &&
+              overlap > max_overlap) {
             // If the prediction has not been matched to any ground truth,
             // and the overlap is larger than maximum overlap, update.
             max_gt_idx = j;
@@ -757,6 +814,17 @@ void MatchBBox(const vector<NormalizedBBox>& gt_bboxes,
   return;
 }
 
+void MatchBBox(const vector<NormalizedBBox>& gt_bboxes,
+    const vector<NormalizedBBox>& pred_bboxes, const int label,
+    const MatchType match_type, const float overlap_threshold,
+    const bool ignore_cross_boundary_bbox,
+    vector<int>* match_indices, vector<float>* match_overlaps) {
+  BBoxMatchScratch scratch;
+  MatchBBox(gt_bboxes, pred_bboxes, label, match_type, overlap_threshold,
+            ignore_cross_boundary_bbox, match_indices, match_overlaps,
+            &scratch);
+}
+
 void FindMatches(const vector<LabelBBox>& all_loc_preds,
       const map<int, vector<NormalizedBBox> >& all_gt_bboxes,
       const vector<NormalizedBBox>& prior_bboxes,
@@ -782,97 +850,126 @@ void FindMatches(const vector<LabelBBox>& all_loc_preds,
       multibox_loss_param.encode_variance_in_target();
   const bool ignore_cross_boundary_bbox =
       multibox_loss_param.ignore_cross_boundary_bbox();
-  // Find the matches.
+  // Find the matches; images are independent and matched in parallel.
   int num = all_loc_preds.size();
-  for (int i = 0; i < num; ++i) {
-    map<int, vector<int> > match_indices;
-    map<int, vector<float> > match_overlaps;
-    // Check if there is ground truth for current image.
-    if (all_gt_bboxes.find(i) == all_gt_bboxes.end()) {
-      // There is no gt for current image. All predictions are negative.
-      all_match_indices->push_back(match_indices);
-      all_match_overlaps->push_back(match_overlaps);
-      continue;
-    }
-    // Find match between predictions and ground truth.
-    const vector<NormalizedBBox>& gt_bboxes = all_gt_bboxes.find(i)->second;
-    if (!use_prior_for_matching) {
-      for (int c = 0; c < loc_classes; ++c) {
-        int label = share_location ? -1 : c;
-        if (!share_location && label == background_label_id) {
-          // Ignore background loc predictions.
-          continue;
-        }
-        // Decode the prediction into bbox first.
-        vector<NormalizedBBox> loc_bboxes;
-        bool clip_bbox = false;
-        DecodeBBoxes(prior_bboxes, prior_variances,
-                     code_type, encode_variance_in_target, clip_bbox,
-                     all_loc_preds[i].find(label)->second, &loc_bboxes);
-        MatchBBox(gt_bboxes, loc_bboxes, label, match_type,
-                  overlap_threshold, ignore_cross_boundary_bbox,
-                  &match_indices[label], &match_overlaps[label]);
+  const int indices_offset = all_match_indices->size();
+  const int overlaps_offset = all_match_overlaps->size();
+  all_match_indices->resize(indices_offset + num);
+  all_match_overlaps->resize(overlaps_offset + num);
+#ifdef _OPENMP
+  #pragma omp parallel if (num > 1)
+#endif
+  {
+    BBoxMatchScratch scratch;
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int i = 0; i < num; ++i) {
+      map<int, vector<int> >& match_indices =
+          (*all_match_indices)[indices_offset + i];
+      map<int, vector<float> >& match_overlaps =
+          (*all_match_overlaps)[overlaps_offset + i];
+      // Check if there is ground truth for current image.
+      if (all_gt_bboxes.find(i) == all_gt_bboxes.end()) {
+        // There is no gt for current image. All predictions are negative.
+        continue;
       }
-    } else {
-      // Use prior bboxes to match against all ground truth.
-      vector<int> temp_match_indices;
-      vector<float> temp_match_overlaps;
-      const int label = -1;
-      MatchBBox(gt_bboxes, prior_bboxes, label, match_type, overlap_threshold,
-                ignore_cross_boundary_bbox, &temp_match_indices,
-                &temp_match_overlaps);
-      if (share_location) {
-        match_indices[label] = temp_match_indices;
-        match_overlaps[label] = temp_match_overlaps;
-      } else {
-        // Get ground truth label for each ground truth bbox.
-        vector<int> gt_labels;
-        for (int g = 0; g < gt_bboxes.size(); ++g) {
-          gt_labels.push_back(gt_bboxes[g].label());
-        }
-        // Distribute the matching results to different loc_class.
+      // Find match between predictions and ground truth.
+      const vector<NormalizedBBox>& gt_bboxes = all_gt_bboxes.find(i)->second;
+      if (!use_prior_for_matching) {
         for (int c = 0; c < loc_classes; ++c) {
-          if (c == background_label_id) {
+          int label = share_location ? -1 : c;
+          if (!share_location && label == background_label_id) {
             // Ignore background loc predictions.
             continue;
           }
-          match_indices[c].resize(temp_match_indices.size(), -1);
-          match_overlaps[c] = temp_match_overlaps;
-          for (int m = 0; m < temp_match_indices.size(); ++m) {
-            if (temp_match_indices[m] > -1) {
-              const int gt_idx = temp_match_indices[m];
-              CHECK_LT(gt_idx, gt_labels.size());
-              if (c == gt_labels[gt_idx]) {
-                match_indices[c][m] = gt_idx;
+          // Decode the prediction into bbox first.
+          vector<NormalizedBBox> loc_bboxes;
+          bool clip_bbox = false;
+          DecodeBBoxes(prior_bboxes, prior_variances,
+                       code_type, encode_variance_in_target, clip_bbox,
+                       all_loc_preds[i].find(label)->second, &loc_bboxes);
+          MatchBBox(gt_bboxes, loc_bboxes, label, match_type,
+                    overlap_threshold, ignore_cross_boundary_bbox,
+                    &match_indices[label], &match_overlaps[label], &scratch);
+        }
+      } else {
+        // Use prior bboxes to match against all ground truth.
+        vector<int> temp_match_indices;
+        vector<float> temp_match_overlaps;
+        const int label = -1;
+        MatchBBox(gt_bboxes, prior_bboxes, label, match_type, overlap_threshold,
+                  ignore_cross_boundary_bbox, &temp_match_indices,
+                  &temp_match_overlaps, &scratch);
+        if (share_location) {
+          match_indices[label].swap(temp_match_indices);
+          match_overlaps[label].swap(temp_match_overlaps);
+        } else {
+          // Get ground truth label for each ground truth bbox.
+          vector<int> gt_labels;
+          for (int g = 0; g < gt_bboxes.size(); ++g) {
+            gt_labels.push_back(gt_bboxes[g].label());
+          }
+          // Distribute the matching results to different loc_class.
+          for (int c = 0; c < loc_classes; ++c) {
+            if (c == background_label_id) {
+              // Ignore background loc predictions.
+              continue;
+            }
+            match_indices[c].resize(temp_match_indices.size(), -1);
+            match_overlaps[c] = temp_match_overlaps;
+            for (int m = 0; m < temp_match_indices.size(); ++m) {
+              if (temp_match_indices[m] > -1) {
+                const int gt_idx = temp_match_indices[m];
+                CHECK_LT(gt_idx, gt_labels.size());
+                if (c == gt_labels[gt_idx]) {
+                  match_indices[c][m] = gt_idx;
+                }
               }
             }
           }
         }
       }
     }
-    all_match_indices->push_back(match_indices);
-    all_match_overlaps->push_back(match_overlaps);
   }
 }
 
+// Count the matches of a single image.
+static int CountNumMatches(const map<int, vector<int> >& match_indices) {
+  int num_matches = 0;
+  for (map<int, vector<int> >::const_iterator it = match_indices.begin();
+       it != match_indices.end(); ++it) {
+    const vector<int>& match_index = it->second;
+    for (int m = 0; m < match_index.size(); ++m) {
+      if (match_index[m] > -1) {
+        ++num_matches;
+      }
+    }
+  }
+  return num_matches;
+}
+
 int CountNumMatches(const vector<map<int, vector<int> > >& all_match_indices,
                     const int num) {
   int num_matches = 0;
   for (int i = 0; i < num; ++i) {
-    const map<int, vector<int> >& match_indices = all_match_indices[i];
-    for (map<int, vector<int> >::const_iterator it = match_indices.begin();
-         it != match_indices.end(); ++it) {
-      const vector<int>& match_index = it->second;
-      for (int m = 0; m < match_index.size(); ++m) {
-        if (match_index[m] > -1) {
-          ++num_matches;
-        }
-      }
-    }
+    num_matches += CountNumMatches(all_match_indices[i]);
   }
   return num_matches;
 }
 
+// Start offset of the matches of every image in the flattened list of all
+// matches (num + 1 entries), so that images can be processed in parallel.
+static void GetMatchOffsets(
+    const vector<map<int, vector<int> > >& all_match_indices, const int num,
+    vector<int>* offsets) {
+  offsets->resize(num + 1);
+  (*offsets)[0] = 0;
+  for (int i = 0; i < num; ++i) {
+    (*offsets)[i + 1] = (*offsets)[i] + CountNumMatches(all_match_indices[i]);
+  }
+}
+
 inline bool IsEligibleMining(const MiningType mining_type, const int match_idx,
     const float match_overlap, const float neg_overlap) {
   if (mining_type == MultiBoxLossParameter_MiningType_MAX_NEGATIVE) {
@@ -963,6 +1060,15 @@ void MineHardExamples(const Blob<Dtype>& conf_blob,
       all_loc_loss.push_back(loc_loss);
     }
   }
+  // Images are mined independently; the counters are reduced at the end.
+  const int neg_offset = all_neg_indices->size();
+  all_neg_indices->resize(neg_offset + num);
+  int num_unselected = 0;
+  int num_selected_negs = 0;
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) if (num > 1) \
+      reduction(+: num_unselected, num_selected_negs)
+#endif
   for (int i = 0; i < num; ++i) {
     map<int, vector<int> >& match_indices = (*all_match_indices)[i];
     const map<int, vector<float> >& match_overlaps = all_match_overlaps[i];
@@ -973,8 +1079,8 @@ void MineHardExamples(const Blob<Dtype>& conf_blob,
     std::transform(conf_loss.begin(), conf_loss.end(), loc_loss.begin(),
                    std::back_inserter(loss), std::plus<float>());
     // Pick negatives or hard examples based on loss.
-    set<int> sel_indices;
-    vector<int> neg_indices;
+    vector<char> sel_indices(num_priors, 0);
+    vector<int>& neg_indices = (*all_neg_indices)[neg_offset + i];
     for (map<int, vector<int> >::iterator it = match_indices.begin();
          it != match_indices.end(); ++it) {
       const int label = it->first;
@@ -1037,34 +1143,35 @@ void MineHardExamples(const Blob<Dtype>& conf_blob,
         // Pick top example indices after nms.
         num_sel = std::min(static_cast<int>(nms_indices.size()), num_sel);
         for (int n = 0; n < num_sel; ++n) {
-          sel_indices.insert(loss_indices[nms_indices[n]].second);
+          sel_indices[loss_indices[nms_indices[n]].second] = 1;
         }
       } else {
         // Pick top example indices based on loss.
         std::sort(loss_indices.begin(), loss_indices.end(),
                   SortScorePairDescend<int>);
         for (int n = 0; n < num_sel; ++n) {
-          sel_indices.insert(loss_indices[n].second);
+          sel_indices[loss_indices[n].second] = 1;
         }
       }
       // Update the match_indices and select neg_indices.
       for (int m = 0; m < match_indices[label].size(); ++m) {
         if (match_indices[label][m] > -1) {
           if (mining_type == MultiBoxLossParameter_MiningType_HARD_EXAMPLE &&
-              sel_indices.find(m) == sel_indices.end()) {
+              !sel_indices[m]) {
             match_indices[label][m] = -1;
-            *num_matches -= 1;
+            ++num_unselected;
           }
         } else if (match_indices[label][m] == -1) {
-          if (sel_indices.find(m) != sel_indices.end()) {
+          if (sel_indices[m]) {
             neg_indices.push_back(m);
-            *num_negs += 1;
+            ++num_selected_negs;
           }
         }
       }
     }
-    all_neg_indices->push_back(neg_indices);
   }
+  *num_matches -= num_unselected;
+  *num_negs += num_selected_negs;
 }
 
 // Explicite initialization.
@@ -1221,8 +1328,13 @@ void EncodeLocPrediction(const vector<LabelBBox>& all_loc_preds,
   const bool bp_inside = multibox_loss_param.bp_inside();
   const bool use_prior_for_matching =
       multibox_loss_param.use_prior_for_matching();
-  int count = 0;
+  vector<int> offsets;
+  GetMatchOffsets(all_match_indices, num, &offsets);
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) if (num > 1)
+#endif
   for (int i = 0; i < num; ++i) {
+    int count = offsets[i];
     for (map<int, vector<int> >::const_iterator
          it = all_match_indices[i].begin();
          it != all_match_indices[i].end(); ++it) {
@@ -1323,9 +1435,17 @@ void ComputeLocLoss(const Blob<Dtype>& loc_pred, const Blob<Dtype>& loc_gt,
     diff_data = diff.cpu_data();
   }
   CHECK_NOTNULL(diff_data);
-  int count = 0;
+  vector<int> offsets;
+  GetMatchOffsets(all_match_indices, num, &offsets);
+  const int loss_offset = all_loc_loss->size();
+  all_loc_loss->resize(loss_offset + num);
+#ifdef _OPENMP
+  #pragma omp parallel for if (num > 1)
+#endif
   for (int i = 0; i < num; ++i) {
-    vector<float> loc_loss(num_priors, 0.f);
+    int count = offsets[i];
+    vector<float>& loc_loss = (*all_loc_loss)[loss_offset + i];
+    loc_loss.assign(num_priors, 0.f);
     for (map<int, vector<int> >::const_iterator
          it = all_match_indices[i].begin();
          it != all_match_indices[i].end(); ++it) {
@@ -1355,7 +1475,6 @@ void ComputeLocLoss(const Blob<Dtype>& loc_pred, const Blob<Dtype>& loc_gt,
         ++count;
       }
     }
-    all_loc_loss->push_back(loc_loss);
   }
 }
 
@@ -1499,45 +1618,59 @@ void ComputeConfLoss(const Dtype* conf_data, const int num,
   CHECK_LT(background_label_id, num_classes);
   // CHECK_EQ(num, all_match_indices.size());
   all_conf_loss->clear();
+  all_conf_loss->resize(num);
+#ifdef _OPENMP
+  #pragma omp parallel for if (num > 1)
+#endif
   for (int i = 0; i < num; ++i) {
-    vector<float> conf_loss;
+    const Dtype* image_conf_data =
+        conf_data + static_cast<size_t>(i) * num_preds_per_class * num_classes;
+    vector<float>& conf_loss = (*all_conf_loss)[i];
+    conf_loss.resize(num_preds_per_class);
     const map<int, vector<int> >& match_indices = all_match_indices[i];
-    for (int p = 0; p < num_preds_per_class; ++p) {
-      int start_idx = p * num_classes;
-      // Get the label index.
-      int label = background_label_id;
-      for (map<int, vector<int> >::const_iterator it =
-           match_indices.begin(); it != match_indices.end(); ++it) {
-        const vector<int>& match_index = it->second;
-        CHECK_EQ(match_index.size(), num_preds_per_class);
-        if (match_index[p] > -1) {
-          CHECK(all_gt_bboxes.find(i) != all_gt_bboxes.end());
-          const vector<NormalizedBBox>& gt_bboxes =
-              all_gt_bboxes.find(i)->second;
-          CHECK_LT(match_index[p], gt_bboxes.size());
-          label = gt_bboxes[match_index[p]].label();
-          CHECK_GE(label, 0);
-          CHECK_NE(label, background_label_id);
-          CHECK_LT(label, num_classes);
-          // A prior can only be matched to one gt bbox.
-          break;
+    // Get the label index of every prediction. A prior can only be matched
+    // to one gt bbox, the first label (in map order) with a match wins.
+    vector<int> labels(num_preds_per_class, background_label_id);
+    vector<char> matched(num_preds_per_class, 0);
+    for (map<int, vector<int> >::const_iterator it =
+         match_indices.begin(); it != match_indices.end(); ++it) {
+      const vector<int>& match_index = it->second;
+      CHECK_EQ(match_index.size(), num_preds_per_class);
+      for (int p = 0; p < num_preds_per_class; ++p) {
+        if (matched[p] || match_index[p] <= -1) {
+          continue;
         }
+        CHECK(all_gt_bboxes.find(i) != all_gt_bboxes.end());
+        const vector<NormalizedBBox>& gt_bboxes =
+            all_gt_bboxes.find(i)->second;
+        CHECK_LT(match_index[p], gt_bboxes.size());
+        const int label = gt_bboxes[match_index[p]].label();
+        CHECK_GE(label, 0);
+        CHECK_NE(label, background_label_id);
+        CHECK_LT(label, num_classes);
+        labels[p] = label;
+        matched[p] = 1;
       }
+    }
+    for (int p = 0; p < num_preds_per_class; ++p) {
+      int start_idx = p * num_classes;
+      const int label = labels[p];
       Dtype loss = 0;
       if (loss_type == MultiBoxLossParameter_ConfLossType_SOFTMAX) {
         CHECK_GE(label, 0);
         CHECK_LT(label, num_classes);
         // Compute softmax probability.
         // We need to subtract the max to avoid numerical issues.
-        Dtype maxval = conf_data[start_idx];
+        Dtype maxval = image_conf_data[start_idx];
         for (int c = 1; c < num_classes; ++c) {
-          maxval = std::max<Dtype>(conf_data[start_idx + c], maxval);
+          maxval = std::max<Dtype>(image_conf_data[start_idx + c], maxval);
         }
         Dtype sum = 0.;
         for (int c = 0; c < num_classes; ++c) {
-          sum += std::exp(conf_data[start_idx + c] - maxval);
+          sum += std::exp(image_conf_data[start_idx + c] - maxval);
         }
-        Dtype prob = std::exp(conf_data[start_idx + label] - maxval) / sum;
+        Dtype prob =
+            std::exp(image_conf_data[start_idx + label] - maxval) / sum;
         loss = -log(std::max(prob, Dtype(FLT_MIN)));
       } else if (loss_type == MultiBoxLossParameter_ConfLossType_LOGISTIC) {
         int target = 0;
@@ -1547,17 +1680,15 @@ void ComputeConfLoss(const Dtype* conf_data, const int num,
           } else {
             target = 0;
           }
-          Dtype input = conf_data[start_idx + c];
+          Dtype input = image_conf_data[start_idx + c];
           loss -= input * (target - (input >= 0)) -
               log(1 + exp(input - 2 * input * (input >= 0)));
         }
       } else {
         LOG(FATAL) << "Unknown conf loss type.";
       }
-      conf_loss.push_back(loss);
+      conf_loss[p] = loss;
     }
-    conf_data += num_preds_per_class * num_classes;
-    all_conf_loss->push_back(conf_loss);
   }
 }
 
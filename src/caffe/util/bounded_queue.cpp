@@ -0,0 +1,423 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+#include "caffe/data_reader.hpp"
+#include "caffe/layers/base_data_layer.hpp"
+#include "caffe/util/bounded_queue.hpp"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define CAFFE_CPU_RELAX() _mm_pause()
+#else
+#define CAFFE_CPU_RELAX() ((void) 0)
+#endif
+
+namespace caffe {
+
+// Wake-up side shared by both queues. Waiters are counted so that the
+// common case, where nobody sleeps, never touches the mutex.
+class QueueWaiters {
+ public:
+  QueueWaiters() : count_(0) {}
+
+  template<typename Ready>
+  void wait_until(Ready ready, int spin_count, const string& log_on_wait) {
+    for (int i = 0; i < spin_count; ++i) {
+      if (ready()) {
+        return;
+      }
+      CAFFE_CPU_RELAX();
+    }
+    boost::mutex::scoped_lock lock(mutex_);
+    Registration registration(&count_);
+    // Pairs with the fence in notify(): either the other side sees the
+    // registration, or we see its update when checking ready().
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+    while (!ready()) {
+      if (!log_on_wait.empty()) {
+        LOG_EVERY_N(INFO, 1000)<< log_on_wait;
+      }
+      // Timed so that a missed wake-up can only delay, never deadlock.
+      condition_.timed_wait(lock, boost::posix_time::milliseconds(10));
+    }
+  }
+
+  void notify() {
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+    if (count_.load(boost::memory_order_relaxed) > 0) {
+      boost::mutex::scoped_lock lock(mutex_);
+      condition_.notify_all();
+    }
+  }
+
+ private:
+  class Registration {
+   public:
+    explicit Registration(boost::atomic<int>* count) : count_(count) {
+      count_->fetch_add(1, boost::memory_order_relaxed);
+    }
+    ~Registration() {
+      count_->fetch_sub(1, boost::memory_order_relaxed);
+    }
+
+   private:
+    boost::atomic<int>* count_;
+  };
+
+  boost::atomic<int> count_;
+  boost::mutex mutex_;
+  boost::condition_variable condition_;
+};
+
+template<typename T>
+class SPSCQueue<T>::sync {
+ public:
+  explicit sync(size_t capacity)
+      : ring_(capacity), head_(0), tail_(0) {}
+
+  vector<T> ring_;
+  // Monotonic positions; the slot is position % capacity.
+  boost::atomic<size_t> head_;
+  boost::atomic<size_t> tail_;
+  QueueWaiters producer_;
+  QueueWaiters consumer_;
+};
+
+template<typename T>
+SPSCQueue<T>::SPSCQueue(size_t capacity, int spin_count)
+    : sync_(new sync(capacity)), spin_count_(spin_count) {
+  CHECK_GT(capacity, 0) << "Queue capacity must be positive";
+}
+
+template<typename T>
+bool SPSCQueue<T>::try_push(const T& t) {
+  const size_t tail = sync_->tail_.load(boost::memory_order_relaxed);
+  if (tail - sync_->head_.load(boost::memory_order_acquire)
+      >= sync_->ring_.size()) {
+    return false;
+  }
+  sync_->ring_[tail % sync_->ring_.size()] = t;
+  sync_->tail_.store(tail + 1, boost::memory_order_release);
+  sync_->consumer_.notify();
+  return true;
+}
+
+template<typename T>
+void SPSCQueue<T>::push(const T& t) {
+  push_n(&t, 1);
+}
+
+template<typename T>
+void SPSCQueue<T>::push_n(const T* items, size_t n) {
+  sync* s = sync_.get();
+  const size_t capacity = s->ring_.size();
+  size_t done = 0;
+  while (done < n) {
+    const size_t tail = s->tail_.load(boost::memory_order_relaxed);
+    s->producer_.wait_until(
+        [s, tail, capacity]() {
+          return tail - s->head_.load(boost::memory_order_acquire) < capacity;
+        }, spin_count_, "");
+    const size_t space =
+        capacity - (tail - s->head_.load(boost::memory_order_acquire));
+    const size_t count = std::min(space, n - done);
+    for (size_t i = 0; i < count; ++i) {
+      s->ring_[(tail + i) % capacity] = items[done + i];
+    }
+    s->tail_.store(tail + count, boost::memory_order_release);
+    s->consumer_.notify();
+    done += count;
+  }
+}
+
+template<typename T>
+bool SPSCQueue<T>::try_pop(T* t) {
+  const size_t head = sync_->head_.load(boost::memory_order_relaxed);
+  if (head == sync_->tail_.load(boost::memory_order_acquire)) {
+    return false;
+  }
+  T& cell = sync_->ring_[head % sync_->ring_.size()];
+  *t = cell;
+  cell = T();
+  sync_->head_.store(head + 1, boost::memory_order_release);
+  sync_->producer_.notify();
+  return true;
+}
+
+template<typename T>
+T SPSCQueue<T>::pop(const string& log_on_wait) {
+  T t;
+  pop_n(&t, 1, log_on_wait);
+  return t;
+}
+
+template<typename T>
+void SPSCQueue<T>::pop_n(T* items, size_t n, const string& log_on_wait) {
+  sync* s = sync_.get();
+  const size_t capacity = s->ring_.size();
+  size_t done = 0;
+  while (done < n) {
+    const size_t head = s->head_.load(boost::memory_order_relaxed);
+    s->consumer_.wait_until(
+        [s, head]() {
+          return s->tail_.load(boost::memory_order_acquire) != head;
+        }, spin_count_, log_on_wait);
+    const size_t available = s->tail_.load(boost::memory_order_acquire) - head;
+    const size_t count = std::min(available, n - done);
+    for (size_t i = 0; i < count; ++i) {
+      T& cell = s->ring_[(head + i) % capacity];
+      items[done + i] = cell;
+      cell = T();
+    }
+    s->head_.store(head + count, boost::memory_order_release);
+    s->producer_.notify();
+    done += count;
+  }
+}
+
+template<typename T>
+bool SPSCQueue<T>::try_peek(T* t) {
+  const size_t head = sync_->head_.load(boost::memory_order_relaxed);
+  if (head == sync_->tail_.load(boost::memory_order_acquire)) {
+    return false;
+  }
+  *t = sync_->ring_[head % sync_->ring_.size()];
+  return true;
+}
+
+template<typename T>
+T SPSCQueue<T>::peek() {
+  sync* s = sync_.get();
+  const size_t head = s->head_.load(boost::memory_order_relaxed);
+  s->consumer_.wait_until(
+      [s, head]() {
+        return s->tail_.load(boost::memory_order_acquire) != head;
+      }, spin_count_, "");
+  return s->ring_[head % s->ring_.size()];
+}
+
+template<typename T>
+size_t SPSCQueue<T>::size() const {
+  return sync_->tail_.load(boost::memory_order_acquire)
+      - sync_->head_.load(boost::memory_order_acquire);
+}
+
+template<typename T>
+size_t SPSCQueue<T>::capacity() const {
+  return sync_->ring_.size();
+}
+
+template<typename T>
+class MPMCQueue<T>::sync {
+ public:
+  struct Cell {
+    boost::atomic<size_t> sequence;
+    T data;
+  };
+
+  explicit sync(size_t capacity)
+      : cells_(new Cell[capacity]), capacity_(capacity),
+        enqueue_pos_(0), dequeue_pos_(0) {
+    for (size_t i = 0; i < capacity; ++i) {
+      cells_[i].sequence.store(i, boost::memory_order_relaxed);
+    }
+  }
+
+  // Claims a free cell and stores t in it; false if the queue is full.
+  bool enqueue(const T& t) {
+    size_t pos = enqueue_pos_.load(boost::memory_order_relaxed);
+    for (;;) {
+      Cell* cell = &cells_[pos % capacity_];
+      const size_t seq = cell->sequence.load(boost::memory_order_acquire);
+      const ptrdiff_t diff =
+          static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+            boost::memory_order_relaxed)) {
+          cell->data = t;
+          cell->sequence.store(pos + 1, boost::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(boost::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Claims a filled cell and moves its value to t; false if empty.
+  bool dequeue(T* t) {
+    size_t pos = dequeue_pos_.load(boost::memory_order_relaxed);
+    for (;;) {
+      Cell* cell = &cells_[pos % capacity_];
+      const size_t seq = cell->sequence.load(boost::memory_order_acquire);
+      const ptrdiff_t diff =
+          static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+            boost::memory_order_relaxed)) {
+          *t = cell->data;
+          cell->data = T();
+          cell->sequence.store(pos + capacity_, boost::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(boost::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool empty() const {
+    const size_t pos = dequeue_pos_.load(boost::memory_order_relaxed);
+    return cells_[pos % capacity_].sequence.load(boost::memory_order_acquire)
+        != pos + 1;
+  }
+
+  bool full() const {
+    const size_t pos = enqueue_pos_.load(boost::memory_order_relaxed);
+    return cells_[pos % capacity_].sequence.load(boost::memory_order_acquire)
+        != pos;
+  }
+
+  boost::scoped_array<Cell> cells_;
+  const size_t capacity_;
+  boost::atomic<size_t> enqueue_pos_;
+  boost::atomic<size_t> dequeue_pos_;
+  QueueWaiters producers_;
+  QueueWaiters consumers_;
+};
+
+template<typename T>
+MPMCQueue<T>::MPMCQueue(size_t capacity, int spin_count)
+    : sync_(new sync(capacity)), spin_count_(spin_count) {
+  CHECK_GT(capacity, 0) << "Queue capacity must be positive";
+}
+
+template<typename T>
+bool MPMCQueue<T>::try_push(const T& t) {
+  if (!sync_->enqueue(t)) {
+    return false;
+  }
+  sync_->consumers_.notify();
+  return true;
+}
+
+template<typename T>
+void MPMCQueue<T>::push(const T& t) {
+  push_n(&t, 1);
+}
+
+template<typename T>
+void MPMCQueue<T>::push_n(const T* items, size_t n) {
+  sync* s = sync_.get();
+  size_t done = 0;
+  while (done < n) {
+    s->producers_.wait_until([s]() { return !s->full(); }, spin_count_, "");
+    size_t pushed = 0;
+    while (done < n && s->enqueue(items[done])) {
+      ++done;
+      ++pushed;
+    }
+    if (pushed > 0) {
+      s->consumers_.notify();
+    }
+  }
+}
+
+template<typename T>
+bool MPMCQueue<T>::try_pop(T* t) {
+  if (!sync_->dequeue(t)) {
+    return false;
+  }
+  sync_->producers_.notify();
+  return true;
+}
+
+template<typename T>
+T MPMCQueue<T>::pop(const string& log_on_wait) {
+  T t;
+  pop_n(&t, 1, log_on_wait);
+  return t;
+}
+
+template<typename T>
+void MPMCQueue<T>::pop_n(T* items, size_t n, const string& log_on_wait) {
+  sync* s = sync_.get();
+  size_t done = 0;
+  while (done < n) {
+    s->consumers_.wait_until([s]() { return !s->empty(); }, spin_count_,
+        log_on_wait);
+    size_t popped = 0;
+    while (done < n && s->dequeue(&items[done])) {
+      ++done;
+      ++popped;
+    }
+    if (popped > 0) {
+      s->producers_.notify();
+    }
+  }
+}
+
+template<typename T>
+size_t MPMCQueue<T>::size() const {
+  const size_t enqueued = sync_->enqueue_pos_.load(boost::memory_order_acquire);
+  const size_t dequeued = sync_->dequeue_pos_.load(boost::memory_order_acquire);
+  return enqueued > dequeued ? enqueued - dequeued : 0;
+}
+
+template<typename T>
+size_t MPMCQueue<T>::capacity() const {
+  return sync_->capacity_;
+}
+
+template class SPSCQueue<int>;
+template class SPSCQueue<std::string*>;
+template class MPMCQueue<int>;
+template class MPMCQueue<Batch<float>*>;
+template class MPMCQueue<Batch<double>*>;
+
+}  // namespace caffe
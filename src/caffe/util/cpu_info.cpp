@@ -36,6 +36,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <glog/logging.h>
+#ifdef USE_OMPT
+#include <boost/atomic.hpp>
+#include <omp-tools.h>
+#include <time.h>
+#endif
 
 #include <fstream>
 #include <set>
@@ -187,6 +192,10 @@ unsigned Collection::getProcessorSpeedMHz() {
   return processors.size() ? processors[0].speedMHz : 0;
 }
 
+const char *Collection::getProcessorModelName() {
+  return processors.size() ? processors[0].modelName.c_str() : "";
+}
+
 unsigned Collection::getTotalNumberOfSockets() {
   return totalNumberOfSockets;
 }
@@ -246,6 +255,7 @@ void Collection::parseValue(const char *fieldName, const char *valueString) {
   }
 
   if (beginsWith(fieldName, "model name")) {
+    currentProcessor->modelName = valueString;
     currentProcessor->speedMHz = extractSpeedFromModelName(valueString);
   }
 }
@@ -377,6 +387,16 @@ bool OpenMpManager::isMajorThread(boost::thread::id currentThread) {
 void OpenMpManager::bindCurrentThreadToNonPrimaryCoreIfPossible() {
   OpenMpManager &openMpManager = getInstance();
   if (openMpManager.isThreadsBindAllowed()) {
+    // OpenMP threads are bound to the first CPU of every core; when cores
+    // have more CPUs, keep helper threads like the data prefetchers on
+    // those so they never preempt a compute thread
+    cpu_set_t spareCpuSet;
+    CPU_XOR(&spareCpuSet, &openMpManager.currentCpuSet,
+      &openMpManager.currentCoreSet);
+    if (CPU_COUNT(&spareCpuSet) > 0) {
+      sched_setaffinity(0, sizeof(spareCpuSet), &spareCpuSet);
+      return;
+    }
     int totalNumberOfAvailableCores = CPU_COUNT(&openMpManager.currentCoreSet);
     int logicalCoreToBindTo = totalNumberOfAvailableCores > 1 ? 1 : 0;
     openMpManager.bindCurrentThreadToLogicalCoreCpus(logicalCoreToBindTo);
@@ -535,5 +555,90 @@ unsigned OpenMpManager::getProcessorSpeedMHz() {
 
 #endif  // _OPENMP
 
+int limitOpenMpThreads(int numThreads) {
+#ifdef _OPENMP
+  const int maxThreads = omp_get_max_threads();
+  if (numThreads > 0 && numThreads < maxThreads && !omp_in_parallel()) {
+    omp_set_num_threads(numThreads);
+    return maxThreads;
+  }
+#endif
+  return 0;
+}
+
+void restoreOpenMpThreads(int numThreads) {
+#ifdef _OPENMP
+  if (numThreads > 0) {
+    omp_set_num_threads(numThreads);
+  }
+#endif
+}
+
+#ifdef USE_OMPT
+
+static bool isBarrierWaitMeasured = false;
+static boost::atomic<int64_t> barrierWaitNs(0);
+static __thread int64_t barrierWaitBeginNs;
+
+static int64_t getMonotonicNs() {
+  timespec currentTime;
+  clock_gettime(CLOCK_MONOTONIC, &currentTime);
+  return static_cast<int64_t>(currentTime.tv_sec) * 1000000000 +
+    currentTime.tv_nsec;
+}
+
+static void onSyncRegionWait(ompt_sync_region_t kind,
+    ompt_scope_endpoint_t endpoint, ompt_data_t *parallelData,
+    ompt_data_t *taskData, const void *codePtr) {
+  if (kind == ompt_sync_region_taskwait ||
+      kind == ompt_sync_region_taskgroup ||
+      kind == ompt_sync_region_reduction) {
+    return;
+  }
+  if (endpoint == ompt_scope_begin) {
+    barrierWaitBeginNs = getMonotonicNs();
+  } else {
+    barrierWaitNs += getMonotonicNs() - barrierWaitBeginNs;
+  }
+}
+
+static int initializeOmptTool(ompt_function_lookup_t lookup,
+    int initialDeviceNum, ompt_data_t *toolData) {
+  ompt_set_callback_t setCallback =
+    reinterpret_cast<ompt_set_callback_t>(lookup("ompt_set_callback"));
+  isBarrierWaitMeasured = setCallback &&
+    setCallback(ompt_callback_sync_region_wait,
+      reinterpret_cast<ompt_callback_t>(&onSyncRegionWait)) ==
+    ompt_set_always;
+  return 1;
+}
+
+static void finalizeOmptTool(ompt_data_t *toolData) {
+}
+
+#endif  // USE_OMPT
+
+int64_t getOpenMpBarrierWaitNs() {
+#ifdef USE_OMPT
+  if (isBarrierWaitMeasured) {
+    return barrierWaitNs;
+  }
+#endif
+  return -1;
+}
+
 }  // namespace cpu
 }  // namespace caffe
+
+#ifdef USE_OMPT
+
+// Called by OMPT capable OpenMP runtimes when they start up
+extern "C" ompt_start_tool_result_t *ompt_start_tool(
+    unsigned int ompVersion, const char *runtimeVersion) {
+  static ompt_start_tool_result_t result = {
+    &caffe::cpu::initializeOmptTool, &caffe::cpu::finalizeOmptTool, {0}
+  };
+  return &result;
+}
+
+#endif  // USE_OMPT
@@ -0,0 +1,315 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef USE_OPENCV
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "caffe/util/decoded_image_cache.hpp"
+
+namespace caffe {
+
+namespace {
+
+const char kCacheMagic[8] = {'C', 'A', 'F', 'F', 'E', 'I', 'M', 'G'};
+const uint32_t kCacheVersion = 2;
+// Used to size the slot table: about two slots per image of this size.
+const size_t kAssumedImageBytes = 64 << 10;
+// Lookups and inserts give up after this many occupied slots.
+const uint32_t kMaxProbes = 64;
+const size_t kDataAlignment = 64;
+// Copying one image takes far less; a slot written for longer belongs to a
+// writer that died, and the next insert of the same id takes it over.
+const int64_t kStaleWriteSeconds = 60;
+
+// The low bits of Slot::state. The rest holds the time the write started
+// while kSlotWriting, and the entry's offset once kSlotReady.
+enum SlotState { kSlotEmpty = 0, kSlotWriting, kSlotReady, kSlotDead };
+const int kSlotStateBits = 2;
+
+inline uint64_t SlotWord(uint64_t value, SlotState state) {
+  return (value << kSlotStateBits) | state;
+}
+
+inline SlotState WordState(uint64_t word) {
+  return static_cast<SlotState>(word & ((1 << kSlotStateBits) - 1));
+}
+
+inline uint64_t WordValue(uint64_t word) {
+  return word >> kSlotStateBits;
+}
+
+// A second hash of the image id, independent of Hash, which tells apart ids
+// that share a slot id.
+uint64_t CheckHash(const string& bytes) {
+  uint64_t hash = 0x9e3779b97f4a7c15ULL ^ bytes.size();
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    hash = (hash ^ static_cast<unsigned char>(bytes[i])) *
+        0xff51afd7ed558ccdULL;
+    hash ^= hash >> 29;
+  }
+  return hash;
+}
+
+}  // namespace
+
+struct DecodedImageCache::Header {
+  char magic[8];
+  uint32_t version;
+  // Power of two.
+  uint32_t num_slots;
+  uint64_t data_offset;
+  uint64_t data_size;
+  // Bump allocator for the data area, advanced atomically.
+  uint64_t data_used;
+  char key[256];
+};
+
+struct DecodedImageCache::Slot {
+  // Hash of the image id; 0 marks a free slot.
+  uint64_t id;
+  // SlotState and its value, replaced atomically: an image is published by
+  // a single compare-and-swap from the writer's kSlotWriting word.
+  uint64_t state;
+};
+
+// Precedes the pixels of every image in the data area.
+struct DecodedImageCache::Entry {
+  uint64_t check;
+  int32_t rows;
+  int32_t cols;
+  int32_t type;
+  char padding[kDataAlignment - 20];
+};
+
+uint64_t DecodedImageCache::Hash(const string& bytes) {
+  // 64-bit FNV-1a: stable across processes and builds.
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    hash ^= static_cast<unsigned char>(bytes[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash ? hash : 1;
+}
+
+DecodedImageCache::DecodedImageCache(const string& dir, const string& key,
+    size_t size_mb)
+    : fd_(-1), map_(NULL), map_size_(size_mb << 20) {
+  CHECK_GT(size_mb, 0) << "Decoded image cache size must be positive";
+  std::ostringstream name;
+  name << dir << "/" << std::hex << std::setw(16) << std::setfill('0')
+       << Hash(key) << ".imgcache";
+  filename_ = name.str();
+
+  fd_ = open(filename_.c_str(), O_RDWR | O_CREAT, 0644);
+  CHECK_GE(fd_, 0) << "Failed to open decoded image cache " << filename_
+                   << ": " << strerror(errno);
+  // Serializes the creation of the file between processes.
+  CHECK_EQ(flock(fd_, LOCK_EX), 0) << "Failed to lock " << filename_;
+  struct stat st;
+  CHECK_EQ(fstat(fd_, &st), 0) << "Failed to stat " << filename_;
+  const bool create = (st.st_size == 0);
+  if (create) {
+    CHECK_EQ(ftruncate(fd_, map_size_), 0)
+        << "Failed to size " << filename_ << ": " << strerror(errno);
+  } else {
+    map_size_ = st.st_size;
+  }
+  void* map = mmap(NULL, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+      0);
+  CHECK(map != MAP_FAILED) << "Failed to map " << filename_ << ": "
+                           << strerror(errno);
+  map_ = static_cast<char*>(map);
+
+  Header* header = reinterpret_cast<Header*>(map_);
+  if (create) {
+    uint32_t num_slots = 1024;
+    while (num_slots < 2 * (map_size_ / kAssumedImageBytes)) {
+      num_slots *= 2;
+    }
+    const size_t table_end = sizeof(Header) + num_slots * sizeof(Slot);
+    header->version = kCacheVersion;
+    header->num_slots = num_slots;
+    header->data_offset = (table_end + 4095) / 4096 * 4096;
+    CHECK_LT(header->data_offset, map_size_)
+        << "Decoded image cache of " << size_mb << " MB is too small";
+    header->data_size = map_size_ - header->data_offset;
+    header->data_used = 0;
+    strncpy(header->key, key.c_str(), sizeof(header->key) - 1);
+    // The slot table is zero-filled by ftruncate. Mark the file valid last.
+    memcpy(header->magic, kCacheMagic, sizeof(kCacheMagic));
+  } else {
+    CHECK(memcmp(header->magic, kCacheMagic, sizeof(kCacheMagic)) == 0 &&
+        header->version == kCacheVersion)
+        << filename_ << " is not a decoded image cache of this version; "
+        << "remove it to rebuild the cache";
+    CHECK_EQ(strncmp(header->key, key.c_str(), sizeof(header->key) - 1), 0)
+        << filename_ << " caches different images (" << header->key << ")";
+  }
+  flock(fd_, LOCK_UN);
+  LOG(INFO) << (create ? "Created" : "Opened") << " decoded image cache "
+            << filename_ << " (" << (map_size_ >> 20) << " MB)";
+}
+
+DecodedImageCache::~DecodedImageCache() {
+  if (map_) {
+    munmap(map_, map_size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+DecodedImageCache::Slot* DecodedImageCache::slots() const {
+  return reinterpret_cast<Slot*>(map_ + sizeof(Header));
+}
+
+cv::Mat DecodedImageCache::Find(const string& id) const {
+  const Header* header = reinterpret_cast<const Header*>(map_);
+  const uint64_t hash = Hash(id);
+  const uint32_t mask = header->num_slots - 1;
+  const uint32_t probes = std::min(kMaxProbes, header->num_slots);
+  Slot* table = slots();
+  for (uint32_t i = 0; i < probes; ++i) {
+    Slot* slot = &table[(hash + i) & mask];
+    const uint64_t slot_id = __atomic_load_n(&slot->id, __ATOMIC_ACQUIRE);
+    if (slot_id == 0) {
+      break;
+    }
+    if (slot_id != hash) {
+      continue;
+    }
+    const uint64_t word = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+    if (WordState(word) != kSlotReady) {
+      continue;
+    }
+    char* data = map_ + header->data_offset + WordValue(word);
+    const Entry* entry = reinterpret_cast<const Entry*>(data);
+    if (entry->check == CheckHash(id)) {
+      return cv::Mat(entry->rows, entry->cols, entry->type,
+          data + sizeof(Entry));
+    }
+  }
+  return cv::Mat();
+}
+
+void DecodedImageCache::Insert(const string& id, const cv::Mat& img) {
+  if (!img.data) {
+    return;
+  }
+  CHECK_EQ(img.depth(), CV_8U) << "Only 8-bit images can be cached";
+  const cv::Mat pixels = img.isContinuous() ? img : img.clone();
+  const uint64_t bytes = pixels.total() * pixels.elemSize();
+  Header* header = reinterpret_cast<Header*>(map_);
+  const uint64_t hash = Hash(id);
+  const uint64_t check = CheckHash(id);
+  const uint32_t mask = header->num_slots - 1;
+  const uint32_t probes = std::min(kMaxProbes, header->num_slots);
+  const int64_t now = time(NULL);
+  const uint64_t writing = SlotWord(now, kSlotWriting);
+  Slot* table = slots();
+  for (uint32_t i = 0; i < probes; ++i) {
+    Slot* slot = &table[(hash + i) & mask];
+    uint64_t expected = 0;
+    if (__atomic_compare_exchange_n(&slot->id, &expected, hash, false,
+        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      __atomic_store_n(&slot->state, writing, __ATOMIC_RELEASE);
+    } else if (expected != hash) {
+      continue;
+    } else {
+      uint64_t word = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+      if (WordState(word) == kSlotReady) {
+        const Entry* entry = reinterpret_cast<const Entry*>(
+            map_ + header->data_offset + WordValue(word));
+        if (entry->check == check) {
+          return;
+        }
+        // Another id with the same hash
+        continue;
+      }
+      if (WordState(word) != kSlotWriting ||
+          now - static_cast<int64_t>(WordValue(word)) < kStaleWriteSeconds ||
+          !__atomic_compare_exchange_n(&slot->state, &word, writing, false,
+              __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // Being cached by another thread or process, not claimed yet, or
+        // given up on because the file is full.
+        return;
+      }
+      LOG(INFO) << "Taking over an image in " << filename_
+                << " whose writer stopped";
+    }
+    const uint64_t size = (sizeof(Entry) + bytes + kDataAlignment - 1) /
+        kDataAlignment * kDataAlignment;
+    const uint64_t offset =
+        __atomic_fetch_add(&header->data_used, size, __ATOMIC_RELAXED);
+    uint64_t word = writing;
+    if (offset + size > header->data_size) {
+      __atomic_compare_exchange_n(&slot->state, &word,
+          SlotWord(0, kSlotDead), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+      LOG_FIRST_N(INFO, 1) << "Decoded image cache " << filename_
+                           << " is full";
+      return;
+    }
+    char* data = map_ + header->data_offset + offset;
+    Entry* entry = reinterpret_cast<Entry*>(data);
+    entry->check = check;
+    entry->rows = pixels.rows;
+    entry->cols = pixels.cols;
+    entry->type = pixels.type();
+    memcpy(data + sizeof(Entry), pixels.data, bytes);
+    // Fails only if this write took so long that another insert took over
+    __atomic_compare_exchange_n(&slot->state, &word,
+        SlotWord(offset, kSlotReady), false, __ATOMIC_ACQ_REL,
+        __ATOMIC_ACQUIRE);
+    return;
+  }
+}
+
+}  // namespace caffe
+#endif  // USE_OPENCV
@@ -0,0 +1,238 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string.h>
+#include <algorithm>
+#if defined(__F16C__) || defined(__AVX2__) || defined(__AVX512BF16__)
+#include <immintrin.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "caffe/util/half_math.hpp"
+
+namespace caffe {
+
+// Values converted per task; a chunk of each buffer stays in L2.
+static const size_t kHalfChunkSize = 16384;
+
+static inline uint32_t float_bits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static inline float bits_float(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static inline uint16_t fp16_from_float(float value) {
+  uint32_t x = float_bits(value);
+  const uint16_t sign = (x >> 16) & 0x8000;
+  x &= 0x7fffffff;
+  if (x >= 0x7f800000) {  // infinity, or NaN kept quiet
+    return sign | 0x7c00 | (x > 0x7f800000 ? 0x200 : 0);
+  }
+  if (x >= 0x477ff000) {  // rounds past 65504
+    return sign | 0x7c00;
+  }
+  if (x < 0x38800000) {  // below 2^-14, a subnormal half
+    if (x < 0x33000000) {  // at most 2^-25, which ties to 0
+      return sign;
+    }
+    const uint32_t mantissa = (x & 0x7fffff) | 0x800000;
+    const int shift = 126 - static_cast<int>(x >> 23);
+    uint32_t result = mantissa >> shift;
+    const uint32_t rest = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (result & 1))) {
+      ++result;
+    }
+    return sign | result;
+  }
+  // Rebias the exponent from 127 to 15; a carry out of the mantissa when
+  // rounding correctly increments the exponent.
+  x -= 112u << 23;
+  return sign | ((x + 0xfff + ((x >> 13) & 1)) >> 13);
+}
+
+static inline float float_from_fp16(uint16_t h) {
+  const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+  uint32_t exponent = (h >> 10) & 0x1f;
+  uint32_t mantissa = h & 0x3ff;
+  if (exponent == 0x1f) {
+    return bits_float(sign | 0x7f800000 | (mantissa << 13));
+  }
+  if (exponent == 0) {
+    if (mantissa == 0) {
+      return bits_float(sign);
+    }
+    // Normalize the subnormal
+    exponent = 113;
+    while (!(mantissa & 0x400)) {
+      mantissa <<= 1;
+      --exponent;
+    }
+    return bits_float(sign | (exponent << 23) | ((mantissa & 0x3ff) << 13));
+  }
+  return bits_float(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+static inline uint16_t bf16_from_float(float value) {
+  const uint32_t x = float_bits(value);
+  if ((x & 0x7fffffff) > 0x7f800000) {  // NaN, kept quiet
+    return (x >> 16) | 0x40;
+  }
+  return (x + 0x7fff + ((x >> 16) & 1)) >> 16;
+}
+
+static inline float float_from_bf16(uint16_t h) {
+  return bits_float(static_cast<uint32_t>(h) << 16);
+}
+
+static void to_half(const size_t n, const float* x, HalfFormat format,
+    uint16_t* y) {
+  size_t i = 0;
+  if (format == FLOAT16) {
+#ifdef __F16C__
+    for (; i + 8 <= n; i += 8) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i), _mm256_cvtps_ph(
+          _mm256_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+#endif
+    for (; i < n; ++i) {
+      y[i] = fp16_from_float(x[i]);
+    }
+  } else {
+#ifdef __AVX512BF16__
+    // Flushes subnormal values to 0, unlike the scalar code
+    for (; i + 16 <= n; i += 16) {
+      const __m256bh h = _mm512_cvtneps_pbh(_mm512_loadu_ps(x + i));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i),
+          reinterpret_cast<const __m256i&>(h));
+    }
+#endif
+    for (; i < n; ++i) {
+      y[i] = bf16_from_float(x[i]);
+    }
+  }
+}
+
+static void to_half(const size_t n, const double* x, HalfFormat format,
+    uint16_t* y) {
+  for (size_t i = 0; i < n; ++i) {
+    const float value = static_cast<float>(x[i]);
+    y[i] = format == FLOAT16 ? fp16_from_float(value) : bf16_from_float(value);
+  }
+}
+
+static void from_half(const size_t n, const uint16_t* x, HalfFormat format,
+    float* y) {
+  size_t i = 0;
+  if (format == FLOAT16) {
+#ifdef __F16C__
+    for (; i + 8 <= n; i += 8) {
+      _mm256_storeu_ps(y + i, _mm256_cvtph_ps(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i))));
+    }
+#endif
+    for (; i < n; ++i) {
+      y[i] = float_from_fp16(x[i]);
+    }
+  } else {
+#ifdef __AVX2__
+    for (; i + 8 <= n; i += 8) {
+      const __m256i h = _mm256_cvtepu16_epi32(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+      _mm256_storeu_ps(y + i,
+          _mm256_castsi256_ps(_mm256_slli_epi32(h, 16)));
+    }
+#endif
+    for (; i < n; ++i) {
+      y[i] = float_from_bf16(x[i]);
+    }
+  }
+}
+
+static void from_half(const size_t n, const uint16_t* x, HalfFormat format,
+    double* y) {
+  for (size_t i = 0; i < n; ++i) {
+    y[i] = format == FLOAT16 ? float_from_fp16(x[i]) : float_from_bf16(x[i]);
+  }
+}
+
+template <typename Dtype>
+void caffe_cpu_to_half(const size_t n, const Dtype* x, HalfFormat format,
+    uint16_t* y) {
+  const long num_chunks = (n + kHalfChunkSize - 1) / kHalfChunkSize;
+#ifdef _OPENMP
+  #pragma omp parallel for if(num_chunks > 1 && !omp_in_parallel())
+#endif
+  for (long c = 0; c < num_chunks; ++c) {
+    const size_t begin = c * kHalfChunkSize;
+    const size_t size = std::min(kHalfChunkSize, n - begin);
+    to_half(size, x + begin, format, y + begin);
+  }
+}
+
+template <typename Dtype>
+void caffe_cpu_from_half(const size_t n, const uint16_t* x, HalfFormat format,
+    Dtype* y) {
+  const long num_chunks = (n + kHalfChunkSize - 1) / kHalfChunkSize;
+#ifdef _OPENMP
+  #pragma omp parallel for if(num_chunks > 1 && !omp_in_parallel())
+#endif
+  for (long c = 0; c < num_chunks; ++c) {
+    const size_t begin = c * kHalfChunkSize;
+    const size_t size = std::min(kHalfChunkSize, n - begin);
+    from_half(size, x + begin, format, y + begin);
+  }
+}
+
+template void caffe_cpu_to_half<float>(const size_t n, const float* x,
+    HalfFormat format, uint16_t* y);
+template void caffe_cpu_to_half<double>(const size_t n, const double* x,
+    HalfFormat format, uint16_t* y);
+template void caffe_cpu_from_half<float>(const size_t n, const uint16_t* x,
+    HalfFormat format, float* y);
+template void caffe_cpu_from_half<double>(const size_t n, const uint16_t* x,
+    HalfFormat format, double* y);
+
+}  // namespace caffe
@@ -0,0 +1,288 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef USE_MKL
+#include <mkl_service.h>
+#endif
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "caffe/util/host_allocator.hpp"
+
+namespace caffe {
+
+// Every block starts with a header of kHeaderBytes, which keeps the data
+// behind it 64-byte aligned.
+struct HostAllocator::BlockHeader {
+  uint64_t magic;
+  size_t size;  // size class, without the header
+  int node;     // free list the block returns to
+  bool touched;
+};
+
+static const size_t kHeaderBytes = 64;
+static const uint64_t kBlockMagic = 0xcaffe0a110c0b10cULL;
+static const size_t kPageBytes = 4096;
+// Blocks from this size on are first touched by all threads and cached in
+// the list of kSpreadNode rather than in a per-node one.
+static const size_t kParallelTouchBytes = 1 << 20;
+static const int kSpreadNode = -1;
+// Pages per thread whose placement is checked after a parallel first touch.
+static const int kSampledPages = 16;
+
+HostAllocator& HostAllocator::Get() {
+  // Never destroyed, so that blocks freed by static objects at exit still
+  // find the allocator.
+  static HostAllocator* allocator = new HostAllocator();
+  return *allocator;
+}
+
+HostAllocator::HostAllocator() {
+  memset(&stats_, 0, sizeof(stats_));  // NOLINT(caffe/alt_fn)
+  size_t pool_mb = 1024;
+  const char* env = getenv("CAFFE_HOST_POOL_MB");
+  if (env) {
+    pool_mb = strtoul(env, NULL, 10);
+  }
+  max_cached_bytes_ = pool_mb << 20;
+}
+
+size_t HostAllocator::SizeClass(size_t size) {
+  if (size <= 1024) {
+    return std::max<size_t>(64, (size + 63) & ~static_cast<size_t>(63));
+  }
+  int shift = 10;
+  while ((static_cast<size_t>(2) << shift) <= size) {
+    ++shift;
+  }
+  const size_t step = static_cast<size_t>(1) << (shift - 2);
+  return (size + step - 1) / step * step;
+}
+
+int HostAllocator::CurrentNode() {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned cpu, node;
+  if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) {
+    return node;
+  }
+#endif
+  return 0;
+}
+
+void* HostAllocator::RawAllocate(size_t size) {
+#ifdef USE_MKL
+  void* ptr = mkl_malloc(size, 64);
+#else
+  void* ptr = NULL;
+  if (posix_memalign(&ptr, 64, size)) {
+    ptr = NULL;
+  }
+#endif
+  CHECK(ptr) << "host allocation of size " << size << " failed";
+  return ptr;
+}
+
+void HostAllocator::RawFree(void* ptr) {
+#ifdef USE_MKL
+  mkl_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+
+void* HostAllocator::Allocate(size_t size) {
+  const size_t size_class = SizeClass(size);
+  const FreeListKey key(
+      size_class >= kParallelTouchBytes ? kSpreadNode : CurrentNode(),
+      size_class);
+  BlockHeader* header = NULL;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    ++stats_.allocations;
+    stats_.bytes_in_use += size_class;
+    stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.bytes_in_use);
+    std::map<FreeListKey, std::vector<BlockHeader*> >::iterator it =
+        free_lists_.find(key);
+    if (it != free_lists_.end() && !it->second.empty()) {
+      header = it->second.back();
+      it->second.pop_back();
+      stats_.bytes_cached -= size_class;
+      ++stats_.pool_hits;
+    }
+  }
+  if (!header) {
+    header = static_cast<BlockHeader*>(RawAllocate(kHeaderBytes + size_class));
+    header->magic = kBlockMagic;
+    header->size = size_class;
+    header->node = key.first;
+    header->touched = false;
+  }
+  return reinterpret_cast<char*>(header) + kHeaderBytes;
+}
+
+void HostAllocator::Free(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  BlockHeader* header = reinterpret_cast<BlockHeader*>(
+      static_cast<char*>(ptr) - kHeaderBytes);
+  CHECK_EQ(header->magic, kBlockMagic) << "Freeing a foreign host pointer";
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    stats_.bytes_in_use -= header->size;
+    if (stats_.bytes_cached + header->size <= max_cached_bytes_) {
+      free_lists_[FreeListKey(header->node, header->size)].push_back(header);
+      stats_.bytes_cached += header->size;
+      return;
+    }
+  }
+  RawFree(header);
+}
+
+void HostAllocator::Zero(void* ptr, size_t size) {
+  BlockHeader* header = reinterpret_cast<BlockHeader*>(
+      static_cast<char*>(ptr) - kHeaderBytes);
+  CHECK_EQ(header->magic, kBlockMagic);
+  char* data = static_cast<char*>(ptr);
+#ifdef _OPENMP
+  if (size >= kParallelTouchBytes && omp_get_max_threads() > 1 &&
+      !omp_in_parallel()) {
+    const bool sample = !header->touched;
+    uint64_t local_pages = 0;
+    uint64_t remote_pages = 0;
+    #pragma omp parallel reduction(+:local_pages, remote_pages)
+    {
+      const size_t nthreads = omp_get_num_threads();
+      const size_t tid = omp_get_thread_num();
+      const size_t begin = size * tid / nthreads;
+      const size_t end = size * (tid + 1) / nthreads;
+      memset(data + begin, 0, end - begin);  // NOLINT(caffe/alt_fn)
+#if defined(__linux__) && defined(SYS_move_pages)
+      const size_t pages = (end - begin) / kPageBytes;
+      if (sample && pages) {
+        const int count = std::min<size_t>(kSampledPages, pages);
+        void* addresses[kSampledPages];
+        int status[kSampledPages];
+        for (int i = 0; i < count; ++i) {
+          const uintptr_t address = reinterpret_cast<uintptr_t>(data + begin) +
+              (end - begin) / count * i;
+          addresses[i] = reinterpret_cast<void*>(
+              address & ~static_cast<uintptr_t>(kPageBytes - 1));
+        }
+        // With no target nodes, move_pages only reports where pages are.
+        if (syscall(SYS_move_pages, 0, count, addresses, NULL, status, 0)
+            == 0) {
+          const int node = CurrentNode();
+          for (int i = 0; i < count; ++i) {
+            if (status[i] == node) {
+              ++local_pages;
+            } else if (status[i] >= 0) {
+              ++remote_pages;
+            }
+          }
+        }
+      }
+#endif
+    }
+    header->touched = true;
+    if (sample) {
+      boost::mutex::scoped_lock lock(mutex_);
+      stats_.local_pages += local_pages;
+      stats_.remote_pages += remote_pages;
+    }
+    return;
+  }
+#endif
+  memset(data, 0, size);  // NOLINT(caffe/alt_fn)
+  header->touched = true;
+}
+
+void HostAllocator::Discard(void* ptr, size_t size) {
+#ifdef __linux__
+  const uintptr_t page_mask = kPageBytes - 1;
+  const uintptr_t begin =
+      (reinterpret_cast<uintptr_t>(ptr) + page_mask) & ~page_mask;
+  const uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + size) & ~page_mask;
+  if (end > begin) {
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+  }
+#endif
+}
+
+void HostAllocator::Trim() {
+  std::map<FreeListKey, std::vector<BlockHeader*> > free_lists;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    free_lists.swap(free_lists_);
+    stats_.bytes_cached = 0;
+  }
+  for (std::map<FreeListKey, std::vector<BlockHeader*> >::iterator it =
+       free_lists.begin(); it != free_lists.end(); ++it) {
+    for (size_t i = 0; i < it->second.size(); ++i) {
+      RawFree(it->second[i]);
+    }
+  }
+}
+
+HostAllocatorStats HostAllocator::stats() {
+  boost::mutex::scoped_lock lock(mutex_);
+  return stats_;
+}
+
+void HostAllocator::LogStats() {
+  const HostAllocatorStats s = stats();
+  LOG(INFO) << "Host allocator: " << s.allocations << " allocations ("
+            << s.pool_hits << " from cache), peak " << (s.peak_bytes >> 20)
+            << " MB, in use " << (s.bytes_in_use >> 20) << " MB, cached "
+            << (s.bytes_cached >> 20) << " MB, sampled pages "
+            << s.local_pages << " local / " << s.remote_pages << " remote";
+}
+
+}  // namespace caffe
@@ -198,6 +198,14 @@ template void im3d2col_cpu<double>(const double* data_im, const int channels,
     const int stride_d, const int stride_h, const int stride_w,
     const int dilation_d, const int dilation_h, const int dilation_w,
     double* data_col);
+// u8 activations for the quantized 3D convolution path
+template void im3d2col_cpu<uint8_t>(const uint8_t* data_im, const int channels,
+    const int depth, const int height, const int width,
+    const int kernel_d, const int kernel_h, const int kernel_w,
+    const int pad_d, const int pad_h, const int pad_w,
+    const int stride_d, const int stride_h, const int stride_w,
+    const int dilation_d, const int dilation_h, const int dilation_w,
+    uint8_t* data_col);
 
 template <typename Dtype>
 inline void im2col_nd_core_cpu(const Dtype* data_input, const bool im2col,
@@ -51,6 +51,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 #endif  // USE_OPENCV
 
+#include <boost/thread.hpp>
+
 #include <algorithm>
 #include <numeric>
 #include <vector>
@@ -649,7 +651,7 @@ void RandomSaturation(const cv::Mat& in_img, cv::Mat* out_img,
 
 void AdjustSaturation(const cv::Mat& in_img, const float delta,
                       cv::Mat* out_img) {
-  if (fabs(delta - 1.f) != 1e-3) {
+  if (fabs(delta - 1.f) > 1e-3) {
     // Convert to HSV colorspae.
     cv::cvtColor(in_img, *out_img, CV_BGR2HSV);
 
@@ -720,7 +722,8 @@ void RandomOrderChannels(const cv::Mat& in_img, cv::Mat* out_img,
   }
 }
 
-cv::Mat ApplyDistort(const cv::Mat& in_img, const DistortionParameter& param) {
+cv::Mat ApplyDistortChain(const cv::Mat& in_img,
+                          const DistortionParameter& param) {
   cv::Mat out_img = in_img;
   float prob;
   caffe_rng_uniform(1, 0.f, 1.f, &prob);
@@ -765,6 +768,182 @@ cv::Mat ApplyDistort(const cv::Mat& in_img, const DistortionParameter& param) {
 
   return out_img;
 }
+
+// Draws a distortion the way the Random* functions above do: returns true
+// and the drawn delta with probability prob.
+static bool DrawDistortion(const float prob, const float lower,
+                           const float upper, const char* name,
+                           float* delta) {
+  float p;
+  caffe_rng_uniform(1, 0.f, 1.f, &p);
+  if (p >= prob) {
+    return false;
+  }
+  CHECK_GE(upper, lower) << name << " range must not be empty.";
+  caffe_rng_uniform(1, lower, upper, delta);
+  return true;
+}
+
+// Folds out = saturate(round(alpha * in + beta)), i.e. what
+// cv::Mat::convertTo does for 8-bit data, into a lookup table.
+static void ComposeAffineLut(const float alpha, const float beta, uchar* lut) {
+  for (int i = 0; i < 256; ++i) {
+    lut[i] = cv::saturate_cast<uchar>(alpha * lut[i] + beta);
+  }
+}
+
+// Scales the saturation and shifts the hue of n pixels held as planar
+// floats with values in [0, 255]. The pixels go through the 8-bit HSV
+// image (H in [0, 180), S and V in [0, 255]) computed exactly as
+// cv::cvtColor does, so the result matches the AdjustSaturation and
+// AdjustHue chain up to its extra rounding. Branch-free, so that the loop
+// vectorizes.
+static void AdjustSaturationHue(const int n, const float saturation,
+                                const float hue, float* b, float* g,
+                                float* r) {
+#ifdef _OPENMP
+  #pragma omp simd
+#endif
+  for (int i = 0; i < n; ++i) {
+    const int bi = b[i], gi = g[i], ri = r[i];
+    const int v = std::max(bi, std::max(gi, ri));
+    const int diff = v - std::min(bi, std::min(gi, ri));
+    // OpenCV's fixed-point reciprocals (255 << 12) / v and
+    // (180 << 12) / (6 * diff), which float division rounds to exactly.
+    const int sdiv = rintf(1044480.f / std::max(v, 1));
+    const int hdiv = rintf(122880.f / std::max(diff, 1));
+    const int s = (diff * sdiv + (1 << 11)) >> 12;
+    const int vr = -(v == ri), vg = -(v == gi);
+    const int num = (vr & (gi - bi)) + (~vr & ((vg & (bi - ri + 2 * diff)) +
+        (~vg & (ri - gi + 4 * diff))));
+    int h = (num * hdiv + (1 << 11)) >> 12;
+    h += (h >> 31) & 180;
+
+    const int sa = std::min(static_cast<int>(rintf(s * saturation)), 255);
+    int hu = std::min(std::max(static_cast<int>(rintf(h + hue)), 0), 255);
+    hu -= 180 & -(hu >= 180);
+
+    // Back to BGR: channel n is v * (1 - s * clamp(min(k, 4 - k), 0, 1))
+    // with k = (n + h / 30) mod 6 and n = 1, 3, 5 for b, g, r, evaluated in
+    // units of h (k * 30) so that all selects stay integer.
+    const float vs = v * sa * (1.f / (255 * 30));
+    int k = 30 + hu;
+    k -= 180 & -(k >= 180);
+    b[i] = v - vs * std::min(std::max(std::min(k, 120 - k), 0), 30);
+    k = 90 + hu;
+    k -= 180 & -(k >= 180);
+    g[i] = v - vs * std::min(std::max(std::min(k, 120 - k), 0), 30);
+    k = 150 + hu;
+    k -= 180 & -(k >= 180);
+    r[i] = v - vs * std::min(std::max(std::min(k, 120 - k), 0), 30);
+  }
+}
+
+// Per-thread planar row buffers of DistortBGR.
+static boost::thread_specific_ptr<vector<float> > distort_rows_;
+
+// Single pass over an 8-bit BGR image: pre_lut on every channel, then the
+// saturation and hue adjustment if adjust_hsv, then post_lut, then the
+// channel order (out channel c is channel order[c]).
+static void DistortBGR(const cv::Mat& in_img, const uchar* pre_lut,
+                       const bool adjust_hsv, const float saturation,
+                       const float hue, const uchar* post_lut,
+                       const int* order, cv::Mat* out_img) {
+  const int cols = in_img.cols;
+  out_img->create(in_img.size(), in_img.type());
+  if (!distort_rows_.get()) {
+    distort_rows_.reset(new vector<float>());
+  }
+  vector<float>& rows = *distort_rows_;
+  if (rows.size() < static_cast<size_t>(3 * cols)) {
+    rows.resize(3 * cols);
+  }
+  float* planes[3] = {&rows[0], &rows[cols], &rows[2 * cols]};
+  for (int y = 0; y < in_img.rows; ++y) {
+    const uchar* src = in_img.ptr<uchar>(y);
+    uchar* dst = out_img->ptr<uchar>(y);
+    if (!adjust_hsv) {
+      for (int x = 0; x < cols; ++x) {
+        for (int c = 0; c < 3; ++c) {
+          dst[3 * x + c] = post_lut[pre_lut[src[3 * x + order[c]]]];
+        }
+      }
+      continue;
+    }
+    for (int x = 0; x < cols; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        planes[c][x] = pre_lut[src[3 * x + c]];
+      }
+    }
+    AdjustSaturationHue(cols, saturation, hue, planes[0], planes[1],
+                        planes[2]);
+    for (int x = 0; x < cols; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        dst[3 * x + c] =
+            post_lut[cv::saturate_cast<uchar>(planes[order[c]][x])];
+      }
+    }
+  }
+}
+
+cv::Mat ApplyDistort(const cv::Mat& in_img, const DistortionParameter& param) {
+  if (in_img.type() != CV_8UC3 || in_img.empty()) {
+    return ApplyDistortChain(in_img, param);
+  }
+  // Draw everything in the order of ApplyDistortChain, so both consume the
+  // random streams identically.
+  float prob;
+  caffe_rng_uniform(1, 0.f, 1.f, &prob);
+  const bool contrast_first = prob > 0.5;
+  float brightness = 0, contrast = 1, saturation = 1, hue = 0;
+  DrawDistortion(param.brightness_prob(), -param.brightness_delta(),
+                 param.brightness_delta(), "brightness", &brightness);
+  if (contrast_first) {
+    DrawDistortion(param.contrast_prob(), param.contrast_lower(),
+                   param.contrast_upper(), "contrast", &contrast);
+  }
+  DrawDistortion(param.saturation_prob(), param.saturation_lower(),
+                 param.saturation_upper(), "saturation", &saturation);
+  DrawDistortion(param.hue_prob(), -param.hue_delta(), param.hue_delta(),
+                 "hue", &hue);
+  if (!contrast_first) {
+    DrawDistortion(param.contrast_prob(), param.contrast_lower(),
+                   param.contrast_upper(), "contrast", &contrast);
+  }
+  CHECK_GE(contrast, 0) << "contrast lower must be non-negative.";
+  CHECK_GE(saturation, 0) << "saturation lower must be non-negative.";
+  int order[3] = {0, 1, 2};
+  caffe_rng_uniform(1, 0.f, 1.f, &prob);
+  if (prob < param.random_order_prob()) {
+    std::random_shuffle(order, order + 3);
+  }
+
+  // Brightness and contrast are per-channel maps of uchar values, so they
+  // fold into tables around the single HSV round trip.
+  uchar pre_lut[256], post_lut[256];
+  for (int i = 0; i < 256; ++i) {
+    pre_lut[i] = post_lut[i] = i;
+  }
+  bool identity = true;
+  if (fabs(brightness) > 0) {
+    ComposeAffineLut(1, brightness, pre_lut);
+    identity = false;
+  }
+  if (fabs(contrast - 1.f) > 1e-3) {
+    ComposeAffineLut(contrast, 0, contrast_first ? pre_lut : post_lut);
+    identity = false;
+  }
+  const bool adjust_hsv = fabs(saturation - 1.f) > 1e-3 || fabs(hue) > 0;
+  if (identity && !adjust_hsv && order[0] == 0 && order[1] == 1 &&
+      order[2] == 2) {
+    return in_img;
+  }
+  cv::Mat out_img;
+  DistortBGR(in_img, pre_lut, adjust_hsv, saturation, hue, post_lut, order,
+             &out_img);
+  return out_img;
+}
+
 #endif  // USE_OPENCV
 
 }  // namespace caffe
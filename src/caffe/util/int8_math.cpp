@@ -0,0 +1,320 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#if defined(__AVX512VNNI__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "caffe/common.hpp"
+#include "caffe/util/int8_math.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void caffe_cpu_quantize_u8(const int n, const Dtype* x, const float scale,
+    uint8_t* y) {
+#ifdef _OPENMP
+  #pragma omp parallel for if(n > 4096 && !omp_in_parallel())
+#endif
+  for (int i = 0; i < n; ++i) {
+    const float v = std::nearbyint(static_cast<float>(x[i]) * scale);
+    y[i] = static_cast<uint8_t>(std::min(std::max(v, 0.f), 255.f));
+  }
+}
+
+template <typename Dtype>
+void caffe_cpu_quantize_s8(const int n, const Dtype* x, const float scale,
+    int8_t* y) {
+#ifdef _OPENMP
+  #pragma omp parallel for if(n > 4096 && !omp_in_parallel())
+#endif
+  for (int i = 0; i < n; ++i) {
+    const float v = std::nearbyint(static_cast<float>(x[i]) * scale);
+    y[i] = static_cast<int8_t>(std::min(std::max(v, -127.f), 127.f));
+  }
+}
+
+#if defined(__AVX512VNNI__)
+// Each step multiplies 4 u8 values of B by 4 s8 weights and accumulates in
+// s32 (vpdpbusd). B is packed per panel of kInt8GemmPanel columns as
+// [K / 4][column][4], so one 64 byte load feeds 16 output columns.
+static const int kInt8GemmStep = 4;
+static const int kInt8GemmVector = 16;
+typedef uint8_t PackedB;
+typedef __m512i Int8GemmVec;
+#elif defined(__AVX2__)
+// Each step multiplies 2 values of B by 2 weights, both widened to s16, and
+// accumulates in s32 (vpmaddwd, which cannot saturate for u8 x s8). B is
+// packed per panel as [K / 2][column][2] of s16.
+static const int kInt8GemmStep = 2;
+static const int kInt8GemmVector = 8;
+typedef int16_t PackedB;
+typedef __m256i Int8GemmVec;
+#else
+static const int kInt8GemmStep = 1;
+static const int kInt8GemmVector = 64;
+typedef uint8_t PackedB;
+#endif
+// Output columns per panel and output rows per block of accumulators; a
+// block of kInt8GemmRows x kInt8GemmPanel s32 values stays in registers.
+static const int kInt8GemmPanel = 4 * kInt8GemmVector;
+static const int kInt8GemmRows = 4;
+
+static inline int int8_gemm_steps(const int K) {
+  return (K + kInt8GemmStep - 1) / kInt8GemmStep;
+}
+
+// Packs the kInt8GemmStep weights A[m][k ..] of every step into one s32, the
+// value broadcast to all lanes, zero past K.
+static void pack_weights(const int M, const int K, const int8_t* A,
+    int32_t* packed) {
+  const int steps = int8_gemm_steps(K);
+  for (int m = 0; m < M; ++m) {
+    const int8_t* a = A + static_cast<size_t>(m) * K;
+    for (int s = 0; s < steps; ++s) {
+      uint32_t value = 0;
+      for (int i = 0; i < kInt8GemmStep; ++i) {
+        const int k = s * kInt8GemmStep + i;
+        if (k < K) {
+          // Bytes for vpdpbusd, s16 halves for vpmaddwd
+          const uint32_t bits = kInt8GemmStep == 2 ?
+              static_cast<uint16_t>(a[k]) : static_cast<uint8_t>(a[k]);
+          value |= bits << (i * 32 / kInt8GemmStep);
+        }
+      }
+      packed[static_cast<size_t>(m) * steps + s] =
+          kInt8GemmStep == 1 ? a[s] : static_cast<int32_t>(value);
+    }
+  }
+}
+
+// Packs columns [n0, n0 + len) of B into panel, zero padded to
+// kInt8GemmPanel columns and to a whole number of steps.
+static void pack_panel(const int N, const int K, const uint8_t* B,
+    const int n0, const int len, PackedB* panel) {
+  const int steps = int8_gemm_steps(K);
+  for (int s = 0; s < steps; ++s) {
+    PackedB* p = panel + static_cast<size_t>(s) * kInt8GemmPanel *
+        kInt8GemmStep;
+    const uint8_t* rows[kInt8GemmStep];
+    bool full = len == kInt8GemmPanel;
+    for (int i = 0; i < kInt8GemmStep; ++i) {
+      const int k = s * kInt8GemmStep + i;
+      rows[i] = k < K ? B + static_cast<size_t>(k) * N + n0 : NULL;
+      full = full && k < K;
+    }
+#if defined(__AVX512VNNI__)
+    if (full) {
+      // Interleaves 16 columns of 4 rows into 16 groups of 4 bytes
+      for (int j = 0; j < kInt8GemmPanel; j += 16) {
+        __m128i r[4];
+        for (int i = 0; i < 4; ++i) {
+          r[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[i] + j));
+        }
+        const __m128i lo01 = _mm_unpacklo_epi8(r[0], r[1]);
+        const __m128i hi01 = _mm_unpackhi_epi8(r[0], r[1]);
+        const __m128i lo23 = _mm_unpacklo_epi8(r[2], r[3]);
+        const __m128i hi23 = _mm_unpackhi_epi8(r[2], r[3]);
+        __m128i* out = reinterpret_cast<__m128i*>(p + j * 4);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(lo01, lo23));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo01, lo23));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi01, hi23));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi01, hi23));
+      }
+      continue;
+    }
+#elif defined(__AVX2__)
+    if (full) {
+      // Interleaves 16 columns of 2 rows into 16 pairs of s16
+      const __m128i zero = _mm_setzero_si128();
+      for (int j = 0; j < kInt8GemmPanel; j += 16) {
+        const __m128i r0 =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[0] + j));
+        const __m128i r1 =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[1] + j));
+        const __m128i lo = _mm_unpacklo_epi8(r0, r1);
+        const __m128i hi = _mm_unpackhi_epi8(r0, r1);
+        __m128i* out = reinterpret_cast<__m128i*>(p + j * 2);
+        _mm_storeu_si128(out, _mm_unpacklo_epi8(lo, zero));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(lo, zero));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi8(hi, zero));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi8(hi, zero));
+      }
+      continue;
+    }
+#endif
+    for (int i = 0; i < kInt8GemmStep; ++i) {
+      for (int j = 0; j < kInt8GemmPanel; ++j) {
+        p[j * kInt8GemmStep + i] = (rows[i] && j < len) ? rows[i][j] : 0;
+      }
+    }
+  }
+}
+
+// Rows [m0, m0 + Rows) and columns [n0, n0 + len) of C from packed weights
+// and a packed panel of B
+template <int Rows>
+static void gemm_block(const int N, const int K, const int32_t* weights,
+    const PackedB* panel, const int m0, const int n0, const int len,
+    int32_t* C) {
+  const int steps = int8_gemm_steps(K);
+  const int32_t* a = weights + static_cast<size_t>(m0) * steps;
+#if defined(__AVX512VNNI__) || defined(__AVX2__)
+  const int kVectors = kInt8GemmPanel / kInt8GemmVector;
+  Int8GemmVec acc[Rows][kVectors];
+  for (int r = 0; r < Rows; ++r) {
+    for (int v = 0; v < kVectors; ++v) {
+#if defined(__AVX512VNNI__)
+      acc[r][v] = _mm512_setzero_si512();
+#else
+      acc[r][v] = _mm256_setzero_si256();
+#endif
+    }
+  }
+  const Int8GemmVec* p = reinterpret_cast<const Int8GemmVec*>(panel);
+  for (int s = 0; s < steps; ++s, p += kVectors) {
+    Int8GemmVec b[kVectors];
+    for (int v = 0; v < kVectors; ++v) {
+      b[v] = p[v];
+    }
+    for (int r = 0; r < Rows; ++r) {
+#if defined(__AVX512VNNI__)
+      const Int8GemmVec w = _mm512_set1_epi32(a[r * steps + s]);
+      for (int v = 0; v < kVectors; ++v) {
+        acc[r][v] = _mm512_dpbusd_epi32(acc[r][v], b[v], w);
+      }
+#else
+      const Int8GemmVec w = _mm256_set1_epi32(a[r * steps + s]);
+      for (int v = 0; v < kVectors; ++v) {
+        acc[r][v] = _mm256_add_epi32(acc[r][v], _mm256_madd_epi16(b[v], w));
+      }
+#endif
+    }
+  }
+  for (int r = 0; r < Rows; ++r) {
+    int32_t* c = C + static_cast<size_t>(m0 + r) * N + n0;
+    memcpy(c, acc[r], len * sizeof(int32_t));
+  }
+#else
+  for (int r = 0; r < Rows; ++r) {
+    int32_t* c = C + static_cast<size_t>(m0 + r) * N + n0;
+    std::fill(c, c + len, 0);
+    for (int k = 0; k < steps; ++k) {
+      const int32_t a_k = a[r * steps + k];
+      const PackedB* b = panel + k * kInt8GemmPanel;
+      for (int j = 0; j < len; ++j) {
+        c[j] += a_k * static_cast<int32_t>(b[j]);
+      }
+    }
+  }
+#endif
+}
+
+void caffe_cpu_gemm_s8u8s32(const int M, const int N, const int K,
+    const int8_t* A, const uint8_t* B, int32_t* C) {
+  const int steps = int8_gemm_steps(K);
+  const int num_panels = (N + kInt8GemmPanel - 1) / kInt8GemmPanel;
+  const size_t panel_size =
+      static_cast<size_t>(kInt8GemmPanel) * steps * kInt8GemmStep;
+  vector<int32_t> weights(static_cast<size_t>(M) * steps);
+  pack_weights(M, K, A, &weights[0]);
+#ifdef _OPENMP
+  #pragma omp parallel if(num_panels > 1 && !omp_in_parallel())
+#endif
+  {
+    // One panel per thread, aligned for the vector loads
+    void* buffer = NULL;
+    CHECK_EQ(posix_memalign(&buffer, 64, panel_size * sizeof(PackedB)), 0);
+    PackedB* panel = static_cast<PackedB*>(buffer);
+#ifdef _OPENMP
+    #pragma omp for
+#endif
+    for (int t = 0; t < num_panels; ++t) {
+      const int n0 = t * kInt8GemmPanel;
+      const int len = std::min(kInt8GemmPanel, N - n0);
+      pack_panel(N, K, B, n0, len, panel);
+      int m0 = 0;
+      for (; m0 + kInt8GemmRows <= M; m0 += kInt8GemmRows) {
+        gemm_block<kInt8GemmRows>(N, K, &weights[0], panel, m0, n0, len, C);
+      }
+      for (; m0 < M; ++m0) {
+        gemm_block<1>(N, K, &weights[0], panel, m0, n0, len, C);
+      }
+    }
+    free(buffer);
+  }
+}
+
+template <typename Dtype>
+void caffe_cpu_dequantize_s32(const int M, const int N, const int32_t* x,
+    const float* scale, const Dtype* bias, Dtype* y) {
+#ifdef _OPENMP
+  #pragma omp parallel for if(M > 1 && !omp_in_parallel())
+#endif
+  for (int m = 0; m < M; ++m) {
+    const Dtype s = scale[m];
+    const Dtype b = bias ? bias[m] : Dtype(0);
+    const int32_t* x_m = x + static_cast<size_t>(m) * N;
+    Dtype* y_m = y + static_cast<size_t>(m) * N;
+    for (int n = 0; n < N; ++n) {
+      y_m[n] = static_cast<Dtype>(x_m[n]) * s + b;
+    }
+  }
+}
+
+template void caffe_cpu_quantize_u8<float>(const int n, const float* x,
+    const float scale, uint8_t* y);
+template void caffe_cpu_quantize_u8<double>(const int n, const double* x,
+    const float scale, uint8_t* y);
+template void caffe_cpu_quantize_s8<float>(const int n, const float* x,
+    const float scale, int8_t* y);
+template void caffe_cpu_quantize_s8<double>(const int n, const double* x,
+    const float scale, int8_t* y);
+template void caffe_cpu_dequantize_s32<float>(const int M, const int N,
+    const int32_t* x, const float* scale, const float* bias, float* y);
+template void caffe_cpu_dequantize_s32<double>(const int M, const int N,
+    const int32_t* x, const float* scale, const double* bias, double* y);
+
+}  // namespace caffe
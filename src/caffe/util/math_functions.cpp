@@ -45,7 +45,6 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 
 #include <boost/math/special_functions/next.hpp>
-#include <boost/random.hpp>
 
 #include <algorithm>
 #include <limits>
@@ -377,17 +376,61 @@ float caffe_nextafter(const float b);
 template
 double caffe_nextafter(const double b);
 
+// Length from which the random number generators split their output across
+// threads.
+static const long kRngParallelSize = 32768;
+
+// Fills r[0, n) from consecutive blocks of a fresh Philox stream, kPerBlock
+// values per block, fill(words, values) turning the four words of a block
+// into its values. Every value depends only on the key and its index, so
+// the result is the same for any number of threads.
+template <int kPerBlock, typename T, typename Fill>
+static void philox_generate(const long n, T* r, const Fill& fill) {
+  const Philox philox = caffe_philox();
+  const long full_blocks = n / kPerBlock;
+  bool run_parallel = false;
+#ifdef _OPENMP
+  run_parallel = (n >= kRngParallelSize) && (omp_in_parallel() == 0);
+  #pragma omp parallel for if(run_parallel)
+#endif
+  for (long i = 0; i < full_blocks; ++i) {
+    uint32_t words[4];
+    philox(i, words);
+    fill(words, r + i * kPerBlock);
+  }
+  const long tail = n - full_blocks * kPerBlock;
+  if (tail > 0) {
+    uint32_t words[4];
+    T values[kPerBlock];
+    philox(full_blocks, words);
+    fill(words, values);
+    std::copy(values, values + tail, r + full_blocks * kPerBlock);
+  }
+}
+
+// Uniform numbers in [0, 1) with the full precision of the type, from one
+// word for float and two for double.
+static inline float philox_unit(const uint32_t* w, float) {
+  return (w[0] >> 8) * (1.f / (1 << 24));
+}
+
+static inline double philox_unit(const uint32_t* w, double) {
+  const uint64_t bits = (static_cast<uint64_t>(w[0] >> 5) << 26) | (w[1] >> 6);
+  return bits * (1. / (static_cast<uint64_t>(1) << 53));
+}
+
 template <typename Dtype>
 void caffe_rng_uniform(const long n, const Dtype a, const Dtype b, Dtype* r) {
   CHECK_GE(n, 0);
   CHECK(r);
   CHECK_LE(a, b);
-  boost::uniform_real<Dtype> random_distribution(a, caffe_nextafter<Dtype>(b));
-  boost::variate_generator<caffe::rng_t*, boost::uniform_real<Dtype> >
-      variate_generator(caffe_rng(), random_distribution);
-  for (long i = 0; i < n; ++i) {
-    r[i] = variate_generator();
-  }
+  const Dtype range = b - a;
+  static const int kWords = sizeof(Dtype) / sizeof(uint32_t);
+  philox_generate<4 / kWords>(n, r, [=](const uint32_t* w, Dtype* v) {
+    for (int j = 0; j < 4 / kWords; ++j) {
+      v[j] = std::min(a + range * philox_unit(w + j * kWords, Dtype()), b);
+    }
+  });
 }
 
 template
@@ -404,12 +447,19 @@ void caffe_rng_gaussian(const long n, const Dtype a,
   CHECK_GE(n, 0);
   CHECK(r);
   CHECK_GT(sigma, 0);
-  boost::normal_distribution<Dtype> random_distribution(a, sigma);
-  boost::variate_generator<caffe::rng_t*, boost::normal_distribution<Dtype> >
-      variate_generator(caffe_rng(), random_distribution);
-  for (long i = 0; i < n; ++i) {
-    r[i] = variate_generator();
-  }
+  // Box-Muller: each pair of uniforms gives a pair of normals.
+  static const int kWords = sizeof(Dtype) / sizeof(uint32_t);
+  static const Dtype kTwoPi = 6.283185307179586;
+  philox_generate<4 / kWords>(n, r, [=](const uint32_t* w, Dtype* v) {
+    for (int j = 0; j < 4 / kWords; j += 2) {
+      // 1 - u lies in (0, 1], so the logarithm stays finite.
+      const Dtype u = Dtype(1) - philox_unit(w + j * kWords, Dtype());
+      const Dtype radius = sigma * std::sqrt(Dtype(-2) * std::log(u));
+      const Dtype theta = kTwoPi * philox_unit(w + (j + 1) * kWords, Dtype());
+      v[j] = a + radius * std::cos(theta);
+      v[j + 1] = a + radius * std::sin(theta);
+    }
+  });
 }
 
 template
@@ -420,59 +470,24 @@ template
 void caffe_rng_gaussian<double>(const long n, const double mu,
                                 const double sigma, double* r);
 
-#ifdef USE_MKL
-static void bernoulli_generate(long n, double p, int* r) {
-  int seed = 17 + caffe_rng_rand() % 4096;
-
-#ifdef _OPENMP
-  int nthr = omp_get_max_threads();
-  int threshold = nthr * caffe::cpu::OpenMpManager::getProcessorSpeedMHz() / 3;
-  bool run_parallel =
-    (Caffe::mode() != Caffe::GPU) &&
-    (omp_in_parallel() == 0) &&
-    (n >= threshold);
-  if (!run_parallel) nthr = 1;
-
-#pragma omp parallel num_threads(nthr)
-  {
-    const int ithr = omp_get_thread_num();
-    const long avg_amount = (n + nthr - 1) / nthr;
-    const long my_offset = ithr * avg_amount;
-    const long my_amount = std::min(my_offset + avg_amount, n) - my_offset;
-#else
-  {
-    const long my_amount = n;
-    const long my_offset = 0;
-#endif
-
-    if (my_amount > 0) {
-      VSLStreamStatePtr stream;
-      vslNewStream(&stream, VSL_BRNG_MCG31, seed);
-      vslSkipAheadStream(stream, my_offset);
-      viRngBernoulli(VSL_RNG_METHOD_BERNOULLI_ICDF, stream, my_amount,
-        r + my_offset, p);
-      vslDeleteStream(&stream);
+template <typename Dtype, typename T>
+static void bernoulli_generate(const long n, const Dtype p, T* r) {
+  CHECK_GE(n, 0);
+  CHECK(r);
+  CHECK_GE(p, 0);
+  CHECK_LE(p, 1);
+  // A word w is a success when w < p * 2^32, so p = 1 always succeeds.
+  const uint64_t threshold = static_cast<uint64_t>(p * 4294967296.);
+  philox_generate<4>(n, r, [=](const uint32_t* w, T* v) {
+    for (int j = 0; j < 4; ++j) {
+      v[j] = w[j] < threshold;
     }
-  }
+  });
 }
-#endif
 
 template <typename Dtype>
 void caffe_rng_bernoulli(const long n, const Dtype p, int* r) {
-  CHECK_GE(n, 0);
-  CHECK(r);
-  CHECK_GE(p, 0);
-  CHECK_LE(p, 1);
-#ifdef USE_MKL
   bernoulli_generate(n, p, r);
-#else
-  boost::bernoulli_distribution<Dtype> random_distribution(p);
-  boost::variate_generator<caffe::rng_t*, boost::bernoulli_distribution<Dtype> >
-      variate_generator(caffe_rng(), random_distribution);
-  for (long i = 0; i < n; ++i) {
-    r[i] = variate_generator();
-  }
-#endif
 }
 
 template
@@ -483,20 +498,7 @@ void caffe_rng_bernoulli<float>(const long n, const float p, int* r);
 
 template <typename Dtype>
 void caffe_rng_bernoulli(const long n, const Dtype p, unsigned int* r) {
-  CHECK_GE(n, 0);
-  CHECK(r);
-  CHECK_GE(p, 0);
-  CHECK_LE(p, 1);
-#ifdef USE_MKL
-  bernoulli_generate(n, p, reinterpret_cast<int *>(r));
-#else
-  boost::bernoulli_distribution<Dtype> random_distribution(p);
-  boost::variate_generator<caffe::rng_t*, boost::bernoulli_distribution<Dtype> >
-      variate_generator(caffe_rng(), random_distribution);
-  for (long i = 0; i < n; ++i) {
-    r[i] = static_cast<unsigned int>(variate_generator());
-  }
-#endif
+  bernoulli_generate(n, p, r);
 }
 
 template
@@ -554,6 +556,67 @@ size_t caffe_cpu_asum<size_t>(const long n, const size_t* x) {
   return 0;
 }
 
+// Row length from which a single softmax row is split across threads.
+static const long kSoftmaxParallelSize = 16384;
+
+template <typename Dtype>
+Dtype caffe_cpu_softmax(const long n, const Dtype* x, Dtype* y) {
+  bool run_parallel = false;
+#ifdef _OPENMP
+  run_parallel = (n >= kSoftmaxParallelSize) && (omp_in_parallel() == 0);
+#endif
+  Dtype max_val = x[0];
+#ifdef _OPENMP
+  #pragma omp parallel for simd reduction(max: max_val) if(run_parallel)
+#endif
+  for (long i = 0; i < n; ++i) {
+    max_val = x[i] > max_val ? x[i] : max_val;
+  }
+
+  // Each thread exponentiates and sums its own contiguous chunk, so the
+  // values are still in cache for the reduction.
+  Dtype sum = 0;
+#ifdef _OPENMP
+  #pragma omp parallel reduction(+: sum) if(run_parallel)
+#endif
+  {
+    long begin = 0;
+    long end = n;
+#ifdef _OPENMP
+    const long nthr = omp_get_num_threads();
+    const long chunk = (n + nthr - 1) / nthr;
+    begin = std::min(n, chunk * omp_get_thread_num());
+    end = std::min(n, begin + chunk);
+#endif
+#ifdef _OPENMP
+    #pragma omp simd
+#endif
+    for (long i = begin; i < end; ++i) {
+      y[i] = x[i] - max_val;
+    }
+    caffe_exp<Dtype>(end - begin, y + begin, y + begin);
+#ifdef _OPENMP
+    #pragma omp simd reduction(+: sum)
+#endif
+    for (long i = begin; i < end; ++i) {
+      sum += y[i];
+    }
+  }
+
+  const Dtype inv_sum = Dtype(1) / sum;
+#ifdef _OPENMP
+  #pragma omp parallel for simd if(run_parallel)
+#endif
+  for (long i = 0; i < n; ++i) {
+    y[i] *= inv_sum;
+  }
+  return max_val + std::log(sum);
+}
+
+template float caffe_cpu_softmax<float>(const long n, const float* x, float* y);
+template double caffe_cpu_softmax<double>(const long n, const double* x,
+    double* y);
+
 template <>
 void caffe_cpu_scale<float>(const long n, const float alpha, const float *x,
                             float* y) {
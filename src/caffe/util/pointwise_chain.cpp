@@ -0,0 +1,390 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "caffe/filler.hpp"
+#include "caffe/util/math_functions.hpp"
+#include "caffe/util/pointwise_chain.hpp"
+
+namespace caffe {
+
+// Number of elements processed per tile. Input, output and one Eltwise
+// operand tile of this size stay within a 32KB L1 data cache.
+static const int kPointwiseTileSize = 2048;
+
+template <typename Dtype>
+static inline Dtype pointwise_sigmoid(Dtype x) {
+  // Same formulation as SigmoidLayer, kept in Dtype so the loops vectorize
+  return Dtype(0.5) * std::tanh(Dtype(0.5) * x) + Dtype(0.5);
+}
+
+template <typename Dtype>
+bool PointwiseChain<Dtype>::IsParameterFree(const LayerParameter& layer_param) {
+  const string& type = layer_param.type();
+  return (type == "ReLU" || type == "Power" || type == "Sigmoid" ||
+          type == "Swish") &&
+         layer_param.bottom_size() == 1 && layer_param.top_size() == 1;
+}
+
+template <typename Dtype>
+bool PointwiseChain<Dtype>::IsPointwise(const LayerParameter& layer_param) {
+  if (IsParameterFree(layer_param)) {
+    return true;
+  }
+  const string& type = layer_param.type();
+  if (layer_param.top_size() != 1) {
+    return false;
+  }
+  // Only per-channel Scale/Bias with a learned parameter blob
+  if (type == "Scale") {
+    return layer_param.bottom_size() == 1 &&
+           layer_param.scale_param().axis() == 1 &&
+           layer_param.scale_param().num_axes() == 1;
+  }
+  if (type == "Bias") {
+    return layer_param.bottom_size() == 1 &&
+           layer_param.bias_param().axis() == 1 &&
+           layer_param.bias_param().num_axes() == 1;
+  }
+  if (type == "Eltwise") {
+    const EltwiseParameter& eltwise_param = layer_param.eltwise_param();
+    return layer_param.bottom_size() >= 2 &&
+           (eltwise_param.coeff_size() == 0 ||
+            eltwise_param.coeff_size() == layer_param.bottom_size());
+  }
+  return false;
+}
+
+template <typename Dtype>
+void PointwiseChain<Dtype>::Init(const FusedPointwiseParameter& fused_param,
+    const string& input_name, const vector<string>& operand_names) {
+  ops_.clear();
+  num_operands_ = operand_names.size();
+  num_param_blobs_ = 0;
+  string current = input_name;
+  for (int i = 0; i < fused_param.op_size(); ++i) {
+    const LayerParameter& op_param = fused_param.op(i);
+    CHECK(IsPointwise(op_param)) << "Layer " << op_param.name()
+        << " of type " << op_param.type() << " can not be fused";
+    Op op;
+    op.alpha = op.beta = op.gamma = Dtype(0);
+    op.param_id = op.bias_id = -1;
+    op.eltwise_op = EltwiseParameter_EltwiseOp_SUM;
+    const string& type = op_param.type();
+    if (type != "Eltwise") {
+      CHECK_EQ(op_param.bottom(0), current) << "Fused op " << op_param.name()
+          << " does not consume the output of the previous op";
+    }
+    if (type == "ReLU") {
+      op.type = RELU;
+      op.alpha = op_param.relu_param().negative_slope();
+    } else if (type == "Power") {
+      op.type = POWER;
+      op.alpha = op_param.power_param().power();
+      op.beta = op_param.power_param().scale();
+      op.gamma = op_param.power_param().shift();
+    } else if (type == "Sigmoid") {
+      op.type = SIGMOID;
+    } else if (type == "Swish") {
+      op.type = SWISH;
+      op.alpha = op_param.swish_param().beta();
+    } else if (type == "Scale") {
+      const ScaleParameter& scale_param = op_param.scale_param();
+      op.type = SCALE;
+      op.param_id = num_param_blobs_++;
+      FillerParameter filler(scale_param.filler());
+      if (!scale_param.has_filler()) {
+        // Default to unit (1) filler for identity operation, as ScaleLayer.
+        filler.set_type("constant");
+        filler.set_value(1);
+      }
+      op.fillers.push_back(filler);
+      if (scale_param.bias_term()) {
+        op.bias_id = num_param_blobs_++;
+        op.fillers.push_back(scale_param.bias_filler());
+      }
+    } else if (type == "Bias") {
+      op.type = BIAS;
+      op.bias_id = num_param_blobs_++;
+      op.fillers.push_back(op_param.bias_param().filler());
+    } else {
+      const EltwiseParameter& eltwise_param = op_param.eltwise_param();
+      op.type = ELTWISE;
+      op.eltwise_op = eltwise_param.operation();
+      bool consumes_current = false;
+      for (int j = 0; j < op_param.bottom_size(); ++j) {
+        const string& bottom_name = op_param.bottom(j);
+        int input = -1;
+        if (bottom_name != current) {
+          input = std::find(operand_names.begin(), operand_names.end(),
+              bottom_name) - operand_names.begin();
+          CHECK_LT(input, num_operands_) << "Fused op " << op_param.name()
+              << " reads " << bottom_name
+              << " which is not a bottom of the fused layer";
+        } else {
+          consumes_current = true;
+        }
+        op.inputs.push_back(input);
+        op.coeffs.push_back(eltwise_param.coeff_size() ?
+            eltwise_param.coeff(j) : Dtype(1));
+      }
+      CHECK(consumes_current) << "Fused op " << op_param.name()
+          << " does not consume the output of the previous op";
+      CHECK(op.eltwise_op == EltwiseParameter_EltwiseOp_SUM ||
+            eltwise_param.coeff_size() == 0)
+          << "Eltwise coefficients are only valid for SUM";
+    }
+    ops_.push_back(op);
+    current = op_param.top(0);
+  }
+}
+
+template <typename Dtype>
+void PointwiseChain<Dtype>::InitEpilogue(
+    const FusedPointwiseParameter& fused_param) {
+  CHECK_GT(fused_param.op_size(), 0) << "Empty pointwise epilogue";
+  for (int i = 0; i < fused_param.op_size(); ++i) {
+    CHECK(IsParameterFree(fused_param.op(i))) << "Layer "
+        << fused_param.op(i).name() << " can not be fused as an epilogue";
+  }
+  Init(fused_param, fused_param.op(0).bottom(0), vector<string>());
+}
+
+template <typename Dtype>
+void PointwiseChain<Dtype>::InitParamBlobs(int channels,
+    vector<shared_ptr<Blob<Dtype> > >* blobs) const {
+  const vector<int> param_shape(1, channels);
+  for (int i = 0; i < ops_.size(); ++i) {
+    for (int j = 0; j < ops_[i].fillers.size(); ++j) {
+      shared_ptr<Blob<Dtype> > blob(new Blob<Dtype>(param_shape));
+      shared_ptr<Filler<Dtype> > filler(
+          GetFiller<Dtype>(ops_[i].fillers[j]));
+      filler->Fill(blob.get());
+      blobs->push_back(blob);
+    }
+  }
+}
+
+template <typename Dtype>
+void PointwiseChain<Dtype>::ApplyOp(const Op& op, const Dtype* src,
+    Dtype* dst, int offset, int count, int channel,
+    const vector<const Dtype*>& operands,
+    const vector<const Dtype*>& params) const {
+  switch (op.type) {
+  case RELU: {
+    const Dtype negative_slope = op.alpha;
+    for (int i = 0; i < count; ++i) {
+      dst[i] = std::max(src[i], Dtype(0))
+          + negative_slope * std::min(src[i], Dtype(0));
+    }
+    break;
+  }
+  case POWER: {
+    const Dtype power = op.alpha;
+    const Dtype scale = op.beta;
+    const Dtype shift = op.gamma;
+    if (power == Dtype(1)) {
+      for (int i = 0; i < count; ++i) {
+        dst[i] = scale * src[i] + shift;
+      }
+    } else {
+      for (int i = 0; i < count; ++i) {
+        dst[i] = std::pow(scale * src[i] + shift, power);
+      }
+    }
+    break;
+  }
+  case SIGMOID:
+    for (int i = 0; i < count; ++i) {
+      dst[i] = pointwise_sigmoid(src[i]);
+    }
+    break;
+  case SWISH: {
+    const Dtype beta = op.alpha;
+    for (int i = 0; i < count; ++i) {
+      dst[i] = src[i] * pointwise_sigmoid(beta * src[i]);
+    }
+    break;
+  }
+  case SCALE: {
+    const Dtype scale = params[op.param_id][channel];
+    if (op.bias_id >= 0) {
+      const Dtype bias = params[op.bias_id][channel];
+      for (int i = 0; i < count; ++i) {
+        dst[i] = src[i] * scale + bias;
+      }
+    } else {
+      for (int i = 0; i < count; ++i) {
+        dst[i] = src[i] * scale;
+      }
+    }
+    break;
+  }
+  case BIAS: {
+    const Dtype bias = params[op.bias_id][channel];
+    for (int i = 0; i < count; ++i) {
+      dst[i] = src[i] + bias;
+    }
+    break;
+  }
+  case ELTWISE: {
+    // The running value is folded in first, so dst may alias src.
+    int num_current = 0;
+    Dtype current_coeff = Dtype(0);
+    for (int j = 0; j < op.inputs.size(); ++j) {
+      if (op.inputs[j] < 0) {
+        ++num_current;
+        current_coeff += op.coeffs[j];
+      }
+    }
+    switch (op.eltwise_op) {
+    case EltwiseParameter_EltwiseOp_SUM:
+      for (int i = 0; i < count; ++i) {
+        dst[i] = current_coeff * src[i];
+      }
+      break;
+    case EltwiseParameter_EltwiseOp_PROD:
+      for (int i = 0; i < count; ++i) {
+        Dtype value = src[i];
+        for (int k = 1; k < num_current; ++k) {
+          value *= src[i];
+        }
+        dst[i] = value;
+      }
+      break;
+    case EltwiseParameter_EltwiseOp_MAX:
+      if (dst != src) {
+        caffe_copy(count, src, dst);
+      }
+      break;
+    default:
+      LOG(FATAL) << "Unknown elementwise operation.";
+    }
+    for (int j = 0; j < op.inputs.size(); ++j) {
+      if (op.inputs[j] < 0) {
+        continue;
+      }
+      const Dtype* operand = operands[op.inputs[j]] + offset;
+      const Dtype coeff = op.coeffs[j];
+      switch (op.eltwise_op) {
+      case EltwiseParameter_EltwiseOp_SUM:
+        for (int i = 0; i < count; ++i) {
+          dst[i] += coeff * operand[i];
+        }
+        break;
+      case EltwiseParameter_EltwiseOp_PROD:
+        for (int i = 0; i < count; ++i) {
+          dst[i] *= operand[i];
+        }
+        break;
+      default:
+        for (int i = 0; i < count; ++i) {
+          dst[i] = std::max(dst[i], operand[i]);
+        }
+      }
+    }
+    break;
+  }
+  default:
+    LOG(FATAL) << "Unknown pointwise op";
+  }
+}
+
+template <typename Dtype>
+void PointwiseChain<Dtype>::Forward(const Dtype* input, Dtype* output,
+    const vector<const Dtype*>& operands, const vector<const Dtype*>& params,
+    int outer, int channels, int inner, bool parallel) const {
+  CHECK_EQ(operands.size(), num_operands_);
+  CHECK_EQ(params.size(), num_param_blobs_);
+  const int num_rows = outer * channels;
+  const int count = num_rows * inner;
+  if (ops_.empty()) {
+    if (output != input) {
+      caffe_copy(count, input, output);
+    }
+    return;
+  }
+  // Split the data into tiles of about kPointwiseTileSize elements. A tile
+  // either covers a piece of one (n, c) row or a run of whole rows, so
+  // per-channel ops see a constant channel per row segment.
+  const int tiles_per_row = (inner + kPointwiseTileSize - 1)
+      / kPointwiseTileSize;
+  const int rows_per_tile = std::max(1, kPointwiseTileSize / inner);
+  const int num_tiles = inner >= kPointwiseTileSize ?
+      num_rows * tiles_per_row :
+      (num_rows + rows_per_tile - 1) / rows_per_tile;
+
+#ifdef _OPENMP
+  #pragma omp parallel for if (parallel && num_tiles > 1)
+#endif
+  for (int tile = 0; tile < num_tiles; ++tile) {
+    int begin, end;
+    if (inner >= kPointwiseTileSize) {
+      const int row = tile / tiles_per_row;
+      begin = row * inner + (tile % tiles_per_row) * kPointwiseTileSize;
+      end = std::min(begin + kPointwiseTileSize, (row + 1) * inner);
+    } else {
+      begin = tile * rows_per_tile * inner;
+      end = std::min(begin + rows_per_tile * inner, count);
+    }
+    for (int k = 0; k < ops_.size(); ++k) {
+      const Op& op = ops_[k];
+      // The first op reads the input, the rest update the tile in place.
+      const Dtype* src = k == 0 ? input : output;
+      if (op.type == SCALE || op.type == BIAS) {
+        for (int pos = begin; pos < end; ) {
+          const int row = pos / inner;
+          const int segment_end = std::min(end, (row + 1) * inner);
+          ApplyOp(op, src + pos, output + pos, pos, segment_end - pos,
+              row % channels, operands, params);
+          pos = segment_end;
+        }
+      } else {
+        ApplyOp(op, src + begin, output + begin, begin, end - begin, 0,
+            operands, params);
+      }
+    }
+  }
+}
+
+INSTANTIATE_CLASS(PointwiseChain);
+
+}  // namespace caffe
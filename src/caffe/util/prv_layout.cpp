@@ -0,0 +1,205 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef MKLDNN_SUPPORTED
+#include <string>
+#include <vector>
+#include "caffe/mkldnn_memory.hpp"
+#endif
+#include "caffe/util/prv_layout.hpp"
+
+namespace caffe {
+
+#ifdef MKLDNN_SUPPORTED
+
+// Returns the descriptor of blob's private data if it holds MKL-DNN floats
+template <typename Dtype>
+static shared_ptr<MKLDNNMemoryDescriptor<Dtype, false> > float_prv_descriptor(
+    Blob<Dtype>* blob) {
+  shared_ptr<MKLDNNMemoryDescriptor<Dtype, false> > descriptor;
+  if (!std::is_same<Dtype, float>::value || blob->prv_data() == NULL ||
+      blob->get_prv_data_descriptor()->get_descr_type() !=
+      PrvMemDescr::PRV_DESCR_MKLDNN) {
+    return descriptor;
+  }
+  descriptor = get_mkldnn_prv_descriptor<Dtype, false>(blob);
+  if (descriptor->prv_memory_pd()->desc().data.data_type != mkldnn_f32) {
+    descriptor.reset();
+  }
+  return descriptor;
+}
+
+template <typename Dtype>
+bool prv_data_elementwise(Blob<Dtype>* blob) {
+  shared_ptr<MKLDNNMemoryDescriptor<Dtype, false> > descriptor =
+      float_prv_descriptor(blob);
+  return descriptor && descriptor->prv_count() == blob->count();
+}
+
+template <typename Dtype>
+bool prv_layout_matches(Blob<Dtype>* blob, Blob<Dtype>* like) {
+  shared_ptr<MKLDNNMemoryDescriptor<Dtype, false> > descriptor =
+      float_prv_descriptor(blob);
+  return descriptor && prv_data_elementwise(like) &&
+      *descriptor->prv_memory_pd() ==
+      *get_mkldnn_prv_descriptor<Dtype, false>(like)->prv_memory_pd();
+}
+
+template <typename Dtype>
+int prv_channel_block(Blob<Dtype>* blob) {
+  if (blob->num_axes() != 4) {
+    return 0;
+  }
+  shared_ptr<MKLDNNMemoryDescriptor<Dtype, false> > descriptor =
+      float_prv_descriptor(blob);
+  if (!descriptor) {
+    return 0;
+  }
+  const mkldnn_memory_format_t format =
+      descriptor->prv_memory_pd()->desc().data.format;
+  const int block = format == mkldnn_nChw8c ? 8 :
+      format == mkldnn_nChw16c ? 16 : 0;
+  return block > 0 && blob->shape(1) % block == 0 ? block : 0;
+}
+
+template <typename Dtype>
+Dtype* mutable_prv_data_like(Blob<Dtype>* top, Blob<Dtype>* like) {
+  shared_ptr<MKLDNNMemoryDescriptor<Dtype, false> > like_descriptor =
+      float_prv_descriptor(like);
+  if (!like_descriptor) {
+    return NULL;
+  }
+  if (top == like) {
+    return prv_data_elementwise(like) ? like->mutable_prv_data() : NULL;
+  }
+  shared_ptr<memory::primitive_desc> usr_memory_pd, prv_memory_pd;
+  if (top->shape() == like->shape()) {
+    if (!prv_data_elementwise(like)) {
+      return NULL;
+    }
+    usr_memory_pd = like_descriptor->usr_memory_pd();
+    prv_memory_pd = like_descriptor->prv_memory_pd();
+  } else {
+    const int block = prv_channel_block(like);
+    if (block == 0 || top->num_axes() != 4 ||
+        top->shape(0) != like->shape(0) || top->shape(2) != like->shape(2) ||
+        top->shape(3) != like->shape(3) || top->shape(1) % block != 0) {
+      return NULL;
+    }
+    engine cpu_engine = CpuEngine::Instance().get_engine();
+    memory::dims dims = {top->shape(0), top->shape(1), top->shape(2),
+                         top->shape(3)};
+    const memory::format format = static_cast<memory::format>(
+        like_descriptor->prv_memory_pd()->desc().data.format);
+    usr_memory_pd.reset(new memory::primitive_desc(
+        memory::desc(dims, memory::data_type::f32, memory::format::nchw),
+        cpu_engine));
+    prv_memory_pd.reset(new memory::primitive_desc(
+        memory::desc(dims, memory::data_type::f32, format), cpu_engine));
+  }
+  // Keep writing into the private buffer top already has in this layout
+  shared_ptr<PrvMemDescr> top_descriptor = top->get_prv_data_descriptor();
+  if (top_descriptor &&
+      top_descriptor->get_descr_type() == PrvMemDescr::PRV_DESCR_MKLDNN &&
+      *get_mkldnn_prv_descriptor<Dtype, false>(top)->prv_memory_pd() ==
+      *prv_memory_pd && top_descriptor != like->get_prv_data_descriptor()) {
+    top->set_prv_data_descriptor(top_descriptor, false);
+    return top->mutable_prv_data();
+  }
+  shared_ptr<MKLDNNData<Dtype> > descriptor(new MKLDNNData<Dtype>(
+      usr_memory_pd, prv_memory_pd, top, like_descriptor->mkldnn_layer()));
+  descriptor->name = "prv_data_like @ " + like_descriptor->name;
+  MKLDNNPrimitive<Dtype> memory_primitive(descriptor->get_prv_memory());
+  descriptor->set_mkldnn_primitive(memory_primitive);
+  top->set_prv_data_descriptor(descriptor, false);
+  return top->mutable_prv_data();
+}
+
+#else  // MKLDNN_SUPPORTED
+
+template <typename Dtype>
+bool prv_data_elementwise(Blob<Dtype>* blob) {
+  return false;
+}
+
+template <typename Dtype>
+bool prv_layout_matches(Blob<Dtype>* blob, Blob<Dtype>* like) {
+  return false;
+}
+
+template <typename Dtype>
+int prv_channel_block(Blob<Dtype>* blob) {
+  return 0;
+}
+
+template <typename Dtype>
+Dtype* mutable_prv_data_like(Blob<Dtype>* top, Blob<Dtype>* like) {
+  return NULL;
+}
+
+#endif  // MKLDNN_SUPPORTED
+
+template <typename Dtype>
+void elementwise_data(Blob<Dtype>* bottom, Blob<Dtype>* top,
+    const Dtype** bottom_data, Dtype** top_data) {
+  *top_data = mutable_prv_data_like(top, bottom);
+  if (*top_data) {
+    *bottom_data = bottom->prv_data();
+  } else {
+    *bottom_data = bottom->cpu_data();
+    *top_data = top->mutable_cpu_data();
+  }
+}
+
+template bool prv_data_elementwise<float>(Blob<float>* blob);
+template bool prv_data_elementwise<double>(Blob<double>* blob);
+template bool prv_layout_matches<float>(Blob<float>* blob,
+    Blob<float>* like);
+template bool prv_layout_matches<double>(Blob<double>* blob,
+    Blob<double>* like);
+template int prv_channel_block<float>(Blob<float>* blob);
+template int prv_channel_block<double>(Blob<double>* blob);
+template float* mutable_prv_data_like<float>(Blob<float>* top,
+    Blob<float>* like);
+template double* mutable_prv_data_like<double>(Blob<double>* top,
+    Blob<double>* like);
+template void elementwise_data<float>(Blob<float>* bottom, Blob<float>* top,
+    const float** bottom_data, float** top_data);
+template void elementwise_data<double>(Blob<double>* bottom,
+    Blob<double>* top, const double** bottom_data, double** top_data);
+
+}  // namespace caffe
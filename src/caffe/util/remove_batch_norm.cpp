@@ -97,14 +97,108 @@ void MergeLayer(LayerParameter &layer1,
 }
 
 
+bool IsBNFoldableLayer(const LayerParameter& layer_param) {
+  if (layer_param.top_size() != 1) return false;
+  if (layer_param.type().compare("Convolution") == 0 ||
+      layer_param.type().compare("Deconvolution") == 0) {
+    // BatchNorm normalizes over axis 1, which must be the conv channel axis
+    return layer_param.convolution_param().axis() == 1;
+  }
+  if (layer_param.type().compare("InnerProduct") == 0) {
+    return layer_param.inner_product_param().axis() == 1;
+  }
+  return false;
+}
+
+static bool HasBiasTerm(const LayerParameter& layer_param) {
+  if (layer_param.type().compare("InnerProduct") == 0) {
+    return layer_param.inner_product_param().bias_term();
+  }
+  return layer_param.convolution_param().bias_term();
+}
+
+static void EnableBiasTerm(LayerParameter* layer_param) {
+  if (layer_param->type().compare("InnerProduct") == 0) {
+    layer_param->mutable_inner_product_param()->set_bias_term(true);
+  } else {
+    layer_param->mutable_convolution_param()->set_bias_term(true);
+  }
+}
+
+static int NumOutputChannels(const LayerParameter& layer_param) {
+  if (layer_param.type().compare("InnerProduct") == 0) {
+    return layer_param.inner_product_param().num_output();
+  }
+  return layer_param.convolution_param().num_output();
+}
+
+// A Scale layer can be folded only if it applies one factor per channel
+// of its single input, i.e. the BatchNorm-like configuration.
+static bool IsFoldableScaleLayer(const LayerParameter& layer_param) {
+  return layer_param.type().compare("Scale") == 0 &&
+         layer_param.bottom_size() == 1 &&
+         layer_param.scale_param().axis() == 1 &&
+         layer_param.scale_param().num_axes() == 1;
+}
+
+// Multiply every weight contributing to output channel i by alpha[i].
+// Weight layouts differ between the conv-like layers:
+//   Convolution:            (O, I / group, k...)
+//   InnerProduct:           (O, K), or (K, O) when transposed
+//   Deconvolution:          (I, O / group, k...)
+template <typename Dtype>
+static void ScaleOutputChannels(const LayerParameter& layer_param,
+                                Blob<Dtype>* weight_blob, const Dtype* alpha,
+                                int num_output) {
+  Dtype* weight = weight_blob->mutable_cpu_data();
+  if (layer_param.type().compare("Deconvolution") == 0) {
+    const int group = layer_param.convolution_param().group();
+    const int in_channels = weight_blob->shape(0);
+    const int out_per_group = weight_blob->shape(1);
+    const int in_per_group = in_channels / group;
+    const int kernel_dim = weight_blob->count(2);
+    CHECK_EQ(out_per_group * group, num_output);
+#ifdef _OPENMP
+    #pragma omp parallel for collapse(2)
+#endif
+    for (int i = 0; i < in_channels; ++i) {
+      for (int j = 0; j < out_per_group; ++j) {
+        const int o = (i / in_per_group) * out_per_group + j;
+        caffe_scal(kernel_dim, alpha[o],
+                   weight + (i * out_per_group + j) * kernel_dim);
+      }
+    }
+  } else if (layer_param.type().compare("InnerProduct") == 0 &&
+             layer_param.inner_product_param().transpose()) {
+    const int K = weight_blob->count() / num_output;
+    CHECK_EQ(weight_blob->shape(weight_blob->num_axes() - 1), num_output);
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+    for (int k = 0; k < K; ++k) {
+      caffe_mul(num_output, weight + k * num_output, alpha,
+                weight + k * num_output);
+    }
+  } else {
+    CHECK_EQ(weight_blob->shape(0), num_output);
+    const int weight_count = weight_blob->count() / num_output;
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+    for (int i = 0; i < num_output; ++i) {
+      caffe_scal(weight_count, alpha[i], weight + i * weight_count);
+    }
+  }
+}
+
 template <typename Dtype>
 void AdjustConvLayer(LayerParameter &conv_layer,
                      const LayerParameter &batch_norm_layer,
                      const LayerParameter &scale_layer, bool is_net_init) {
   if (is_net_init) {
-    if (!conv_layer.convolution_param().bias_term()) {
+    if (!HasBiasTerm(conv_layer)) {
       //We will merge batch norm and scale layer to con layer, if conv layer doesn't use bias, adjust it!
-      conv_layer.mutable_convolution_param()->set_bias_term(true);
+      EnableBiasTerm(&conv_layer);
     }
   } else {
     Blob<Dtype> conv_weight_blob, conv_bias_blob;
@@ -112,13 +206,14 @@ void AdjustConvLayer(LayerParameter &conv_layer,
     Blob<Dtype> bn_mean_blob, bn_variance_blob, bn_scale_factor_blob;
     Dtype bn_scale_factor;
     Dtype bn_eps = batch_norm_layer.batch_norm_param().eps();
+    const int num_output = NumOutputChannels(conv_layer);
 
     conv_weight_blob.FromProto(conv_layer.blobs(0), true);
-    if (!conv_layer.convolution_param().bias_term()) {
-      conv_layer.mutable_convolution_param()->set_bias_term(true);
+    if (!HasBiasTerm(conv_layer) || conv_layer.blobs_size() < 2) {
+      EnableBiasTerm(&conv_layer);
       vector<int> conv_bias_shape_vec;
       conv_bias_shape_vec.resize(1);
-      conv_bias_shape_vec[0] = conv_weight_blob.shape(0);
+      conv_bias_shape_vec[0] = num_output;
       conv_bias_blob.Reshape(conv_bias_shape_vec);
       caffe_set(conv_bias_blob.count(), (Dtype)0, conv_bias_blob.mutable_cpu_data());
       BlobProto conv_bias_blob_proto;
@@ -128,32 +223,34 @@ void AdjustConvLayer(LayerParameter &conv_layer,
       conv_bias_blob.FromProto(conv_layer.blobs(1), true);
     }
 
-    //We assume scale layer use weight & bias, but is bias necessary? Need confirm!
     scale_weight_blob.FromProto(scale_layer.blobs(0), true);
-    scale_bias_blob.FromProto(scale_layer.blobs(1), true);
+    // Scale layers default to bias_term: false, in which case beta is zero
+    if (scale_layer.blobs_size() > 1) {
+      scale_bias_blob.FromProto(scale_layer.blobs(1), true);
+    } else {
+      scale_bias_blob.ReshapeLike(scale_weight_blob);
+      caffe_set(scale_bias_blob.count(), (Dtype)0, scale_bias_blob.mutable_cpu_data());
+    }
     bn_mean_blob.FromProto(batch_norm_layer.blobs(0), true);
     bn_variance_blob.FromProto(batch_norm_layer.blobs(1), true);
     bn_scale_factor_blob.FromProto(batch_norm_layer.blobs(2), true);
     bn_scale_factor = bn_scale_factor_blob.cpu_data()[0] == 0 ? 1 : (1 / bn_scale_factor_blob.cpu_data()[0]);
-    CHECK_EQ(bn_variance_blob.shape(0), scale_weight_blob.shape(0));
-    CHECK_EQ(conv_weight_blob.shape(0), scale_weight_blob.shape(0));
-    CHECK_EQ(scale_weight_blob.count(), bn_variance_blob.count());
+    CHECK_EQ(bn_variance_blob.count(), scale_weight_blob.count());
+    CHECK_EQ(scale_weight_blob.count(), num_output);
+    CHECK_EQ(conv_bias_blob.count(), num_output);
     int alpha_count = scale_weight_blob.count();
-    Dtype alpha, scale_weight_val, bn_variance_val;
-    Dtype * conv_weight_buf = conv_weight_blob.mutable_cpu_data();
+    vector<Dtype> alpha(alpha_count);
+    Dtype scale_weight_val, bn_variance_val;
     Dtype * conv_bias_buf = conv_bias_blob.mutable_cpu_data();
     const Dtype * scale_bias_buf = scale_bias_blob.cpu_data();
     const Dtype * bn_mean_buf = bn_mean_blob.cpu_data();
-    int weight_count = conv_weight_blob.count() / conv_weight_blob.shape(0);
     for (int i = 0; i < alpha_count; i++) {
       scale_weight_val = scale_weight_blob.cpu_data()[i];
       bn_variance_val = bn_variance_blob.cpu_data()[i];
-      alpha = scale_weight_val / (std::sqrt(bn_variance_val * bn_scale_factor + bn_eps));
-      conv_bias_buf[i] = conv_bias_buf[i] * alpha + (scale_bias_buf[i] -(bn_mean_buf[i] * bn_scale_factor * alpha));
-      Dtype * weight_area = conv_weight_buf + i * weight_count;
-      caffe_scal(weight_count, alpha, weight_area);
-
+      alpha[i] = scale_weight_val / (std::sqrt(bn_variance_val * bn_scale_factor + bn_eps));
+      conv_bias_buf[i] = conv_bias_buf[i] * alpha[i] + (scale_bias_buf[i] -(bn_mean_buf[i] * bn_scale_factor * alpha[i]));
     }
+    ScaleOutputChannels(conv_layer, &conv_weight_blob, alpha.data(), num_output);
     BlobProto *updated_weight_blob_proto = conv_layer.mutable_blobs(0);
     BlobProto *updated_bias_blob_proto = conv_layer.mutable_blobs(1);
     conv_weight_blob.ToProto(updated_weight_blob_proto);
@@ -194,6 +291,9 @@ void RemoveBNScale(const NetParameter& param, NetParameter* param_compiled) {
 
   // - In TEST Phase, if we detect sequential layers conv->batch norm ->scale,
     // We will merge batch norm and scale layer into conv layer.
+    // "conv" is any layer accepted by IsBNFoldableLayer: 2D/3D Convolution,
+    // Deconvolution and InnerProduct, whatever engine they run on. A ReLU
+    // following the Scale is left in place and then reads the conv output.
   if(param.state().phase() != TEST) {
     param_compiled->CopyFrom(param);
     param_compiled->mutable_compile_net_state()->set_bn_scale_remove(false);
@@ -207,12 +307,13 @@ void RemoveBNScale(const NetParameter& param, NetParameter* param_compiled) {
     LayerParameter *layer_param = (const_cast<NetParameter&>(param)).mutable_layer(i);
     bool layer_included = true;
     bool bn_use_global_stats_set = true;
-    if (layer_param->type().compare("Convolution") == 0) {
+    if (IsBNFoldableLayer(*layer_param)) {
       std::vector<const LayerParameter*> child_layers_params;
 	  Net<Dtype>::GetBlobConsumers(child_layers_params, layer_param->top(0), param, i + 1 < param.layer_size() ? i + 1 : i);
       const LayerParameter &child_layer_param = child_layers_params.size() > 0 ? *(child_layers_params[0]) : *layer_param;
       // check whether child layer is BatchNorm
-      if (child_layer_param.type().compare("BatchNorm") == 0) {
+      if (child_layer_param.type().compare("BatchNorm") == 0 &&
+          child_layer_param.bottom_size() == 1) {
         BatchNormParameter bn_param = child_layer_param.batch_norm_param();
         if (is_net_init) {
           //Testing Network init process
@@ -249,13 +350,14 @@ void RemoveBNScale(const NetParameter& param, NetParameter* param_compiled) {
         std::vector<const LayerParameter*> grandchild_layers_params;
 		Net<Dtype>::GetBlobConsumers(grandchild_layers_params, child_layer_param.top(0), param, i + 2 < param.layer_size() ? i + 2 : i);
         const LayerParameter &grandchild_layer_param = (grandchild_layers_params.size() > 0) ? *(grandchild_layers_params[0]) : child_layer_param;
-        if (grandchild_layer_param.type().compare("Scale") == 0) {
+        if (IsFoldableScaleLayer(grandchild_layer_param) &&
+            grandchild_layer_param.bottom(0) == child_layer_param.top(0)) {
           MergeLayer(*layer_param, grandchild_layer_param);
           AdjustConvLayer<Dtype>(*layer_param, child_layer_param, grandchild_layer_param, is_net_init);
           if (bn_scale_remove == false) bn_scale_remove = true;
           layers_to_drop.insert(child_layer_param.name());
           layers_to_drop.insert(grandchild_layer_param.name());
-        } else if (&child_layer_param != &grandchild_layer_param) {
+        } else {
           //In fact, conv-->batchnorm can also be optimized. In such case, we check the blob size of batch norm layer
           //if is 3, it means current net hasn't used scale layer, this is equivalent to scale layer with all 1 weights and 0 bias
           //if is 4 or 5, it means intel caffe compilation rule 1 works here, we can recover the scale layer from batch norm layer
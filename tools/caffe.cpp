@@ -53,6 +53,8 @@ namespace bp = boost::python;
 #include "boost/make_shared.hpp"
 #include "caffe/caffe.hpp"
 #include "caffe/training_utils.hpp"
+#include "caffe/util/cpu_info.hpp"
+#include "caffe/util/format.hpp"
 #include "caffe/util/performance.hpp"
 #include "caffe/util/signal_handler.h"
 
@@ -331,6 +333,7 @@ int train() {
     solver->Solve();
   }
   LOG(INFO) << "Optimization Done.";
+  caffe::HostAllocator::Get().LogStats();
   return 0;
 }
 RegisterBrewFunction(train);
@@ -451,7 +454,11 @@ int test() {
     Caffe::set_mode(Caffe::CPU);
   }
   // Instantiate the caffe net.
+  // The trained weights replace whatever the fillers would produce; the net
+  // only fills the params they do not cover.
+  Caffe::set_skip_param_fill(true);
   Net<float> caffe_net(FLAGS_model, caffe::TEST, FLAGS_level, &stages, NULL, FLAGS_engine);
+  Caffe::set_skip_param_fill(false);
   caffe_net.CopyTrainedLayersFrom(FLAGS_weights);
   LOG(INFO) << "Running for " << FLAGS_iterations << " iterations.";
 
@@ -575,6 +582,12 @@ int time() {
   Timer timer;
   std::vector<double> forward_time_per_layer(layers.size(), 0.0);
   std::vector<double> backward_time_per_layer(layers.size(), 0.0);
+  // Nanoseconds the OpenMP threads of each layer waited in barriers
+  const bool barrier_wait_known = caffe::cpu::getOpenMpBarrierWaitNs() >= 0;
+  std::vector<int64_t> forward_wait_per_layer(layers.size(), 0);
+  std::vector<int64_t> backward_wait_per_layer(layers.size(), 0);
+  // Layout conversions between private and plain memory in each forward
+  std::vector<uint64_t> forward_conversions_per_layer(layers.size(), 0);
   double forward_time = 0.0;
   double backward_time = 0.0;
   for (int j = 0; j < FLAGS_iterations; ++j) {
@@ -582,18 +595,26 @@ int time() {
     iter_timer.Start();
     forward_timer.Start();
     for (int i = 0; i < layers.size(); ++i) {
+      const int64_t wait = caffe::cpu::getOpenMpBarrierWaitNs();
+      const uint64_t conversions = caffe::PrvMemDescr::conversions();
       timer.Start();
       layers[i]->Forward(bottom_vecs[i], top_vecs[i]);
       forward_time_per_layer[i] += timer.MicroSeconds();
+      forward_wait_per_layer[i] += caffe::cpu::getOpenMpBarrierWaitNs() - wait;
+      forward_conversions_per_layer[i] +=
+          caffe::PrvMemDescr::conversions() - conversions;
     }
     forward_time += forward_timer.MicroSeconds();
     if (!FLAGS_forward_only) {
       backward_timer.Start();
       for (int i = layers.size() - 1; i >= 0; --i) {
+        const int64_t wait = caffe::cpu::getOpenMpBarrierWaitNs();
         timer.Start();
         layers[i]->Backward(top_vecs[i], bottom_need_backward[i],
                             bottom_vecs[i]);
         backward_time_per_layer[i] += timer.MicroSeconds();
+        backward_wait_per_layer[i] +=
+            caffe::cpu::getOpenMpBarrierWaitNs() - wait;
       }
       backward_time += backward_timer.MicroSeconds();
       LOG(INFO) << "Iteration: " << j + 1 << " forward-backward time: "
@@ -615,6 +636,39 @@ int time() {
         FLAGS_iterations << " ms.";
     }
   }
+  if (barrier_wait_known) {
+    LOG(INFO) << "Average OpenMP barrier wait per layer, summed over the "
+      "threads: ";
+    for (int i = 0; i < layers.size(); ++i) {
+      const caffe::string& layername = layers[i]->layer_param().name();
+      const int num_threads = layers[i]->num_threads();
+      const caffe::string threads = num_threads > 0 ?
+        caffe::format_int(num_threads) : "all";
+      LOG(INFO) << std::setfill(' ') << std::setw(10) << layername <<
+        "\tforward: " << forward_wait_per_layer[i] / 1e6 /
+        FLAGS_iterations << " ms on " << threads << " threads.";
+      if (!FLAGS_forward_only) {
+        LOG(INFO) << std::setfill(' ') << std::setw(10) << layername <<
+          "\tbackward: " << backward_wait_per_layer[i] / 1e6 /
+          FLAGS_iterations << " ms on " << threads << " threads.";
+      }
+    }
+  } else {
+    LOG(INFO) << "OpenMP barrier wait isn't measured, it needs USE_OMPT and "
+      "an OpenMP runtime supporting OMPT.";
+  }
+  uint64_t forward_conversions = 0;
+  for (int i = 0; i < layers.size(); ++i) {
+    if (forward_conversions_per_layer[i] > 0) {
+      LOG(INFO) << std::setfill(' ') << std::setw(10) <<
+        layers[i]->layer_param().name() << "\tlayout conversions: " <<
+        static_cast<double>(forward_conversions_per_layer[i]) /
+        FLAGS_iterations << " per forward.";
+      forward_conversions += forward_conversions_per_layer[i];
+    }
+  }
+  LOG(INFO) << "Average layout conversions per forward pass: " <<
+    static_cast<double>(forward_conversions) / FLAGS_iterations;
   total_timer.Stop();
   LOG(INFO) << "Average Forward pass: " << forward_time / 1000 /
     FLAGS_iterations << " ms.";
@@ -625,6 +679,7 @@ int time() {
       FLAGS_iterations << " ms.";
   }
   LOG(INFO) << "Total Time: " << total_timer.MilliSeconds() << " ms.";
+  caffe::HostAllocator::Get().LogStats();
   LOG(INFO) << "*** Benchmark ends ***";
   return 0;
 }
@@ -0,0 +1,138 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Times the CPU forward pass of a stride-2 Deconvolution layer through the
+// direct sub-pixel path and through GEMM + col2im, in 2D and 3D.
+// Usage: deconv_benchmark [--batch=8] [--channels=64] [--size=64] [--depth=8]
+//                         [--kernel=4] [--stride=2] [--pad=1] [--iterations=10]
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/layer_factory.hpp"
+#include "caffe/util/benchmark.hpp"
+
+using caffe::Blob;
+using caffe::Caffe;
+using caffe::CPUTimer;
+using caffe::Layer;
+using caffe::LayerParameter;
+using caffe::LayerRegistry;
+using caffe::shared_ptr;
+using caffe::vector;
+
+DEFINE_int32(batch, 8, "Number of samples per forward pass.");
+DEFINE_int32(channels, 64, "Input and output channels.");
+DEFINE_int32(size, 64, "Input height and width.");
+DEFINE_int32(depth, 8, "Input depth of the 3D case; 0 skips it.");
+DEFINE_int32(kernel, 4, "Kernel size along every spatial axis.");
+DEFINE_int32(stride, 2, "Stride (upsampling factor) along every spatial axis.");
+DEFINE_int32(pad, 1, "Padding along every spatial axis.");
+DEFINE_int32(iterations, 10, "Number of timed forward passes per path.");
+
+// Average forward time in milliseconds, after one warm-up pass.
+static float TimeForward(bool subpixel, const vector<Blob<float>*>& bottom,
+    const vector<Blob<float>*>& top) {
+  LayerParameter param;
+  param.set_type("Deconvolution");
+  param.set_engine("CAFFE");
+  caffe::ConvolutionParameter* conv_param = param.mutable_convolution_param();
+  conv_param->set_num_output(FLAGS_channels);
+  conv_param->add_kernel_size(FLAGS_kernel);
+  conv_param->add_stride(FLAGS_stride);
+  conv_param->add_pad(FLAGS_pad);
+  conv_param->set_engine(caffe::ConvolutionParameter_Engine_CAFFE);
+  conv_param->mutable_weight_filler()->set_type("gaussian");
+  conv_param->mutable_bias_filler()->set_type("constant");
+  conv_param->set_subpixel_deconv(subpixel);
+  shared_ptr<Layer<float> > layer = LayerRegistry<float>::CreateLayer(param);
+  layer->SetUp(bottom, top);
+  layer->Forward(bottom, top);
+  CPUTimer timer;
+  timer.Start();
+  for (int i = 0; i < FLAGS_iterations; ++i) {
+    layer->Forward(bottom, top);
+  }
+  timer.Stop();
+  return timer.MilliSeconds() / FLAGS_iterations;
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = 1;
+  gflags::SetUsageMessage("Times sub-pixel and GEMM + col2im deconvolution\n"
+      "usage: deconv_benchmark [--batch=8] [--channels=64] [--size=64]");
+  caffe::GlobalInit(&argc, &argv);
+  Caffe::set_mode(Caffe::CPU);
+  CHECK_GT(FLAGS_batch, 0);
+  CHECK_GT(FLAGS_channels, 0);
+  CHECK_GT(FLAGS_size, 0);
+  CHECK_GT(FLAGS_iterations, 0);
+
+  for (int num_axes = 2; num_axes <= 3; ++num_axes) {
+    if (num_axes == 3 && FLAGS_depth <= 0) {
+      continue;
+    }
+    vector<int> shape(2, FLAGS_batch);
+    shape[1] = FLAGS_channels;
+    if (num_axes == 3) {
+      shape.push_back(FLAGS_depth);
+    }
+    shape.push_back(FLAGS_size);
+    shape.push_back(FLAGS_size);
+    Blob<float> data(shape);
+    Blob<float> top;
+    caffe::FillerParameter filler_param;
+    caffe::GaussianFiller<float> filler(filler_param);
+    filler.Fill(&data);
+    vector<Blob<float>*> bottom_vec(1, &data);
+    vector<Blob<float>*> top_vec(1, &top);
+
+    const float subpixel_ms = TimeForward(true, bottom_vec, top_vec);
+    const float gemm_ms = TimeForward(false, bottom_vec, top_vec);
+    LOG(INFO) << num_axes << "D " << data.shape_string() << " -> "
+              << top.shape_string() << ": sub-pixel " << subpixel_ms
+              << " ms, GEMM + col2im " << gemm_ms << " ms ("
+              << gemm_ms / subpixel_ms << "x)";
+  }
+  return 0;
+}
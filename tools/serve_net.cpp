@@ -0,0 +1,204 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// This program serves a net over a line protocol on stdin and stdout, with
+// dynamic batching of the requests (see caffe/inference_server.hpp).
+// Usage:
+//    serve_net [FLAGS] MODEL [WEIGHTS]
+//
+// Every input line is a request: an id followed by the values of one sample
+// of the net's input, e.g. "17 0.5 0.25 ...". For each request a line
+//   <id> <latency ms> <queue depth> <batch size> <values of output 0>
+// is written, in the order the requests came in. Statistics are logged
+// when stdin is closed.
+
+#include <boost/thread.hpp>
+
+#include <cstdlib>
+#include <deque>
+#include <iostream>  // NOLINT(readability/streams)
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
+#include "caffe/caffe.hpp"
+#include "caffe/inference_server.hpp"
+#include "caffe/util/io.hpp"
+#include "caffe/util/upgrade_proto.hpp"
+
+using namespace caffe;  // NOLINT(build/namespaces)
+using std::string;
+
+DEFINE_int32(workers, 1,
+    "Number of nets serving requests. They share the weights.");
+DEFINE_int32(max_batch_size, 8,
+    "Largest number of requests run in one forward pass.");
+DEFINE_double(latency_budget_ms, 10,
+    "Time a request may take from arrival to answer, waiting for a fuller "
+    "batch included.");
+DEFINE_string(batch_buckets, "",
+    "Comma separated batch sizes the nets run at; batches are padded up to "
+    "the next one. Defaults to powers of two.");
+
+typedef std::pair<string, shared_ptr<InferenceRequest<float> > > Pending;
+
+// Writes the answers in the order of the requests.
+class Printer {
+ public:
+  Printer() : closed_(false), thread_(&Printer::Entry, this) {}
+
+  void Push(const Pending& pending) {
+    boost::mutex::scoped_lock lock(mutex_);
+    queue_.push_back(pending);
+    cond_.notify_one();
+  }
+
+  void Close() {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      closed_ = true;
+      cond_.notify_one();
+    }
+    thread_.join();
+  }
+
+ private:
+  void Entry() {
+    while (true) {
+      Pending pending;
+      {
+        boost::mutex::scoped_lock lock(mutex_);
+        while (queue_.empty() && !closed_) {
+          cond_.wait(lock);
+        }
+        if (queue_.empty()) {
+          return;
+        }
+        pending = queue_.front();
+        queue_.pop_front();
+      }
+      const InferenceRequest<float>& request = *pending.second;
+      pending.second->Wait();
+      std::ostringstream line;
+      line << pending.first << " " << request.latency_ms() << " "
+           << request.queue_depth() << " " << request.batch_size();
+      const vector<float>& output = request.outputs()[0];
+      for (size_t i = 0; i < output.size(); ++i) {
+        line << " " << output[i];
+      }
+      std::cout << line.str() << std::endl;
+    }
+  }
+
+  boost::mutex mutex_;
+  boost::condition_variable cond_;
+  std::deque<Pending> queue_;
+  bool closed_;
+  boost::thread thread_;
+};
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  // Log to stderr, stdout carries the answers
+  FLAGS_alsologtostderr = 1;
+
+#ifndef GFLAGS_GFLAGS_H_
+  namespace gflags = google;
+#endif
+
+  gflags::SetUsageMessage("Serve a net with dynamic batching over stdin "
+        "and stdout.\n"
+        "Usage:\n"
+        "    serve_net [FLAGS] MODEL [WEIGHTS]\n");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  if (argc < 2 || argc > 3) {
+    gflags::ShowUsageWithFlagsRestrict(argv[0], "tools/serve_net");
+    return 1;
+  }
+
+  NetParameter param;
+  ReadNetParamsFromTextFileOrDie(argv[1], &param);
+  InferenceServer<float>::Options options;
+  options.num_workers = FLAGS_workers;
+  options.max_batch_size = FLAGS_max_batch_size;
+  options.latency_budget_ms = FLAGS_latency_budget_ms;
+  std::stringstream buckets(FLAGS_batch_buckets);
+  string bucket;
+  while (std::getline(buckets, bucket, ',')) {
+    options.batch_buckets.push_back(atoi(bucket.c_str()));
+  }
+  InferenceServer<float> server(param, argc == 3 ? argv[2] : "", options);
+  LOG(INFO) << "Serving " << param.name() << " with " << FLAGS_workers
+            << " workers, samples of " << server.sample_size() << " values";
+
+  Printer printer;
+  string line;
+  while (std::getline(std::cin, line)) {
+    std::istringstream values(line);
+    string id;
+    if (!(values >> id)) {
+      continue;
+    }
+    vector<float> input;
+    float value;
+    while (values >> value) {
+      input.push_back(value);
+    }
+    if (static_cast<int>(input.size()) != server.sample_size()) {
+      LOG(ERROR) << "Request " << id << " has " << input.size()
+                 << " values instead of " << server.sample_size();
+      continue;
+    }
+    printer.Push(Pending(id, server.Submit(input)));
+  }
+  printer.Close();
+
+  const InferenceServerStats stats = server.stats();
+  LOG(INFO) << "Served " << stats.requests << " requests in "
+            << stats.batches << " batches, mean batch size "
+            << stats.mean_batch_size << ", " << stats.padded_samples
+            << " padded samples";
+  LOG(INFO) << "Latency mean " << stats.mean_latency_ms << " ms, p50 "
+            << stats.p50_latency_ms << " ms, p99 " << stats.p99_latency_ms
+            << " ms, max queue depth " << stats.max_queue_depth;
+  return 0;
+}
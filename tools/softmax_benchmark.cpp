@@ -0,0 +1,139 @@
+/*
+All modification made by Intel Corporation: © 2016 Intel Corporation
+
+All contributions by the University of California:
+Copyright (c) 2014, 2015, The Regents of the University of California (Regents)
+All rights reserved.
+
+All other contributions:
+Copyright (c) 2014, 2015, the respective contributors
+All rights reserved.
+For the list of contributors go to https://github.com/BVLC/caffe/blob/master/CONTRIBUTORS.md
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Times the CPU forward pass of the classifier head layers (SoftmaxWithLoss,
+// Accuracy and ArgMax) for large class counts.
+// Usage: softmax_benchmark [--classes=1000,20000,100000] [--batch=32]
+//                          [--top_k=5] [--iterations=20]
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <string>
+#include <vector>
+
+#include "boost/algorithm/string.hpp"
+#include "boost/lexical_cast.hpp"
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/layer_factory.hpp"
+#include "caffe/util/benchmark.hpp"
+#include "caffe/util/rng.hpp"
+
+using caffe::Blob;
+using caffe::Caffe;
+using caffe::CPUTimer;
+using caffe::Layer;
+using caffe::LayerParameter;
+using caffe::LayerRegistry;
+using caffe::shared_ptr;
+using caffe::string;
+using caffe::vector;
+
+DEFINE_string(classes, "1000,20000,100000",
+    "Comma separated list of class counts to benchmark.");
+DEFINE_int32(batch, 32, "Number of samples per forward pass.");
+DEFINE_int32(top_k, 5, "top_k of the Accuracy layer.");
+DEFINE_int32(iterations, 20, "Number of timed forward passes per layer.");
+
+// Average forward time of a layer in milliseconds, after one warm-up pass.
+static float TimeForward(const LayerParameter& param,
+    const vector<Blob<float>*>& bottom, const vector<Blob<float>*>& top) {
+  shared_ptr<Layer<float> > layer = LayerRegistry<float>::CreateLayer(param);
+  layer->SetUp(bottom, top);
+  layer->Forward(bottom, top);
+  CPUTimer timer;
+  timer.Start();
+  for (int i = 0; i < FLAGS_iterations; ++i) {
+    layer->Forward(bottom, top);
+  }
+  timer.Stop();
+  return timer.MilliSeconds() / FLAGS_iterations;
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = 1;
+  gflags::SetUsageMessage("Times SoftmaxWithLoss, Accuracy and ArgMax\n"
+      "usage: softmax_benchmark [--classes=1000,20000,100000] [--batch=32]");
+  caffe::GlobalInit(&argc, &argv);
+  Caffe::set_mode(Caffe::CPU);
+  CHECK_GT(FLAGS_batch, 0);
+  CHECK_GT(FLAGS_iterations, 0);
+
+  vector<string> class_counts;
+  boost::split(class_counts, FLAGS_classes, boost::is_any_of(","));
+  for (int c = 0; c < class_counts.size(); ++c) {
+    const int classes = boost::lexical_cast<int>(class_counts[c]);
+    CHECK_GE(classes, FLAGS_top_k);
+
+    Blob<float> scores(FLAGS_batch, classes, 1, 1);
+    Blob<float> labels(FLAGS_batch, 1, 1, 1);
+    Blob<float> top;
+    caffe::FillerParameter filler_param;
+    filler_param.set_std(4);
+    caffe::GaussianFiller<float> filler(filler_param);
+    filler.Fill(&scores);
+    for (int i = 0; i < FLAGS_batch; ++i) {
+      labels.mutable_cpu_data()[i] = caffe::caffe_rng_rand() % classes;
+    }
+    vector<Blob<float>*> bottom(1, &scores);
+    bottom.push_back(&labels);
+    vector<Blob<float>*> top_vec(1, &top);
+
+    LayerParameter loss_param;
+    loss_param.set_type("SoftmaxWithLoss");
+    const float loss_ms = TimeForward(loss_param, bottom, top_vec);
+
+    LayerParameter accuracy_param;
+    accuracy_param.set_type("Accuracy");
+    accuracy_param.mutable_accuracy_param()->set_top_k(FLAGS_top_k);
+    const float accuracy_ms = TimeForward(accuracy_param, bottom, top_vec);
+
+    LayerParameter argmax_param;
+    argmax_param.set_type("ArgMax");
+    const float argmax_ms = TimeForward(argmax_param,
+        vector<Blob<float>*>(1, &scores), top_vec);
+
+    LOG(INFO) << "classes " << classes << ", batch " << FLAGS_batch
+              << ": SoftmaxWithLoss " << loss_ms << " ms, Accuracy(top-"
+              << FLAGS_top_k << ") " << accuracy_ms << " ms, ArgMax "
+              << argmax_ms << " ms";
+  }
+  return 0;
+}